@@ -1,7 +1,29 @@
-// LibtorrentWrapper.cpp  –  C++17, single TU
+// LibtorrentWrapper.cpp  –  C++17 (SHA engines live in piece_hash.cpp,
+// container parsing in audio_identity.cpp and seek_index.cpp)
 // -------------------------------------------------------------
+// The JNI bridge is only built for Android. Desktop builds (benchmarks,
+// Dart FFI on Linux) export just the C ABI declared in audyn_ffi.h.
+#ifndef AUDYN_WITH_JNI
+#  ifdef __ANDROID__
+#    define AUDYN_WITH_JNI 1
+#  else
+#    define AUDYN_WITH_JNI 0
+#  endif
+#endif
+
+#if AUDYN_WITH_JNI
 #include <jni.h>
+#endif
+#ifdef __ANDROID__
 #include <android/log.h>
+#else
+#include <cstdio>
+#endif
+#include "audyn_ffi.h"
+#include "piece_hash.hpp"
+#include "audio_identity.hpp"
+#include "seek_index.hpp"
+#include "uring.hpp"
 #include <fstream>
 #include <string>
 #include <mutex>
@@ -9,6 +31,23 @@
 #include <thread>
 #include <chrono>
 #include <sstream>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <algorithm>
+#include <shared_mutex>
+#include <unordered_set>
+#include <cstring>
+#include <charconv>
+#include <cmath>
+#include <string_view>
 #include <libtorrent/session.hpp>
 #include <libtorrent/settings_pack.hpp>
 #include <libtorrent/add_torrent_params.hpp>
@@ -19,18 +58,43 @@
 #include <libtorrent/version.hpp>
 #include <libtorrent/torrent_flags.hpp>
 #include <libtorrent/create_torrent.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/disk_interface.hpp>
+#include <libtorrent/disk_buffer_holder.hpp>
+#include <libtorrent/disk_observer.hpp>
+#include <libtorrent/io_context.hpp>
+#include <libtorrent/performance_counters.hpp>
+#include <libtorrent/hasher.hpp>
+#include <libtorrent/session_params.hpp>
+#include <libtorrent/posix_disk_io.hpp>
+#include <libtorrent/mmap_disk_io.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/executor_work_guard.hpp>
 #include <libtorrent/file_storage.hpp>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #include <future>
-#include <jni.h>
 #include <libtorrent/torrent_handle.hpp>
 #include <libtorrent/sha1_hash.hpp>
 #include <libtorrent/hex.hpp>
 
 
 #define  LOG_TAG  "LibtorrentWrapper"
+#ifdef __ANDROID__
 #define  LOGI(...)  ((void)__android_log_print(ANDROID_LOG_INFO ,LOG_TAG,__VA_ARGS__))
 #define  LOGE(...)  ((void)__android_log_print(ANDROID_LOG_ERROR,LOG_TAG,__VA_ARGS__))
+#else
+#define  LOG_STDERR(lvl, fmt, ...)  ((void)std::fprintf(stderr, "%s " LOG_TAG ": " fmt "\n", lvl, ##__VA_ARGS__))
+#define  LOGI(...)  LOG_STDERR("I", __VA_ARGS__)
+#define  LOGE(...)  LOG_STDERR("E", __VA_ARGS__)
+#endif
 
 using namespace lt;          // libtorrent namespace
 using lt::torrent_flags::seed_mode;
@@ -43,678 +107,8555 @@ using lt::torrent_flags::disable_pex;
 static std::unique_ptr<session> g_ses;
 static std::mutex               g_mtx;
 
-// ───────────────────────── helpers ────────────────────────────
-static session& get_session()
+// ───────────────────────  alert pump  ─────────────────────────
+// Alerts are pulled by a single pump thread that sleeps on a condition
+// variable until libtorrent's set_alert_notify() hook fires. The hook runs
+// on libtorrent's network thread and only flips a flag, so an idle session
+// causes zero wakeups and a new alert reaches its subscribers right away.
+//
+// Subscribers register the alert categories they consume (optionally
+// narrowed to one alert type); the session's alert_mask is always the union
+// of those categories, so nothing is generated that nobody reads.
+class alert_dispatcher
 {
-    std::lock_guard<std::mutex> lk(g_mtx);
-    if (g_ses) return *g_ses;
+public:
+    using handler_t = std::function<void(alert*)>;
+    using sub_id    = std::uint32_t;
 
-    settings_pack sp;
-    sp.set_int(settings_pack::alert_mask,
-               alert::error_notification |
-               alert::status_notification |
-               alert::dht_notification);
+    sub_id subscribe(alert_category_t categories, handler_t fn, int alert_type = -1)
+    {
+        sub_id id;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            id = ++m_next_id;
+            auto subs = std::make_shared<sub_list>(*m_subs);
+            subs->push_back({id, categories, alert_type, std::move(fn)});
+            m_subs = std::move(subs);
+        }
+        update_mask();
+        return id;
+    }
 
-    sp.set_bool(settings_pack::enable_outgoing_tcp ,true);
-    sp.set_bool(settings_pack::enable_incoming_tcp ,true);
-    sp.set_bool(settings_pack::enable_outgoing_utp ,true);
-    sp.set_bool(settings_pack::enable_incoming_utp ,true);
-    sp.set_bool(settings_pack::enable_dht          ,true);
-    sp.set_bool(settings_pack::enable_lsd          ,true);
-    sp.set_bool(settings_pack::enable_upnp         ,true);
-    sp.set_bool(settings_pack::enable_natpmp       ,true);
-    sp.set_str (settings_pack::listen_interfaces, "0.0.0.0:6881");
+    void unsubscribe(sub_id id)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto subs = std::make_shared<sub_list>();
+            for (auto const& s : *m_subs)
+                if (s.id != id) subs->push_back(s);
+            m_subs = std::move(subs);
+        }
+        update_mask();
+    }
 
-    g_ses = std::make_unique<session>(sp);
+    // Runs after every drained batch of alerts, on the pump thread.
+    void on_batch_end(std::function<void()> fn)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_batch_end.push_back(std::move(fn));
+    }
 
-    // (Deprecated, but harmless)
-    g_ses->add_dht_router({"67.215.246.10", 6881});
-    g_ses->add_dht_router({"82.221.103.244", 6881});
+    // Runs `fn` with the session on the pump thread. Lets callers that must
+    // not touch g_mtx (lock-free readers) ask for session work; dropped when
+    // no session is running.
+    bool post(std::function<void(session&)> fn)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (!m_thread.joinable()) return false;
+            m_tasks.push_back(std::move(fn));
+            m_pending = true;
+        }
+        m_cv.notify_one();
+        return true;
+    }
 
-    LOGI("libtorrent %s session started", LIBTORRENT_VERSION);
+    // union of every subscriber's categories, ready for settings_pack::alert_mask
+    int alert_mask() const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        return mask_of(*m_subs);
+    }
 
-    // background alert pump
-    std::thread([]{
-        while (true) {
-            std::vector<alert*> alerts;
+    void start(session& ses)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_thread.joinable()) return;
+        m_ses     = &ses;
+        m_stop    = false;
+        m_pending = true;       // alerts may already be queued before the hook is set
+        ses.set_alert_notify([this] {
             {
-                std::lock_guard<std::mutex> lk(g_mtx);
-                if (!g_ses) break;
-                g_ses->pop_alerts(&alerts);
+                std::lock_guard<std::mutex> l(m_mtx);
+                m_pending = true;
             }
-            for (auto* a : alerts) {
-                if (auto* b = alert_cast<dht_error_alert>(a))
-                    LOGE("[DHT] %s", b->message().c_str());
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            m_cv.notify_one();
+        });
+        m_thread = std::thread([this] { run(); });
+    }
+
+    // Blocks until the pump thread has drained its current batch and exited.
+    // Must be called before the session it was started on is destroyed.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (!m_thread.joinable()) return;
+            m_stop = true;
         }
-    }).detach();
+        m_cv.notify_one();
+        m_thread.join();
 
-    return *g_ses;
-}
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_ses) m_ses->set_alert_notify({});
+        m_ses = nullptr;
+        m_tasks.clear();
+    }
 
-std::string escape_json_string(const std::string& s) {
-    std::ostringstream o;
-    for (auto c : s) {
-        switch (c) {
-            case '"': o << "\\\""; break;
-            case '\\': o << "\\\\"; break;
-            case '\b': o << "\\b"; break;
-            case '\f': o << "\\f"; break;
-            case '\n': o << "\\n"; break;
-            case '\r': o << "\\r"; break;
-            case '\t': o << "\\t"; break;
-            default:
-                if ('\x00' <= c && c <= '\x1f') {
-                    o << "\\u" << std::hex << (int)c;
-                } else {
-                    o << c;
-                }
-        }
+private:
+    struct subscriber {
+        sub_id           id;
+        alert_category_t categories;
+        int              type;
+        handler_t        fn;
+    };
+    using sub_list = std::vector<subscriber>;
+
+    static int mask_of(sub_list const& subs)
+    {
+        alert_category_t m{};
+        for (auto const& s : subs) m |= s.categories;
+        return static_cast<int>(static_cast<std::uint32_t>(m));
     }
-    return o.str();
-}
 
-// Recursive conversion from libtorrent::entry to JSON string
-std::string entry_to_json(const lt::entry& e) {
-    using namespace lt;
+    void update_mask()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_ses) return;     // picked up by get_session() when the session is built
 
-    switch (e.type()) {
-        case entry::int_t:
-            return std::to_string(e.integer());
-        case entry::string_t:
-            return "\"" + escape_json_string(e.string()) + "\"";
-        case entry::list_t: {
-            std::string res = "[";
-            bool first = true;
-            for (auto& item : e.list()) {
-                if (!first) res += ",";
-                res += entry_to_json(item);
-                first = false;
+        // apply_settings() only posts to the network thread, safe under m_mtx
+        settings_pack sp;
+        sp.set_int(settings_pack::alert_mask, mask_of(*m_subs));
+        m_ses->apply_settings(std::move(sp));
+    }
+
+    void run()
+    {
+        std::vector<alert*> alerts;
+        std::vector<std::function<void(session&)>> tasks;
+        for (;;) {
+            std::shared_ptr<const sub_list> subs;
+            std::vector<std::function<void()>> batch_end;
+            session* ses;
+            {
+                std::unique_lock<std::mutex> lk(m_mtx);
+                m_cv.wait(lk, [this] { return m_pending || m_stop; });
+                if (m_stop) break;
+                m_pending = false;
+                subs = m_subs;
+                ses  = m_ses;
+                batch_end = m_batch_end;
+                tasks.swap(m_tasks);
             }
-            res += "]";
-            return res;
-        }
-        case entry::dictionary_t: {
-            std::string res = "{";
-            bool first = true;
-            for (auto& pair : e.dict()) {
-                if (!first) res += ",";
-                res += "\"" + escape_json_string(pair.first) + "\":" + entry_to_json(pair.second);
-                first = false;
+
+            for (auto& t : tasks) {
+                try { t(*ses); }
+                catch (std::exception const& e) { LOGE("alert pump task: %s", e.what()); }
             }
-            res += "}";
-            return res;
+            tasks.clear();
+
+            ses->pop_alerts(&alerts);
+            for (auto* a : alerts) {
+                auto const cat  = a->category();
+                auto const type = a->type();
+                for (auto const& s : *subs) {
+                    if (!(cat & s.categories)) continue;
+                    if (s.type >= 0 && s.type != type) continue;
+                    try { s.fn(a); }
+                    catch (std::exception const& e) { LOGE("alert subscriber %u: %s", s.id, e.what()); }
+                }
+            }
+            for (auto& fn : batch_end) fn();
         }
-        default:
-            return "\"\""; // fallback empty string for unknown types
     }
-}
 
-// ────────────────────────  JNI exports  ───────────────────────
-extern "C" {
+    mutable std::mutex               m_mtx;
+    std::condition_variable          m_cv;
+    std::shared_ptr<const sub_list>  m_subs = std::make_shared<sub_list>();
+    std::vector<std::function<void()>>          m_batch_end;
+    std::vector<std::function<void(session&)>>  m_tasks;
+    sub_id                           m_next_id = 0;
+    session*                         m_ses     = nullptr;
+    bool                             m_pending = false;
+    bool                             m_stop    = false;
+    std::thread                      m_thread;
+};
 
+static alert_dispatcher g_alerts;
 
-extern "C" JNIEXPORT jstring JNICALL
-Java_com_example_audyn_LibtorrentWrapper_getAllTorrents(JNIEnv* env, jobject) {
-    std::lock_guard<std::mutex> lk(g_mtx);
-    if (!g_ses) return env->NewStringUTF("[]");
+// ───────────────────────  library storage  ────────────────────
+// Seeds are served from the songs where they already sit in the library.
+// Passing each song's folder as its save_path gave the session one save
+// path per track, a descriptor per file in libtorrent's file pool and a
+// torrent that broke as soon as its file was renamed. A seed is instead
+// added under the single virtual save path library_root, and g_library
+// maps (info-hash, file index) to the real path of each file; adding the
+// same torrent again from a new path, or torrent_handle::rename_file()
+// with an absolute path, relinks it. library_disk_io serves those torrents
+// itself and hands every other torrent to libtorrent's default backend.
 
-    lt::entry::list_type lst;
+static constexpr char library_root[] = "/audyn-library";
 
-    for (const auto& th : g_ses->get_torrents()) {
-        if (!th.is_valid()) continue;
-        const lt::torrent_status st = th.status();
+class library_table
+{
+public:
+    struct entry {
+        std::string              source;    // the song, or the album folder
+        std::string              dir;       // the folder `source` is in
+        std::vector<std::string> paths;     // by file index, "" for pad files
+    };
 
-        lt::entry::dictionary_type d;
-        d["name"]           = st.name;
-        d["state"]          = static_cast<int>(st.state);
-        d["progress"]       = st.progress;
-        d["num_peers"]      = static_cast<int>(st.num_peers);
-        d["download_rate"]  = st.download_rate;
-        d["upload_rate"]    = st.upload_rate;
-        d["save_path"]      = th.save_path();
+    // registers (or relinks) the files of `fs` under `source`: a single
+    // file is `source` itself, an album's tracks keep their paths below it
+    void add(sha1_hash const& key, file_storage const& fs, std::string source)
+    {
+        while (source.size() > 1 && source.back() == '/') source.pop_back();
+        entry e;
+        auto const slash = source.find_last_of('/');
+        e.dir = slash == std::string::npos ? std::string()
+              : slash == 0                 ? std::string("/") : source.substr(0, slash);
+        e.paths.reserve(static_cast<std::size_t>(fs.num_files()));
+        for (file_index_t const i : fs.file_range()) {
+            if (fs.pad_file_at(i)) { e.paths.emplace_back(); continue; }
+            if (fs.num_files() == 1) { e.paths.push_back(source); continue; }
+            std::string const rel = fs.file_path(i);          // "<album>/<track>"
+            auto const cut = rel.find('/');
+            e.paths.push_back(cut == std::string::npos ? source + "/" + rel : source + rel.substr(cut));
+        }
+        e.source = std::move(source);
 
-        lst.push_back(std::move(d));
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        record& r = m_records[key];
+        r.e     = std::move(e);
+        r.fresh = true;
     }
 
-    lt::entry allTorrentsEntry(lst);
-    std::string jsonStr = entry_to_json(allTorrentsEntry);
-    return env->NewStringUTF(jsonStr.c_str());
-}
+    bool relink(sha1_hash const& key, int file, std::string path)
+    {
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end() || file < 0 || file >= int(it->second.e.paths.size())) return false;
+        if (it->second.e.paths.size() == 1) it->second.e.source = path;
+        it->second.e.paths[std::size_t(file)] = std::move(path);
+        return true;
+    }
 
-// -----------------------------------------------------------------
-// getTorrentStats()  →  JSON (bencoded list of dictionaries)
-// -----------------------------------------------------------------
-JNIEXPORT jstring JNICALL
-Java_com_example_audyn_LibtorrentWrapper_getTorrentStats(JNIEnv* env, jobject) {
-    std::lock_guard<std::mutex> lk(g_mtx);
-    if (!g_ses) return env->NewStringUTF("[]");
+    bool find(sha1_hash const& key, entry& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) return false;
+        out = it->second.e;
+        return true;
+    }
+
+    bool path(sha1_hash const& key, int file, std::string& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end() || file < 0 || file >= int(it->second.e.paths.size())) return false;
+        out = it->second.e.paths[std::size_t(file)];
+        return !out.empty();
+    }
 
-    lt::entry::list_type lst;
+    bool dir(sha1_hash const& key, std::string& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) return false;
+        out = it->second.e.dir;
+        return true;
+    }
 
-    for (const auto& th : g_ses->get_torrents()) {
-        if (!th.is_valid()) continue;
-        const lt::torrent_status st = th.status();
+    // The disk backend opened / closed a storage of `key`. An entry lives
+    // while a storage uses it; one registered since the last open survives
+    // the close, as the torrent was removed and added again meanwhile.
+    bool attach(sha1_hash const& key)
+    {
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) return false;
+        ++it->second.storages;
+        it->second.fresh = false;
+        return true;
+    }
 
-        lt::entry::dictionary_type d;
-        d["name"]           = st.name;
-        d["state"]          = static_cast<int>(st.state);
-        d["progress"]       = st.progress;
-        d["num_peers"]      = static_cast<int>(st.num_peers);
-        d["download_rate"]  = st.download_rate;
-        d["upload_rate"]    = st.upload_rate;
-        d["save_path"]      = th.save_path();
+    void detach(sha1_hash const& key)
+    {
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) return;
+        if (--it->second.storages <= 0 && !it->second.fresh) m_records.erase(it);
+    }
 
-        lst.push_back(std::move(d));
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        return m_records.size();
     }
 
-    lt::entry allTorrentsEntry(lst);
-    std::string jsonStr = entry_to_json(allTorrentsEntry);
-    return env->NewStringUTF(jsonStr.c_str());
-}
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        m_records.clear();
+    }
 
+private:
+    struct record {
+        entry e;
+        int   storages = 0;
+        bool  fresh    = true;      // added, no storage opened for it since
+    };
 
-// -----------------------------------------------------------------
-// addTorrent(...)
-// -----------------------------------------------------------------
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_addTorrent(JNIEnv* env, jobject,
-                                                    jstring jPath,
-                                                    jstring jSave,
-                                                    jboolean jSeed,
-                                                    jboolean jAnnounce,
-                                                    jboolean jEnableDHT,
-                                                    jboolean jEnableLSD,
-                                                    jboolean jEnableUTP,
-                                                    jboolean jEnableTrackers,
-                                                    jboolean jEnablePEX)
+    mutable std::shared_mutex                m_mtx;
+    std::unordered_map<sha1_hash, record>    m_records;
+};
+
+static library_table g_library;
+
+// save path to show for a torrent: the folder of its source for a seed
+static std::string shown_save_path(sha1_hash const& key, std::string const& save_path)
 {
-    if (!jPath || !jSave) return JNI_FALSE;
+    std::string dir;
+    if (save_path == library_root && g_library.dir(key, dir)) return dir;
+    return save_path;
+}
 
-    const char* path  = env->GetStringUTFChars(jPath , nullptr);
-    const char* spath = env->GetStringUTFChars(jSave , nullptr);
+struct library_io_stats {
+    std::atomic<std::uint64_t> reads{0}, writes{0}, hashes{0};
+    std::atomic<std::uint64_t> opens{0}, reuses{0}, evictions{0};
+    std::atomic<std::int64_t>  open_files{0}, file_limit{0};
+    std::atomic<bool>          ring{false};     // reads go through io_uring
+    std::atomic<std::uint64_t> ring_batches{0}, ring_ops{0}, fixed_files{0}, fixed_buffers{0};
+};
 
-    bool ok = false;
-    try {
-        auto& ses = get_session();
+static library_io_stats g_library_stats;
 
-        error_code ec;
-        auto ti = std::make_shared<torrent_info>(std::string(path), ec);
-        if (ec) throw std::runtime_error(ec.message());
+// Bounded LRU of descriptors shared by every library torrent: seeding ten
+// thousand songs keeps at most `capacity` files open, and a block request
+// is one pread() on a descriptor that is usually open already. Library
+// files are the user's own media and only ever opened O_RDONLY.
+class library_files
+{
+public:
+    struct file {
+        std::uint64_t id     = 0;       // unique per open(), never reused
+        int         fd       = -1;
+        std::string path;
+        file() = default;
+        file(file const&) = delete;
+        file& operator=(file const&) = delete;
+        ~file() { if (fd >= 0) ::close(fd); }
+    };
+    using file_ptr = std::shared_ptr<file const>;
 
-        add_torrent_params p;
-        p.ti        = ti;
-        p.save_path = spath;
-        p.flags     = {};
+    library_files(int capacity, library_io_stats& stats) : m_stats(stats) { set_capacity(capacity); }
 
-        if (jSeed)              p.flags |= seed_mode;
-        if (!jAnnounce)         p.flags |= paused;
-        if (!jEnableDHT)        p.flags |= disable_dht;
-        if (!jEnableLSD)        p.flags |= disable_lsd;
-        if (!jEnablePEX)        p.flags |= disable_pex;
+    // `id` is file_id() of one file of one storage; null with `err` set
+    // when the file cannot be opened
+    file_ptr open(std::uint64_t id, std::string const& path, int& err)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_open.find(id);
+            if (it != m_open.end() && it->second.f->path == path) {
+                m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+                it->second.used = clock_type::now();
+                m_stats.reuses.fetch_add(1, std::memory_order_relaxed);
+                return it->second.f;
+            }
+        }
 
-        if (!jEnableTrackers)   p.trackers.clear();
+        auto f = std::make_shared<file>();
+        f->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f->fd < 0) { err = errno; return {}; }
+        f->id   = m_next_id.fetch_add(1, std::memory_order_relaxed) + 1;
+        f->path = path;
+        m_stats.opens.fetch_add(1, std::memory_order_relaxed);
 
-        // Disable uTP globally if requested
-        if (!jEnableUTP) {
-            settings_pack s;
-            s.set_bool(settings_pack::enable_outgoing_utp, false);
-            s.set_bool(settings_pack::enable_incoming_utp, false);
-            ses.apply_settings(s);
+        std::vector<file_ptr> closing;      // closed once m_mtx is released
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_open.find(id);
+        if (it != m_open.end()) {
+            closing.push_back(std::move(it->second.f));
+            it->second.f    = f;
+            it->second.used = clock_type::now();
+            m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+        } else {
+            m_lru.push_front(id);
+            m_open.emplace(id, slot{f, m_lru.begin(), clock_type::now()});
         }
+        trim_locked(closing);
+        return f;
+    }
 
-        ses.async_add_torrent(std::move(p));
-        ok = true;
+    // every descriptor of one storage
+    void close(std::uint32_t storage)
+    {
+        std::vector<file_ptr> closing;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (auto it = m_open.begin(); it != m_open.end();) {
+            if (std::uint32_t(it->first >> 32) != storage) { ++it; continue; }
+            closing.push_back(std::move(it->second.f));
+            m_lru.erase(it->second.pos);
+            it = m_open.erase(it);
+        }
+        m_stats.open_files.store(std::int64_t(m_open.size()), std::memory_order_relaxed);
     }
-    catch (std::exception const& e) { LOGE("addTorrent: %s", e.what()); }
 
-    env->ReleaseStringUTFChars(jPath , path );
-    env->ReleaseStringUTFChars(jSave , spath);
-    return ok ? JNI_TRUE : JNI_FALSE;
-}
+    std::vector<open_file_state> status(std::uint32_t storage) const
+    {
+        std::vector<open_file_state> out;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (auto const& [id, s] : m_open) {
+            if (std::uint32_t(id >> 32) != storage) continue;
+            out.push_back({file_index_t(int(id & 0xffffffffu)), file_open_mode::read_only, s.used});
+        }
+        return out;
+    }
 
+    void set_capacity(int capacity)
+    {
+        std::vector<file_ptr> closing;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_capacity = std::size_t(std::max(capacity, 1));
+        m_stats.file_limit.store(std::int64_t(m_capacity), std::memory_order_relaxed);
+        trim_locked(closing);
+    }
 
-bool file_exists(const std::string& path) {
-    struct ::stat buffer;  // <-- use ::stat to refer to system stat
-    return (::stat(path.c_str(), &buffer) == 0);
-}
+    static std::uint64_t file_id(std::uint32_t storage, file_index_t f)
+    {
+        return std::uint64_t(storage) << 32 | std::uint32_t(static_cast<int>(f));
+    }
 
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_createTorrent(JNIEnv* env, jobject,
-                                                       jstring jFilePath,
-                                                       jstring jOutputPath,
-                                                       jobjectArray jTrackers) {
-    if (!jFilePath || !jOutputPath) return JNI_FALSE;
+private:
+    struct slot {
+        file_ptr                           f;
+        std::list<std::uint64_t>::iterator pos;
+        time_point                         used;
+    };
 
-    const char* filePath = env->GetStringUTFChars(jFilePath, nullptr);
-    const char* outputPath = env->GetStringUTFChars(jOutputPath, nullptr);
-
-    std::string inputPathStr(filePath);
-    std::string outputPathStr(outputPath);
-
-    env->ReleaseStringUTFChars(jFilePath, filePath);
-    env->ReleaseStringUTFChars(jOutputPath, outputPath);
-
-    bool result = false;
-    std::mutex mtx;
-    std::condition_variable cv;
-    bool done = false;
-
-    std::thread worker([&]() {
-        try {
-            lt::file_storage fs;
-            lt::add_files(fs, inputPathStr);
-
-            lt::create_torrent t(fs);
-
-            // Add trackers from jobjectArray jTrackers
-            if (jTrackers != nullptr) {
-                jsize trackerCount = env->GetArrayLength(jTrackers);
-                for (jsize i = 0; i < trackerCount; ++i) {
-                    jstring jTracker = (jstring)env->GetObjectArrayElement(jTrackers, i);
-                    if (jTracker) {
-                        const char* trackerStr = env->GetStringUTFChars(jTracker, nullptr);
-                        if (trackerStr) {
-                            t.add_tracker(trackerStr);
-                            env->ReleaseStringUTFChars(jTracker, trackerStr);
-                        }
-                        env->DeleteLocalRef(jTracker);
-                    }
-                }
-            }
+    void trim_locked(std::vector<file_ptr>& closing)
+    {
+        while (m_open.size() > m_capacity) {
+            auto it = m_open.find(m_lru.back());
+            closing.push_back(std::move(it->second.f));
+            m_open.erase(it);
+            m_lru.pop_back();
+            m_stats.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_stats.open_files.store(std::int64_t(m_open.size()), std::memory_order_relaxed);
+    }
 
-            lt::error_code ec;
+    mutable std::mutex                      m_mtx;
+    std::unordered_map<std::uint64_t, slot> m_open;
+    std::list<std::uint64_t>                m_lru;      // most recently used first
+    std::size_t                             m_capacity = 1;
+    std::atomic<std::uint64_t>              m_next_id{0};
+    library_io_stats&                       m_stats;
+};
 
-            auto progress_cb = [&](lt::piece_index_t piece) {
-                LOGI("Hashing piece %d", piece);
-                return false; // false = continue hashing, true = cancel
-            };
+// one torrent served from the library, shared with the jobs still running
+// on it
+struct library_storage {
+    sha1_hash     key;
+    std::uint32_t serial;       // names its descriptors in library_files
+    file_storage  files;        // a copy: jobs may outlive the torrent
+};
 
-            // Correct call: callback before error_code
-            lt::set_piece_hashes(t, inputPathStr, progress_cb, ec);
+// Block and piece reads of library torrents, batched through one io_uring
+// on desktop Linux (see uring.hpp). Everything queued since the previous
+// kick() – libtorrent's submit_jobs() – goes to the kernel in a single
+// io_uring_enter() that also collects finished reads. Buffers come from an
+// arena registered as a fixed buffer, so the kernel maps no pages per
+// read; blocks handed to libtorrent stay in the arena until it frees them,
+// and a read that finds the arena full gets a heap buffer instead. A file
+// read a second time is registered in a slot of the ring's file table and
+// read by slot from then on. One thread prepares, submits and reaps.
+class uring_reader
+{
+public:
+    // `buf` (nullptr on error) belongs to the callee, which hands it back
+    // through release(); runs on the ring thread
+    using done_fn = std::function<void(char* buf, storage_error const& ec)>;
 
-            if (ec) {
-                LOGE("set_piece_hashes failed: [%s] %s", ec.category().name(), ec.message().c_str());
-                result = false;
-            } else {
-                lt::entry e = t.generate();
-                std::vector<char> buffer;
-                lt::bencode(std::back_inserter(buffer), e);
-
-                std::ofstream outFile(outputPathStr, std::ios::binary | std::ios::trunc);
-                if (!outFile.is_open()) {
-                    LOGE("Failed to open output file: %s", outputPathStr.c_str());
-                    result = false;
-                } else {
-                    outFile.write(buffer.data(), buffer.size());
-                    outFile.close();
-                    LOGI("Torrent successfully created at: %s", outputPathStr.c_str());
-                    result = true;
-                }
-            }
-        } catch (const std::exception& e) {
-            LOGE("Exception during createTorrent: %s", e.what());
-            result = false;
-        }
+    static constexpr std::size_t arena_bytes = 8 * 1024 * 1024;
+    static constexpr std::size_t arena_block = default_block_size;
+    static constexpr unsigned    depth       = 128;
+    static constexpr unsigned    file_slots  = 1024;
 
-        {
-            std::lock_guard<std::mutex> lock(mtx);
-            done = true;
+    // null where io_uring cannot be used; the caller stays on pread()
+    static std::unique_ptr<uring_reader> create(library_files& files, library_io_stats& stats)
+    {
+        if (!uring::supported()) return {};
+        std::unique_ptr<uring_reader> r(new uring_reader(files, stats));
+        if (int const e = r->m_ring.open(depth)) {
+            LOGI("io_uring unavailable (%s); library reads use pread()", std::strerror(e));
+            return {};
         }
-        cv.notify_one();
-    });
+        void* arena = ::mmap(nullptr, arena_bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena != MAP_FAILED) {
+            r->m_arena = static_cast<char*>(arena);
+            r->m_used.assign(arena_bytes / arena_block, 0);
+            // RLIMIT_MEMLOCK may refuse; the arena still saves a malloc()
+            if (int const e = r->m_ring.register_buffer(arena, arena_bytes))
+                LOGI("io_uring: no fixed buffer (%s)", std::strerror(e));
+        }
+        if (int const e = r->m_ring.register_files(file_slots))
+            LOGI("io_uring: no fixed files (%s)", std::strerror(e));
+        r->m_slot_busy.assign(r->m_ring.file_slots(), 0);
+        r->m_slot_file.assign(r->m_ring.file_slots(), 0);
+        r->m_thread = std::thread([p = r.get()] { p->run(); });
+        return r;
+    }
 
-    // Wait for thread to finish
+    ~uring_reader()
     {
-        std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [&] { return done; });
+        stop();
+        if (m_arena) ::munmap(m_arena, arena_bytes);
     }
 
-    worker.join();
-
-    return result ? JNI_TRUE : JNI_FALSE;
-}
+    // queues a read of `len` bytes at `offset` into `piece`; false once
+    // the ring has failed, and the caller reads some other way (what was
+    // queued by then is read with pread() on the ring thread)
+    bool read(std::shared_ptr<library_storage const> st, piece_index_t piece, int offset, int len,
+              done_fn done)
+    {
+        auto r = std::make_unique<request>();
+        r->st     = std::move(st);
+        r->piece  = piece;
+        r->offset = offset;
+        r->len    = len;
+        r->done   = std::move(done);
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_broken || m_stop) return false;
+        m_queue.push_back(std::move(r));
+        return true;
+    }
 
+    // the end of a batch of read()s
+    void kick()
+    {
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            queued = !m_queue.empty();
+        }
+        if (queued) m_cv.notify_one();
+    }
 
-// -----------------------------------------------------------------
-// removeTorrentByName(name)  → bool
-// -----------------------------------------------------------------
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_removeTorrentByName(JNIEnv* env, jobject,
-                                                             jstring jName)
-{
-    if (!jName) return JNI_FALSE;
-    const char* name = env->GetStringUTFChars(jName, nullptr);
+    bool owns(char const* b) const
+    {
+        return m_arena && b >= m_arena && b < m_arena + arena_bytes;
+    }
 
-    bool removed = false;
+    void release(char* b)
     {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        if (!g_ses) goto done;
+        if (!owns(b)) { std::free(b); return; }
+        std::size_t const first = std::size_t(b - m_arena) / arena_block;
+        std::lock_guard<std::mutex> lk(m_arena_mtx);
+        std::size_t const n = m_used[first];
+        std::fill_n(m_used.begin() + std::ptrdiff_t(first), n, std::uint16_t(0));
+    }
 
-        for (auto const& th : g_ses->get_torrents()) {
-            if (!th.is_valid()) continue;
-            if (th.status().name == name) {
-                g_ses->remove_torrent(th);
-                removed = true;
-                break;
-            }
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_stop = true;
         }
+        m_cv.notify_one();
+        if (m_thread.joinable()) m_thread.join();
     }
-    done:
-    env->ReleaseStringUTFChars(jName, name);
-    return removed ? JNI_TRUE : JNI_FALSE;
-}
+
+private:
+    struct request;
+
+    struct op {
+        request*                req;
+        library_files::file_ptr f;          // open until the read is done
+        char*                   buf;
+        unsigned                len;        // still to read
+        std::uint64_t           off;
+        file_index_t            file;
+        int                     slot = -1;  // registered file, -1 for the fd
+        iovec                   iov{};
+    };
+
+    struct request {
+        std::shared_ptr<library_storage const> st;
+        piece_index_t   piece{0};
+        int             offset = 0;
+        int             len    = 0;
+        done_fn         done;
+        char*           buf    = nullptr;
+        std::vector<op> ops;
+        int             left   = 0;
+        storage_error   ec;
+    };
+
+    uring_reader(library_files& files, library_io_stats& stats) : m_files(files), m_stats(stats) {}
+
+    // arena blocks, first fit; m_used[first] holds the run length
+    char* alloc(int len)
+    {
+        std::size_t const n = (std::size_t(len) + arena_block - 1) / arena_block;
+        if (m_arena && n > 0) {
+            std::lock_guard<std::mutex> lk(m_arena_mtx);
+            std::size_t run = 0;
+            for (std::size_t i = 0; i < m_used.size();) {
+                if (m_used[i]) { i += m_used[i]; run = 0; continue; }
+                if (++run == n) {
+                    std::size_t const first = i + 1 - n;
+                    std::fill_n(m_used.begin() + std::ptrdiff_t(first), n, std::uint16_t(1));
+                    m_used[first] = std::uint16_t(n);
+                    return m_arena + first * arena_block;
+                }
+                ++i;
+            }
+        }
+        return static_cast<char*>(std::malloc(std::size_t(std::max(len, 1))));
+    }
+
+    void run()
+    {
+        std::vector<uring::completion> done(depth);
+        for (;;) {
+            std::deque<std::unique_ptr<request>> fresh;
+            {
+                std::unique_lock<std::mutex> lk(m_mtx);
+                if (m_inflight == 0 && m_backlog.empty())
+                    m_cv.wait(lk, [this] { return m_stop || !m_queue.empty(); });
+                if (m_stop && m_queue.empty() && m_inflight == 0 && m_backlog.empty()) return;
+                fresh.swap(m_queue);
+            }
+            for (auto& r : fresh) prepare(r.release());
+            queue_backlog();
+            if (m_inflight == 0) continue;
+
+            int const rc = m_ring.submit(1);
+            if (rc < 0 && rc != -EAGAIN && rc != -EBUSY) fail(-rc);
+            m_stats.ring_batches.fetch_add(1, std::memory_order_relaxed);
+            while (unsigned const n = m_ring.reap(done.data(), depth))
+                for (unsigned i = 0; i < n; ++i)
+                    complete(reinterpret_cast<op*>(static_cast<std::uintptr_t>(done[i].user_data)), done[i].res);
+        }
+    }
+
+    // maps the range onto files and opens them; the reads wait in m_backlog
+    void prepare(request* r)
+    {
+        file_storage const& fs = r->st->files;
+        r->buf = alloc(r->len);
+        if (!r->buf) {
+            r->ec = storage_error(error_code(ENOMEM, generic_category()), operation_t::alloc_cache_piece);
+            finish(r);
+            return;
+        }
+        auto const slices = fs.map_block(r->piece, r->offset, r->len);
+        r->ops.reserve(slices.size());
+        char* p = r->buf;
+        for (file_slice const& s : slices) {
+            if (fs.pad_file_at(s.file_index)) {
+                std::memset(p, 0, std::size_t(s.size));
+                p += s.size;
+                continue;
+            }
+            std::string path;
+            int err = ENOENT;
+            library_files::file_ptr f;
+            if (g_library.path(r->st->key, static_cast<int>(s.file_index), path))
+                f = m_files.open(library_files::file_id(r->st->serial, s.file_index), path, err);
+            if (!f) {
+                r->ec = storage_error(error_code(err, generic_category()), s.file_index, operation_t::file_open);
+                r->ops.clear();
+                finish(r);
+                return;
+            }
+            r->ops.push_back(op{r, std::move(f), p, unsigned(s.size), std::uint64_t(s.offset), s.file_index});
+            p += s.size;
+        }
+        r->left = int(r->ops.size());
+        if (r->left == 0) { finish(r); return; }
+        for (op& o : r->ops) m_backlog.push_back(&o);
+    }
+
+    void queue_backlog()
+    {
+        if (m_broken) {
+            while (!m_backlog.empty()) {
+                op* o = m_backlog.front();
+                m_backlog.pop_front();
+                ssize_t n;
+                do n = ::pread(o->f->fd, o->buf, o->len, static_cast<off_t>(o->off));
+                while (n < 0 && errno == EINTR);
+                int const res = n < 0 ? -errno : int(n);
+                ++m_inflight;
+                complete(o, res);           // a short read comes back to the front
+            }
+            return;
+        }
+        bool const fixed_buffer = m_ring.has_buffer();
+        while (!m_backlog.empty() && m_inflight < depth) {
+            op* o = m_backlog.front();
+            int const slot = slot_for(*o->f);
+            bool const fixed_buf = fixed_buffer && owns(o->buf);
+            if (!m_ring.read(slot >= 0 ? slot : o->f->fd, slot >= 0, o->buf, o->len, o->off,
+                             fixed_buf, &o->iov, reinterpret_cast<std::uintptr_t>(o))) break;
+            if (slot >= 0) ++m_slot_busy[std::size_t(slot)];
+            o->slot = slot;
+            m_backlog.pop_front();
+            ++m_inflight;
+            m_stats.ring_ops.fetch_add(1, std::memory_order_relaxed);
+            if (slot >= 0)  m_stats.fixed_files.fetch_add(1, std::memory_order_relaxed);
+            if (fixed_buf)  m_stats.fixed_buffers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // the registered slot of `f`, registering it on its second read; -1
+    // to read through its descriptor
+    int slot_for(library_files::file const& f)
+    {
+        unsigned const n = unsigned(m_slot_file.size());
+        if (n == 0) return -1;
+        auto const it = m_slot_of.find(f.id);
+        if (it != m_slot_of.end()) return int(it->second);
+        if (m_seen.insert(f.id).second) {
+            if (m_seen.size() > 4 * n) m_seen.clear();
+            return -1;
+        }
+        for (unsigned k = 0; k < n; ++k) {
+            unsigned const s = m_hand++ % n;
+            if (m_slot_busy[s]) continue;
+            if (m_ring.update_file(s, f.fd) != 0) return -1;
+            if (m_slot_file[s]) m_slot_of.erase(m_slot_file[s]);
+            m_slot_file[s] = f.id;
+            m_slot_of[f.id] = s;
+            return int(s);
+        }
+        return -1;
+    }
+
+    void complete(op* o, int res)
+    {
+        --m_inflight;
+        if (o->slot >= 0) --m_slot_busy[std::size_t(o->slot)];
+        request* r = o->req;
+        if (res > 0 && unsigned(res) < o->len) {            // short read: the rest again
+            o->buf += res;
+            o->len -= unsigned(res);
+            o->off += std::uint64_t(res);
+            m_backlog.push_front(o);
+            return;
+        }
+        if (res <= 0 && !r->ec) {
+            r->ec = storage_error(res == 0 ? error_code(boost::asio::error::eof)
+                                           : error_code(-res, generic_category()),
+                                  o->file, operation_t::file_read);
+        }
+        if (--r->left == 0) finish(r);
+    }
+
+    void finish(request* r)
+    {
+        char* buf = r->buf;
+        if (r->ec && buf) { release(buf); buf = nullptr; }
+        r->done(buf, r->ec);
+        delete r;
+    }
+
+    // the ring refuses submissions: reads the kernel did not pick up go
+    // back to the backlog for pread(), the others are waited for, and
+    // read() says no from now on
+    void fail(int err)
+    {
+        LOGE("io_uring submit failed (%s); library reads fall back to pread()", std::strerror(err));
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_broken = true;
+        }
+        m_stats.ring.store(false, std::memory_order_relaxed);
+        std::vector<std::uint64_t> back(depth);
+        unsigned const taken = m_ring.take_back(back.data(), depth);
+        for (unsigned i = 0; i < taken; ++i) {
+            op* o = reinterpret_cast<op*>(static_cast<std::uintptr_t>(back[i]));
+            --m_inflight;
+            if (o->slot >= 0) --m_slot_busy[std::size_t(o->slot)];
+            o->slot = -1;
+            m_backlog.push_front(o);
+        }
+        std::vector<uring::completion> done(depth);
+        while (m_inflight > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            while (unsigned const n = m_ring.reap(done.data(), depth))
+                for (unsigned i = 0; i < n; ++i)
+                    complete(reinterpret_cast<op*>(static_cast<std::uintptr_t>(done[i].user_data)), done[i].res);
+        }
+    }
+
+    library_files&                              m_files;
+    library_io_stats&                           m_stats;
+    uring::ring                                 m_ring;
+    char*                                       m_arena = nullptr;
+    std::mutex                                  m_arena_mtx;
+    std::vector<std::uint16_t>                  m_used;     // per arena block
+
+    // ring thread only
+    std::deque<op*>                             m_backlog;
+    unsigned                                    m_inflight = 0;
+    std::vector<unsigned>                       m_slot_busy;
+    std::vector<std::uint64_t>                  m_slot_file;    // file id per slot, 0 free
+    std::unordered_map<std::uint64_t, unsigned> m_slot_of;
+    std::unordered_set<std::uint64_t>           m_seen;         // read once, not registered
+    unsigned                                    m_hand = 0;
+
+    std::mutex                                  m_mtx;
+    std::condition_variable                     m_cv;
+    std::deque<std::unique_ptr<request>>        m_queue;
+    bool                                        m_stop   = false;
+    bool                                        m_broken = false;   // set by the ring thread
+    std::thread                                 m_thread;
+};
+
+// Upload-path cache of library_disk_io's seeds. While a release spreads
+// through the swarm one seed serves the same few pieces to peer after
+// peer, and every request went back to flash. Each block request adds to
+// the heat of its (info-hash, piece), counted in pieces served (a whole
+// piece transfer adds 1) and halved every `decay_every` requests, so heat
+// follows what is popular now. A piece served more than once gets a
+// piece-sized entry that fills as its blocks are read and answers from RAM
+// from then on. Within `capacity` the hottest pieces stay pinned: a new
+// entry only ever displaces colder ones. A verified piece never changes,
+// so entries only go when displaced, trimmed or forgotten with their
+// torrent.
+class upload_cache
+{
+public:
+    static constexpr std::size_t   default_capacity = 16 * 1024 * 1024;
+    static constexpr std::uint64_t decay_every      = 4096;
+    static constexpr double        admit_above      = 1.0;
+
+    // counts a request for [offset, offset + len) of `piece`, which is
+    // `piece_size` bytes long: a malloc()ed copy of the range if it is
+    // cached, null (and the read goes to disk) if not
+    char* read(sha1_hash const& ih, int piece, int offset, int len, int piece_size)
+    {
+        if (len <= 0 || piece_size <= 0 || offset < 0 || offset + len > piece_size) return nullptr;
+        key const k{ih, piece};
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (++m_requests % decay_every == 0) decay_locked();
+        double const heat = m_heat[k] += double(len) / double(piece_size);
+        auto const it = m_entries.find(k);
+        if (it != m_entries.end() && it->second.has(offset, len)) {
+            char* buf = static_cast<char*>(std::malloc(std::size_t(len)));
+            if (buf) {
+                std::memcpy(buf, it->second.data.get() + offset, std::size_t(len));
+                ++m_hits;
+                return buf;
+            }
+        }
+        ++m_misses;
+        if (it == m_entries.end() && heat > admit_above) admit_locked(k, heat, piece_size);
+        return nullptr;
+    }
+
+    // a block read from disk; kept if its piece has an entry
+    void fill(sha1_hash const& ih, int piece, int offset, char const* buf, int len)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto const it = m_entries.find(key{ih, piece});
+        if (it == m_entries.end()) return;
+        entry& e = it->second;
+        if (offset < 0 || len <= 0 || offset + len > e.size) return;
+        std::memcpy(e.data.get() + offset, buf, std::size_t(len));
+        int const last = e.size - 1;
+        for (int b = (offset + default_block_size - 1) / default_block_size; ; ++b) {
+            int const end = std::min((b + 1) * default_block_size, e.size);
+            if (end > offset + len || b * default_block_size > last) break;
+            e.have[std::size_t(b)] = true;
+        }
+    }
+
+    void forget(sha1_hash const& ih)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+            it = it->first.ih == ih ? drop_locked(it) : std::next(it);
+        for (auto it = m_heat.begin(); it != m_heat.end();)
+            it = it->first.ih == ih ? m_heat.erase(it) : std::next(it);
+    }
+
+    // a piece that may be rewritten (failed its hash check, being rechecked)
+    void forget(sha1_hash const& ih, int piece)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto const it = m_entries.find(key{ih, piece});
+        if (it != m_entries.end()) drop_locked(it);
+    }
+
+    void set_capacity(std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_capacity = bytes;
+        shrink_locked(bytes);
+    }
+
+    // the levels of piece_cache::trim()
+    void trim(int level)
+    {
+        if (level == 20) return;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        shrink_locked(level >= 60 || level == 15 ? 0 : m_bytes / 2);
+        ++m_trims;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        shrink_locked(0);
+        m_heat.clear();
+    }
+
+    struct hot_piece {
+        sha1_hash ih;
+        int       piece;
+        double    heat;
+        bool      cached;
+    };
+    struct stats {
+        std::uint64_t capacity, bytes, entries, tracked;
+        std::uint64_t hits, misses, admitted, displaced, trims;
+        std::vector<hot_piece> hottest;     // by heat, at most `top`
+    };
+
+    stats snapshot(std::size_t top) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        stats st{m_capacity, m_bytes, m_entries.size(), m_heat.size(),
+                 m_hits, m_misses, m_admitted, m_displaced, m_trims, {}};
+        std::vector<std::pair<double, key>> all;
+        all.reserve(m_heat.size());
+        for (auto const& [k, h] : m_heat) all.emplace_back(h, k);
+        std::size_t const n = std::min(all.size(), top);
+        std::partial_sort(all.begin(), all.begin() + std::ptrdiff_t(n), all.end(),
+                          [](auto const& a, auto const& b) { return a.first > b.first; });
+        for (std::size_t i = 0; i < n; ++i)
+            st.hottest.push_back({all[i].second.ih, all[i].second.piece, all[i].first,
+                                  m_entries.count(all[i].second) != 0});
+        return st;
+    }
+
+private:
+    struct key {
+        sha1_hash ih;
+        int       piece;
+        bool operator==(key const& o) const { return piece == o.piece && ih == o.ih; }
+    };
+    struct key_hash {
+        std::size_t operator()(key const& k) const
+        { return std::hash<sha1_hash>()(k.ih) ^ (std::size_t(k.piece) * 0x9E3779B97F4A7C15ull); }
+    };
+    struct entry {
+        std::unique_ptr<char[]> data;
+        int                     size = 0;
+        std::vector<bool>       have;       // per 16 KiB block
+
+        bool has(int offset, int len) const
+        {
+            for (int b = offset / default_block_size; b * default_block_size < offset + len; ++b)
+                if (!have[std::size_t(b)]) return false;
+            return true;
+        }
+    };
+    using entry_map = std::unordered_map<key, entry, key_hash>;
+
+    double heat_locked(key const& k) const
+    {
+        auto const it = m_heat.find(k);
+        return it == m_heat.end() ? 0.0 : it->second;
+    }
+
+    entry_map::iterator drop_locked(entry_map::iterator it)
+    {
+        m_bytes -= std::size_t(it->second.size);
+        return m_entries.erase(it);
+    }
+
+    // room for `size` more bytes, made only from entries colder than
+    // `heat`, and only if that is enough
+    void admit_locked(key const& k, double heat, int size)
+    {
+        if (std::size_t(size) > m_capacity) return;
+        std::vector<std::pair<double, entry_map::iterator>> colder;
+        std::size_t freed = 0;
+        if (m_bytes + std::size_t(size) > m_capacity) {
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+                double const h = heat_locked(it->first);
+                if (h < heat) colder.emplace_back(h, it);
+            }
+            std::sort(colder.begin(), colder.end(),
+                      [](auto const& a, auto const& b) { return a.first < b.first; });
+            std::size_t n = 0;
+            while (m_bytes - freed + std::size_t(size) > m_capacity) {
+                if (n == colder.size()) return;
+                freed += std::size_t(colder[n++].second->second.size);
+            }
+            colder.resize(n);
+        }
+        for (auto const& c : colder) { drop_locked(c.second); ++m_displaced; }
+
+        entry e;
+        e.data.reset(new (std::nothrow) char[std::size_t(size)]);
+        if (!e.data) return;
+        e.size = size;
+        e.have.assign(std::size_t((size + default_block_size - 1) / default_block_size), false);
+        m_bytes += std::size_t(size);
+        m_entries.emplace(k, std::move(e));
+        ++m_admitted;
+    }
+
+    // coldest first
+    void shrink_locked(std::size_t keep)
+    {
+        if (m_bytes <= keep) return;
+        std::vector<std::pair<double, entry_map::iterator>> all;
+        all.reserve(m_entries.size());
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            all.emplace_back(heat_locked(it->first), it);
+        std::sort(all.begin(), all.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+        for (auto const& a : all) {
+            if (m_bytes <= keep) break;
+            drop_locked(a.second);
+        }
+    }
+
+    // halves every heat; cold pieces without an entry stop being tracked
+    void decay_locked()
+    {
+        for (auto it = m_heat.begin(); it != m_heat.end();) {
+            it->second /= 2;
+            if (it->second < 1.0 / 16 && !m_entries.count(it->first)) it = m_heat.erase(it);
+            else ++it;
+        }
+    }
+
+    mutable std::mutex                              m_mtx;
+    entry_map                                       m_entries;
+    std::unordered_map<key, double, key_hash>       m_heat;
+    std::size_t                                     m_capacity  = default_capacity;
+    std::size_t                                     m_bytes     = 0;
+    std::uint64_t                                   m_requests  = 0;
+    std::uint64_t                                   m_hits      = 0;
+    std::uint64_t                                   m_misses    = 0;
+    std::uint64_t                                   m_admitted  = 0;
+    std::uint64_t                                   m_displaced = 0;
+    std::uint64_t                                   m_trims     = 0;
+};
+
+static upload_cache g_upload_cache;
+
+// disk_interface of the session: torrents added under library_root with a
+// g_library entry get a library_storage, read-only and read with pread()
+// by a few worker threads of its own; any other torrent is passed through
+// to the default backend. Jobs queue up and the workers are woken once per
+// submit_jobs() batch. With `use_ring`, and where io_uring works, block
+// and hash reads go through a uring_reader instead and the workers only
+// hash and check. Block reads of library seeds pass `cache` (an
+// upload_cache) first: only peers read a seed through libtorrent, so its
+// heat counts uploads and nothing else. Reads of other torrents, whose
+// callers include read_piece() on a download, go straight to their
+// backend.
+class library_disk_io final : public disk_interface, buffer_allocator_interface
+{
+public:
+    library_disk_io(io_context& ioc, settings_interface const& sett, counters& cnt,
+                    bool use_ring = true, library_io_stats& stats = g_library_stats,
+                    upload_cache* cache = &g_upload_cache)
+        : m_ioc(ioc)
+        , m_settings(sett)
+        , m_inner(default_disk_io_constructor(ioc, sett, cnt))
+        , m_cache(cache)
+        , m_stats(stats)
+        , m_files(sett.get_int(settings_pack::file_pool_size), stats)
+    {
+        if (use_ring) m_ring = uring_reader::create(m_files, stats);
+        m_stats.ring.store(m_ring != nullptr, std::memory_order_relaxed);
+        int const threads = std::clamp(sett.get_int(settings_pack::aio_threads), 1, 4);
+        for (int i = 0; i < threads; ++i) m_threads.emplace_back([this] { run(); });
+    }
+
+    ~library_disk_io() override
+    {
+        if (m_ring) m_ring->stop();
+        stop();
+    }
+
+    storage_holder new_torrent(storage_params const& p, std::shared_ptr<void> const& t) override
+    {
+        slot s;
+        s.key          = p.info_hash;
+        s.piece_length = p.files.piece_length();
+        s.total_size   = p.files.total_size();
+        if (p.path == library_root && g_library.attach(p.info_hash))
+            s.lib = std::make_shared<library_storage>(library_storage{p.info_hash, ++m_serial, p.files});
+        else
+            s.inner = m_inner->new_torrent(p, t);
+
+        int idx;
+        if (!m_free.empty()) {
+            idx = m_free.back();
+            m_free.pop_back();
+            m_slots[std::size_t(idx)] = std::move(s);
+        } else {
+            idx = int(m_slots.size());
+            m_slots.push_back(std::move(s));
+        }
+        return storage_holder(storage_index_t(idx), *this);
+    }
+
+    void remove_torrent(storage_index_t s) override
+    {
+        slot& sl = m_slots[std::size_t(static_cast<int>(s))];
+        if (m_cache) m_cache->forget(sl.key);
+        if (sl.lib) {
+            m_files.close(sl.lib->serial);
+            g_library.detach(sl.lib->key);
+        }
+        sl = slot();        // an inner storage_holder hands its storage back here
+        m_free.push_back(static_cast<int>(s));
+    }
+
+    void async_read(storage_index_t s, peer_request const& r
+        , std::function<void(disk_buffer_holder, storage_error const&)> h
+        , disk_job_flags_t f) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_read(inner(s), r, std::move(h), f); return; }
+        if (m_cache) {
+            slot const& sl = m_slots[std::size_t(static_cast<int>(s))];
+            std::int64_t const start = std::int64_t(static_cast<int>(r.piece)) * sl.piece_length;
+            int const piece_size = int(std::min<std::int64_t>(sl.piece_length, sl.total_size - start));
+            if (char* buf = m_cache->read(sl.key, static_cast<int>(r.piece), r.start, r.length, piece_size)) {
+                boost::asio::post(m_ioc, [this, buf, len = r.length, h = std::move(h)] {
+                    h(disk_buffer_holder(*this, buf, len), storage_error());
+                });
+                return;
+            }
+            h = [this, key = sl.key, r, done = std::move(h)](disk_buffer_holder b, storage_error const& ec) {
+                if (!ec && b) m_cache->fill(key, static_cast<int>(r.piece), r.start, b.data(), r.length);
+                done(std::move(b), ec);
+            };
+        }
+        if (m_ring && m_ring->read(st, r.piece, r.start, r.length,
+                [this, len = r.length, h](char* buf, storage_error const& ec) {
+                    m_stats.reads.fetch_add(1, std::memory_order_relaxed);
+                    boost::asio::post(m_ioc, [this, buf, len, ec, h] {
+                        h(buf ? disk_buffer_holder(*this, buf, len) : disk_buffer_holder(), ec);
+                    });
+                }))
+            return;
+        submit([this, st, r, h = std::move(h)] {
+            storage_error ec;
+            char* buf = static_cast<char*>(std::malloc(std::size_t(r.length)));
+            if (!buf) ec = storage_error(error_code(ENOMEM, generic_category()), operation_t::alloc_cache_piece);
+            else read_range(*st, r.piece, r.start, buf, r.length, ec);
+            if (ec && buf) { std::free(buf); buf = nullptr; }
+            m_stats.reads.fetch_add(1, std::memory_order_relaxed);
+            boost::asio::post(m_ioc, [this, buf, len = r.length, ec, h] {
+                h(buf ? disk_buffer_holder(*this, buf, len) : disk_buffer_holder(), ec);
+            });
+        });
+    }
+
+    bool async_write(storage_index_t s, peer_request const& r, char const* buf
+        , std::shared_ptr<disk_observer> o
+        , std::function<void(storage_error const&)> h, disk_job_flags_t f) override
+    {
+        if (!library(s)) return m_inner->async_write(inner(s), r, buf, std::move(o), std::move(h), f);
+        // never into the user's media: a seed that fails a piece is stopped
+        // (see get_session()), not repaired from the swarm
+        m_stats.writes.fetch_add(1, std::memory_order_relaxed);
+        boost::asio::post(m_ioc, [h = std::move(h)] {
+            h(storage_error(error_code(EROFS, generic_category()), operation_t::file_write));
+        });
+        return false;
+    }
+
+    void async_hash(storage_index_t s, piece_index_t piece, span<sha256_hash> v2
+        , disk_job_flags_t f
+        , std::function<void(piece_index_t, sha1_hash const&, storage_error const&)> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_hash(inner(s), piece, v2, f, std::move(h)); return; }
+        bool const v1 = bool(f & disk_interface::v1_hash);
+        int const size1 = v1 ? st->files.piece_size(piece) : 0;
+        int const size2 = v2.empty() ? 0 : st->files.piece_size2(piece);
+        int const size  = std::max(size1, size2);
+        auto hash = [this, piece, v2, size1, size2, h](char* buf, storage_error const& ec) {
+            sha1_hash ph;
+            if (!ec) {
+                if (size1 > 0) ph = hasher(buf, size1).final();
+                for (int i = 0; i < int(v2.size()); ++i) {
+                    int const off = i * default_block_size;
+                    int const len = std::min(default_block_size, size2 - off);
+                    v2[i] = len > 0 ? hasher256(buf + off, len).final() : sha256_hash();
+                }
+            }
+            m_stats.hashes.fetch_add(1, std::memory_order_relaxed);
+            boost::asio::post(m_ioc, [piece, ph, ec, h] { h(piece, ph, ec); });
+        };
+        // the ring only reads; hashing is worker-thread work
+        if (m_ring && m_ring->read(st, piece, 0, size, [this, hash](char* buf, storage_error const& ec) {
+                submit_now([this, hash, buf, ec] {
+                    hash(buf, ec);
+                    if (buf) free_disk_buffer(buf);
+                });
+            }))
+            return;
+        submit([this, st, piece, size, hash] {
+            std::vector<char> buf(std::size_t(std::max(size, 1)));
+            storage_error ec;
+            read_range(*st, piece, 0, buf.data(), size, ec);
+            hash(buf.data(), ec);
+        });
+    }
+
+    void async_hash2(storage_index_t s, piece_index_t piece, int offset, disk_job_flags_t f
+        , std::function<void(piece_index_t, sha256_hash const&, storage_error const&)> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_hash2(inner(s), piece, offset, f, std::move(h)); return; }
+        int const len = std::min(default_block_size, st->files.piece_size2(piece) - offset);
+        auto hash = [this, piece, len, h](char const* buf, storage_error const& ec) {
+            sha256_hash out;
+            if (!ec && len > 0) out = hasher256(buf, len).final();
+            m_stats.hashes.fetch_add(1, std::memory_order_relaxed);
+            boost::asio::post(m_ioc, [piece, out, ec, h] { h(piece, out, ec); });
+        };
+        if (len > 0 && m_ring && m_ring->read(st, piece, offset, len, [this, hash](char* buf, storage_error const& ec) {
+                submit_now([this, hash, buf, ec] {
+                    hash(buf, ec);
+                    if (buf) free_disk_buffer(buf);
+                });
+            }))
+            return;
+        submit([this, st, piece, offset, len, hash] {
+            std::vector<char> buf(std::size_t(std::max(len, 1)));
+            storage_error ec;
+            if (len > 0) read_range(*st, piece, offset, buf.data(), len, ec);
+            hash(buf.data(), ec);
+        });
+    }
+
+    // library files stay where the library keeps them
+    void async_move_storage(storage_index_t s, std::string p, move_flags_t f
+        , std::function<void(status_t, std::string const&, storage_error const&)> h) override
+    {
+        if (!library(s)) { m_inner->async_move_storage(inner(s), std::move(p), f, std::move(h)); return; }
+        boost::asio::post(m_ioc, [h = std::move(h)] {
+            h(status_t::fatal_disk_error, library_root,
+              storage_error(boost::asio::error::operation_not_supported, operation_t::file_rename));
+        });
+    }
+
+    void async_release_files(storage_index_t s, std::function<void()> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_release_files(inner(s), std::move(h)); return; }
+        m_files.close(st->serial);
+        boost::asio::post(m_ioc, std::move(h));
+    }
+
+    // every file there at least at its full size; a seed is trusted, its
+    // pieces are checked as they are first read
+    void async_check_files(storage_index_t s, add_torrent_params const* rd
+        , aux::vector<std::string, file_index_t> links
+        , std::function<void(status_t, storage_error const&)> h) override
+    {
+        if (m_cache) m_cache->forget(m_slots[std::size_t(static_cast<int>(s))].key);
+        auto st = library(s);
+        if (!st) { m_inner->async_check_files(inner(s), rd, std::move(links), std::move(h)); return; }
+        bool const trusted = rd && (rd->flags & seed_mode);
+        submit([this, st, trusted, h = std::move(h)] {
+            file_storage const& fs = st->files;
+            storage_error ec;
+            for (file_index_t const i : fs.file_range()) {
+                if (fs.pad_file_at(i)) continue;
+                std::string path;
+                struct ::stat sb{};
+                if (!g_library.path(st->key, static_cast<int>(i), path)) {
+                    ec = storage_error(error_code(ENOENT, generic_category()), i, operation_t::file_stat);
+                } else if (::stat(path.c_str(), &sb) != 0) {
+                    ec = storage_error(error_code(errno, generic_category()), i, operation_t::file_stat);
+                } else if (sb.st_size < fs.file_size(i)) {
+                    ec = storage_error(error_code(errors::mismatching_file_size), i, operation_t::file_stat);
+                }
+                if (ec) break;
+            }
+            status_t const res = ec ? status_t::fatal_disk_error
+                               : trusted ? status_t::no_error : status_t::need_full_check;
+            boost::asio::post(m_ioc, [res, ec, h] { h(res, ec); });
+        });
+    }
+
+    void async_stop_torrent(storage_index_t s, std::function<void()> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_stop_torrent(inner(s), std::move(h)); return; }
+        m_files.close(st->serial);
+        boost::asio::post(m_ioc, std::move(h));
+    }
+
+    // relinks the file instead of moving it: an absolute `name` is where
+    // it is now, a relative one is taken from the folder of the source
+    void async_rename_file(storage_index_t s, file_index_t i, std::string name
+        , std::function<void(std::string const&, file_index_t, storage_error const&)> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_rename_file(inner(s), i, std::move(name), std::move(h)); return; }
+        std::string path = name;
+        std::string dir;
+        if (path.empty() || path.front() != '/')
+            path = g_library.dir(st->key, dir) ? dir + "/" + name : std::string();
+        storage_error ec;
+        if (path.empty() || !g_library.relink(st->key, static_cast<int>(i), std::move(path)))
+            ec = storage_error(error_code(ENOENT, generic_category()), i, operation_t::file_rename);
+        boost::asio::post(m_ioc, [name = std::move(name), i, ec, h = std::move(h)] { h(name, i, ec); });
+    }
+
+    // never deletes anything from the library
+    void async_delete_files(storage_index_t s, remove_flags_t o
+        , std::function<void(storage_error const&)> h) override
+    {
+        auto st = library(s);
+        if (!st) { m_inner->async_delete_files(inner(s), o, std::move(h)); return; }
+        m_files.close(st->serial);
+        boost::asio::post(m_ioc, [h = std::move(h)] { h(storage_error()); });
+    }
+
+    void async_set_file_priority(storage_index_t s
+        , aux::vector<download_priority_t, file_index_t> prio
+        , std::function<void(storage_error const&, aux::vector<download_priority_t, file_index_t>)> h) override
+    {
+        if (!library(s)) { m_inner->async_set_file_priority(inner(s), std::move(prio), std::move(h)); return; }
+        boost::asio::post(m_ioc, [prio = std::move(prio), h = std::move(h)]() mutable {
+            h(storage_error(), std::move(prio));
+        });
+    }
+
+    void async_clear_piece(storage_index_t s, piece_index_t i
+        , std::function<void(piece_index_t)> h) override
+    {
+        if (m_cache) m_cache->forget(m_slots[std::size_t(static_cast<int>(s))].key, static_cast<int>(i));
+        if (!library(s)) { m_inner->async_clear_piece(inner(s), i, std::move(h)); return; }
+        boost::asio::post(m_ioc, [i, h = std::move(h)] { h(i); });
+    }
+
+    void update_stats_counters(counters& c) const override { m_inner->update_stats_counters(c); }
+
+    std::vector<open_file_state> get_status(storage_index_t s) const override
+    {
+        auto st = library(s);
+        return st ? m_files.status(st->serial) : m_inner->get_status(inner(s));
+    }
+
+    void abort(bool wait) override
+    {
+        m_inner->abort(wait);
+        if (m_ring) m_ring->stop();     // its last reads may still hand hashing to the workers
+        stop();
+    }
+
+    void submit_jobs() override
+    {
+        m_inner->submit_jobs();
+        if (m_ring) m_ring->kick();
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            queued = !m_queue.empty();
+        }
+        if (queued) m_cv.notify_all();
+    }
+
+    void settings_updated() override
+    {
+        m_inner->settings_updated();
+        m_files.set_capacity(m_settings.get_int(settings_pack::file_pool_size));
+    }
+
+    void free_disk_buffer(char* b) override
+    {
+        if (m_ring) m_ring->release(b);
+        else        std::free(b);
+    }
+
+private:
+    struct slot {
+        sha1_hash                        key;
+        int                              piece_length = 0;
+        std::int64_t                     total_size   = 0;
+        std::shared_ptr<library_storage> lib;
+        storage_holder                   inner;
+    };
+
+    std::shared_ptr<library_storage> library(storage_index_t s) const
+    { return m_slots[std::size_t(static_cast<int>(s))].lib; }
+    storage_index_t inner(storage_index_t s) const
+    { return m_slots[std::size_t(static_cast<int>(s))].inner; }
+
+    // reads `len` bytes at `offset` into `piece`, file by file; pad files
+    // read as zeros
+    void read_range(library_storage const& st, piece_index_t piece, int offset,
+                    char* buf, int len, storage_error& ec)
+    {
+        file_storage const& fs = st.files;
+        for (file_slice const& s : fs.map_block(piece, offset, len)) {
+            if (fs.pad_file_at(s.file_index)) {
+                std::memset(buf, 0, std::size_t(s.size));
+                buf += s.size;
+                continue;
+            }
+            std::string path;
+            if (!g_library.path(st.key, static_cast<int>(s.file_index), path)) {
+                ec = storage_error(error_code(ENOENT, generic_category()), s.file_index, operation_t::file_open);
+                return;
+            }
+            int err = 0;
+            auto const f = m_files.open(library_files::file_id(st.serial, s.file_index), path, err);
+            if (!f) {
+                ec = storage_error(error_code(err, generic_category()), s.file_index, operation_t::file_open);
+                return;
+            }
+            std::int64_t done = 0;
+            while (done < s.size) {
+                ssize_t const n = ::pread(f->fd, buf + done, std::size_t(s.size - done), off_t(s.offset + done));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    ec = storage_error(n == 0 ? error_code(boost::asio::error::eof)
+                                              : error_code(errno, generic_category()), s.file_index,
+                                           operation_t::file_read);
+                    return;
+                }
+                done += n;
+            }
+            buf += s.size;
+        }
+    }
+
+    void submit(std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_queue.push_back(std::move(job));
+    }
+
+    // from outside a submit_jobs() batch: wakes a worker right away
+    void submit_now(std::function<void()> job)
+    {
+        submit(std::move(job));
+        m_cv.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        for (;;) {
+            m_cv.wait(lk, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) return;        // stopping, and drained
+            auto job = std::move(m_queue.front());
+            m_queue.pop_front();
+            lk.unlock();
+            job();
+            lk.lock();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads) if (t.joinable()) t.join();
+        m_threads.clear();
+    }
+
+    io_context&                             m_ioc;
+    settings_interface const&               m_settings;
+    std::unique_ptr<disk_interface>         m_inner;
+    upload_cache*                           m_cache;
+    library_io_stats&                       m_stats;
+    library_files                           m_files;
+    std::unique_ptr<uring_reader>           m_ring;     // declared after m_files, which it uses
+    std::vector<slot>                       m_slots;    // by storage index; network thread only
+    std::vector<int>                        m_free;
+    std::uint32_t                           m_serial = 0;
+    std::mutex                              m_mtx;
+    std::condition_variable                 m_cv;
+    std::deque<std::function<void()>>       m_queue;
+    bool                                    m_stop = false;
+    std::vector<std::thread>                m_threads;
+};
+
+// ──────────────────  torrent status cache  ────────────────────
+// Native mirror of every torrent's status, keyed by info-hash. It is fed by
+// state_update_alert (only torrents that changed since the previous
+// post_torrent_updates() are reported) plus add/remove alerts, so listing
+// torrents never needs a blocking torrent_handle::status() round trip.
+//
+// The alert pump is the only writer. After each batch it publishes an
+// immutable, versioned status_snapshot through an atomically swapped
+// shared_ptr; readers (JNI entry points, any thread) grab the current
+// snapshot without taking a lock and can hold on to it as long as they like.
+// Unchanged rows are shared between consecutive snapshots, so a publish
+// costs one pointer copy per torrent.
+
+// v1 hash when there is one – that is what the Dart side stores – else the
+// truncated v2 hash, which is what session::find_torrent() accepts.
+static sha1_hash cache_key(info_hash_t const& ih)
+{
+    return ih.has_v1() ? ih.v1 : ih.get_best();
+}
+
+struct torrent_row {
+    torrent_handle          handle;
+    info_hash_t             info_hashes;
+    sha1_hash               key;
+    std::string             name;
+    std::string             save_path;
+    torrent_status::state_t state = torrent_status::checking_resume_data;
+    float                   progress      = 0.f;
+    int                     num_peers     = 0;
+    int                     num_seeds     = 0;
+    int                     download_rate = 0;
+    int                     upload_rate   = 0;
+    std::int64_t            total_done    = 0;
+    std::int64_t            total_wanted  = 0;
+    std::int64_t            all_time_upload = 0;
+    torrent_flags_t         flags{};
+    std::uint64_t           seq = 0;    // update that last touched this row
+
+    bool paused() const { return bool(flags & torrent_flags::paused); }
+};
+using row_ptr = std::shared_ptr<const torrent_row>;
+
+enum class status_sort { none, name, progress, upload_rate, download_rate, num_peers, state };
+
+struct status_snapshot {
+    struct tombstone { std::uint64_t seq; sha1_hash key; };
+
+    std::uint64_t          version = 0;
+    std::vector<row_ptr>   rows;            // ordered by key
+    std::shared_ptr<const std::vector<tombstone>> removed
+                           = std::make_shared<std::vector<tombstone>>();
+    std::uint64_t          removed_floor = 0; // deltas older than this need a full reload
+
+    row_ptr find(sha1_hash const& key) const
+    {
+        auto it = std::lower_bound(rows.begin(), rows.end(), key,
+            [](row_ptr const& r, sha1_hash const& k) { return r->key < k; });
+        return (it != rows.end() && (*it)->key == key) ? *it : row_ptr{};
+    }
+
+    // Sorted, paged view: rows [offset, offset + limit) of the table in the
+    // requested order. Only the first offset + limit rows are fully sorted.
+    std::vector<row_ptr> view(status_sort by, bool descending,
+                              std::size_t offset, std::size_t limit) const
+    {
+        if (offset >= rows.size()) return {};
+        std::size_t const end = std::min(rows.size(), offset + std::min(limit, rows.size()));
+
+        std::vector<row_ptr> out(rows);
+        if (by != status_sort::none) {
+            auto less = [by](row_ptr const& a, row_ptr const& b) {
+                switch (by) {
+                    case status_sort::name:          return a->name < b->name;
+                    case status_sort::progress:      return a->progress < b->progress;
+                    case status_sort::upload_rate:   return a->upload_rate < b->upload_rate;
+                    case status_sort::download_rate: return a->download_rate < b->download_rate;
+                    case status_sort::num_peers:     return a->num_peers < b->num_peers;
+                    case status_sort::state:         return a->state < b->state;
+                    default:                         return a->key < b->key;
+                }
+            };
+            if (descending)
+                std::partial_sort(out.begin(), out.begin() + end, out.end(),
+                                  [&](row_ptr const& a, row_ptr const& b) { return less(b, a); });
+            else
+                std::partial_sort(out.begin(), out.begin() + end, out.end(), less);
+        } else if (descending) {
+            std::reverse(out.begin(), out.end());
+        }
+        return std::vector<row_ptr>(out.begin() + offset, out.begin() + end);
+    }
+};
+using snapshot_ptr = std::shared_ptr<const status_snapshot>;
+
+class status_cache
+{
+public:
+    struct delta {
+        std::uint64_t          seq  = 0;     // pass back as `since` next time
+        bool                   full = false; // `rows` is the whole table
+        std::vector<row_ptr>   rows;
+        std::vector<sha1_hash> removed;
+    };
+
+    // ---- writer side: alert pump thread only ----------------------------
+
+    void on_state_update(state_update_alert const& a)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        std::uint64_t const seq = ++m_seq;
+        for (auto const& st : a.status) {
+            auto r = std::make_shared<torrent_row>();
+            r->handle          = st.handle;
+            r->info_hashes     = st.info_hashes;
+            r->key             = cache_key(st.info_hashes);
+            r->name            = st.name;
+            r->save_path       = shown_save_path(r->key, st.save_path);
+            r->state           = st.state;
+            r->progress        = st.progress;
+            r->num_peers       = st.num_peers;
+            r->num_seeds       = st.num_seeds;
+            r->download_rate   = st.download_rate;
+            r->upload_rate     = st.upload_rate;
+            r->total_done      = st.total_done;
+            r->total_wanted    = st.total_wanted;
+            r->all_time_upload = st.all_time_upload;
+            r->flags           = st.flags;
+            r->seq             = seq;
+            m_rows[r->key] = std::move(r);
+        }
+        m_dirty = true;
+    }
+
+    void on_added(add_torrent_alert const& a)
+    {
+        if (a.error) return;
+        auto const& p = a.params;
+        info_hash_t const ih = p.ti ? p.ti->info_hashes() : p.info_hashes;
+        auto const key = cache_key(ih);
+        bool const seeding = bool(p.flags & torrent_flags::seed_mode);
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_rows.count(key)) return;      // a state update beat us to it
+
+        auto r = std::make_shared<torrent_row>();
+        r->handle      = a.handle;
+        r->info_hashes = ih;
+        r->key         = key;
+        r->name        = p.ti ? p.ti->name() : p.name;
+        r->save_path   = shown_save_path(key, p.save_path);
+        r->flags       = p.flags;
+        r->state       = seeding ? torrent_status::seeding : torrent_status::checking_resume_data;
+        r->progress    = seeding ? 1.f : 0.f;
+        r->seq         = ++m_seq;
+        m_rows.emplace(key, std::move(r));
+        m_dirty = true;
+    }
+
+    void on_removed(torrent_removed_alert const& a)
+    {
+        auto const key = cache_key(a.info_hashes);
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_rows.erase(key) == 0) return;
+        m_removed.push_back({++m_seq, key});
+        while (m_removed.size() > max_tombstones) {
+            m_removed_floor = m_removed.front().seq;
+            m_removed.pop_front();
+        }
+        m_removed_dirty = m_dirty = true;
+    }
+
+    // Called once per drained alert batch.
+    void publish()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_dirty) return;
+        m_dirty = false;
+
+        auto prev = snapshot();
+        auto snap = std::make_shared<status_snapshot>();
+        snap->version       = m_seq;
+        snap->removed_floor = m_removed_floor;
+        snap->rows.reserve(m_rows.size());
+        for (auto const& kv : m_rows) snap->rows.push_back(kv.second);
+        snap->removed = m_removed_dirty
+            ? std::make_shared<std::vector<status_snapshot::tombstone>>(m_removed.begin(), m_removed.end())
+            : prev->removed;
+        m_removed_dirty = false;
+
+        std::atomic_store(&m_snap, snapshot_ptr(std::move(snap)));
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_rows.clear();
+        m_removed.clear();
+        // a new version above every `since` handed out, so even a reader
+        // that was up to date reloads in full
+        m_removed_floor = ++m_seq;
+        auto snap = std::make_shared<status_snapshot>();
+        snap->version       = m_seq;
+        snap->removed_floor = m_removed_floor;
+        std::atomic_store(&m_snap, snapshot_ptr(std::move(snap)));
+    }
+
+    // ---- reader side: any thread, never blocks --------------------------
+
+    snapshot_ptr snapshot() const { return std::atomic_load(&m_snap); }
+
+    // Rows changed and torrents removed after `since`. If the tombstones
+    // needed to answer that have been dropped, the full table is returned
+    // instead and `full` is set.
+    delta updates_since(std::uint64_t since) const
+    {
+        auto const snap = snapshot();
+        delta d;
+        d.seq  = snap->version;
+        d.full = since < snap->removed_floor || since > snap->version;
+        for (auto const& r : snap->rows)
+            if (d.full || r->seq > since) d.rows.push_back(r);
+        if (!d.full)
+            for (auto const& t : *snap->removed)
+                if (t.seq > since) d.removed.push_back(t.key);
+        return d;
+    }
+
+    // Rate-limits post_torrent_updates(): readers call this on every query
+    // and get the table as of the previous update, which keeps a polling UI
+    // current without any timer running while nobody is looking. The post
+    // itself is handed to the alert pump so the caller never touches g_mtx.
+    void request_refresh()
+    {
+        std::int64_t const now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            clock_type::now().time_since_epoch()).count();
+        std::int64_t last = m_last_post_ms.load(std::memory_order_relaxed);
+        if (now - last < refresh_interval_ms) return;
+        if (!m_last_post_ms.compare_exchange_strong(last, now)) return;
+
+        g_alerts.post([](session& ses) {
+            ses.post_torrent_updates(torrent_handle::query_name | torrent_handle::query_save_path);
+        });
+    }
+
+private:
+    static constexpr std::size_t  max_tombstones      = 4096;
+    static constexpr std::int64_t refresh_interval_ms = 500;
+
+    // writer state
+    std::mutex                                  m_mtx;
+    std::map<sha1_hash, row_ptr>                m_rows;
+    std::deque<status_snapshot::tombstone>      m_removed;
+    std::uint64_t                               m_seq = 0;
+    std::uint64_t                               m_removed_floor = 0;
+    bool                                        m_dirty = false;
+    bool                                        m_removed_dirty = false;
+
+    // published state
+    snapshot_ptr                                m_snap = std::make_shared<status_snapshot>();
+    std::atomic<std::int64_t>                   m_last_post_ms{-refresh_interval_ms};
+};
+
+static status_cache g_status;
+
+// ───────────────────────  torrent index  ──────────────────────
+// O(1) lookup of a torrent by info-hash (v1 or v2), by normalised name and
+// by the path of the file it was created from; every track of an album
+// torrent maps to the album. v2 torrents are also indexed by the merkle
+// root of each file, so the same track inside different albums (or next
+// to a single-track torrent of it) is recognised. Membership only changes on
+// add_torrent_alert / torrent_removed_alert, so the maps are updated from
+// the alert pump and read under a shared lock.
+
+// Same key as MusicSeederService.norm() on the Dart side: basename,
+// lower-cased, every run of non-[A-Za-z0-9_] characters collapsed to '_'.
+static std::string norm_name(std::string const& name)
+{
+    auto const slash = name.find_last_of('/');
+    char const* p   = name.data() + (slash == std::string::npos ? 0 : slash + 1);
+    char const* end = name.data() + name.size();
+
+    std::string out;
+    out.reserve(static_cast<std::size_t>(end - p));
+    bool in_run = false;
+    for (; p != end; ++p) {
+        unsigned char const c = static_cast<unsigned char>(*p);
+        bool const word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                       || (c >= '0' && c <= '9') || c == '_';
+        if (word) {
+            out.push_back(static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c));
+            in_run = false;
+        } else if (!in_run) {
+            out.push_back('_');
+            in_run = true;
+        }
+    }
+    return out;
+}
+
+class torrent_index
+{
+public:
+    struct entry {
+        torrent_handle handle;
+        sha1_hash      key;
+        std::string    name_key;     // norm_name(torrent name)
+        std::string    source_path;  // save_path + "/" + name
+        std::string    save_path;
+        std::vector<std::string> file_paths;  // multi-file torrents only
+        sha256_hash    v2;                    // zero for v1-only torrents
+        std::vector<sha256_hash> file_roots;  // by file index, pad files zero
+        bool           in_place = false;      // a seed of the user's own files
+    };
+
+    struct file_ref {
+        sha1_hash key;
+        int       file_index;
+        std::string path;   // inside the torrent
+    };
+
+    void on_added(add_torrent_alert const& a)
+    {
+        if (a.error) return;
+        auto const& p = a.params;
+
+        entry e;
+        e.handle      = a.handle;
+        e.key         = cache_key(p.ti ? p.ti->info_hashes() : p.info_hashes);
+        std::string const name = p.ti ? p.ti->name() : p.name;
+        e.name_key    = norm_name(name);
+        e.in_place    = bool(p.flags & seed_mode);
+        library_table::entry lib;
+        bool const in_library = p.save_path == library_root && g_library.find(e.key, lib);
+        e.save_path   = in_library ? lib.dir : p.save_path;
+        e.source_path = in_library ? lib.source : join_path(p.save_path, name);
+        if (p.ti && p.ti->num_files() > 1) {
+            file_storage const& fs = p.ti->files();
+            for (file_index_t const i : fs.file_range()) {
+                if (fs.pad_file_at(i)) continue;
+                e.file_paths.push_back(in_library ? lib.paths[std::size_t(static_cast<int>(i))]
+                                                  : fs.file_path(i, p.save_path));
+            }
+        }
+        info_hash_t const ih = p.ti ? p.ti->info_hashes() : p.info_hashes;
+        if (ih.has_v2()) e.v2 = ih.v2;
+        if (p.ti && p.ti->v2()) {
+            file_storage const& fs = p.ti->files();
+            for (file_index_t const i : fs.file_range())
+                e.file_roots.push_back(fs.pad_file_at(i) ? sha256_hash() : fs.root(i));
+        }
+
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        m_by_name[e.name_key]    = e.key;
+        m_by_path[e.source_path] = e.key;
+        for (auto const& f : e.file_paths) m_by_path[f] = e.key;
+        if (!e.v2.is_all_zeros()) m_by_v2[e.v2] = e.key;
+        for (std::size_t i = 0; i < e.file_roots.size(); ++i)
+            if (!e.file_roots[i].is_all_zeros()) m_by_root.emplace(e.file_roots[i], std::make_pair(e.key, int(i)));
+        m_by_hash[e.key]         = std::move(e);
+    }
+
+    void on_removed(torrent_removed_alert const& a)
+    {
+        auto const key = cache_key(a.info_hashes);
+
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_by_hash.find(key);
+        if (it == m_by_hash.end()) return;
+        // the name / path may since have been claimed by another torrent
+        auto n = m_by_name.find(it->second.name_key);
+        if (n != m_by_name.end() && n->second == key) m_by_name.erase(n);
+        auto const unmap = [&](std::string const& path) {
+            auto f = m_by_path.find(path);
+            if (f != m_by_path.end() && f->second == key) m_by_path.erase(f);
+        };
+        unmap(it->second.source_path);
+        for (auto const& f : it->second.file_paths) unmap(f);
+        auto v = m_by_v2.find(it->second.v2);
+        if (v != m_by_v2.end() && v->second == key) m_by_v2.erase(v);
+        for (auto const& root : it->second.file_roots) {
+            auto [b, end] = m_by_root.equal_range(root);
+            while (b != end) b = b->second.first == key ? m_by_root.erase(b) : std::next(b);
+        }
+        m_by_hash.erase(it);
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lk(m_mtx);
+        m_by_hash.clear();
+        m_by_name.clear();
+        m_by_path.clear();
+        m_by_v2.clear();
+        m_by_root.clear();
+    }
+
+    bool by_hash(sha1_hash const& key, entry& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto it = m_by_hash.find(key);
+        if (it == m_by_hash.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // `name` may be a torrent name, a file name or a full path – it goes
+    // through norm_name() first, exactly like the Dart side keys.
+    bool by_name(std::string const& name, entry& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto n = m_by_name.find(norm_name(name));
+        return n != m_by_name.end() && find_locked(n->second, out);
+    }
+
+    bool by_path(std::string const& path, entry& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto f = m_by_path.find(path);
+        return f != m_by_path.end() && find_locked(f->second, out);
+    }
+
+    // key a torrent is stored under, from its full v2 info-hash
+    bool key_for_v2(sha256_hash const& v2, sha1_hash& out) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mtx);
+        auto v = m_by_v2.find(v2);
+        if (v == m_by_v2.end()) return false;
+        out = v->second;
+        return true;
+    }
+
+    // every file, in any torrent, with this v2 merkle root
+    std::vector<file_ref> by_file_root(sha256_hash const& root) const
+    {
+        std::vector<file_ref> out;
+        std::vector<torrent_handle> handles;
+        {
+            std::shared_lock<std::shared_mutex> lk(m_mtx);
+            auto [b, end] = m_by_root.equal_range(root);
+            for (; b != end; ++b) {
+                auto it = m_by_hash.find(b->second.first);
+                if (it == m_by_hash.end()) continue;
+                out.push_back({b->second.first, b->second.second, {}});
+                handles.push_back(it->second.handle);
+            }
+        }
+        // torrent_file() waits on the network thread; not under m_mtx
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            if (auto const ti = handles[i].torrent_file())
+                out[i].path = ti->files().file_path(file_index_t(out[i].file_index));
+        }
+        return out;
+    }
+
+private:
+    static std::string join_path(std::string const& dir, std::string const& name)
+    {
+        if (dir.empty()) return name;
+        return dir.back() == '/' ? dir + name : dir + "/" + name;
+    }
+
+    bool find_locked(sha1_hash const& key, entry& out) const
+    {
+        auto it = m_by_hash.find(key);
+        if (it == m_by_hash.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    mutable std::shared_mutex                    m_mtx;
+    std::unordered_map<sha1_hash, entry>         m_by_hash;
+    std::unordered_map<std::string, sha1_hash>   m_by_name;
+    std::unordered_map<std::string, sha1_hash>   m_by_path;
+    std::unordered_map<sha256_hash, sha1_hash>   m_by_v2;
+    std::unordered_multimap<sha256_hash, std::pair<sha1_hash, int>> m_by_root;
+};
+
+static torrent_index g_index;
+
+// where file `f` of an indexed torrent is on disk
+static std::string torrent_file_path(torrent_index::entry const& e, file_storage const& fs, file_index_t f)
+{
+    std::string path;
+    if (g_library.path(e.key, static_cast<int>(f), path)) return path;
+    return fs.file_path(f, e.save_path);
+}
+
+// ───────────────────  binary status channel  ──────────────────
+// Fixed-layout, columnar copy of the status snapshot in one native buffer
+// that dart:ffi maps once and reads in place, so the refresh path needs no
+// JSON and no copy at all. All fields are little-endian.
+//
+//   header (64 bytes)
+//     0  u32  magic 'AUDS'          4  u16  layout version   6  u16  frame slots (2)
+//     8  u32  row capacity         12  u32  bytes per frame
+//    16  u64  latest frame seq (0 = nothing published yet)
+//   frame slot i at 64 + i * frame_bytes; frame n lives in slot n % 2
+//     0  u64  seq (0 while the slot is being rewritten)
+//     8  u64  snapshot version     16  u32  rows   20  u32  total torrents
+//    32  columns, `capacity` entries each, in this order:
+//         f32 progress, i32 download_rate, i32 upload_rate,
+//         u16 num_peers, u16 num_seeds, u8 state, u8 flags, u8[20] info_hash
+//
+// Readers pin() the latest frame, read its slot in place and unpin() it;
+// the writer leaves a pinned slot alone (the publish is retried on the next
+// write), and the mutex both calls take orders the reader after the write.
+// Rows beyond `capacity` are not written; `total` tells the reader the
+// frame was truncated.
+class status_channel
+{
+public:
+    static constexpr std::uint32_t magic        = 0x53445541;   // "AUDS"
+    static constexpr std::uint16_t layout       = 1;
+    static constexpr std::uint16_t slots        = 2;
+    static constexpr std::size_t   header_bytes = 64;
+    static constexpr std::size_t   frame_header = 32;
+
+    enum row_flags : std::uint8_t {
+        flag_paused    = 1,
+        flag_seed_mode = 2,
+        flag_finished  = 4,
+    };
+
+    // Allocates the buffer the first time (later calls keep the original
+    // capacity) and writes the current snapshot into it. The memory lives
+    // for the rest of the process since readers keep a pointer to it.
+    bool ensure(std::uint32_t capacity, status_snapshot const& snap)
+    {
+        std::lock_guard<std::mutex> lk(m_write_mtx);
+        if (!m_buf) {
+            m_capacity    = std::max<std::uint32_t>(8, (capacity + 7) & ~7u);
+            m_frame_bytes = static_cast<std::uint32_t>(frame_header + std::size_t(m_capacity) * row_bytes);
+            m_size        = header_bytes + std::size_t(slots) * m_frame_bytes;
+            m_buf.reset(new std::uint64_t[(m_size + 7) / 8]());
+
+            auto* h = bytes();
+            put<std::uint32_t>(h + 0,  magic);
+            put<std::uint16_t>(h + 4,  layout);
+            put<std::uint16_t>(h + 6,  slots);
+            put<std::uint32_t>(h + 8,  m_capacity);
+            put<std::uint32_t>(h + 12, m_frame_bytes);
+            m_ready.store(true, std::memory_order_release);
+        }
+        write_locked(snap);
+        return true;
+    }
+
+    // Called from the alert pump after each publish; no-op until a reader
+    // asked for the buffer or when nothing changed.
+    void write(status_snapshot const& snap)
+    {
+        if (!m_ready.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lk(m_write_mtx);
+        if (snap.version == m_written_version && m_seq != 0) return;
+        write_locked(snap);
+    }
+
+    // Newest frame seq, held until unpin(); 0 if nothing newer than `since`.
+    std::uint64_t pin(std::uint64_t since)
+    {
+        std::lock_guard<std::mutex> lk(m_write_mtx);
+        if (m_seq == 0 || m_seq == since) return 0;
+        ++m_pins[m_seq % slots];
+        return m_seq;
+    }
+
+    void unpin(std::uint64_t seq)
+    {
+        std::lock_guard<std::mutex> lk(m_write_mtx);
+        if (seq != 0 && m_pins[seq % slots] > 0) --m_pins[seq % slots];
+    }
+
+    void*       data()       { return m_buf.get(); }
+    std::size_t size() const { return m_size; }
+
+private:
+    static constexpr std::size_t row_bytes = 4 + 4 + 4 + 2 + 2 + 1 + 1 + 20;
+
+    std::uint8_t* bytes() { return reinterpret_cast<std::uint8_t*>(m_buf.get()); }
+
+    template <class T> static void put(std::uint8_t* p, T v) { std::memcpy(p, &v, sizeof v); }
+
+    void write_locked(status_snapshot const& snap)
+    {
+        std::uint64_t const seq = m_seq + 1;
+        if (m_pins[seq % slots] > 0) return;
+        std::uint8_t* f = bytes() + header_bytes + (seq % slots) * m_frame_bytes;
+        auto* slot_seq  = reinterpret_cast<std::uint64_t*>(f);
+
+        __atomic_store_n(slot_seq, std::uint64_t(0), __ATOMIC_RELAXED);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::uint32_t const cap  = m_capacity;
+        std::uint32_t const rows = static_cast<std::uint32_t>(std::min<std::size_t>(snap.rows.size(), cap));
+        put<std::uint64_t>(f + 8,  snap.version);
+        put<std::uint32_t>(f + 16, rows);
+        put<std::uint32_t>(f + 20, static_cast<std::uint32_t>(snap.rows.size()));
+
+        std::uint8_t* col = f + frame_header;
+        auto* progress = reinterpret_cast<float*>(col);            col += 4 * cap;
+        auto* down     = reinterpret_cast<std::int32_t*>(col);     col += 4 * cap;
+        auto* up       = reinterpret_cast<std::int32_t*>(col);     col += 4 * cap;
+        auto* peers    = reinterpret_cast<std::uint16_t*>(col);    col += 2 * cap;
+        auto* seeds    = reinterpret_cast<std::uint16_t*>(col);    col += 2 * cap;
+        auto* state    = col;                                      col += cap;
+        auto* flags    = col;                                      col += cap;
+        auto* hashes   = col;
+
+        for (std::uint32_t i = 0; i < rows; ++i) {
+            torrent_row const& r = *snap.rows[i];
+            progress[i] = r.progress;
+            down[i]     = r.download_rate;
+            up[i]       = r.upload_rate;
+            peers[i]    = static_cast<std::uint16_t>(std::min(r.num_peers, 0xffff));
+            seeds[i]    = static_cast<std::uint16_t>(std::min(r.num_seeds, 0xffff));
+            state[i]    = static_cast<std::uint8_t>(r.state);
+            flags[i]    = static_cast<std::uint8_t>(
+                            (r.paused() ? flag_paused : 0)
+                          | ((r.flags & torrent_flags::seed_mode) ? flag_seed_mode : 0)
+                          | (r.state == torrent_status::seeding || r.state == torrent_status::finished
+                                ? flag_finished : 0));
+            std::memcpy(hashes + std::size_t(i) * 20, r.key.data(), 20);
+        }
+
+        __atomic_store_n(slot_seq, seq, __ATOMIC_RELEASE);
+        __atomic_store_n(reinterpret_cast<std::uint64_t*>(bytes() + 16), seq, __ATOMIC_RELEASE);
+        m_seq             = seq;
+        m_written_version = snap.version;
+    }
+
+    std::mutex                       m_write_mtx;
+    std::atomic<bool>                m_ready{false};
+    std::unique_ptr<std::uint64_t[]> m_buf;     // u64 storage keeps every column aligned
+    std::size_t                      m_size        = 0;
+    std::uint32_t                    m_capacity    = 0;
+    std::uint32_t                    m_frame_bytes = 0;
+    std::uint64_t                    m_seq             = 0;
+    std::uint64_t                    m_written_version = 0;
+    std::uint32_t                    m_pins[slots]     = {};   // readers per slot
+};
+
+static status_channel g_status_channel;
+
+// ──────────────────────  disk backends  ───────────────────────
+// The disk subsystem is chosen when get_session() builds the session.
+// custom is library_disk_io: library seeds are read in place, their block
+// reads pass the upload cache, and io_uring is used where it works
+// (`io_uring`); every other torrent goes to libtorrent's default backend.
+// posix and mmap are libtorrent's own backends for everything, and a seed
+// is then added in upload mode with the folder of its source as save
+// path. The backend and `io_uring` are fixed with the session; threads,
+// file pool and cache sizes apply at once (see configure_disk()).
+enum class disk_backend : int { custom = 0, posix = 1, mmap = 2 };
+
+struct disk_config {
+    disk_backend backend        = disk_backend::custom;
+    bool         io_uring       = true;
+    int          aio_threads    = 0;        // 0 keeps libtorrent's default
+    int          file_pool_size = 0;        // 0 keeps libtorrent's default
+    std::int64_t upload_cache   = -1;       // bytes; -1 keeps the current size
+    std::int64_t read_cache     = -1;
+};
+
+static disk_config               g_disk_config;                          // under g_mtx
+static std::atomic<disk_backend> g_session_backend{disk_backend::custom};
+static std::atomic<bool>         g_session_ring{true};
+
+static char const* disk_backend_name(disk_backend b)
+{
+    switch (b) {
+    case disk_backend::posix:  return "posix";
+    case disk_backend::mmap:   return "mmap";
+    case disk_backend::custom: break;
+    }
+    return "custom";
+}
+
+#if AUDYN_WITH_JNI
+static bool parse_disk_backend(std::string const& s, disk_backend& out)
+{
+    if (s == "custom") { out = disk_backend::custom; return true; }
+    if (s == "posix")  { out = disk_backend::posix;  return true; }
+    if (s == "mmap")   { out = disk_backend::mmap;   return true; }
+    return false;
+}
+#endif
+
+// mmap is posix where libtorrent was built without it
+static std::unique_ptr<disk_interface> make_disk_io(disk_backend b, bool ring, io_context& ioc,
+                                                    settings_interface const& s, counters& c,
+                                                    library_io_stats& stats = g_library_stats,
+                                                    upload_cache* cache = &g_upload_cache)
+{
+    switch (b) {
+    case disk_backend::posix:
+        return posix_disk_io_constructor(ioc, s, c);
+    case disk_backend::mmap:
+#if TORRENT_HAVE_MMAP || TORRENT_HAVE_MAP_VIEW_OF_FILE
+        return mmap_disk_io_constructor(ioc, s, c);
+#else
+        return posix_disk_io_constructor(ioc, s, c);
+#endif
+    case disk_backend::custom:
+        break;
+    }
+    return std::make_unique<library_disk_io>(ioc, s, c, ring, stats, cache);
+}
+
+// ───────────────────────── helpers ────────────────────────────
+static session& get_session()
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    if (g_ses) return *g_ses;
+
+    static std::once_flag default_subs;
+    std::call_once(default_subs, [] {
+        g_alerts.subscribe(alert_category::error, [](alert* a) {
+            LOGE("[DHT] %s", a->message().c_str());
+        }, dht_error_alert::alert_type);
+
+        g_alerts.subscribe(alert_category::status, [](alert* a) {
+            g_status.on_state_update(*static_cast<state_update_alert*>(a));
+        }, state_update_alert::alert_type);
+        g_alerts.subscribe(alert_category::status, [](alert* a) {
+            auto const& added = *static_cast<add_torrent_alert*>(a);
+            g_status.on_added(added);
+            g_index.on_added(added);
+        }, add_torrent_alert::alert_type);
+        // a library seed failing a piece no longer matches the user's file
+        // (retagged, edited); its storage is read-only, so stop seeding it
+        // instead of downloading the piece back into the file
+        g_alerts.subscribe(alert_category::status, [](alert* a) {
+            auto const& failed = *static_cast<hash_failed_alert*>(a);
+            std::string dir;
+            if (!g_library.dir(cache_key(failed.handle.info_hashes()), dir)) return;
+            LOGE("library seed in %s failed piece %d, stopping it", dir.c_str(),
+                 static_cast<int>(failed.piece_index));
+            failed.handle.unset_flags(torrent_flags::auto_managed);
+            failed.handle.pause();
+        }, hash_failed_alert::alert_type);
+        g_alerts.subscribe(alert_category::status, [](alert* a) {
+            auto const& removed = *static_cast<torrent_removed_alert*>(a);
+            g_status.on_removed(removed);
+            g_index.on_removed(removed);
+        }, torrent_removed_alert::alert_type);
+        g_alerts.on_batch_end([] {
+            g_status.publish();
+            g_status_channel.write(*g_status.snapshot());
+        });
+    });
+
+    settings_pack sp;
+    sp.set_int(settings_pack::alert_mask, g_alerts.alert_mask());
+
+    sp.set_bool(settings_pack::enable_outgoing_tcp ,true);
+    sp.set_bool(settings_pack::enable_incoming_tcp ,true);
+    sp.set_bool(settings_pack::enable_outgoing_utp ,true);
+    sp.set_bool(settings_pack::enable_incoming_utp ,true);
+    sp.set_bool(settings_pack::enable_dht          ,true);
+    sp.set_bool(settings_pack::enable_lsd          ,true);
+    sp.set_bool(settings_pack::enable_upnp         ,true);
+    sp.set_bool(settings_pack::enable_natpmp       ,true);
+    sp.set_str (settings_pack::listen_interfaces, "0.0.0.0:6881");
+
+    disk_config const dc = g_disk_config;
+    if (dc.aio_threads > 0)    sp.set_int(settings_pack::aio_threads, dc.aio_threads);
+    if (dc.file_pool_size > 0) sp.set_int(settings_pack::file_pool_size, dc.file_pool_size);
+
+    session_params params(std::move(sp));
+    params.disk_io_constructor = [dc](io_context& ioc, settings_interface const& s, counters& c) {
+        return make_disk_io(dc.backend, dc.io_uring, ioc, s, c);
+    };
+    g_session_backend.store(dc.backend);
+    g_session_ring.store(dc.io_uring);
+    g_ses = std::make_unique<session>(std::move(params));
+
+    // (Deprecated, but harmless)
+    g_ses->add_dht_router({"67.215.246.10", 6881});
+    g_ses->add_dht_router({"82.221.103.244", 6881});
+
+    LOGI("libtorrent %s session started, %s disk backend", LIBTORRENT_VERSION,
+         disk_backend_name(dc.backend));
+
+    g_alerts.start(*g_ses);
+
+    return *g_ses;
+}
+
+std::string escape_json_string(const std::string& s) {
+    std::ostringstream o;
+    for (auto c : s) {
+        switch (c) {
+            case '"': o << "\\\""; break;
+            case '\\': o << "\\\\"; break;
+            case '\b': o << "\\b"; break;
+            case '\f': o << "\\f"; break;
+            case '\n': o << "\\n"; break;
+            case '\r': o << "\\r"; break;
+            case '\t': o << "\\t"; break;
+            default:
+                if ('\x00' <= c && c <= '\x1f') {
+                    o << "\\u" << std::hex << (int)c;
+                } else {
+                    o << c;
+                }
+        }
+    }
+    return o.str();
+}
+
+// Recursive conversion from libtorrent::entry to JSON string
+std::string entry_to_json(const lt::entry& e) {
+    using namespace lt;
+
+    switch (e.type()) {
+        case entry::int_t:
+            return std::to_string(e.integer());
+        case entry::string_t:
+            return "\"" + escape_json_string(e.string()) + "\"";
+        case entry::list_t: {
+            std::string res = "[";
+            bool first = true;
+            for (auto& item : e.list()) {
+                if (!first) res += ",";
+                res += entry_to_json(item);
+                first = false;
+            }
+            res += "]";
+            return res;
+        }
+        case entry::dictionary_t: {
+            std::string res = "{";
+            bool first = true;
+            for (auto& pair : e.dict()) {
+                if (!first) res += ",";
+                res += "\"" + escape_json_string(pair.first) + "\":" + entry_to_json(pair.second);
+                first = false;
+            }
+            res += "}";
+            return res;
+        }
+        default:
+            return "\"\""; // fallback empty string for unknown types
+    }
+}
+
+// ─────────────────────  streaming JSON  ───────────────────────
+// Bridge payloads are written straight into a thread-local buffer that
+// keeps its capacity between calls, instead of going through lt::entry
+// dictionaries and string concatenation. String escaping copies clean runs
+// in one go: eight bytes are tested at a time for '"', '\\' or a control
+// character and the per-byte table is only consulted around a hit.
+
+// 0 = copy as is, 'u' = \u00XX, anything else = two-char escape "\<c>"
+static constexpr auto json_escape_table = [] {
+    struct table { char v[256]; } t{};
+    for (int c = 0; c < 0x20; ++c) t.v[c] = 'u';
+    t.v['\b'] = 'b'; t.v['\f'] = 'f'; t.v['\n'] = 'n'; t.v['\r'] = 'r'; t.v['\t'] = 't';
+    t.v['"']  = '"'; t.v['\\'] = '\\';
+    return t;
+}();
+
+// any byte < 0x20, '"' or '\\' in the eight bytes of w
+static inline bool json_needs_escape8(std::uint64_t w)
+{
+    constexpr std::uint64_t ones  = 0x0101010101010101ULL;
+    constexpr std::uint64_t highs = 0x8080808080808080ULL;
+    auto const zero_byte = [](std::uint64_t v) { return (v - ones) & ~v & highs; };
+    return ((w - ones * 0x20) & ~w & highs)
+         | zero_byte(w ^ (ones * '"'))
+         | zero_byte(w ^ (ones * '\\'));
+}
+
+static void json_escape_append(std::string& out, std::string_view s)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    char const* p   = s.data();
+    char const* end = p + s.size();
+
+    while (p != end) {
+        // find the end of the clean run
+        char const* run = p;
+        while (end - run >= 8) {
+            std::uint64_t w;
+            std::memcpy(&w, run, 8);
+            if (json_needs_escape8(w)) break;
+            run += 8;
+        }
+        while (run != end && json_escape_table.v[static_cast<unsigned char>(*run)] == 0) ++run;
+        out.append(p, static_cast<std::size_t>(run - p));
+        if (run == end) break;
+
+        unsigned char const c = static_cast<unsigned char>(*run);
+        char const e = json_escape_table.v[c];
+        if (e == 'u') {
+            char const u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+            out.append(u, 6);
+        } else {
+            char const two[2] = {'\\', e};
+            out.append(two, 2);
+        }
+        p = run + 1;
+    }
+}
+
+class json_writer
+{
+public:
+    explicit json_writer(std::string& out) : m_out(out) { m_out.clear(); }
+
+    json_writer& begin_object() { sep(); m_out.push_back('{'); push(); return *this; }
+    json_writer& end_object()   { m_out.push_back('}'); --m_depth; return *this; }
+    json_writer& begin_array()  { sep(); m_out.push_back('['); push(); return *this; }
+    json_writer& end_array()    { m_out.push_back(']'); --m_depth; return *this; }
+
+    json_writer& key(std::string_view k)
+    {
+        sep();
+        m_out.push_back('"');
+        json_escape_append(m_out, k);
+        m_out.append("\":", 2);
+        m_after_key = true;
+        return *this;
+    }
+
+    json_writer& value(std::string_view v)
+    {
+        sep();
+        m_out.push_back('"');
+        json_escape_append(m_out, v);
+        m_out.push_back('"');
+        return *this;
+    }
+    json_writer& value(char const* v) { return value(std::string_view(v)); }
+    json_writer& value(std::string const& v) { return value(std::string_view(v)); }
+
+    json_writer& value(std::int64_t v)
+    {
+        sep();
+        char tmp[24];
+        auto const r = std::to_chars(tmp, tmp + sizeof tmp, v);
+        m_out.append(tmp, static_cast<std::size_t>(r.ptr - tmp));
+        return *this;
+    }
+    json_writer& value(int v)           { return value(static_cast<std::int64_t>(v)); }
+    json_writer& value(std::uint64_t v) { return value(static_cast<std::int64_t>(v)); }
+
+    // JSON has no NaN or infinity: NaN is written as 0, ±inf as ±1e308
+    json_writer& value(double v)
+    {
+        sep();
+        if (std::isnan(v)) v = 0;
+        else if (std::isinf(v)) v = v > 0 ? 1e308 : -1e308;
+        char tmp[32];
+        int const n = std::snprintf(tmp, sizeof tmp, "%.6g", v);
+        m_out.append(tmp, static_cast<std::size_t>(n));
+        return *this;
+    }
+    json_writer& value(float v) { return value(static_cast<double>(v)); }
+
+    json_writer& value(bool v)
+    {
+        sep();
+        m_out.append(v ? "true" : "false");
+        return *this;
+    }
+
+    json_writer& value(std::nullptr_t)
+    {
+        sep();
+        m_out.append("null");
+        return *this;
+    }
+
+    template <class T>
+    json_writer& field(std::string_view k, T const& v) { return key(k).value(v); }
+
+    std::string const& str() const { return m_out; }
+
+private:
+    void push() { m_first[m_depth++] = true; }
+
+    void sep()
+    {
+        if (m_after_key) { m_after_key = false; return; }
+        if (m_depth == 0) return;
+        if (!m_first[m_depth - 1]) m_out.push_back(',');
+        m_first[m_depth - 1] = false;
+    }
+
+    std::string& m_out;
+    bool         m_first[32];
+    int          m_depth     = 0;
+    bool         m_after_key = false;
+};
+
+// Per-thread output buffer for json_writer; keeps its high-water capacity.
+static std::string& json_arena()
+{
+    thread_local std::string buf;
+    return buf;
+}
+
+// One object per torrent, shared by getAllTorrents, paging and the delta API.
+static void write_row(json_writer& w, torrent_row const& r)
+{
+    char hash[41];
+    aux::to_hex(r.key, hash);
+    w.begin_object()
+     .field("info_hash",     std::string_view(hash, 40))
+     .field("name",          r.name)
+     .field("state",         static_cast<int>(r.state))
+     .field("progress",      r.progress)
+     .field("num_peers",     r.num_peers)
+     .field("download_rate", r.download_rate)
+     .field("upload_rate",   r.upload_rate)
+     .field("save_path",     r.save_path)
+     .end_object();
+}
+
+static void write_rows(json_writer& w, std::vector<row_ptr> const& rows)
+{
+    w.begin_array();
+    for (auto const& r : rows) write_row(w, *r);
+    w.end_array();
+}
+
+// {"seq","full","updated":[…],"removed":[…]} – see getTorrentUpdatesSince
+static void write_updates(json_writer& w, std::uint64_t since)
+{
+    auto const d = g_status.updates_since(since);
+    w.begin_object()
+     .field("seq",  d.seq)
+     .field("full", d.full ? 1 : 0)
+     .key("updated");
+    write_rows(w, d.rows);
+    w.key("removed").begin_array();
+    char hash[41];
+    for (auto const& h : d.removed) {
+        aux::to_hex(h, hash);
+        w.value(std::string_view(hash, 40));
+    }
+    w.end_array().end_object();
+}
+
+#if AUDYN_WITH_JNI
+static jstring rows_to_jstring(JNIEnv* env, std::vector<row_ptr> const& rows)
+{
+    json_writer w(json_arena());
+    write_rows(w, rows);
+    return env->NewStringUTF(w.str().c_str());
+}
+#endif
+
+#if AUDYN_WITH_JNI
+// Legacy lt::entry + entry_to_json() against json_writer on synthetic rows,
+// both writing every write_row() field. Names carry quotes, a tab and
+// non-ASCII so both escape paths are exercised.
+static std::string run_json_benchmark()
+{
+    using clock = std::chrono::steady_clock;
+    std::string out;
+    json_writer res(out);
+    res.begin_array();
+
+    for (int n : {100, 1000, 10000}) {
+        std::vector<row_ptr> rows;
+        rows.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            auto r = std::make_shared<torrent_row>();
+            for (int b = 0; b < 20; ++b) r->key[b] = static_cast<char>(i * 31 + b);
+            r->name          = "Artist \"" + std::to_string(i) + "\" \u2013 Sigur R\u00f3s\ttrack.flac";
+            r->save_path     = "/storage/emulated/0/Music/Album " + std::to_string(i % 97);
+            r->progress      = (i % 1000) / 1000.f;
+            r->num_peers     = i % 50;
+            r->download_rate = i * 17;
+            r->upload_rate   = i * 5;
+            rows.push_back(std::move(r));
+        }
+        int const iters = std::max(3, 200000 / n);
+
+        std::size_t legacy_bytes = 0;
+        auto t0 = clock::now();
+        for (int it = 0; it < iters; ++it) {
+            lt::entry::list_type lst;
+            for (auto const& r : rows) {
+                lt::entry::dictionary_type d;
+                d["info_hash"]     = aux::to_hex(r->key);
+                d["name"]          = r->name;
+                d["state"]         = static_cast<int>(r->state);
+                d["progress"]      = r->progress;
+                d["num_peers"]     = r->num_peers;
+                d["download_rate"] = r->download_rate;
+                d["upload_rate"]   = r->upload_rate;
+                d["save_path"]     = r->save_path;
+                lst.push_back(std::move(d));
+            }
+            legacy_bytes = entry_to_json(lt::entry(lst)).size();
+        }
+        auto t1 = clock::now();
+
+        std::size_t writer_bytes = 0;
+        for (int it = 0; it < iters; ++it) {
+            json_writer w(json_arena());
+            write_rows(w, rows);
+            writer_bytes = w.str().size();
+        }
+        auto t2 = clock::now();
+
+        auto per_row = [&](clock::duration d) {
+            return std::chrono::duration<double, std::nano>(d).count() / (double(iters) * n);
+        };
+        double const legacy_ns = per_row(t1 - t0);
+        double const writer_ns = per_row(t2 - t1);
+
+        res.begin_object()
+           .field("torrents",        n)
+           .field("iterations",      iters)
+           .field("legacy_ns_per",   legacy_ns)
+           .field("writer_ns_per",   writer_ns)
+           .field("legacy_bytes",    static_cast<std::uint64_t>(legacy_bytes))
+           .field("writer_bytes",    static_cast<std::uint64_t>(writer_bytes))
+           .field("speedup",         writer_ns > 0 ? legacy_ns / writer_ns : 0.0)
+           .end_object();
+    }
+    res.end_array();
+    return out;
+}
+#endif
+
+// Single-core piece-hashing throughput of every SHA variant this CPU can
+// run: SHA-1 over 256 KiB pieces and SHA-256 over 16 KiB blocks (the v1
+// and v2 shapes hash_single_file feeds them), ~100 ms per measurement.
+//   {"best", "variants": [{"name", "sha1_mb_s", "sha256_mb_s"}]}
+static std::string run_hash_benchmark()
+{
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t total = 8 << 20;
+    std::vector<std::uint8_t> data(total);
+    for (std::size_t i = 0; i < total; ++i) data[i] = static_cast<std::uint8_t>(i * 2654435761u >> 24);
+
+    auto measure = [&](piece_hash::hash_fn fn, std::size_t len) {
+        std::size_t const n = total / len;
+        std::vector<std::uint8_t const*> msgs(n);
+        for (std::size_t i = 0; i < n; ++i) msgs[i] = data.data() + i * len;
+        std::vector<std::uint8_t> out(n * piece_hash::sha256_size);
+
+        fn(msgs.data(), n, len, out.data());   // warm-up
+        std::uint64_t bytes = 0;
+        auto const start = clock::now();
+        auto elapsed = clock::duration{};
+        do {
+            fn(msgs.data(), n, len, out.data());
+            bytes += total;
+            elapsed = clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(100));
+        return double(bytes) / 1e6 / std::chrono::duration<double>(elapsed).count();
+    };
+
+    std::string out;
+    json_writer res(out);
+    res.begin_object().field("best", piece_hash::best().name).key("variants").begin_array();
+    for (auto const* e : piece_hash::available()) {
+        res.begin_object()
+           .field("name",        e->name)
+           .field("sha1_mb_s",   measure(e->sha1, 256 << 10))
+           .field("sha256_mb_s", measure(e->sha256, 16 << 10))
+           .end_object();
+    }
+    res.end_array().end_object();
+    return out;
+}
+
+// A synthetic seed and download workload in `dir` through each disk
+// backend get_session() can be given, the custom one with and without
+// io_uring. Seeding: `files` single-file torrents of `file_size` bytes
+// (written on first use, reused after) and `reads` 16 KiB block reads at
+// random places in them, the same sequence for every backend. The files
+// are read once before the first backend, so the page cache is warm for
+// all of them and this compares the backends rather than the device.
+// Downloading: about 64 MiB of fresh torrents in dir/download, every block
+// written and then every piece hashed, as a download does; removed again
+// after each backend. `depth` jobs are in flight throughout.
+//   {"files", "file_size", "reads", "depth", "download_files",
+//    "backends": [{"name", "available", "seed": {…}, "download": {…}}]}
+// with {"mb_s", "iops", "p50_us", "p99_us", "errors"} per workload
+static std::string run_disk_benchmark(std::string const& dir, int files, std::int64_t file_size,
+                                      int reads, int depth)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr int block = default_block_size;
+    files     = std::max(files, 1);
+    file_size = std::max<std::int64_t>(file_size, block);
+    depth     = std::max(depth, 1);
+    auto name = [](int i) {
+        char b[16];
+        std::snprintf(b, sizeof(b), "f%05d.bin", i);
+        return std::string(b);
+    };
+    auto make_storage = [file_size](std::string const& n) {
+        file_storage fs;
+        fs.add_file(n, file_size);
+        fs.set_piece_length(4 * block);
+        fs.set_num_pieces(int((file_size + fs.piece_length() - 1) / fs.piece_length()));
+        return fs;
+    };
+    auto make_key = [](char const* kind, int i) {
+        std::string const seed = std::string("audyn-disk-benchmark/") + kind + "/" + std::to_string(i);
+        return hasher(seed.data(), int(seed.size())).final();
+    };
+
+    // the seeding workload
+    std::vector<char> data(static_cast<std::size_t>(file_size));
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 2654435761u >> 24);
+    ::mkdir(dir.c_str(), 0755);
+    std::vector<char> scratch(static_cast<std::size_t>(file_size));
+    for (int i = 0; i < files; ++i) {
+        std::string const path = dir + "/" + name(i);
+        struct ::stat sb{};
+        if (::stat(path.c_str(), &sb) == 0 && sb.st_size == file_size) {
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) { [[maybe_unused]] auto r = ::read(fd, scratch.data(), scratch.size()); ::close(fd); }
+            continue;
+        }
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), std::streamsize(data.size()));
+    }
+
+    std::vector<file_storage> seeds;
+    std::vector<sha1_hash> seed_keys;
+    seeds.reserve(std::size_t(files));
+    for (int i = 0; i < files; ++i) {
+        seeds.push_back(make_storage(name(i)));
+        seed_keys.push_back(make_key("seed", i));
+    }
+    struct block_read { int file; peer_request r; };
+    std::vector<block_read> plan(static_cast<std::size_t>(std::max(reads, 0)));
+    {
+        std::uint64_t x = 0x9e3779b97f4a7c15ull;
+        auto next = [&x] { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+        std::uint64_t const blocks = std::uint64_t(file_size / block);
+        int const per_piece = seeds[0].piece_length() / block;
+        for (auto& p : plan) {
+            p.file = int(next() % std::uint64_t(files));
+            int const b = int(next() % blocks);
+            p.r = peer_request{piece_index_t(b / per_piece), (b % per_piece) * block, block};
+        }
+    }
+
+    // the download workload
+    std::string const dl_dir = dir + "/download";
+    int const dl_files = int(std::clamp<std::int64_t>((64 << 20) / file_size, 1, files));
+    std::vector<file_storage> downloads;
+    std::vector<sha1_hash> dl_keys;
+    std::vector<std::pair<int, peer_request>> dl_writes;
+    std::vector<std::pair<int, piece_index_t>> dl_hashes;
+    for (int i = 0; i < dl_files; ++i) {
+        downloads.push_back(make_storage(name(i)));
+        dl_keys.push_back(make_key("download", i));
+        file_storage const& fs = downloads.back();
+        for (piece_index_t const p : fs.piece_range()) {
+            int const size = fs.piece_size(p);
+            for (int off = 0; off < size; off += block)
+                dl_writes.emplace_back(i, peer_request{p, off, std::min(block, size - off)});
+            dl_hashes.emplace_back(i, p);
+        }
+    }
+    auto clear_downloads = [&] {
+        for (int i = 0; i < dl_files; ++i) std::remove((dl_dir + "/" + name(i)).c_str());
+    };
+    aux::vector<download_priority_t, file_index_t> const prio;
+
+    struct backend { char const* name; disk_backend kind; bool ring; };
+    backend const backends[] = {
+        {"posix",           disk_backend::posix,  false},
+#if TORRENT_HAVE_MMAP || TORRENT_HAVE_MAP_VIEW_OF_FILE
+        {"mmap",            disk_backend::mmap,   false},
+#endif
+        {"custom",          disk_backend::custom, false},
+        {"custom_io_uring", disk_backend::custom, true},
+    };
+
+    // `n` jobs through `disk`, `depth` in flight: start(i, done) issues job
+    // i, which calls done(ok) as it completes
+    struct phase { double secs = 0; int done = 0; int errors = 0; std::vector<std::int64_t> us; };
+    auto drive = [depth](io_context& ioc, disk_interface& disk, int n,
+                         std::function<void(int, std::function<void(bool)>)> const& start) {
+        phase ph;
+        ph.us.reserve(std::size_t(std::max(n, 0)));
+        int issued = 0;
+        auto guard = boost::asio::make_work_guard(ioc);
+        std::function<void()> next = [&] {
+            int const i = issued++;
+            auto const t = clock::now();
+            start(i, [&, t](bool ok) {
+                ph.us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - t).count());
+                if (!ok) ++ph.errors;
+                if (++ph.done == n) { guard.reset(); return; }
+                if (issued < n) { next(); disk.submit_jobs(); }
+            });
+        };
+        auto const t0 = clock::now();
+        for (int i = 0; i < std::min(depth, n); ++i) next();
+        disk.submit_jobs();
+        if (n > 0) ioc.run();
+        else guard.reset();
+        ph.secs = std::chrono::duration<double>(clock::now() - t0).count();
+        ioc.restart();
+        return ph;
+    };
+    auto report = [](json_writer& w, phase& ph, std::uint64_t bytes, int jobs) {
+        std::sort(ph.us.begin(), ph.us.end());
+        auto pct = [&](double p) -> std::int64_t {
+            if (ph.us.empty()) return 0;
+            return ph.us[std::min(ph.us.size() - 1, std::size_t(p * double(ph.us.size())))];
+        };
+        w.begin_object()
+         .field("mb_s",   ph.secs > 0 ? double(bytes) / 1e6 / ph.secs : 0.0)
+         .field("iops",   ph.secs > 0 ? jobs / ph.secs : 0.0)
+         .field("p50_us", pct(0.50))
+         .field("p99_us", pct(0.99))
+         .field("errors", ph.errors)
+         .end_object();
+    };
+    struct no_observer final : disk_observer { void on_disk() override {} };
+    auto const observer = std::make_shared<no_observer>();
+
+    std::string out;
+    json_writer res(out);
+    res.begin_object()
+       .field("files",          files)
+       .field("file_size",      file_size)
+       .field("reads",          int(plan.size()))
+       .field("depth",          depth)
+       .field("download_files", dl_files)
+       .key("backends").begin_array();
+
+    for (backend const& b : backends) {
+        io_context ioc;
+        settings_pack sp;
+        sp.set_int(settings_pack::aio_threads, 4);
+        counters cnt;
+        library_io_stats stats;
+        auto disk = make_disk_io(b.kind, b.ring, ioc, sp, cnt, stats, nullptr);
+        bool const available = !b.ring || stats.ring.load(std::memory_order_relaxed);
+        res.begin_object().field("name", b.name).field("available", available);
+        if (!available) {
+            disk->abort(true);
+            res.end_object();
+            continue;
+        }
+
+        // seeding, from the library for the custom backend
+        bool const library = b.kind == disk_backend::custom;
+        std::string const seed_path = library ? std::string(library_root) : dir;
+        std::vector<storage_holder> held;
+        held.reserve(seeds.size());
+        for (int i = 0; i < files; ++i) {
+            if (library) g_library.add(seed_keys[std::size_t(i)], seeds[std::size_t(i)], dir + "/" + name(i));
+            held.push_back(disk->new_torrent(storage_params(seeds[std::size_t(i)], nullptr, seed_path,
+                                                            storage_mode_sparse, prio, seed_keys[std::size_t(i)]),
+                                             std::shared_ptr<void>()));
+        }
+        phase seed = drive(ioc, *disk, int(plan.size()), [&](int i, std::function<void(bool)> done) {
+            block_read const& p = plan[std::size_t(i)];
+            disk->async_read(held[std::size_t(p.file)], p.r,
+                [done = std::move(done)](disk_buffer_holder, storage_error const& ec) { done(!ec); });
+        });
+        res.key("seed");
+        report(res, seed, std::uint64_t(seed.done) * block, seed.done);
+        held.clear();
+
+        // downloading
+        ::mkdir(dl_dir.c_str(), 0755);
+        clear_downloads();
+        for (int i = 0; i < dl_files; ++i) {
+            held.push_back(disk->new_torrent(storage_params(downloads[std::size_t(i)], nullptr, dl_dir,
+                                                            storage_mode_sparse, prio, dl_keys[std::size_t(i)]),
+                                             std::shared_ptr<void>()));
+        }
+        phase writes = drive(ioc, *disk, int(dl_writes.size()), [&](int i, std::function<void(bool)> done) {
+            auto const& [f, r] = dl_writes[std::size_t(i)];
+            std::int64_t const off = std::int64_t(static_cast<int>(r.piece)) * downloads[0].piece_length() + r.start;
+            disk->async_write(held[std::size_t(f)], r, data.data() + off, observer,
+                [done = std::move(done)](storage_error const& ec) { done(!ec); }, {});
+        });
+        phase hashes = drive(ioc, *disk, int(dl_hashes.size()), [&](int i, std::function<void(bool)> done) {
+            auto const& [f, p] = dl_hashes[std::size_t(i)];
+            disk->async_hash(held[std::size_t(f)], p, {}, disk_interface::v1_hash,
+                [done = std::move(done)](piece_index_t, sha1_hash const&, storage_error const& ec) { done(!ec); });
+        });
+        phase download;
+        download.secs   = writes.secs + hashes.secs;
+        download.done   = writes.done + hashes.done;
+        download.errors = writes.errors + hashes.errors;
+        download.us     = std::move(writes.us);
+        download.us.insert(download.us.end(), hashes.us.begin(), hashes.us.end());
+        res.key("download");
+        report(res, download, std::uint64_t(dl_files) * std::uint64_t(file_size), download.done);
+        res.end_object();
+
+        held.clear();
+        disk->abort(true);
+        ioc.restart();
+        ioc.run();
+        disk.reset();
+        clear_downloads();
+    }
+    ::rmdir(dl_dir.c_str());
+    res.end_array().end_object();
+    return out;
+}
+
+// 40 hex chars (v1 info-hash) or 64 (v2), to the key the torrent is
+// stored under: the v1 hash of a hybrid, the truncated v2 of a v2-only one
+static bool parse_hash_hex(std::string const& hex, sha1_hash& out)
+{
+    if (hex.size() == 40) return aux::from_hex(hex, out.data());
+    sha256_hash v2;
+    if (hex.size() != 64 || !aux::from_hex(hex, v2.data())) return false;
+    if (!g_index.key_for_v2(v2, out)) out = sha1_hash(v2.data());
+    return true;
+}
+
+#if AUDYN_WITH_JNI
+static status_sort parse_sort_key(std::string const& k)
+{
+    if (k == "name")          return status_sort::name;
+    if (k == "progress")      return status_sort::progress;
+    if (k == "upload_rate")   return status_sort::upload_rate;
+    if (k == "download_rate") return status_sort::download_rate;
+    if (k == "num_peers")     return status_sort::num_peers;
+    if (k == "state")         return status_sort::state;
+    return status_sort::none;
+}
+#endif
+
+// ─────────────────────  worker executor  ──────────────────────
+// Hashing and file I/O never run on the thread that called into the
+// library. Jobs go to a small fixed pool with two lanes: interactive work
+// (a user is waiting on it) is always taken first, and background work
+// (bulk seeding) may occupy all workers but one, so an interactive job
+// never waits behind a full pool. Each lane has a bounded queue; submit()
+// fails fast instead of growing without limit.
+enum class job_lane : int { interactive = 0, background = 1 };
+
+class job_executor {
+public:
+    static constexpr std::size_t max_queued[2] = { 64, 4096 };
+
+    ~job_executor() { stop(); }
+
+    static int pool_size()
+    {
+        return static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 2u, 4u));
+    }
+
+    // background jobs that may run at once
+    static int background_slots() { return pool_size() - 1; }
+
+    // false if the lane's queue is full
+    bool post(job_lane l, std::function<void()> fn)
+    {
+        auto const i = static_cast<int>(l);
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_stopping) return false;
+            if (m_queue[i].size() >= max_queued[i]) { ++m_lane[i].rejected; return false; }
+            if (m_workers.empty()) start_locked();
+            m_queue[i].push_back({ std::move(fn), clock::now() });
+        }
+        m_cv.notify_one();
+        return true;
+    }
+
+    // packaged as a future; a rejected job yields a future holding the error
+    template <class F>
+    auto submit(job_lane l, F&& f) -> std::future<decltype(f())>
+    {
+        using R = decltype(f());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto fut  = task->get_future();
+        if (!post(l, [task] { (*task)(); })) {
+            std::promise<R> p;
+            p.set_exception(std::make_exception_ptr(std::runtime_error("job queue full")));
+            return p.get_future();
+        }
+        return fut;
+    }
+
+    void stop()
+    {
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_stopping = true;
+            workers.swap(m_workers);
+        }
+        m_cv.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    // {"workers", "interactive": {…}, "background": {…}}
+    void write_stats(json_writer& w) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        w.begin_object().field("workers", static_cast<int>(m_workers.size()));
+        for (int i = 0; i < 2; ++i) {
+            auto const& s = m_lane[i];
+            w.key(i == 0 ? "interactive" : "background").begin_object()
+             .field("queued",      static_cast<std::uint64_t>(m_queue[i].size()))
+             .field("running",     s.running)
+             .field("completed",   s.completed)
+             .field("rejected",    s.rejected)
+             .field("wait_ms_avg", s.completed ? s.wait_ns / 1e6 / double(s.completed) : 0.0)
+             .field("wait_ms_max", s.wait_ns_max / 1e6)
+             .end_object();
+        }
+        w.end_object();
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct job { std::function<void()> fn; clock::time_point queued; };
+    struct lane_stats {
+        int           running     = 0;
+        std::uint64_t completed   = 0;
+        std::uint64_t rejected    = 0;
+        std::uint64_t wait_ns     = 0;
+        std::uint64_t wait_ns_max = 0;
+    };
+
+    void start_locked()
+    {
+        for (int i = 0; i < pool_size(); ++i) m_workers.emplace_back([this] { run(); });
+    }
+
+    // interactive first; background only while a worker stays free for it
+    int pick_locked() const
+    {
+        if (!m_queue[0].empty()) return 0;
+        int const bg_limit = static_cast<int>(m_workers.size()) - 1;
+        if (!m_queue[1].empty() && m_lane[1].running < bg_limit) return 1;
+        return -1;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        for (;;) {
+            int i = -1;
+            m_cv.wait(lk, [&] { return m_stopping || (i = pick_locked()) >= 0; });
+            if (m_stopping) return;
+
+            job j = std::move(m_queue[i].front());
+            m_queue[i].pop_front();
+            auto& s = m_lane[i];
+            auto const waited = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - j.queued).count());
+            s.wait_ns    += waited;
+            s.wait_ns_max = std::max(s.wait_ns_max, waited);
+            ++s.running;
+
+            lk.unlock();
+            try { j.fn(); }
+            catch (std::exception const& e) { LOGE("job: %s", e.what()); }
+            lk.lock();
+
+            --s.running;
+            ++s.completed;
+            // a finished background job may unblock another one
+            if (i == 1) m_cv.notify_one();
+        }
+    }
+
+    mutable std::mutex         m_mtx;
+    std::condition_variable    m_cv;
+    std::vector<std::thread>   m_workers;
+    std::deque<job>            m_queue[2];
+    lane_stats                 m_lane[2];
+    bool                       m_stopping = false;
+};
+
+static job_executor g_jobs;
+
+// ─────────────────────  torrent versions  ─────────────────────
+// What creation produces. Hybrid (the default, and all this app made
+// before) carries both the v1 SHA-1 piece hashes and the v2 per-file
+// merkle roots, so old v1-only peers and v2 peers share one swarm; v1 and
+// v2 drop the other half. Per-file roots let the same track be recognised
+// across album torrents (torrent_index::by_file_root) and pieces be
+// verified one 16 KiB block at a time while streaming.
+enum class torrent_version : std::uint8_t { hybrid = 0, v1 = 1, v2 = 2 };
+
+// applies to creations that start after it is changed
+static std::atomic<torrent_version> g_torrent_version{torrent_version::hybrid};
+
+#if AUDYN_WITH_JNI
+static bool parse_torrent_version(std::string_view s, torrent_version& out)
+{
+    if (s == "hybrid") out = torrent_version::hybrid;
+    else if (s == "v1") out = torrent_version::v1;
+    else if (s == "v2") out = torrent_version::v2;
+    else return false;
+    return true;
+}
+#endif
+
+// ───────────────────  instant-start preambles  ────────────────
+// Creation can embed the opening seconds of a track in its .torrent, next
+// to the info dict rather than inside it, so the info-hash stays the same
+// and the catalog entry hands them to every peer that adds it:
+//
+//   "audyn.preamble": {"file": 0, "format": "mp3", "duration_ms": 5000, "data": <bytes>}
+//
+// `data` is a byte prefix of the file, tags and headers included, cut on a
+// frame boundary (seek_index::frame_boundary), so a decoder fed nothing
+// else plays it to the end and then waits for the swarm. Being outside the
+// info dict it is not covered by the info-hash; preamble_store checks it
+// against the piece hashes before and as the pieces arrive. A track whose
+// decoder needs metadata behind the audio (an m4a with its moov at the
+// end), or whose tags (cover art) ahead of the audio pass
+// max_preamble_tags, gets no preamble: it would be mostly tags.
+static constexpr int          max_preamble_seconds = 30;
+static constexpr std::int64_t max_preamble_bytes   = 1024 * 1024;
+static constexpr std::int64_t max_preamble_tags    = 64 * 1024;
+static constexpr char         preamble_key[]       = "audyn.preamble";
+
+// seconds of preamble creation embeds, 0 for none (the default); applies
+// to creations that start after it is changed
+static std::atomic<int> g_preamble_seconds{0};
+
+// adds the preamble of `path` (file 0 of `torrent`) when it has one
+static bool add_preamble(entry& torrent, std::string const& path, int seconds)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct ::stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+
+    auto const read = [fd](std::int64_t off, void* buf, std::size_t n) {
+        auto* p = static_cast<char*>(buf);
+        for (std::size_t got = 0; got < n; ) {
+            ssize_t const r = ::pread(fd, p + got, n - got, static_cast<off_t>(off + std::int64_t(got)));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<std::size_t>(r);
+        }
+        return true;
+    };
+
+    seek_index::index idx;
+    std::int64_t need_offset = 0, need_length = 0;
+    std::int64_t cut = -1;
+    if (seek_index::parse(read, st.st_size, idx, need_offset, need_length) == seek_index::status::ok
+        && idx.audio_begin <= max_preamble_tags) {
+        // the byte cap wins over the seconds; the cut may pass it by one frame
+        std::int64_t const want = std::min(idx.byte_at(std::int64_t(seconds) * 1000), max_preamble_bytes);
+        cut = seek_index::frame_boundary(read, idx, want);
+    }
+    std::string data;
+    if (cut > idx.audio_begin && cut >= idx.header_end) {
+        data.resize(static_cast<std::size_t>(cut));
+        if (!read(0, data.data(), data.size())) data.clear();
+    }
+    ::close(fd);
+    if (data.empty()) return false;
+
+    entry& p = torrent[preamble_key];
+    p["file"]        = entry::integer_type(0);
+    p["format"]      = std::string(idx.format);
+    p["duration_ms"] = entry::integer_type(idx.ms_at(cut));
+    p["data"]        = std::move(data);
+    return true;
+}
+
+// ──────────────────────  album torrents  ──────────────────────
+// A creation path ending in '/' names an album: the audio files directly
+// inside that directory, as one multi-file torrent. A 10k-track library
+// then needs a few hundred torrents instead of 10k, each with its own
+// announces, peer list and torrent_info. create_torrent pads every file
+// out to a piece boundary (v2 layout), so a single track can still be
+// fetched on its own through file priorities without touching its
+// neighbours.
+//
+// The key may also name its tracks, "<dir>//<leaf>/<leaf>/…/": the seeder
+// passes the songs it validated that way, so files it rejected (too
+// short, untagged, unreadable) stay out of the torrent.
+static bool is_album_key(std::string const& path)
+{
+    return path.size() > 1 && path.back() == '/';
+}
+
+// `dir/` itself without `tracks`, else `dir` with their leaf names, sorted
+// so the same songs always make the same key (and torrent cache entry)
+static std::string album_key(std::string const& dir, std::vector<std::string> const& tracks)
+{
+    std::string key = is_album_key(dir) ? dir.substr(0, dir.size() - 1) : dir;
+    key += '/';
+    if (tracks.empty()) return key;
+    std::vector<std::string> leaves;
+    for (auto const& t : tracks) {
+        auto const slash = t.find_last_of('/');
+        leaves.push_back(slash == std::string::npos ? t : t.substr(slash + 1));
+    }
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+    key += '/';
+    for (auto const& l : leaves) key += l + '/';
+    return key;
+}
+
+// the directory of album key `key`, no trailing '/'
+static std::string album_dir(std::string const& key)
+{
+    auto const named = key.find("//");
+    return key.substr(0, named == std::string::npos ? key.size() - 1 : named);
+}
+
+// same extensions as MusicSeederService._allowedExt
+static bool is_audio_name(std::string_view name)
+{
+    auto const dot = name.find_last_of('.');
+    if (dot == std::string_view::npos) return false;
+    std::string ext(name.substr(dot + 1));
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext == "mp3" || ext == "flac" || ext == "wav" || ext == "m4a";
+}
+
+// `path` is a visible audio file directly inside `dir` (no trailing '/')
+static bool is_album_member(std::string const& dir, std::string const& path)
+{
+    if (path.size() <= dir.size() + 1 || path[dir.size()] != '/') return false;
+    std::string_view const leaf = std::string_view(path).substr(dir.size() + 1);
+    return leaf.front() != '.' && leaf.find('/') == std::string_view::npos && is_audio_name(leaf);
+}
+
+// the regular files of album key `key` in path order – exactly what
+// hash_torrent puts in its torrent: the named tracks that still exist, or
+// every audio file of the directory
+static std::vector<std::string> album_tracks(std::string const& key)
+{
+    std::string const dir = album_dir(key);
+    std::vector<std::string> out;
+    auto const add = [&](std::string path) {
+        struct ::stat st{};
+        if (is_album_member(dir, path) && ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            out.push_back(std::move(path));
+    };
+    if (key.size() > dir.size() + 1) {
+        for (std::size_t at = dir.size() + 2, end; at < key.size(); at = end + 1) {
+            end = key.find('/', at);
+            add(dir + "/" + key.substr(at, end - at));
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+    DIR* d = ::opendir(dir.c_str());
+    if (!d) return out;
+    while (dirent const* e = ::readdir(d)) add(dir + "/" + e->d_name);
+    ::closedir(d);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// About 16 pieces for the median track, so the padding after each track
+// stays a few percent of it: 256 KiB for typical MP3s, 1 MiB for FLAC.
+static int album_piece_size(file_storage const& fs)
+{
+    std::vector<std::int64_t> sizes;
+    for (file_index_t const i : fs.file_range()) sizes.push_back(fs.file_size(i));
+    int piece = 64 << 10;
+    if (sizes.empty()) return piece;
+    auto const mid = sizes.begin() + static_cast<std::ptrdiff_t>(sizes.size() / 2);
+    std::nth_element(sizes.begin(), mid, sizes.end());
+    while (piece < (1 << 20) && std::int64_t(piece) * 2 * 16 <= *mid) piece *= 2;
+    return piece;
+}
+
+// ──────────────────────  torrent cache  ───────────────────────
+// Generated .torrent files, keyed by source path and validated against
+// the file's identity (device, inode, size, mtime_ns), tracker list,
+// torrent version and preamble seconds (0, the default, is also what
+// records from before preambles read as, so they keep hitting),
+// so a re-seed pass over an unchanged library costs one stat() per track
+// and reads no audio. Stored as an append-only log in the app's no-backup
+// dir (inode numbers mean nothing on another device): only the metadata
+// is read at open, torrent bytes are pread on a hit. Records are in host
+// byte order; a torn or corrupt tail is truncated away at open, and
+// superseded records are dropped when they outweigh the live ones.
+struct file_identity {
+    std::uint64_t dev      = 0;
+    std::uint64_t ino      = 0;
+    std::int64_t  size     = 0;
+    std::int64_t  mtime_ns = 0;
+
+    bool operator==(file_identity const& o) const
+    { return dev == o.dev && ino == o.ino && size == o.size && mtime_ns == o.mtime_ns; }
+    bool operator!=(file_identity const& o) const { return !(*this == o); }
+};
+
+static bool stat_identity(std::string const& path, file_identity& out);
+
+// An album's tracks folded into one identity; adding, removing, renaming
+// or rewriting any track changes it.
+static bool album_identity(std::string const& key, file_identity& out)
+{
+    auto const tracks = album_tracks(key);
+    if (tracks.empty()) return false;
+
+    std::uint64_t h = 14695981039346656037ull;
+    auto const mix = [&h](std::uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+    out = {};
+    for (auto const& t : tracks) {
+        file_identity id;
+        if (!stat_identity(t, id)) return false;
+        for (char const c : t) mix(static_cast<unsigned char>(c));
+        mix(id.dev); mix(id.ino);
+        mix(static_cast<std::uint64_t>(id.size)); mix(static_cast<std::uint64_t>(id.mtime_ns));
+        out.dev       = id.dev;
+        out.size     += id.size;
+        out.mtime_ns  = std::max(out.mtime_ns, id.mtime_ns);
+    }
+    out.ino = h;
+    return true;
+}
+
+// regular files and album keys; plain directories are never cached
+static bool stat_identity(std::string const& path, file_identity& out)
+{
+    if (is_album_key(path)) return album_identity(path, out);
+    struct ::stat st{};
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    out.dev      = static_cast<std::uint64_t>(st.st_dev);
+    out.ino      = static_cast<std::uint64_t>(st.st_ino);
+    out.size     = static_cast<std::int64_t>(st.st_size);
+    out.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+class torrent_cache {
+public:
+    ~torrent_cache() { close(); }
+
+    // loads the index from `dir`/torrents.cache; false if it cannot be used
+    bool open(std::string const& dir)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_pending.reset();
+        return open_locked(dir);
+    }
+
+    // open(`dir`) as soon as the cache is needed: by open_pending(), which
+    // the caller queues on a worker, or by the first lookup, whichever
+    // comes first. A lookup never sees the index of before the call, even
+    // while the worker job still waits behind others
+    void open_later(std::string dir)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_pending = std::move(dir);
+    }
+
+    void open_pending()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_pending.reset();
+        close_locked();
+    }
+
+    // cheap check: would get() hit?
+    bool fresh(std::string const& path, std::vector<std::string> const& trackers,
+               torrent_version version, int preamble_s)
+    {
+        file_identity id;
+        if (!stat_identity(path, id)) return false;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+        auto it = m_index.find(path);
+        return it != m_index.end() && it->second.id == id && it->second.version == version
+            && it->second.preamble_s == preamble_s && it->second.trackers == join(trackers);
+    }
+
+    bool get(std::string const& path, std::vector<std::string> const& trackers,
+             torrent_version version, int preamble_s, std::vector<char>& out)
+    {
+        file_identity id;
+        if (!stat_identity(path, id)) return false;
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+        auto it = m_index.find(path);
+        if (m_fd < 0 || it == m_index.end() || it->second.id != id || it->second.version != version
+            || it->second.preamble_s != preamble_s || it->second.trackers != join(trackers)) {
+            ++m_misses;
+            return false;
+        }
+        entry const& e = it->second;
+        out.resize(e.length);
+        if (!read_at(e.offset, out.data(), e.length) || fnv1a(out.data(), e.length) != e.checksum) {
+            LOGE("torrent cache: bad record for %s", path.c_str());
+            m_dead_bytes += e.length;
+            m_live_bytes -= e.length;
+            m_index.erase(it);
+            out.clear();
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        return true;
+    }
+
+    // stores `buf` for `path` unless the file changed since `before`
+    void put(std::string const& path, file_identity const& before,
+             std::vector<std::string> const& trackers, torrent_version version,
+             int preamble_s, std::vector<char> const& buf)
+    {
+        file_identity now;
+        if (!stat_identity(path, now) || now != before || buf.empty()) return;
+
+        sha1_hash ih;
+        error_code ec;
+        torrent_info const ti(span<char const>(buf.data(), static_cast<std::ptrdiff_t>(buf.size())), ec, from_span);
+        if (ec) return;
+        ih = cache_key(ti.info_hashes());
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+        if (m_fd < 0) return;
+        entry e;
+        e.id       = now;
+        e.trackers = join(trackers);
+        e.ih       = ih;
+        e.version  = version;
+        e.preamble_s = preamble_s;
+        if (!append_locked(path, e, buf)) return;
+
+        auto it = m_index.find(path);
+        if (it != m_index.end()) {
+            m_dead_bytes += it->second.length;
+            m_live_bytes -= it->second.length;
+            it->second = std::move(e);
+        } else {
+            m_index.emplace(path, std::move(e));
+        }
+        m_live_bytes += buf.size();
+    }
+
+    // info-hash (cache_key) of the cached torrent for `path`, if still fresh
+    bool info_hash(std::string const& path, sha1_hash& out)
+    {
+        file_identity id;
+        if (!stat_identity(path, id)) return false;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+        auto it = m_index.find(path);
+        if (it == m_index.end() || it->second.id != id) return false;
+        out = it->second.ih;
+        return true;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        open_pending_locked();
+        m_index.clear();
+        m_live_bytes = m_dead_bytes = 0;
+        if (m_fd >= 0 && ::ftruncate(m_fd, 0) == 0) write_header_locked();
+    }
+
+    // {"open","entries","hits","misses","live_bytes","dead_bytes"}
+    void write_stats(json_writer& w) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        w.begin_object()
+         .field("open",       m_fd >= 0)
+         .field("entries",    static_cast<std::uint64_t>(m_index.size()))
+         .field("hits",       m_hits)
+         .field("misses",     m_misses)
+         .field("live_bytes", m_live_bytes)
+         .field("dead_bytes", m_dead_bytes)
+         .end_object();
+    }
+
+private:
+    static constexpr char          file_magic[8] = { 'A', 'U', 'D', 'Y', 'N', 'T', 'C', '1' };
+    static constexpr std::uint32_t record_magic  = 0x52435441;   // "ATCR"
+
+    // fixed part of a record; followed by path, trackers and torrent bytes
+    struct record_head {
+        std::uint32_t magic;
+        std::uint32_t path_len;
+        std::uint32_t trackers_len;
+        std::uint32_t bytes_len;
+        std::uint32_t bytes_checksum;
+        std::uint32_t meta_checksum;     // of everything above plus the fields below, path and trackers
+        std::uint64_t dev;
+        std::uint64_t ino;
+        std::int64_t  size;
+        std::int64_t  mtime_ns;
+        std::uint8_t  info_hash[20];
+        std::uint8_t  version;           // torrent_version; records from before it read as hybrid
+        std::uint8_t  preamble_s;        // seconds of embedded preamble; older records read as 0
+        std::uint8_t  pad[2];
+    };
+
+    struct entry {
+        file_identity id;
+        std::string   trackers;
+        sha1_hash     ih;
+        torrent_version version = torrent_version::hybrid;
+        int           preamble_s = 0;
+        std::uint64_t offset   = 0;     // of the torrent bytes
+        std::uint32_t length   = 0;
+        std::uint32_t checksum = 0;
+    };
+
+    static std::string join(std::vector<std::string> const& v)
+    {
+        std::string s;
+        for (auto const& t : v) { s += t; s += '\n'; }
+        return s;
+    }
+
+    static std::uint32_t fnv1a(void const* p, std::size_t n, std::uint32_t h = 2166136261u)
+    {
+        auto const* b = static_cast<unsigned char const*>(p);
+        for (std::size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 16777619u; }
+        return h;
+    }
+
+    static std::uint32_t meta_checksum(record_head h, char const* path, char const* trackers)
+    {
+        h.meta_checksum = 0;
+        std::uint32_t c = fnv1a(&h, sizeof(h));
+        c = fnv1a(path, h.path_len, c);
+        return fnv1a(trackers, h.trackers_len, c);
+    }
+
+    bool read_at(std::uint64_t off, void* dst, std::size_t n) const
+    {
+        auto* p = static_cast<char*>(dst);
+        while (n > 0) {
+            ssize_t const r = ::pread(m_fd, p, n, static_cast<off_t>(off));
+            if (r <= 0) { if (r < 0 && errno == EINTR) continue; return false; }
+            p += r; off += static_cast<std::uint64_t>(r); n -= static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    static bool write_all(int fd, std::uint64_t off, void const* src, std::size_t n)
+    {
+        auto const* p = static_cast<char const*>(src);
+        while (n > 0) {
+            ssize_t const r = ::pwrite(fd, p, n, static_cast<off_t>(off));
+            if (r <= 0) { if (r < 0 && errno == EINTR) continue; return false; }
+            p += r; off += static_cast<std::uint64_t>(r); n -= static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    void write_header_locked()
+    {
+        write_all(m_fd, 0, file_magic, sizeof(file_magic));
+        m_end = sizeof(file_magic);
+    }
+
+    void load_locked()
+    {
+        struct ::stat st{};
+        ::fstat(m_fd, &st);
+        auto const file_size = static_cast<std::uint64_t>(st.st_size);
+
+        char magic[sizeof(file_magic)];
+        if (file_size < sizeof(file_magic) || !read_at(0, magic, sizeof(magic))
+            || std::memcmp(magic, file_magic, sizeof(magic)) != 0) {
+            if (::ftruncate(m_fd, 0) == 0) write_header_locked();
+            return;
+        }
+
+        std::uint64_t off = sizeof(file_magic);
+        std::string path, trackers;
+        for (;;) {
+            record_head h{};
+            if (off + sizeof(h) > file_size || !read_at(off, &h, sizeof(h)) || h.magic != record_magic)
+                break;
+            std::uint64_t const body = off + sizeof(h);
+            std::uint64_t const next = body + h.path_len + h.trackers_len + h.bytes_len;
+            if (next > file_size || h.path_len > 4096 || h.trackers_len > (1 << 16)) break;
+            path.resize(h.path_len);
+            trackers.resize(h.trackers_len);
+            if (!read_at(body, path.data(), h.path_len)
+                || !read_at(body + h.path_len, trackers.data(), h.trackers_len)
+                || meta_checksum(h, path.data(), trackers.data()) != h.meta_checksum)
+                break;
+
+            entry e;
+            e.id       = { h.dev, h.ino, h.size, h.mtime_ns };
+            e.trackers = trackers;
+            std::memcpy(e.ih.data(), h.info_hash, sizeof(h.info_hash));
+            e.version  = static_cast<torrent_version>(h.version);
+            e.preamble_s = h.preamble_s;
+            e.offset   = body + h.path_len + h.trackers_len;
+            e.length   = h.bytes_len;
+            e.checksum = h.bytes_checksum;
+
+            auto it = m_index.find(path);
+            if (it != m_index.end()) {
+                m_dead_bytes += it->second.length;
+                m_live_bytes -= it->second.length;
+                it->second = std::move(e);
+            } else {
+                m_index.emplace(path, std::move(e));
+            }
+            m_live_bytes += h.bytes_len;
+            off = next;
+        }
+        m_end = off;
+        if (off < file_size) {
+            LOGE("torrent cache: dropping %llu bytes of torn tail",
+                 static_cast<unsigned long long>(file_size - off));
+            if (::ftruncate(m_fd, static_cast<off_t>(off)) != 0) m_end = file_size;
+        }
+    }
+
+    bool append_to(int fd, std::uint64_t& end, std::string const& path, entry& e,
+                   char const* bytes, std::uint32_t len)
+    {
+        record_head h{};
+        h.magic          = record_magic;
+        h.path_len       = static_cast<std::uint32_t>(path.size());
+        h.trackers_len   = static_cast<std::uint32_t>(e.trackers.size());
+        h.bytes_len      = len;
+        h.bytes_checksum = fnv1a(bytes, len);
+        h.dev            = e.id.dev;
+        h.ino            = e.id.ino;
+        h.size           = e.id.size;
+        h.mtime_ns       = e.id.mtime_ns;
+        std::memcpy(h.info_hash, e.ih.data(), sizeof(h.info_hash));
+        h.version        = static_cast<std::uint8_t>(e.version);
+        h.preamble_s     = static_cast<std::uint8_t>(e.preamble_s);
+        h.meta_checksum  = meta_checksum(h, path.data(), e.trackers.data());
+
+        std::string rec(reinterpret_cast<char const*>(&h), sizeof(h));
+        rec += path;
+        rec += e.trackers;
+        rec.append(bytes, len);
+        if (!write_all(fd, end, rec.data(), rec.size())) return false;
+
+        e.offset   = end + sizeof(h) + path.size() + e.trackers.size();
+        e.length   = len;
+        e.checksum = h.bytes_checksum;
+        end += rec.size();
+        return true;
+    }
+
+    bool append_locked(std::string const& path, entry& e, std::vector<char> const& buf)
+    {
+        if (append_to(m_fd, m_end, path, e, buf.data(), static_cast<std::uint32_t>(buf.size())))
+            return true;
+        LOGE("torrent cache: append failed: %s", std::strerror(errno));
+        // a partial record is cut off at the next open
+        return false;
+    }
+
+    // rewrites live records whose files are unchanged into a fresh log
+    void compact_locked()
+    {
+        std::string const tmp = m_path + ".tmp";
+        int const fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) return;
+
+        std::uint64_t end = sizeof(file_magic);
+        bool ok = write_all(fd, 0, file_magic, sizeof(file_magic));
+        std::unordered_map<std::string, entry> index;
+        std::uint64_t live = 0;
+        std::vector<char> buf;
+        for (auto& [path, e] : m_index) {
+            if (!ok) break;
+            file_identity now;
+            if (!stat_identity(path, now) || now != e.id) continue;
+            buf.resize(e.length);
+            if (!read_at(e.offset, buf.data(), e.length)) continue;
+            entry n = e;
+            ok = append_to(fd, end, path, n, buf.data(), e.length);
+            live += e.length;
+            index.emplace(path, std::move(n));
+        }
+        if (!ok || ::fsync(fd) != 0 || ::rename(tmp.c_str(), m_path.c_str()) != 0) {
+            ::close(fd);
+            ::unlink(tmp.c_str());
+            return;
+        }
+        LOGI("torrent cache: compacted %zu → %zu entries", m_index.size(), index.size());
+        ::close(m_fd);
+        m_fd         = fd;
+        m_end        = end;
+        m_index      = std::move(index);
+        m_live_bytes = live;
+        m_dead_bytes = 0;
+    }
+
+    bool open_locked(std::string const& dir)
+    {
+        close_locked();
+        ::mkdir(dir.c_str(), 0700);
+        m_path = dir + "/torrents.cache";
+        m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (m_fd < 0) {
+            LOGE("torrent cache: cannot open %s: %s", m_path.c_str(), std::strerror(errno));
+            return false;
+        }
+        load_locked();
+        if (m_dead_bytes > (1 << 20) && m_dead_bytes > m_live_bytes) compact_locked();
+        LOGI("torrent cache: %zu entries from %s", m_index.size(), m_path.c_str());
+        return true;
+    }
+
+    void open_pending_locked()
+    {
+        if (!m_pending) return;
+        std::string const dir = std::move(*m_pending);
+        m_pending.reset();
+        open_locked(dir);
+    }
+
+    void close_locked()
+    {
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+        m_index.clear();
+        m_live_bytes = m_dead_bytes = 0;
+    }
+
+    mutable std::mutex                     m_mtx;
+    std::optional<std::string>             m_pending;   // see open_later()
+    std::string                            m_path;
+    int                                    m_fd  = -1;
+    std::uint64_t                          m_end = 0;
+    std::unordered_map<std::string, entry> m_index;
+    std::uint64_t                          m_live_bytes = 0;
+    std::uint64_t                          m_dead_bytes = 0;
+    std::uint64_t                          m_hits       = 0;
+    std::uint64_t                          m_misses     = 0;
+};
+
+static torrent_cache g_torrent_cache;
+
+// ─────────────────────  torrent creation  ─────────────────────
+// Pure helpers run on g_jobs workers; JNI / C callers marshal their
+// arguments first and never hand a JNIEnv across threads.
+
+// set_piece_hashes() has no way to stop early, but it does give up on the
+// first failed hash job. This forwards to the real disk I/O and fails every
+// hash job issued after `cancel` was raised, so a cancelled job winds down
+// after the reads already in flight.
+class cancellable_disk_io final : public disk_interface {
+public:
+    cancellable_disk_io(std::unique_ptr<disk_interface> inner, io_context& ioc,
+                        std::atomic<bool> const& cancel)
+        : m_inner(std::move(inner)), m_ioc(ioc), m_cancel(cancel) {}
+
+    storage_holder new_torrent(storage_params const& p, std::shared_ptr<void> const& t) override
+    { return m_inner->new_torrent(p, t); }
+    void remove_torrent(storage_index_t s) override { m_inner->remove_torrent(s); }
+
+    void async_read(storage_index_t s, peer_request const& r
+        , std::function<void(disk_buffer_holder, storage_error const&)> h
+        , disk_job_flags_t f) override
+    { m_inner->async_read(s, r, std::move(h), f); }
+    bool async_write(storage_index_t s, peer_request const& r, char const* buf
+        , std::shared_ptr<disk_observer> o
+        , std::function<void(storage_error const&)> h, disk_job_flags_t f) override
+    { return m_inner->async_write(s, r, buf, std::move(o), std::move(h), f); }
+
+    void async_hash(storage_index_t s, piece_index_t piece, span<sha256_hash> v2
+        , disk_job_flags_t f
+        , std::function<void(piece_index_t, sha1_hash const&, storage_error const&)> h) override
+    {
+        if (!m_cancel.load(std::memory_order_relaxed)) {
+            m_inner->async_hash(s, piece, v2, f, std::move(h));
+            return;
+        }
+        boost::asio::post(m_ioc, [h = std::move(h), piece] {
+            h(piece, sha1_hash(), storage_error(boost::asio::error::operation_aborted,
+                                                operation_t::file_read));
+        });
+    }
+    void async_hash2(storage_index_t s, piece_index_t piece, int offset, disk_job_flags_t f
+        , std::function<void(piece_index_t, sha256_hash const&, storage_error const&)> h) override
+    { m_inner->async_hash2(s, piece, offset, f, std::move(h)); }
+
+    void async_move_storage(storage_index_t s, std::string p, move_flags_t f
+        , std::function<void(status_t, std::string const&, storage_error const&)> h) override
+    { m_inner->async_move_storage(s, std::move(p), f, std::move(h)); }
+    void async_release_files(storage_index_t s, std::function<void()> h) override
+    { m_inner->async_release_files(s, std::move(h)); }
+    void async_check_files(storage_index_t s, add_torrent_params const* rd
+        , aux::vector<std::string, file_index_t> links
+        , std::function<void(status_t, storage_error const&)> h) override
+    { m_inner->async_check_files(s, rd, std::move(links), std::move(h)); }
+    void async_stop_torrent(storage_index_t s, std::function<void()> h) override
+    { m_inner->async_stop_torrent(s, std::move(h)); }
+    void async_rename_file(storage_index_t s, file_index_t i, std::string name
+        , std::function<void(std::string const&, file_index_t, storage_error const&)> h) override
+    { m_inner->async_rename_file(s, i, std::move(name), std::move(h)); }
+    void async_delete_files(storage_index_t s, remove_flags_t o
+        , std::function<void(storage_error const&)> h) override
+    { m_inner->async_delete_files(s, o, std::move(h)); }
+    void async_set_file_priority(storage_index_t s
+        , aux::vector<download_priority_t, file_index_t> prio
+        , std::function<void(storage_error const&, aux::vector<download_priority_t, file_index_t>)> h) override
+    { m_inner->async_set_file_priority(s, std::move(prio), std::move(h)); }
+    void async_clear_piece(storage_index_t s, piece_index_t i
+        , std::function<void(piece_index_t)> h) override
+    { m_inner->async_clear_piece(s, i, std::move(h)); }
+
+    void update_stats_counters(counters& c) const override { m_inner->update_stats_counters(c); }
+    std::vector<open_file_state> get_status(storage_index_t s) const override { return m_inner->get_status(s); }
+    void abort(bool wait) override { m_inner->abort(wait); }
+    void submit_jobs() override { m_inner->submit_jobs(); }
+    void settings_updated() override { m_inner->settings_updated(); }
+
+private:
+    std::unique_ptr<disk_interface> m_inner;
+    io_context&                     m_ioc;
+    std::atomic<bool> const&        m_cancel;
+};
+
+// Hashes a single-file torrent with piece_hash::best() instead of
+// libtorrent's own hasher: the v1 SHA-1 of every piece and the v2 (BEP 52)
+// per-piece merkle root over 16 KiB SHA-256 leaves. Pieces are read a
+// batch at a time (≤ 4 MiB) so the multi-buffer variant always gets many
+// equally long messages per call: all blocks of a batch for the leaves,
+// and every pair of a tree level across the batch for the upper nodes.
+// The result is byte-for-byte what set_piece_hashes() would produce. Only
+// the half a v1- or v2-only torrent needs is computed.
+//
+// Like settings_pack::hashing_threads for the multi-file path, `threads`
+// workers (the calling thread one of them) take batches in turn. Hashes
+// land in per-piece slots and reach `t` once all are in; `progress` still
+// runs only on the calling thread.
+static void hash_single_file(create_torrent& t, std::string const& file,
+                             std::atomic<bool> const* cancel,
+                             std::function<void(int done, int total)> const& progress,
+                             error_code& ec, int threads = 1)
+{
+    constexpr int block = 16 * 1024;
+    auto const& eng        = piece_hash::best();
+    bool const v1          = !t.is_v2_only();
+    bool const v2          = !t.is_v1_only();
+    std::int64_t const size = t.files().total_size();
+    int const piece_len    = t.piece_length();
+    int const num_pieces   = t.num_pieces();
+    int const per_piece    = piece_len / block;
+
+    // a file shorter than one piece has no piece layer: its root covers
+    // its own blocks rounded up to a power of two, not a whole piece
+    int width = per_piece;
+    if (size < piece_len) {
+        int const blocks = static_cast<int>((size + block - 1) / block);
+        width = 1;
+        while (width < blocks) width *= 2;
+    }
+
+    int const fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { ec.assign(errno, boost::system::generic_category()); return; }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int const batch = std::clamp((4 << 20) / piece_len, 1, 256);
+    threads = std::clamp(threads, 1, std::max(1, (num_pieces + batch - 1) / batch));
+
+    std::vector<std::uint8_t> sha1s(v1 ? std::size_t(num_pieces) * piece_hash::sha1_size : 0);
+    std::vector<std::uint8_t> roots(v2 ? std::size_t(num_pieces) * piece_hash::sha256_size : 0);
+    std::atomic<int>  next_batch{0};
+    std::atomic<int>  hashed{0};
+    std::atomic<bool> stop{false};
+    std::mutex        err_mtx;
+    error_code        err;
+    auto fail = [&](error_code const& e) {
+        {
+            std::lock_guard<std::mutex> lk(err_mtx);
+            if (!err) err = e;
+        }
+        stop = true;
+    };
+
+    auto work = [&](auto const& report) {
+        std::vector<std::uint8_t>        data(std::size_t(batch) * piece_len);
+        std::vector<std::uint8_t>        leaves(v2 ? std::size_t(batch) * per_piece * piece_hash::sha256_size : 0);
+        std::vector<std::uint8_t>        tree(v2 ? std::size_t(batch) * width * piece_hash::sha256_size : 0);
+        std::vector<std::uint8_t>        next(tree.size() / 2);
+        std::vector<std::uint8_t const*> msgs(std::size_t(batch) * std::max(per_piece, width));
+
+        while (!stop.load()) {
+            if (cancel && cancel->load()) { fail(boost::asio::error::operation_aborted); return; }
+            int const first = next_batch.fetch_add(1) * batch;
+            if (first >= num_pieces) return;
+
+            int const n = std::min(batch, num_pieces - first);
+            std::int64_t const off = std::int64_t(first) * piece_len;
+            std::size_t const len = static_cast<std::size_t>(std::min<std::int64_t>(std::int64_t(n) * piece_len, size - off));
+            for (std::size_t got = 0; got < len; ) {
+                ssize_t const r = ::pread(fd, data.data() + got, len - got, static_cast<off_t>(off + std::int64_t(got)));
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) { fail(error_code(r < 0 ? errno : EIO, boost::system::generic_category())); return; }
+                got += static_cast<std::size_t>(r);
+            }
+
+            // v1: one SHA-1 per piece; only the file's last piece can be short
+            if (v1) {
+                std::uint8_t* const out = sha1s.data() + std::size_t(first) * piece_hash::sha1_size;
+                std::size_t const last_len = len - std::size_t(n - 1) * piece_len;
+                for (int k = 0; k < n; ++k) msgs[k] = data.data() + std::size_t(k) * piece_len;
+                int const full_pieces = last_len == std::size_t(piece_len) ? n : n - 1;
+                eng.sha1(msgs.data(), std::size_t(full_pieces), std::size_t(piece_len), out);
+                if (full_pieces < n)
+                    eng.sha1(&msgs[full_pieces], 1, last_len, out + std::size_t(full_pieces) * piece_hash::sha1_size);
+            }
+            if (v2) {
+                // leaves: SHA-256 of every 16 KiB block, the file's last one may be short
+                std::size_t const blocks = (len + block - 1) / block;
+                std::size_t const tail   = len - (blocks - 1) * block;
+                for (std::size_t b = 0; b < blocks; ++b) msgs[b] = data.data() + b * block;
+                std::size_t const full_blocks = tail == std::size_t(block) ? blocks : blocks - 1;
+                eng.sha256(msgs.data(), full_blocks, block, leaves.data());
+                if (full_blocks < blocks)
+                    eng.sha256(&msgs[full_blocks], 1, tail, leaves.data() + full_blocks * piece_hash::sha256_size);
+
+                // per-piece trees side by side, missing leaves zero, reduced one
+                // level at a time across the whole batch
+                std::fill(tree.begin(), tree.end(), std::uint8_t(0));
+                for (int k = 0; k < n; ++k) {
+                    std::size_t const first_block = std::size_t(k) * per_piece;
+                    std::size_t const count = std::min<std::size_t>(per_piece, blocks - first_block);
+                    std::memcpy(tree.data() + std::size_t(k) * width * piece_hash::sha256_size,
+                                leaves.data() + first_block * piece_hash::sha256_size,
+                                std::min<std::size_t>(count, std::size_t(width)) * piece_hash::sha256_size);
+                }
+                for (std::size_t nodes = std::size_t(n) * width; nodes > std::size_t(n); nodes /= 2) {
+                    for (std::size_t i = 0; i < nodes / 2; ++i) msgs[i] = tree.data() + i * 2 * piece_hash::sha256_size;
+                    eng.sha256(msgs.data(), nodes / 2, 2 * piece_hash::sha256_size, next.data());
+                    std::memcpy(tree.data(), next.data(), nodes / 2 * piece_hash::sha256_size);
+                }
+                std::memcpy(roots.data() + std::size_t(first) * piece_hash::sha256_size, tree.data(),
+                            std::size_t(n) * piece_hash::sha256_size);
+            }
+            hashed.fetch_add(n);
+            report();
+        }
+    };
+
+    int reported = 0;
+    auto report = [&] {
+        if (!progress) return;
+        for (int const h = hashed.load(); reported < h; ) progress(++reported, num_pieces);
+    };
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i) helpers.emplace_back([&work] { work([] {}); });
+    work(report);
+    for (auto& h : helpers) h.join();
+    ::close(fd);
+    if (err) { ec = err; return; }
+
+    for (int k = 0; k < num_pieces; ++k) {
+        piece_index_t const piece(k);
+        if (v1) t.set_hash(piece, sha1_hash(reinterpret_cast<char const*>(sha1s.data()) + k * piece_hash::sha1_size));
+        if (v2) t.set_hash2(file_index_t(0), k,
+                            sha256_hash(reinterpret_cast<char const*>(roots.data()) + k * piece_hash::sha256_size));
+    }
+    report();
+}
+
+// bencoded `t`, with the preamble of its first file when asked for one
+static std::vector<char> generate_torrent(create_torrent& t, std::string const& parent, int preamble_s)
+{
+    entry e = t.generate();
+    file_storage const& fs = t.files();
+    if (preamble_s > 0 && fs.num_files() > 0 && !fs.pad_file_at(file_index_t(0)))
+        add_preamble(e, fs.file_path(file_index_t(0), parent), preamble_s);
+    std::vector<char> buf;
+    bencode(std::back_inserter(buf), e);
+    return buf;
+}
+
+// Hashes `path` (a file, a directory or an album key) into a bencoded
+// torrent. `cancel` may be raised from any thread; `progress` runs once per
+// hashed piece on the calling thread. Empty result on failure, cancellation
+// sets `ec` to operation_aborted.
+static std::vector<char> hash_torrent(std::string const& path,
+                                      std::vector<std::string> const& trackers,
+                                      torrent_version version,
+                                      int preamble_s,
+                                      std::atomic<bool> const* cancel,
+                                      std::function<void(int done, int total)> const& progress,
+                                      error_code& ec,
+                                      int hashing_threads = 0)
+{
+    file_storage fs;
+    std::string root = path;
+    int piece_size = 0;
+    create_flags_t flags = version == torrent_version::v1 ? create_torrent::v1_only
+                         : version == torrent_version::v2 ? create_torrent::v2_only
+                         : create_flags_t{};
+    if (is_album_key(path)) {
+        root = album_dir(path);
+        auto const tracks = album_tracks(path);
+        add_files(fs, root, [&root, &tracks](std::string const& p) {
+            return p.size() <= root.size() || std::binary_search(tracks.begin(), tracks.end(), p);
+        });
+        piece_size = album_piece_size(fs);
+        // v1 alone would pack tracks back to back; keep them piece-aligned
+        if (version == torrent_version::v1) flags |= create_torrent::canonical_files;
+    } else {
+        add_files(fs, path);
+    }
+    if (fs.num_files() == 0) {
+        ec = boost::asio::error::not_found;
+        return {};
+    }
+
+    create_torrent t(fs, piece_size, flags);
+    for (auto const& tr : trackers) t.add_tracker(tr);
+
+    int const total = t.num_pieces();
+    int done = 0;
+    auto on_piece = [&](piece_index_t) { if (progress) progress(++done, total); };
+
+    std::string const parent = root.substr(0, root.find_last_of('/'));
+    if (t.files().num_files() == 1) {
+        hash_single_file(t, fs.file_path(file_index_t(0), parent), cancel, progress, ec,
+                         std::max(1, hashing_threads));
+        if (ec) return {};
+        return generate_torrent(t, parent, preamble_s);
+    }
+
+    settings_pack sett;
+    if (hashing_threads > 0) {
+        sett.set_int(settings_pack::hashing_threads, hashing_threads);
+        sett.set_int(settings_pack::aio_threads, 1);
+    }
+    if (cancel) {
+        set_piece_hashes(t, parent, sett,
+            [cancel](io_context& ioc, settings_interface const& s, counters& c)
+                -> std::unique_ptr<disk_interface> {
+                return std::make_unique<cancellable_disk_io>(
+                    default_disk_io_constructor(ioc, s, c), ioc, *cancel);
+            },
+            on_piece, ec);
+        if (!ec && cancel->load()) ec = boost::asio::error::operation_aborted;
+    } else {
+        set_piece_hashes(t, parent, sett, on_piece, ec);
+    }
+    if (ec) return {};
+    return generate_torrent(t, parent, preamble_s);
+}
+
+// hash_torrent() behind g_torrent_cache: an unchanged file is answered
+// from the cache without reading it
+static std::vector<char> cached_hash_torrent(std::string const& path,
+                                             std::vector<std::string> const& trackers,
+                                             std::atomic<bool> const* cancel,
+                                             std::function<void(int done, int total)> const& progress,
+                                             error_code& ec,
+                                             int hashing_threads = 0)
+{
+    torrent_version const version = g_torrent_version.load();
+    int const preamble_s = g_preamble_seconds.load();
+    std::vector<char> buf;
+    if (g_torrent_cache.get(path, trackers, version, preamble_s, buf)) {
+        if (progress) progress(1, 1);
+        return buf;
+    }
+
+    file_identity before;
+    bool const cacheable = stat_identity(path, before);
+    buf = hash_torrent(path, trackers, version, preamble_s, cancel, progress, ec, hashing_threads);
+    if (!ec && cacheable) g_torrent_cache.put(path, before, trackers, version, preamble_s, buf);
+    return buf;
+}
+
+static bool write_buffer_file(std::string const& output, std::vector<char> const& buf)
+{
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LOGE("Failed to open output file: %s", output.c_str());
+        return false;
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    LOGI("Torrent successfully created at: %s", output.c_str());
+    return bool(out);
+}
+
+#if AUDYN_WITH_JNI
+// bencoded single-file (or directory) torrent for `path`; empty on failure
+static std::vector<char> make_torrent_buffer(std::string const& path,
+                                             std::vector<std::string> const& trackers = {})
+{
+    error_code ec;
+    auto buf = cached_hash_torrent(path, trackers, nullptr, {}, ec);
+    if (ec) LOGE("set_piece_hashes failed: [%s] %s", ec.category().name(), ec.message().c_str());
+    return buf;
+}
+
+static bool write_torrent_file(std::string const& input, std::string const& output,
+                               std::vector<std::string> const& trackers)
+{
+    auto const buf = make_torrent_buffer(input, trackers);
+    return !buf.empty() && write_buffer_file(output, buf);
+}
+#endif
+
+// ───────────────────────  audio identity  ─────────────────────
+// Tag-independent content id of a track (see audio_identity.hpp), so the
+// catalog can group the swarms of differently tagged copies of the same
+// recording. Reads the whole payload; run it on g_jobs.
+
+// {"identity","format","file_bytes","payload_bytes"}; identity is 64 hex chars
+static bool write_audio_identity(json_writer& w, std::string const& path, std::string& err)
+{
+    audio_identity::result r;
+    if (!audio_identity::compute(path, r, err)) return false;
+    w.begin_object()
+     .field("identity",      aux::to_hex(span<char const>(reinterpret_cast<char const*>(r.root), sizeof r.root)))
+     .field("format",        r.format)
+     .field("file_bytes",    r.file_bytes)
+     .field("payload_bytes", r.payload_bytes)
+     .end_object();
+    return true;
+}
+
+// ──────────────────────  creation jobs  ───────────────────────
+// startCreateJob / pollCreateJob / cancelCreateJob. Jobs beyond the
+// concurrency cap wait here (not in the executor queue), so cancelling a
+// waiting job is free and a big seeding run cannot flood g_jobs. Progress
+// is counted per piece but only published to listeners every
+// progress_interval, plus once for every state change.
+enum class job_state : int { queued = 0, hashing = 1, done = 2, failed = 3, cancelled = 4 };
+
+static char const* job_state_name(job_state s)
+{
+    switch (s) {
+        case job_state::queued:    return "queued";
+        case job_state::hashing:   return "hashing";
+        case job_state::done:      return "done";
+        case job_state::failed:    return "failed";
+        case job_state::cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+struct create_job {
+    using clock = std::chrono::steady_clock;
+
+    std::int64_t              id = 0;
+    std::string               source;
+    std::string               output;     // empty → keep the bytes for takeCreateJobResult
+    std::vector<std::string>  trackers;
+    job_lane                  lane = job_lane::interactive;
+
+    std::atomic<job_state>    state{job_state::queued};
+    std::atomic<bool>         cancel{false};
+    std::atomic<int>          pieces_done{0};
+    std::atomic<int>          num_pieces{0};
+    clock::time_point         created = clock::now();
+    std::atomic<std::int64_t> elapsed_ms{0};  // set when the job ends
+
+    // throttled progress / state events; may run on any worker thread
+    std::function<void(create_job const&)> on_event;
+
+    mutable std::mutex        m;            // guards bytes / error
+    std::vector<char>         bytes;
+    std::string               error;
+
+    bool finished() const { return state.load() >= job_state::done; }
+
+    void emit()
+    {
+        if (on_event) {
+            try { on_event(*this); }
+            catch (std::exception const& e) { LOGE("create job %lld listener: %s", static_cast<long long>(id), e.what()); }
+        }
+    }
+};
+using job_ptr = std::shared_ptr<create_job>;
+
+class create_job_registry {
+public:
+    static constexpr auto        progress_interval = std::chrono::milliseconds(250);
+    static constexpr std::size_t max_finished      = 256;   // untaken results kept around
+
+    std::int64_t start(job_ptr j)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            j->id = ++m_next_id;
+            m_jobs.emplace(j->id, j);
+            m_waiting.push_back(j);
+        }
+        j->emit();
+        dispatch();
+        return j->id;
+    }
+
+    job_ptr find(std::int64_t id) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_jobs.find(id);
+        return it == m_jobs.end() ? nullptr : it->second;
+    }
+
+    // queued jobs end right away, running ones at their next piece
+    bool cancel(std::int64_t id)
+    {
+        job_ptr j;
+        bool was_waiting = false;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_jobs.find(id);
+            if (it == m_jobs.end() || it->second->finished()) return false;
+            j = it->second;
+            j->cancel = true;
+            auto w = std::find(m_waiting.begin(), m_waiting.end(), j);
+            if (w != m_waiting.end()) { m_waiting.erase(w); was_waiting = true; }
+        }
+        if (was_waiting) finish(j, job_state::cancelled);
+        return true;
+    }
+
+    // hands over the bytes of a finished job and forgets it
+    job_state take(std::int64_t id, std::vector<char>& out)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_jobs.find(id);
+        if (it == m_jobs.end()) return job_state::failed;
+        auto const st = it->second->state.load();
+        if (st < job_state::done) return st;
+        {
+            std::lock_guard<std::mutex> jl(it->second->m);
+            out.swap(it->second->bytes);
+        }
+        m_jobs.erase(it);
+        return st;
+    }
+
+    // take() into a caller's buffer, in one step under the registry lock so
+    // no other take or eviction slips in between: the size of a done job's
+    // bytes, copied to `buf` (and the job forgotten) only if `cap` holds
+    // them. false, with `known` set, for an unknown job or one not done
+    bool take(std::int64_t id, void* buf, std::int64_t cap, std::int64_t& size, bool& known)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_jobs.find(id);
+        known = it != m_jobs.end();
+        if (!known || it->second->state.load() != job_state::done) return false;
+        {
+            std::lock_guard<std::mutex> jl(it->second->m);
+            std::vector<char> const& bytes = it->second->bytes;
+            size = static_cast<std::int64_t>(bytes.size());
+            if (!buf || cap < size) return true;
+            std::memcpy(buf, bytes.data(), bytes.size());
+        }
+        m_jobs.erase(it);
+        return true;
+    }
+
+    void set_concurrency(int n)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_limit = std::clamp(n, 1, 16);
+        }
+        dispatch();
+    }
+
+    void write_job(json_writer& w, create_job const& j) const
+    {
+        auto const st   = j.state.load();
+        int const done  = j.pieces_done.load();
+        int const total = j.num_pieces.load();
+        auto const elapsed = j.finished() ? j.elapsed_ms.load()
+            : std::chrono::duration_cast<std::chrono::milliseconds>(create_job::clock::now() - j.created).count();
+        w.begin_object()
+         .field("id",          j.id)
+         .field("state",       job_state_name(st))
+         .field("pieces_done", done)
+         .field("num_pieces",  total)
+         .field("progress",    total > 0 ? double(done) / total : (st == job_state::done ? 1.0 : 0.0))
+         .field("elapsed_ms",  static_cast<std::int64_t>(elapsed))
+         .field("source",      j.source);
+        if (!j.output.empty()) w.field("output", j.output);
+        if (st == job_state::failed) {
+            std::lock_guard<std::mutex> jl(j.m);
+            w.field("error", j.error);
+        }
+        w.end_object();
+    }
+
+private:
+    void dispatch()
+    {
+        for (;;) {
+            job_ptr j;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                if (m_running >= m_limit || m_waiting.empty()) return;
+                j = m_waiting.front();
+                m_waiting.pop_front();
+                ++m_running;
+            }
+            if (!g_jobs.post(j->lane, [this, j] { run(j); })) {
+                {
+                    std::lock_guard<std::mutex> lk(m_mtx);
+                    --m_running;
+                }
+                fail(j, "job queue full");
+            }
+        }
+    }
+
+    void run(job_ptr const& j)
+    {
+        j->state = job_state::hashing;
+        j->emit();
+
+        auto last = create_job::clock::now();
+        auto on_progress = [&](int done, int total) {
+            j->num_pieces.store(total, std::memory_order_relaxed);
+            j->pieces_done.store(done, std::memory_order_relaxed);
+            auto const now = create_job::clock::now();
+            if (now - last < progress_interval) return;
+            last = now;
+            j->emit();
+        };
+
+        error_code ec;
+        std::vector<char> buf;
+        try { buf = cached_hash_torrent(j->source, j->trackers, &j->cancel, on_progress, ec); }
+        catch (std::exception const& e) { ec = boost::asio::error::fault; LOGE("create job: %s", e.what()); }
+
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            --m_running;
+        }
+
+        if (j->cancel.load())
+            finish(j, job_state::cancelled);
+        else if (ec || buf.empty())
+            fail(j, ec ? ec.message() : "no files");
+        else if (!j->output.empty() && !write_buffer_file(j->output, buf))
+            fail(j, "cannot write " + j->output);
+        else {
+            if (j->output.empty()) {
+                std::lock_guard<std::mutex> jl(j->m);
+                j->bytes = std::move(buf);
+            }
+            finish(j, job_state::done);
+        }
+        dispatch();
+    }
+
+    void fail(job_ptr const& j, std::string msg)
+    {
+        {
+            std::lock_guard<std::mutex> jl(j->m);
+            j->error = std::move(msg);
+        }
+        finish(j, job_state::failed);
+    }
+
+    void finish(job_ptr const& j, job_state st)
+    {
+        j->elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            create_job::clock::now() - j->created).count();
+        j->state = st;
+        j->emit();
+
+        // results nobody collects must not pile up
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_finished.push_back(j->id);
+        while (m_finished.size() > max_finished) {
+            auto it = m_jobs.find(m_finished.front());
+            if (it != m_jobs.end() && it->second->finished()) m_jobs.erase(it);
+            m_finished.pop_front();
+        }
+    }
+
+    mutable std::mutex                       m_mtx;
+    std::unordered_map<std::int64_t, job_ptr> m_jobs;
+    std::deque<job_ptr>                      m_waiting;
+    std::deque<std::int64_t>                 m_finished;
+    std::int64_t                             m_next_id = 0;
+    int                                      m_running = 0;
+    int                                      m_limit   = 2;
+};
+
+static create_job_registry g_create_jobs;
+
+// ───────────────────  batch torrent creation  ─────────────────
+// createTorrentsBatch: one torrent per path (a track, or an album key), for
+// seeding a whole library.
+// Files go to the background lane of g_jobs a window at a time, so a batch
+// never holds more than `window` files in memory and other background work
+// still gets its turn. Each file posted to the window is fadvise'd
+// WILLNEED, so the kernel reads it in while the files ahead of it are
+// being hashed; every worker hashes with cores / slots threads, so the
+// whole batch keeps every core busy. Results are reported per file in
+// completion order.
+struct hash_batch {
+    using clock = std::chrono::steady_clock;
+
+    std::int64_t              id = 0;
+    std::vector<std::string>  paths;
+    std::vector<std::string>  trackers;
+    // per album key in paths (by index), the tracks to hash instead of
+    // every audio file of its directory; may be shorter than paths
+    std::vector<std::vector<std::string>> album_tracks;
+    std::atomic<bool>         cancel{false};
+    clock::time_point         started = clock::now();
+
+    // (batch, index into paths, .torrent bytes or empty, error); worker thread
+    std::function<void(hash_batch const&, std::size_t, std::vector<char>&&, std::string const&)> on_result;
+    // (batch, succeeded, failed); once, after the last result or a cancel
+    std::function<void(hash_batch const&, int, int)> on_done;
+
+    // what paths[i] is hashed as
+    std::string source(std::size_t i) const
+    {
+        if (i >= album_tracks.size() || album_tracks[i].empty() || !is_album_key(paths[i])) return paths[i];
+        return album_key(paths[i], album_tracks[i]);
+    }
+
+    // guarded by batch_runner::m_mtx
+    std::size_t next     = 0;
+    int         inflight = 0;
+    int         ok       = 0;
+    int         failed   = 0;
+};
+using batch_ptr = std::shared_ptr<hash_batch>;
+
+class batch_runner {
+public:
+    static constexpr off_t readahead_bytes = 8 << 20;   // per queued file
+
+    std::int64_t start(batch_ptr b)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            b->id = ++m_next_id;
+            m_batches.emplace(b->id, b);
+        }
+        // the first window's cache checks stat and prefetch() opens its
+        // files: not on the caller's (platform) thread
+        if (!g_jobs.post(job_lane::background, [this, b] { feed(b); })) feed(b);
+        return b->id;
+    }
+
+    // stops feeding new files; files being hashed wind down and report
+    // operation_aborted
+    bool cancel(std::int64_t id)
+    {
+        batch_ptr b;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_batches.find(id);
+            if (it == m_batches.end()) return false;
+            b = it->second;
+        }
+        b->cancel = true;
+        feed(b);
+        return true;
+    }
+
+private:
+    static int window()          { return job_executor::background_slots() * 2; }
+    static int threads_per_job()
+    {
+        int const cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        return std::max(1, cores / job_executor::background_slots());
+    }
+
+    // starts the kernel reading `path` ahead of the hasher; for an album
+    // only the first track is read ahead, the rest are just marked
+    // sequential
+    static void prefetch(std::string const& path, off_t willneed = readahead_bytes)
+    {
+        if (is_album_key(path)) {
+            for (auto const& t : album_tracks(path)) {
+                prefetch(t, willneed);
+                willneed = 0;
+            }
+            return;
+        }
+        int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (willneed > 0) ::posix_fadvise(fd, 0, willneed, POSIX_FADV_WILLNEED);
+        ::close(fd);
+    }
+
+    // tops the window up; a file the executor rejects fails right away
+    void feed(batch_ptr const& b)
+    {
+        for (;;) {
+            std::vector<std::size_t> post;
+            bool done = false;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                if (b->cancel.load()) b->next = b->paths.size();
+                while (b->next < b->paths.size() && b->inflight < window()) {
+                    post.push_back(b->next++);
+                    ++b->inflight;
+                }
+                if (b->inflight == 0 && b->next >= b->paths.size())
+                    done = m_batches.erase(b->id) > 0;
+            }
+            if (done && b->on_done) b->on_done(*b, b->ok, b->failed);
+
+            bool rejected = false;
+            for (std::size_t const i : post) {
+                // cached files are answered without touching the audio
+                std::string const source = b->source(i);
+                if (!g_torrent_cache.fresh(source, b->trackers, g_torrent_version.load(),
+                                           g_preamble_seconds.load()))
+                    prefetch(source);
+                if (g_jobs.post(job_lane::background, [this, b, i] { run(b, i); })) continue;
+                report(b, i, {}, "job queue full");
+                rejected = true;
+            }
+            if (!rejected) return;
+        }
+    }
+
+    void run(batch_ptr const& b, std::size_t i)
+    {
+        error_code ec;
+        std::vector<char> buf;
+        try { buf = cached_hash_torrent(b->source(i), b->trackers, &b->cancel, {}, ec, threads_per_job()); }
+        catch (std::exception const& e) { ec = boost::asio::error::fault; LOGE("batch %lld: %s", static_cast<long long>(b->id), e.what()); }
+
+        std::string err;
+        if (ec) err = ec.message();
+        else if (buf.empty()) err = "no files";
+        report(b, i, std::move(buf), err);
+        feed(b);
+    }
+
+    void report(batch_ptr const& b, std::size_t i, std::vector<char>&& buf, std::string const& err)
+    {
+        if (b->on_result) {
+            try { b->on_result(*b, i, std::move(buf), err); }
+            catch (std::exception const& e) { LOGE("batch %lld listener: %s", static_cast<long long>(b->id), e.what()); }
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            --b->inflight;
+            ++(err.empty() ? b->ok : b->failed);
+        }
+    }
+
+    std::mutex                                  m_mtx;
+    std::unordered_map<std::int64_t, batch_ptr> m_batches;
+    std::int64_t                                m_next_id = 0;
+};
+
+static batch_runner g_batches;
+
+// ───────────────────────  piece tracker  ──────────────────────
+// Verified pieces of the torrents something is playing from, shared by the
+// stream server's readers and the playback scheduler. A torrent is tracked
+// while it has at least one user, and piece_finished_alert is only
+// subscribed to while anything is tracked.
+class piece_tracker
+{
+public:
+    // starts tracking `h` (or adds a user to it)
+    void acquire(torrent_handle const& h, int num_pieces)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto& w = m_watch[h];
+            if (w.users++ > 0) return;
+            w.have.assign(std::size_t(num_pieces), false);
+        }
+        update_subscription();
+
+        // pieces finishing while status() runs are already recorded above
+        torrent_status const st = h.status(torrent_handle::query_pieces);
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_watch.find(h);
+            if (it == m_watch.end()) return;
+            auto& have = it->second.have;
+            for (int i = 0; i < num_pieces; ++i) {
+                if (st.is_seeding || (i < st.pieces.size() && st.pieces[piece_index_t(i)]))
+                    have[std::size_t(i)] = true;
+            }
+        }
+        m_cv.notify_all();
+    }
+
+    void release(torrent_handle const& h)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_watch.find(h);
+            if (it == m_watch.end() || --it->second.users > 0) return;
+            m_watch.erase(it);
+        }
+        update_subscription();
+    }
+
+    bool has(torrent_handle const& h, int piece) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        return has_locked(h, piece);
+    }
+
+    // first piece in [from, to] that is not verified yet, to + 1 if none
+    int first_missing(torrent_handle const& h, int from, int to) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (; from <= to; ++from)
+            if (!has_locked(h, from)) break;
+        return from;
+    }
+
+    // blocks until `piece` is verified; false on timeout or once `cancel`
+    // is set (follow that with wake())
+    bool wait(torrent_handle const& h, int piece, std::chrono::seconds timeout,
+              std::atomic<bool> const& cancel)
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        return m_cv.wait_for(lk, timeout, [&] {
+            return cancel.load() || has_locked(h, piece);
+        }) && !cancel.load();
+    }
+
+    void wake()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_cv.notify_all();
+    }
+
+private:
+    struct watch {
+        std::vector<bool> have;
+        int               users = 0;
+    };
+
+    bool has_locked(torrent_handle const& h, int piece) const
+    {
+        auto it = m_watch.find(h);
+        return it != m_watch.end() && piece >= 0
+            && piece < static_cast<int>(it->second.have.size()) && it->second.have[std::size_t(piece)];
+    }
+
+    void update_subscription()
+    {
+        std::lock_guard<std::mutex> sl(m_sub_mtx);
+        bool tracking;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            tracking = !m_watch.empty();
+        }
+        if (tracking && m_sub == 0) {
+            m_sub = g_alerts.subscribe(alert_category::piece_progress, [this](alert* a) {
+                on_piece(*static_cast<piece_finished_alert*>(a));
+            }, piece_finished_alert::alert_type);
+        } else if (!tracking && m_sub != 0) {
+            g_alerts.unsubscribe(m_sub);
+            m_sub = 0;
+        }
+    }
+
+    void on_piece(piece_finished_alert const& a)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_watch.find(a.handle);
+            int const i = static_cast<int>(a.piece_index);
+            if (it == m_watch.end() || i < 0 || i >= static_cast<int>(it->second.have.size())) return;
+            it->second.have[std::size_t(i)] = true;
+        }
+        m_cv.notify_all();
+    }
+
+    mutable std::mutex                            m_mtx;
+    std::condition_variable                       m_cv;
+    std::unordered_map<torrent_handle, watch>     m_watch;
+    std::mutex                                    m_sub_mtx;
+    alert_dispatcher::sub_id                      m_sub = 0;
+};
+
+static piece_tracker g_pieces;
+
+// ──────────────────────  seek index  ──────────────────────────
+// Time → byte map of a torrent's track, read from the container header
+// (seek_index.cpp) through the verified pieces only. `h` must be tracked
+// by g_pieces. seek_index::status::need names the file range that has to
+// arrive before the parse can finish.
+static seek_index::status read_seek_index(torrent_handle const& h, torrent_info const& ti,
+                                          file_index_t f, std::string const& path,
+                                          seek_index::index& out,
+                                          std::int64_t& need_offset, std::int64_t& need_length)
+{
+    file_storage const& fs = ti.files();
+    int fd = -1;
+    auto const read = [&](std::int64_t off, void* buf, std::size_t n) {
+        int const first = static_cast<int>(fs.map_file(f, off, 1).piece);
+        int const last  = static_cast<int>(fs.map_file(f, off + std::int64_t(n) - 1, 1).piece);
+        if (g_pieces.first_missing(h, first, last) <= last) return false;
+        if (fd < 0 && (fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC)) < 0) return false;
+        auto* p = static_cast<char*>(buf);
+        for (std::size_t got = 0; got < n; ) {
+            ssize_t const r = ::pread(fd, p + got, n - got, static_cast<off_t>(off + std::int64_t(got)));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<std::size_t>(r);
+        }
+        return true;
+    };
+    auto const st = seek_index::parse(read, fs.file_size(f), out, need_offset, need_length);
+    if (fd >= 0) ::close(fd);
+    return st;
+}
+
+// ──────────────────────  preamble store  ──────────────────────
+// Preambles (see add_preamble()) of the torrents added from .torrent
+// bytes, keyed by info-hash, until their pieces are on disk. Once the
+// torrent is streamed, played or prefetched, feed() hands the whole pieces
+// a preamble covers to add_piece(), which checks them against the piece
+// hashes like any download: they pass in milliseconds instead of waiting
+// for peers, and a hash_failed_alert on any of them rejects the preamble.
+// The partial piece at its end cannot be checked before the swarm brings
+// the rest of it, so read() serves those bytes from memory ahead of the
+// swarm once every whole piece has passed; when the real piece passes its
+// hash check the two are compared, and a mismatch rejects the preamble
+// (after less than one piece of it was played). Bounded by `budget`,
+// least recently used out first.
+class preamble_store
+{
+public:
+    static constexpr std::size_t budget = 32 * 1024 * 1024;
+
+    // keeps the preamble of a .torrent being added, if it has a usable one
+    void adopt(torrent_info const& ti, bdecode_node const& root)
+    {
+        bdecode_node const p = root.dict_find_dict(preamble_key);
+        if (!p) return;
+        file_storage const& fs = ti.files();
+        string_view const data = p.dict_find_string_value("data");
+        std::int64_t const size = static_cast<std::int64_t>(data.size());
+        // the cut may pass max_preamble_bytes by one frame
+        if (p.dict_find_int_value("file", -1) != 0 || fs.num_files() == 0
+            || fs.file_offset(file_index_t(0)) != 0 || size == 0
+            || size > std::min(fs.file_size(file_index_t(0)), 2 * max_preamble_bytes)) return;
+
+        sha1_hash const key = cache_key(ti.info_hashes());
+        std::lock_guard<std::mutex> lk(m_mtx);
+        record& r = m_records[key];
+        if (r.fed) return;          // the same torrent added again while it plays
+        m_bytes -= r.data.size();
+        r.data.assign(data.begin(), data.end());
+        r.format       = std::string(p.dict_find_string_value("format"));
+        r.duration_ms  = p.dict_find_int_value("duration_ms", 0);
+        r.length       = size;
+        r.piece_length = ti.piece_length();
+        r.whole        = 0;
+        while (r.whole < ti.num_pieces()
+               && std::int64_t(r.whole) * r.piece_length + ti.piece_size(piece_index_t(r.whole)) <= size)
+            ++r.whole;
+        r.tail  = std::int64_t(r.whole) * r.piece_length < size ? r.whole : -1;
+        r.state = phase::pending;
+        r.used  = ++m_clock;
+        m_bytes += r.data.size();
+        trim_locked();
+    }
+
+    // puts the preamble of `h` to work; `h` must be tracked by g_pieces
+    void feed(torrent_handle const& h, torrent_info const& ti)
+    {
+        sha1_hash const key = cache_key(ti.info_hashes());
+        std::vector<std::pair<int, std::vector<char>>> pieces;
+        bool tail_there = false;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_records.find(key);
+            if (it == m_records.end() || it->second.fed || it->second.state != phase::pending) return;
+            record& r = it->second;
+            r.fed    = true;
+            r.handle = h;
+            r.used   = ++m_clock;
+            r.waiting.assign(std::size_t(r.whole), false);
+            for (int i = 0; i < r.whole; ++i) {
+                if (g_pieces.has(h, i)) continue;
+                auto const* p = r.data.data() + std::size_t(i) * std::size_t(r.piece_length);
+                pieces.emplace_back(i, std::vector<char>(p, p + ti.piece_size(piece_index_t(i))));
+                r.waiting[std::size_t(i)] = true;
+                ++r.whole_left;
+            }
+            if (r.tail < 0 && r.whole_left == 0) {
+                settle_locked(r, phase::verified);      // all of it was on disk already
+                return;
+            }
+            tail_there = r.tail >= 0 && g_pieces.has(h, r.tail);
+            m_handles[h] = key;
+        }
+        update_subscription();
+        for (auto& [i, buf] : pieces) h.add_piece(piece_index_t(i), std::move(buf));
+        if (tail_there) check_tail_later(key);
+    }
+
+    // copies preamble bytes at `pos` of file `file` into `buf` (at most
+    // `n`): bytes of the unverified last piece, once every whole piece has
+    // passed; 0 when there are none to serve
+    std::size_t read(torrent_handle const& h, int file, std::int64_t pos, char* buf, std::size_t n)
+    {
+        if (file != 0) return 0;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto const k = m_handles.find(h);
+        if (k == m_handles.end()) return 0;
+        auto const it = m_records.find(k->second);
+        if (it == m_records.end()) return 0;
+        record& r = it->second;
+        if (r.state != phase::pending || r.tail < 0 || r.tail_ok || r.whole_left > 0) return 0;
+        if (pos < std::int64_t(r.tail) * r.piece_length || pos >= r.length) return 0;
+        n = static_cast<std::size_t>(std::min<std::int64_t>(std::int64_t(n), r.length - pos));
+        std::memcpy(buf, r.data.data() + pos, n);
+        r.used = ++m_clock;
+        return n;
+    }
+
+    // {"format","duration_ms","length","state"}; false if `key` came without one
+    bool write_info(sha1_hash const& key, json_writer& w) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) return false;
+        record const& r = it->second;
+        w.begin_object()
+         .field("format",      r.format)
+         .field("duration_ms", r.duration_ms)
+         .field("length",      r.length)
+         .field("state",       r.state == phase::verified ? "verified"
+                             : r.state == phase::rejected ? "rejected" : "pending")
+         .end_object();
+        return true;
+    }
+
+    void clear()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_records.clear();
+            m_handles.clear();
+            m_bytes = 0;
+        }
+        update_subscription();
+    }
+
+private:
+    enum class phase : std::uint8_t { pending, verified, rejected };
+
+    struct record {
+        std::vector<char> data;                 // dropped once settled
+        std::string       format;
+        std::int64_t      duration_ms  = 0;
+        std::int64_t      length       = 0;
+        int               piece_length = 0;
+        int               whole        = 0;     // pieces the preamble holds entirely
+        int               tail         = -1;    // the piece it ends inside, -1 if none
+        std::vector<bool> waiting;              // whole pieces handed to add_piece()
+        int               whole_left   = 0;     // of those, not passed yet
+        bool              tail_ok      = false; // matched its piece before they all passed
+        phase             state        = phase::pending;
+        bool              fed          = false;
+        torrent_handle    handle;
+        std::uint64_t     used         = 0;
+    };
+
+    // the preamble has served its purpose or failed; its bytes go
+    void settle_locked(record& r, phase p)
+    {
+        r.state = p;
+        m_bytes -= r.data.size();
+        std::vector<char>().swap(r.data);
+        if (r.fed) m_handles.erase(r.handle);
+    }
+
+    void trim_locked()
+    {
+        while (m_bytes > budget) {
+            auto victim = m_records.end();
+            for (auto it = m_records.begin(); it != m_records.end(); ++it)
+                if (!it->second.data.empty() && (victim == m_records.end() || it->second.used < victim->second.used))
+                    victim = it;
+            if (victim == m_records.end()) break;
+            m_bytes -= victim->second.data.size();
+            if (victim->second.fed) m_handles.erase(victim->second.handle);
+            m_records.erase(victim);
+        }
+    }
+
+    void update_subscription()
+    {
+        std::lock_guard<std::mutex> sl(m_sub_mtx);
+        bool watching;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            watching = !m_handles.empty();
+        }
+        if (watching && m_subs[0] == 0) {
+            m_subs[0] = g_alerts.subscribe(alert_category::piece_progress, [this](alert* a) {
+                auto const& p = *static_cast<piece_finished_alert*>(a);
+                on_piece(p.handle, static_cast<int>(p.piece_index), true);
+            }, piece_finished_alert::alert_type);
+            m_subs[1] = g_alerts.subscribe(alert_category::status, [this](alert* a) {
+                auto const& p = *static_cast<hash_failed_alert*>(a);
+                on_piece(p.handle, static_cast<int>(p.piece_index), false);
+            }, hash_failed_alert::alert_type);
+        } else if (!watching && m_subs[0] != 0) {
+            for (auto& s : m_subs) { g_alerts.unsubscribe(s); s = 0; }
+        }
+    }
+
+    void on_piece(torrent_handle const& h, int piece, bool passed)
+    {
+        sha1_hash key;
+        bool check_tail = false;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto const k = m_handles.find(h);
+            if (k == m_handles.end()) return;
+            key = k->second;
+            auto const it = m_records.find(key);
+            if (it == m_records.end()) return;
+            record& r = it->second;
+            if (piece >= 0 && piece < r.whole && r.waiting[std::size_t(piece)]) {
+                if (!passed) {
+                    LOGE("preamble of %s fails piece %d; dropped", aux::to_hex(key).c_str(), piece);
+                    settle_locked(r, phase::rejected);
+                } else {
+                    r.waiting[std::size_t(piece)] = false;
+                    if (--r.whole_left == 0 && (r.tail < 0 || r.tail_ok)) settle_locked(r, phase::verified);
+                }
+            } else if (piece == r.tail && passed) {
+                check_tail = true;
+            }
+        }
+        if (check_tail) check_tail_later(key);
+        update_subscription();
+    }
+
+    // compares the partial piece's preamble bytes with the verified ones
+    // on disk, off the alert thread
+    void check_tail_later(sha1_hash const& key)
+    {
+        g_jobs.post(job_lane::background, [this, key] {
+            torrent_index::entry e;
+            if (!g_index.by_hash(key, e)) return;
+            auto const ti = e.handle.torrent_file();
+            if (!ti) return;
+            std::string const path = torrent_file_path(e, ti->files(), file_index_t(0));
+
+            std::int64_t from = 0, length = 0;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                auto it = m_records.find(key);
+                if (it == m_records.end() || it->second.state != phase::pending
+                    || it->second.tail < 0 || it->second.tail_ok) return;
+                from   = std::int64_t(it->second.tail) * it->second.piece_length;
+                length = it->second.length - from;
+            }
+            std::vector<char> disk(static_cast<std::size_t>(length));
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return;
+            std::size_t got = 0;
+            while (got < disk.size()) {
+                ssize_t const r = ::pread(fd, disk.data() + got, disk.size() - got,
+                                          static_cast<off_t>(from + std::int64_t(got)));
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) break;
+                got += static_cast<std::size_t>(r);
+            }
+            ::close(fd);
+            if (got < disk.size()) return;
+
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                auto it = m_records.find(key);
+                if (it == m_records.end() || it->second.state != phase::pending) return;
+                record& r = it->second;
+                bool const same = std::memcmp(r.data.data() + from, disk.data(), disk.size()) == 0;
+                if (!same) {
+                    LOGE("preamble of %s differs from its last piece; dropped", aux::to_hex(key).c_str());
+                    settle_locked(r, phase::rejected);
+                } else if (r.whole_left == 0) {
+                    settle_locked(r, phase::verified);
+                } else {
+                    r.tail_ok = true;
+                }
+            }
+            update_subscription();
+        });
+    }
+
+    mutable std::mutex                            m_mtx;
+    std::unordered_map<sha1_hash, record>         m_records;
+    std::unordered_map<torrent_handle, sha1_hash> m_handles;     // fed and pending
+    std::size_t                                   m_bytes = 0;
+    std::uint64_t                                 m_clock = 0;
+    std::mutex                                    m_sub_mtx;
+    alert_dispatcher::sub_id                      m_subs[2] = {0, 0};
+};
+
+static preamble_store g_preambles;
+
+// ─────────────────  playback deadline scheduler  ──────────────
+// Makes piece priority follow the player's play head rather than the
+// rarest-first picker. The player reports its position (and the track's
+// bitrate, or its duration) about once a second; the pieces covering the
+// next `window` seconds of audio get set_piece_deadline()s timed to when
+// playback will reach them, so the time-critical picker fetches them in
+// play order.
+//
+// Positions map to bytes through the track's seek index once its header
+// pieces are in – those get the earliest deadlines – so a seek into a VBR
+// track asks for exactly the pieces holding that timestamp. Until then, and
+// for containers without one, the byte rate is taken as constant.
+//
+// The window starts narrow and doubles while the verified buffer keeps up
+// with it, up to max_window_s; when the buffer runs low it falls back to
+// the narrow window so the swarm's bandwidth goes to the next few seconds.
+// A seek – flagged by the player, or a jump in the reported position –
+// drops the old deadlines and schedules the new window right away. Every
+// update reports the buffer health, seconds of verified audio ahead of the
+// play head, and counts underruns: the times the play head caught up with
+// the download.
+class playback_scheduler
+{
+public:
+    struct health {
+        std::int64_t position_ms = 0;
+        std::int64_t offset      = 0;       // play head, bytes into the file
+        double       buffer_s    = 0;
+        int          window_s    = 0;
+        int          first_piece = 0;       // deadline window, inclusive
+        int          last_piece  = -1;
+        int          underruns   = 0;
+        std::int64_t underrun_ms = 0;
+        bool         playing     = false;
+        char const*  index       = "none";  // container of the seek index in use
+    };
+
+    // `bitrate_kbps` 0 derives the byte rate from `duration_ms` and the
+    // file size; false for a bad file index or while there is no metadata
+    bool update(torrent_index::entry const& e, int file, std::int64_t position_ms,
+                std::int64_t duration_ms, int bitrate_kbps, bool playing, bool seek,
+                health& out)
+    {
+        torrent_handle const& h = e.handle;
+        key const k{h, file};
+        bool known, want_index = false;
+        std::shared_ptr<torrent_info const> ti;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_heads.find(k);
+            known = it != m_heads.end();
+            if (known) {
+                want_index = !it->second.indexed && !it->second.unindexable;
+                ti = it->second.ti;
+            }
+        }
+        if (!known) {
+            if (!begin(h, file)) return false;
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_heads.find(k);
+            if (it == m_heads.end()) return false;
+            want_index = !it->second.indexed && !it->second.unindexable;
+            ti = it->second.ti;
+        }
+
+        // header reads stay outside m_mtx; at most one parse per update
+        seek_index::index idx;
+        std::int64_t need_offset = 0, need_length = 0;
+        auto st = seek_index::status::need;
+        if (want_index) {
+            st = read_seek_index(h, *ti, file_index_t(file), torrent_file_path(e, ti->files(), file_index_t(file)),
+                                 idx, need_offset, need_length);
+        }
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_heads.find(k);
+        if (it == m_heads.end()) return false;      // stopped meanwhile
+        playhead& p = it->second;
+        file_storage const& fs = p.ti->files();
+        auto const now = clock::now();
+        std::int64_t const elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - p.updated).count();
+
+        bool remap = false;     // re-place the window with the real map
+        if (want_index && !p.indexed) {
+            if (st == seek_index::status::ok) {
+                p.idx     = std::move(idx);
+                p.indexed = true;
+                remap     = true;
+            } else if (st == seek_index::status::none) {
+                p.unindexable = true;
+            } else {
+                fetch_header(h, p, need_offset, need_length);
+            }
+        }
+
+        std::int64_t rate = bitrate_kbps > 0 ? std::int64_t(bitrate_kbps) * 1000 / 8
+                          : duration_ms > 0 ? p.size * 1000 / duration_ms : 0;
+        if (rate <= 0) rate = default_byte_rate;
+
+        // the play head moves on its own while playing; anything further
+        // off than that is a seek the player did not flag
+        if (p.scheduled && !seek) {
+            std::int64_t const expected = p.position_ms + (p.playing ? elapsed_ms : 0);
+            seek = std::abs(position_ms - expected) > seek_tolerance_ms;
+        }
+        bool const resumed = playing && !p.playing;
+        p.rate        = rate;
+        p.position_ms = position_ms;
+        p.offset      = p.byte_at(position_ms);
+        p.playing     = playing;
+        p.updated     = now;
+
+        // verified audio ahead of the play head
+        int const head = piece_at(fs, p.file, p.offset);
+        int const tail = piece_at(fs, p.file, p.size - 1);
+        int const missing = g_pieces.first_missing(h, head, tail);
+        std::int64_t const buffered_to = missing > tail ? p.size
+            : std::max(p.offset, piece_start(*p.ti, p.file, missing));
+        double const buffer_s = std::max<std::int64_t>(0, p.ms_at(buffered_to) - position_ms) / 1000.0;
+
+        if (playing && buffered_to == p.offset) {
+            if (p.underrun) p.underrun_ms += elapsed_ms;
+            else { p.underrun = true; ++p.underruns; }
+        } else {
+            p.underrun = false;
+        }
+
+        int const old_window = p.window_s;
+        if (seek) p.window_s = min_window_s;
+        else if (buffer_s >= p.window_s * 0.75) p.window_s = std::min(max_window_s, p.window_s * 2);
+        else if (buffer_s < min_window_s / 2.0) p.window_s = min_window_s;
+
+        reschedule(h, p, seek || remap || resumed || p.window_s != old_window || !p.scheduled);
+
+        out.position_ms = position_ms;
+        out.offset      = p.offset;
+        out.buffer_s    = buffer_s;
+        out.window_s    = p.window_s;
+        out.first_piece = p.first;
+        out.last_piece  = p.last;
+        out.underruns   = p.underruns;
+        out.underrun_ms = p.underrun_ms;
+        out.playing     = playing;
+        out.index       = p.indexed ? p.idx.format : "none";
+        return true;
+    }
+
+    // hands the window's pieces back to the regular picker
+    bool stop(torrent_handle const& h, int file)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto it = m_heads.find(key{h, file});
+            if (it == m_heads.end()) return false;
+            if (h.is_valid()) {
+                playhead const& p = it->second;
+                for (int i = p.first; i <= p.last; ++i)
+                    if (!g_pieces.has(h, i)) h.reset_piece_deadline(piece_index_t(i));
+                for (int const i : p.header)
+                    if (!g_pieces.has(h, i)) h.reset_piece_deadline(piece_index_t(i));
+            }
+            m_heads.erase(it);
+        }
+        g_pieces.release(h);
+        return true;
+    }
+
+    // on session shutdown; the torrents are going away with it
+    void clear()
+    {
+        std::map<key, playhead> heads;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            heads.swap(m_heads);
+        }
+        for (auto const& p : heads) g_pieces.release(p.first.first);
+    }
+
+    // whether a player is reporting its play head for `file` of `h`
+    bool drives(torrent_handle const& h, int file) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        return m_heads.count(key{h, file}) > 0;
+    }
+
+    // whether a player is reporting a play head for any file of `h`
+    bool plays(torrent_handle const& h) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto const it = m_heads.lower_bound(key{h, 0});
+        return it != m_heads.end() && it->first.first == h;
+    }
+
+    // whether `piece` of `h` is inside some play head's deadline window
+    bool covers(torrent_handle const& h, int piece) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (auto it = m_heads.lower_bound(key{h, 0}); it != m_heads.end() && it->first.first == h; ++it) {
+            playhead const& p = it->second;
+            if (piece >= p.first && piece <= p.last) return true;
+            if (std::find(p.header.begin(), p.header.end(), piece) != p.header.end()) return true;
+        }
+        return false;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+    using key   = std::pair<torrent_handle, int>;
+
+    static constexpr int          min_window_s      = 8;
+    static constexpr int          max_window_s      = 120;
+    static constexpr std::int64_t seek_tolerance_ms = 3000;
+    static constexpr std::int64_t default_byte_rate = 320 * 1000 / 8;
+
+    struct playhead {
+        std::shared_ptr<torrent_info const> ti;
+        file_index_t  file;
+        std::int64_t  size        = 0;
+        std::int64_t  position_ms = 0;
+        std::int64_t  offset      = 0;
+        std::int64_t  rate        = default_byte_rate;  // bytes per second, without an index
+        seek_index::index idx;
+        bool          indexed     = false;
+        bool          unindexable = false;
+        std::vector<int> header;            // pieces the seek index is waiting for
+        int           window_s    = min_window_s;
+        int           first       = 0;      // pieces holding a deadline
+        int           last        = -1;
+        bool          scheduled   = false;
+        bool          playing     = false;
+        bool          underrun    = false;
+        int           underruns   = 0;
+        std::int64_t  underrun_ms = 0;
+        clock::time_point updated = clock::now();
+
+        std::int64_t byte_at(std::int64_t ms) const
+        {
+            std::int64_t const b = indexed ? idx.byte_at(ms) : ms * rate / 1000;
+            return std::clamp<std::int64_t>(b, 0, size - 1);
+        }
+
+        std::int64_t ms_at(std::int64_t b) const
+        {
+            return indexed ? idx.ms_at(b) : b * 1000 / rate;
+        }
+    };
+
+    static int piece_at(file_storage const& fs, file_index_t f, std::int64_t offset)
+    {
+        return static_cast<int>(fs.map_file(f, offset, 1).piece);
+    }
+
+    // where piece `i` starts, relative to the start of file `f`
+    static std::int64_t piece_start(torrent_info const& ti, file_index_t f, int i)
+    {
+        return std::int64_t(i) * ti.piece_length() - ti.files().file_offset(f);
+    }
+
+    // fetches the metadata outside m_mtx – torrent_file() waits on the
+    // network thread
+    bool begin(torrent_handle const& h, int file)
+    {
+        auto ti = h.torrent_file();
+        if (!ti) return false;
+        file_storage const& fs = ti->files();
+        if (file < 0 || file >= fs.num_files() || fs.pad_file_at(file_index_t(file))
+            || fs.file_size(file_index_t(file)) == 0) return false;
+        file_index_t const f(file);
+
+        // a track the user left unselected in an album is wanted after
+        // all, and paused torrents ignore deadlines
+        if (h.file_priority(f) == dont_download) h.file_priority(f, default_priority);
+        h.resume();
+
+        g_pieces.acquire(h, ti->num_pieces());
+        g_preambles.feed(h, *ti);
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            auto const ins = m_heads.emplace(key{h, file}, playhead{});
+            if (ins.second) {
+                playhead& p = ins.first->second;
+                p.ti   = std::move(ti);
+                p.file = f;
+                p.size = fs.file_size(f);
+                return true;
+            }
+        }
+        g_pieces.release(h);        // another update got there first
+        return true;
+    }
+
+    // the bytes the seek index still needs come before everything else
+    static void fetch_header(torrent_handle const& h, playhead& p, std::int64_t offset, std::int64_t length)
+    {
+        file_storage const& fs = p.ti->files();
+        if (length <= 0 || offset < 0 || offset + length > p.size) return;
+        int const first = piece_at(fs, p.file, offset);
+        int const last  = piece_at(fs, p.file, offset + length - 1);
+        for (int i = first; i <= last; ++i) {
+            if (g_pieces.has(h, i)
+                || std::find(p.header.begin(), p.header.end(), i) != p.header.end()) continue;
+            h.set_piece_deadline(piece_index_t(i), 0);
+            p.header.push_back(i);
+        }
+    }
+
+    // moves the deadline window to the play head; `all` re-times every
+    // piece in it (after a seek, a resume or a resize), otherwise only the
+    // pieces the window slid onto get a deadline
+    static void reschedule(torrent_handle const& h, playhead& p, bool all)
+    {
+        file_storage const& fs = p.ti->files();
+        std::int64_t const ahead = p.byte_at(p.position_ms + std::int64_t(p.window_s) * 1000);
+        int const first = piece_at(fs, p.file, p.offset);
+        int const last  = piece_at(fs, p.file, std::max(ahead, p.offset));
+
+        for (int i = p.first; i <= p.last; ++i)
+            if ((i < first || i > last) && !g_pieces.has(h, i)) h.reset_piece_deadline(piece_index_t(i));
+
+        int const from = (all || !p.scheduled) ? first : std::max(first, p.last + 1);
+        for (int i = from; i <= last; ++i) {
+            if (g_pieces.has(h, i)) continue;
+            // half of the time until playback gets there, leaving the other
+            // half for the transfer itself
+            std::int64_t const start   = std::max(p.offset, piece_start(*p.ti, p.file, i));
+            std::int64_t const until_ms = std::max<std::int64_t>(0, p.ms_at(start) - p.position_ms);
+            h.set_piece_deadline(piece_index_t(i), static_cast<int>(std::min<std::int64_t>(until_ms / 2, std::numeric_limits<int>::max())));
+        }
+        p.first     = first;
+        p.last      = last;
+        p.scheduled = true;
+    }
+
+    mutable std::mutex          m_mtx;
+    std::map<key, playhead>     m_heads;
+};
+
+static playback_scheduler g_playback;
+
+// ─────────────────────  upcoming-track prefetch  ──────────────
+// Downloads the opening seconds of the next tracks in the play queue
+// before the current one ends, so a swarm track starts without a gap. The
+// player hands over its upcoming queue in play order (shuffle applied)
+// whenever it changes; the first `tracks` swarm entries get the pieces
+// covering their first `seconds` of audio – plus any header range their
+// seek index still needs, an m4a moov at the end, say – raised to a piece
+// priority above the default, the next track highest. Priorities never
+// preempt the time-critical picker, so the play head window of the current
+// track always goes first; prefetch only competes with the rest of the
+// download.
+//
+// Missing bytes across all entries stay within `budget` – later entries
+// get what the earlier ones leave. Pieces that drop out of the queue get
+// their previous priority back unless someone changed it meanwhile (a
+// play head selecting the file, say), and a torrent prefetch had to
+// resume is paused again once none of its tracks is queued or playing.
+class prefetch_manager
+{
+public:
+    struct item {
+        sha1_hash    key;
+        int          file         = 0;
+        std::int64_t starts_in_ms = -1;     // -1: unknown, spaced by default_lead_ms
+    };
+
+    void configure(int seconds, int tracks, std::int64_t budget)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (seconds > 0) m_seconds = std::min(seconds, 300);
+        if (tracks >= 0) m_tracks  = std::min(tracks, 16);
+        if (budget >= 0) m_budget  = budget;
+    }
+
+    // replaces the upcoming queue; unknown torrents and bad file indices
+    // are skipped
+    void set_queue(std::vector<item> const& queue)
+    {
+        std::lock_guard<std::mutex> ql(m_queue_mtx);
+        int seconds, tracks;
+        std::int64_t budget;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            seconds = m_seconds;
+            tracks  = m_tracks;
+            budget  = m_budget;
+        }
+
+        // plan outside m_mtx: metadata and header reads wait on the
+        // network thread and the disk
+        std::map<key, entry> next;
+        std::int64_t used = 0;
+        int rank = 0;
+        for (item const& it : queue) {
+            if (rank >= tracks) break;
+            torrent_index::entry e;
+            if (!g_index.by_hash(it.key, e)) continue;
+            auto ti = e.handle.torrent_file();
+            if (!ti) continue;
+            file_storage const& fs = ti->files();
+            if (it.file < 0 || it.file >= fs.num_files() || fs.pad_file_at(file_index_t(it.file))
+                || fs.file_size(file_index_t(it.file)) == 0) continue;
+            key const k{e.handle, it.file};
+            if (next.count(k)) continue;
+
+            g_pieces.acquire(e.handle, ti->num_pieces());
+            g_preambles.feed(e.handle, *ti);
+            entry& n = next[k];
+            n.key          = it.key;
+            n.starts_in_ms = it.starts_in_ms >= 0 ? it.starts_in_ms : default_lead_ms * (rank + 1);
+            n.starts_in_ms = std::max(n.starts_in_ms, min_lead_ms);
+            n.rank         = rank;
+            plan(e, std::move(ti), file_index_t(it.file), seconds, budget - used, n);
+            used += n.bytes;
+            ++rank;
+        }
+
+        std::map<key, entry> old;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            old.swap(m_entries);
+            m_entries = next;
+            m_used    = used;
+        }
+
+        // the priority each missing piece is due, the earlier entry's when
+        // two tracks share a piece
+        std::map<piece_key, download_priority_t> want;
+        std::set<torrent_handle> fetching;
+        for (auto const& n : next) {
+            torrent_handle const& h = n.first.first;
+            download_priority_t const prio(static_cast<std::uint8_t>(
+                std::max(int(static_cast<std::uint8_t>(top_priority)) - n.second.rank, min_priority)));
+            for (int const p : n.second.pieces) {
+                if (g_pieces.has(h, p)) continue;
+                auto const ins = want.emplace(piece_key{h, p}, prio);
+                if (!ins.second && prio > ins.first->second) ins.first->second = prio;
+                fetching.insert(h);
+            }
+        }
+        restore(want, fetching);
+
+        for (auto const& w : want) {
+            torrent_handle const& h = w.first.first;
+            piece_index_t const p(w.first.second);
+            auto const it = m_raised.find(w.first);
+            if (it == m_raised.end()) {
+                download_priority_t const prev = h.piece_priority(p);
+                if (prev >= w.second) continue;     // already wanted as much
+                m_raised.emplace(w.first, raised{prev, w.second});
+            } else if (it->second.set == w.second) {
+                continue;
+            } else {
+                it->second.set = w.second;
+            }
+            h.piece_priority(p, w.second);
+        }
+        // a paused torrent fetches nothing
+        for (torrent_handle const& h : fetching) {
+            if (!(h.flags() & paused)) continue;
+            h.resume();
+            m_resumed.insert(h);
+        }
+        // every planned entry holds its own reference; the previous
+        // queue's go now
+        for (auto const& o : old) g_pieces.release(o.first.first);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> ql(m_queue_mtx);
+        std::map<key, entry> old;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            old.swap(m_entries);
+            m_used = 0;
+        }
+        restore({}, {});
+        for (auto const& o : old) g_pieces.release(o.first.first);
+    }
+
+    // {"seconds","tracks","budget","used","entries":[{"info_hash","file_index",
+    //  "first_piece","last_piece","pieces","done","bytes","starts_in_ms"}]}
+    void write_stats(json_writer& w) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        w.begin_object()
+         .field("seconds", m_seconds)
+         .field("tracks",  m_tracks)
+         .field("budget",  m_budget)
+         .field("used",    m_used)
+         .key("entries").begin_array();
+        for (auto const& e : m_entries) {
+            int done = 0;
+            for (int const p : e.second.pieces) done += g_pieces.has(e.first.first, p) ? 1 : 0;
+            w.begin_object()
+             .field("info_hash",    aux::to_hex(e.second.key))
+             .field("file_index",   e.first.second)
+             .field("first_piece",  e.second.pieces.empty() ? -1 : e.second.pieces.front())
+             .field("last_piece",   e.second.pieces.empty() ? -1 : e.second.pieces.back())
+             .field("pieces",       static_cast<int>(e.second.pieces.size()))
+             .field("done",         done)
+             .field("bytes",        e.second.bytes)
+             .field("starts_in_ms", e.second.starts_in_ms)
+             .end_object();
+        }
+        w.end_array().end_object();
+    }
+
+private:
+    using key = std::pair<torrent_handle, int>;
+
+    static constexpr std::int64_t default_lead_ms   = 60 * 1000;
+    // never ahead of the current track's next few seconds
+    static constexpr std::int64_t min_lead_ms       = 10 * 1000;
+    // the lowest priority a queued track gets, still above the default
+    static constexpr int          min_priority      = static_cast<std::uint8_t>(default_priority) + 1;
+    static constexpr std::int64_t default_byte_rate = 320 * 1000 / 8;
+
+    struct entry {
+        sha1_hash        key;
+        std::vector<int> pieces;            // in fetch order, header range first
+        std::int64_t     bytes        = 0;  // of those, still missing
+        std::int64_t     starts_in_ms = 0;
+        int              rank         = 0;  // place among the prefetched tracks
+    };
+
+    // (torrent, piece)
+    using piece_key = std::pair<torrent_handle, int>;
+
+    struct raised {
+        download_priority_t prev;           // before prefetch raised it
+        download_priority_t set;            // what prefetch set
+    };
+
+    // hands back every raised piece not in `want`, and pauses the torrents
+    // prefetch resumed that are neither in `fetching` nor playing; under
+    // m_queue_mtx
+    void restore(std::map<piece_key, download_priority_t> const& want, std::set<torrent_handle> const& fetching)
+    {
+        for (auto it = m_raised.begin(); it != m_raised.end(); ) {
+            if (want.count(it->first)) { ++it; continue; }
+            torrent_handle const& h = it->first.first;
+            piece_index_t const p(it->first.second);
+            if (h.is_valid() && h.piece_priority(p) == it->second.set) h.piece_priority(p, it->second.prev);
+            it = m_raised.erase(it);
+        }
+        for (auto it = m_resumed.begin(); it != m_resumed.end(); ) {
+            if (fetching.count(*it)) { ++it; continue; }
+            // a track of it is playing now: the player's to pause
+            if (it->is_valid() && !g_playback.plays(*it)) it->pause();
+            it = m_resumed.erase(it);
+        }
+    }
+
+    // pieces for the first `seconds` of file `f`, cut off at `budget`
+    // missing bytes
+    static void plan(torrent_index::entry const& e, std::shared_ptr<torrent_info const> ti,
+                     file_index_t f, int seconds, std::int64_t budget, entry& out)
+    {
+        torrent_handle const& h = e.handle;
+        file_storage const& fs = ti->files();
+        std::int64_t const size = fs.file_size(f);
+
+        seek_index::index idx;
+        std::int64_t need_offset = 0, need_length = 0;
+        auto const st = read_seek_index(h, *ti, f, torrent_file_path(e, fs, f), idx, need_offset, need_length);
+        std::int64_t const end = st == seek_index::status::ok
+            ? idx.byte_at(std::int64_t(seconds) * 1000)
+            : std::int64_t(seconds) * default_byte_rate;
+
+        std::vector<int> want;
+        int const last = static_cast<int>(fs.map_file(f, std::clamp<std::int64_t>(end, 0, size - 1), 1).piece);
+        for (int i = static_cast<int>(fs.map_file(f, 0, 1).piece); i <= last; ++i) want.push_back(i);
+        if (st == seek_index::status::need && need_length > 0 && need_offset + need_length <= size) {
+            int const a = static_cast<int>(fs.map_file(f, need_offset, 1).piece);
+            int const b = static_cast<int>(fs.map_file(f, need_offset + need_length - 1, 1).piece);
+            // the header range goes first: without it the player cannot start
+            std::vector<int> head;
+            for (int i = a; i <= b; ++i)
+                if (std::find(want.begin(), want.end(), i) == want.end()) head.push_back(i);
+            want.insert(want.begin(), head.begin(), head.end());
+        }
+
+        for (int const p : want) {
+            std::int64_t const n = g_pieces.has(h, p) ? 0 : ti->piece_size(piece_index_t(p));
+            if (out.bytes + n > budget) break;
+            out.bytes += n;
+            out.pieces.push_back(p);
+        }
+    }
+
+    std::mutex              m_queue_mtx;        // one queue change at a time
+    mutable std::mutex      m_mtx;
+    std::map<key, entry>    m_entries;
+    // only touched under m_queue_mtx
+    std::map<piece_key, raised> m_raised;
+    std::set<torrent_handle>    m_resumed;
+    int                     m_seconds = 20;
+    int                     m_tracks  = 2;
+    std::int64_t            m_budget  = 32 * 1024 * 1024;
+    std::int64_t            m_used    = 0;
+};
+
+static prefetch_manager g_prefetch;
+
+// ─────────────────────  playback read cache  ──────────────────
+// Pieces the stream server has read back from disk, keyed by (info-hash,
+// piece) and shared by every reader: scrubbing back, a replay, or the
+// second connection a player opens to probe a header is answered from RAM
+// with neither a disk read nor a swarm round trip. A piece cannot change
+// after passing its hash check, so entries never go stale; a removed
+// torrent's just age out. Least recently used first out within
+// `capacity` bytes (0 turns the cache off). trim() takes the OS's memory
+// pressure level (Android's onTrimMemory) and gives memory back.
+class piece_cache
+{
+public:
+    using buffer = std::shared_ptr<std::vector<char> const>;
+
+    static constexpr std::size_t default_capacity = 32 * 1024 * 1024;
+
+    buffer get(sha1_hash const& ih, int piece)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = m_map.find(key{ih, piece});
+        if (it == m_map.end()) { ++m_misses; return {}; }
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        ++m_hits;
+        return it->second->second;
+    }
+
+    void put(sha1_hash const& ih, int piece, buffer b)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!b || b->size() > m_capacity) return;
+        key const k{ih, piece};
+        auto it = m_map.find(k);
+        if (it != m_map.end()) {
+            m_bytes -= it->second->second->size();
+            m_lru.erase(it->second);
+            m_map.erase(it);
+        }
+        m_bytes += b->size();
+        m_lru.emplace_front(k, std::move(b));
+        m_map.emplace(k, m_lru.begin());
+        evict_locked(m_capacity);
+    }
+
+    void set_capacity(std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_capacity = bytes;
+        evict_locked(bytes);
+    }
+
+    // ComponentCallbacks2 levels: COMPLETE (80), MODERATE (60) and
+    // RUNNING_CRITICAL (15) empty the cache, the other pressure levels
+    // halve it; UI_HIDDEN (20) alone is no pressure – music plays on
+    void trim(int level)
+    {
+        if (level == 20) return;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        evict_locked(level >= 60 || level == 15 ? 0 : m_bytes / 2);
+        ++m_trims;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        evict_locked(0);
+    }
+
+    // {"capacity","bytes","entries","hits","misses","hit_rate","evictions","trims"}
+    void write_stats(json_writer& w) const
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        std::uint64_t const lookups = m_hits + m_misses;
+        w.begin_object()
+         .field("capacity",  static_cast<std::uint64_t>(m_capacity))
+         .field("bytes",     static_cast<std::uint64_t>(m_bytes))
+         .field("entries",   static_cast<std::uint64_t>(m_map.size()))
+         .field("hits",      m_hits)
+         .field("misses",    m_misses)
+         .field("hit_rate",  lookups ? double(m_hits) / double(lookups) : 0.0)
+         .field("evictions", m_evictions)
+         .field("trims",     m_trims)
+         .end_object();
+    }
+
+private:
+    struct key {
+        sha1_hash ih;
+        int       piece;
+        bool operator==(key const& o) const { return piece == o.piece && ih == o.ih; }
+    };
+    struct key_hash {
+        std::size_t operator()(key const& k) const
+        { return std::hash<sha1_hash>()(k.ih) ^ (std::size_t(k.piece) * 0x9E3779B97F4A7C15ull); }
+    };
+    using lru_list = std::list<std::pair<key, buffer>>;
+
+    void evict_locked(std::size_t keep)
+    {
+        while (m_bytes > keep && !m_lru.empty()) {
+            m_bytes -= m_lru.back().second->size();
+            m_map.erase(m_lru.back().first);
+            m_lru.pop_back();
+            ++m_evictions;
+        }
+    }
+
+    mutable std::mutex                                           m_mtx;
+    lru_list                                                     m_lru;       // most recent first
+    std::unordered_map<key, lru_list::iterator, key_hash>        m_map;
+    std::size_t                                                  m_capacity  = default_capacity;
+    std::size_t                                                  m_bytes     = 0;
+    std::uint64_t                                                m_hits      = 0;
+    std::uint64_t                                                m_misses    = 0;
+    std::uint64_t                                                m_evictions = 0;
+    std::uint64_t                                                m_trims     = 0;
+};
+
+static piece_cache g_piece_cache;
+
+// ───────────────────────  stream server  ──────────────────────
+// Loopback HTTP/1.1 server that lets the player start a swarm track long
+// before it has finished downloading:
+//
+//   GET | HEAD  /stream/<info-hash>/<file-index>     (Range: bytes=…)
+//
+// A request's byte range is mapped onto pieces, and the pieces just ahead
+// of the reader get staggered set_piece_deadline()s, so the time-critical
+// picker fetches them in playback order; a seek makes a new request, which
+// drops the old deadlines and sets new ones. Once the player reports its
+// play head, g_playback owns the deadlines of that file and the reader only
+// asks for a piece it is blocked on outside the play-head window. A reader
+// blocks until its piece has passed the hash check (g_pieces) and then
+// takes it from g_piece_cache or straight from the file, so no piece is
+// copied through the alert queue and nothing unverified is served – apart from the tail of a
+// catalog preamble (g_preambles), which lets playback start before the
+// first peer answers. Listens on 127.0.0.1 only, one thread per
+// connection – a player holds one or two.
+class stream_server
+{
+public:
+    // binds 127.0.0.1:`port` (0 = any free one) unless already running;
+    // the port it listens on, or -1
+    int start(int port = 0)
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_listen >= 0) return m_stop ? -1 : m_port;
+
+        int const fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int const one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons(static_cast<std::uint16_t>(port));
+        socklen_t len = sizeof addr;
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0
+            || ::listen(fd, 8) != 0
+            || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            LOGE("stream server: %s", std::strerror(errno));
+            ::close(fd);
+            return -1;
+        }
+        m_listen = fd;
+        m_port   = ntohs(addr.sin_port);
+        m_stop   = false;
+        m_accept = std::thread([this] { accept_loop(); });
+        LOGI("stream server on 127.0.0.1:%d", m_port);
+        return m_port;
+    }
+
+    // closes every connection and waits for their threads
+    void stop()
+    {
+        std::thread accept;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_listen < 0 || m_stop) return;
+            m_stop = true;
+            ::shutdown(m_listen, SHUT_RDWR);        // wakes accept()
+            for (int const c : m_conns) ::shutdown(c, SHUT_RDWR);
+            accept.swap(m_accept);
+        }
+        g_pieces.wake();        // readers waiting for a piece
+        accept.join();
+
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_cv.wait(lk, [this] { return m_conns.empty(); });
+        ::close(m_listen);
+        m_listen = -1;
+        m_port   = 0;
+    }
+
+    // "http://127.0.0.1:<port>/stream/<key>/<file>", starting the server
+    // on first use; "" if it cannot listen
+    std::string url(sha1_hash const& key, int file)
+    {
+        int const port = start();
+        if (port < 0) return {};
+        return "http://127.0.0.1:" + std::to_string(port) + "/stream/"
+             + aux::to_hex(key) + "/" + std::to_string(file);
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    // the deadline window: this much of the file ahead of the reader, the
+    // next piece due now and each one after it deadline_step_ms later
+    static constexpr std::int64_t window_bytes     = 4 * 1024 * 1024;
+    static constexpr int          deadline_step_ms = 400;
+    // a reader gives up when its piece has not arrived for this long
+    static constexpr auto         stall_timeout    = std::chrono::seconds(30);
+    static constexpr std::size_t  max_header       = 8 * 1024;
+    static constexpr std::size_t  chunk_size       = 256 * 1024;
+
+    struct request {
+        bool         head       = false;
+        bool         keep_alive = true;
+        std::string  hash;
+        int          file       = -1;
+        bool         ranged     = false;
+        std::int64_t first      = 0;    // -1: suffix range of `last` bytes
+        std::int64_t last       = -1;   // -1: to the end
+    };
+
+    void accept_loop()
+    {
+        for (;;) {
+            int const c = ::accept4(m_listen, nullptr, nullptr, SOCK_CLOEXEC);
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                if (m_stop) { if (c >= 0) ::close(c); return; }
+                if (c >= 0) m_conns.insert(c);
+            }
+            if (c < 0) {
+                // EMFILE and the like: back off instead of spinning
+                if (errno != EINTR && errno != ECONNABORTED)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            std::thread([this, c] { serve(c); }).detach();
+        }
+    }
+
+    void serve(int c)
+    {
+        timeval tv{60, 0};      // idle keep-alive connections go away
+        ::setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+        ::setsockopt(c, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+
+        std::string buf;
+        try { while (handle(c, buf)) {} }
+        catch (std::exception const& e) { LOGE("stream server: %s", e.what()); }
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_conns.erase(c);
+        ::close(c);             // under m_mtx: stop() must not shut a reused fd
+        m_cv.notify_all();
+    }
+
+    static bool send_all(int c, char const* p, std::size_t n)
+    {
+        while (n > 0) {
+            ssize_t const r = ::send(c, p, n, MSG_NOSIGNAL);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            p += r;
+            n -= static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    static bool reply(int c, char const* status, std::string const& extra = {})
+    {
+        std::string const r = std::string("HTTP/1.1 ") + status
+            + "\r\nContent-Length: 0\r\n" + extra + "Connection: close\r\n\r\n";
+        send_all(c, r.data(), r.size());
+        return false;
+    }
+
+    static char const* mime_type(std::string const& name)
+    {
+        auto const dot = name.find_last_of('.');
+        std::string ext = dot == std::string::npos ? std::string() : name.substr(dot + 1);
+        for (auto& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        if (ext == "mp3")  return "audio/mpeg";
+        if (ext == "flac") return "audio/flac";
+        if (ext == "m4a")  return "audio/mp4";
+        if (ext == "wav")  return "audio/wav";
+        return "application/octet-stream";
+    }
+
+    static bool iequals_prefix(std::string_view s, std::string_view prefix)
+    {
+        if (s.size() < prefix.size()) return false;
+        for (std::size_t i = 0; i < prefix.size(); ++i)
+            if (std::tolower(static_cast<unsigned char>(s[i])) != prefix[i]) return false;
+        return true;
+    }
+
+    static bool parse_int(std::string_view s, std::int64_t& out)
+    {
+        if (s.empty()) return false;
+        auto const r = std::from_chars(s.data(), s.data() + s.size(), out);
+        return r.ec == std::errc() && r.ptr == s.data() + s.size() && out >= 0;
+    }
+
+    // request line and the two headers that matter; only the first range
+    // of a multi-range request is honoured
+    static bool parse_request(std::string_view head, request& req)
+    {
+        auto const eol = head.find("\r\n");
+        std::string_view const line = head.substr(0, eol);
+        auto const sp1 = line.find(' ');
+        auto const sp2 = line.find(' ', sp1 == std::string_view::npos ? sp1 : sp1 + 1);
+        if (sp1 == std::string_view::npos || sp2 == std::string_view::npos) return false;
+
+        std::string_view const method = line.substr(0, sp1);
+        if (method == "HEAD") req.head = true;
+        else if (method != "GET") return false;
+        req.keep_alive = line.substr(sp2 + 1) != "HTTP/1.0";
+
+        std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        target = target.substr(0, target.find('?'));
+        constexpr std::string_view prefix = "/stream/";
+        if (target.substr(0, prefix.size()) != prefix) return false;
+        target.remove_prefix(prefix.size());
+        auto const slash = target.find('/');
+        if (slash == std::string_view::npos) return false;
+        req.hash = std::string(target.substr(0, slash));
+        target.remove_prefix(slash + 1);
+        target = target.substr(0, target.find('/'));       // a trailing file name is ignored
+        std::int64_t file;
+        if (!parse_int(target, file) || file > std::numeric_limits<int>::max()) return false;
+        req.file = static_cast<int>(file);
+
+        for (std::size_t pos = eol; pos != std::string_view::npos && pos + 2 < head.size(); ) {
+            auto const next = head.find("\r\n", pos + 2);
+            std::string_view const h = head.substr(pos + 2, next == std::string_view::npos
+                                                             ? std::string_view::npos : next - pos - 2);
+            pos = next;
+            if (iequals_prefix(h, "connection:")) {
+                std::string_view v = h.substr(11);
+                while (!v.empty() && v.front() == ' ') v.remove_prefix(1);
+                if (iequals_prefix(v, "close")) req.keep_alive = false;
+                if (iequals_prefix(v, "keep-alive")) req.keep_alive = true;
+            } else if (iequals_prefix(h, "range:")) {
+                std::string_view v = h.substr(6);
+                while (!v.empty() && v.front() == ' ') v.remove_prefix(1);
+                if (!iequals_prefix(v, "bytes=")) continue;
+                v.remove_prefix(6);
+                v = v.substr(0, v.find(','));
+                auto const dash = v.find('-');
+                if (dash == std::string_view::npos) continue;
+                std::int64_t a = -1, b = -1;
+                bool const has_a = parse_int(v.substr(0, dash), a);
+                bool const has_b = parse_int(v.substr(dash + 1), b);
+                if (has_a && (!has_b || b >= a)) { req.ranged = true; req.first = a; req.last = has_b ? b : -1; }
+                else if (!has_a && has_b)        { req.ranged = true; req.first = -1; req.last = b; }
+            }
+        }
+        return true;
+    }
+
+    // one request/response; false closes the connection
+    bool handle(int c, std::string& buf)
+    {
+        std::size_t end;
+        while ((end = buf.find("\r\n\r\n")) == std::string::npos) {
+            if (buf.size() > max_header) return reply(c, "431 Request Header Fields Too Large");
+            char tmp[2048];
+            ssize_t const n = ::recv(c, tmp, sizeof tmp, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf.append(tmp, static_cast<std::size_t>(n));
+        }
+        request req;
+        bool const ok = parse_request(std::string_view(buf).substr(0, end), req);
+        buf.erase(0, end + 4);
+        if (!ok) return reply(c, "400 Bad Request");
+
+        sha1_hash key;
+        torrent_index::entry e;
+        if (!parse_hash_hex(req.hash, key) || !g_index.by_hash(key, e))
+            return reply(c, "404 Not Found");
+
+        // a magnet link may still be fetching its metadata
+        std::shared_ptr<torrent_info const> ti;
+        for (auto const give_up = clock::now() + stall_timeout; !(ti = e.handle.torrent_file()); ) {
+            if (m_stop || !e.handle.is_valid() || clock::now() > give_up)
+                return reply(c, "503 Service Unavailable");
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        }
+        file_storage const& fs = ti->files();
+        if (req.file >= fs.num_files() || fs.pad_file_at(file_index_t(req.file)))
+            return reply(c, "404 Not Found");
+        file_index_t const f(req.file);
+        std::int64_t const size = fs.file_size(f);
+
+        std::int64_t first = 0, last = size - 1;
+        if (req.ranged) {
+            if (req.first < 0) first = std::max<std::int64_t>(0, size - req.last);
+            else {
+                first = req.first;
+                if (req.last >= 0) last = std::min(last, req.last);
+            }
+            if (first >= size || (req.first < 0 && req.last == 0))
+                return reply(c, "416 Range Not Satisfiable",
+                             "Content-Range: bytes */" + std::to_string(size) + "\r\n");
+        }
+
+        std::string const name(fs.file_name(f));
+        std::string head = req.ranged ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+        head += "Content-Type: ";
+        head += mime_type(name);
+        head += "\r\nAccept-Ranges: bytes\r\nContent-Length: " + std::to_string(last + 1 - first) + "\r\n";
+        if (req.ranged)
+            head += "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last)
+                  + "/" + std::to_string(size) + "\r\n";
+        head += req.keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        if (!send_all(c, head.data(), head.size())) return false;
+        if (req.head || size == 0) return req.keep_alive;
+
+        // a track the user left unselected in an album is wanted after all
+        if (e.handle.file_priority(f) == dont_download) e.handle.file_priority(f, default_priority);
+
+        g_pieces.acquire(e.handle, ti->num_pieces());
+        g_preambles.feed(e.handle, *ti);
+        bool const sent = send_range(c, e.handle, *ti, f, torrent_file_path(e, fs, f), first, last + 1);
+        g_pieces.release(e.handle);
+        return sent && req.keep_alive;
+    }
+
+    static bool open_file(int& fd, std::string const& path)
+    {
+        if (fd >= 0) return true;
+        if ((fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC)) >= 0) return true;
+        LOGE("stream %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    static bool read_at(int fd, char* p, std::size_t n, std::int64_t off)
+    {
+        for (std::size_t got = 0; got < n; ) {
+            ssize_t const r = ::pread(fd, p + got, n - got, static_cast<off_t>(off + std::int64_t(got)));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    // writes [pos, end) of file `f` as its pieces come in
+    bool send_range(int c, torrent_handle const& h, torrent_info const& ti, file_index_t f,
+                    std::string const& path, std::int64_t pos, std::int64_t const end)
+    {
+        file_storage const& fs = ti.files();
+        int const window = static_cast<int>(std::max<std::int64_t>(2, window_bytes / ti.piece_length()));
+        int const last   = static_cast<int>(fs.map_file(f, end - 1, 1).piece);
+        int scheduled    = static_cast<int>(fs.map_file(f, pos, 1).piece);
+        std::int64_t const size = fs.file_size(f);
+        sha1_hash const ih = cache_key(ti.info_hashes());
+        std::vector<int> deadlines;
+
+        std::vector<char> chunk(chunk_size);
+        int fd = -1;
+        bool ok = true;
+        while (pos < end) {
+            peer_request const r = fs.map_file(f, pos, 1);
+            int const piece = static_cast<int>(r.piece);
+            // with a play head reported, only the piece blocking this read
+            int const ahead = g_playback.drives(h, static_cast<int>(f)) ? 1 : window;
+            for (; scheduled <= last && scheduled < piece + ahead; ++scheduled) {
+                if (g_pieces.has(h, scheduled) || g_playback.covers(h, scheduled)) continue;
+                // torrents added without announcing start out paused
+                if (deadlines.empty()) h.resume();
+                h.set_piece_deadline(piece_index_t(scheduled), (scheduled - piece) * deadline_step_ms);
+                deadlines.push_back(scheduled);
+            }
+            // the opening seconds can come from the torrent's preamble while
+            // the swarm is still connecting
+            if (!g_pieces.has(h, piece)) {
+                std::size_t const k = g_preambles.read(h, static_cast<int>(f), pos, chunk.data(),
+                    static_cast<std::size_t>(std::min<std::int64_t>(end - pos, std::int64_t(chunk.size()))));
+                if (k > 0) {
+                    if (!send_all(c, chunk.data(), k)) { ok = false; break; }
+                    pos += std::int64_t(k);
+                    continue;
+                }
+            }
+            if (!g_pieces.wait(h, piece, stall_timeout, m_stop)) { ok = false; break; }
+
+            // a piece that lies wholly inside this file goes through
+            // g_piece_cache; one shared with a neighbouring file is read
+            // for just this request
+            std::int64_t const piece_len = ti.piece_size(r.piece);
+            std::int64_t const piece_pos = pos - r.start;
+            if (piece_pos >= 0 && piece_pos + piece_len <= size) {
+                auto buf = g_piece_cache.get(ih, piece);
+                if (!buf) {
+                    auto b = std::make_shared<std::vector<char>>(static_cast<std::size_t>(piece_len));
+                    if (!open_file(fd, path) || !read_at(fd, b->data(), b->size(), piece_pos)) { ok = false; break; }
+                    g_piece_cache.put(ih, piece, b);
+                    buf = std::move(b);
+                }
+                std::size_t const n = static_cast<std::size_t>(std::min<std::int64_t>(end - pos, piece_len - r.start));
+                if (!send_all(c, buf->data() + r.start, n)) { ok = false; break; }
+                pos += std::int64_t(n);
+                continue;
+            }
+            std::size_t const n = static_cast<std::size_t>(std::min<std::int64_t>(
+                {end - pos, piece_len - r.start, std::int64_t(chunk.size())}));
+            if (!open_file(fd, path) || !read_at(fd, chunk.data(), n, pos) || !send_all(c, chunk.data(), n)) {
+                ok = false;
+                break;
+            }
+            pos += std::int64_t(n);
+        }
+        if (fd >= 0) ::close(fd);
+
+        // a seek or a closed connection leaves pieces the player no longer
+        // waits for; hand them back to the regular picker
+        for (int const p : deadlines)
+            if (!g_pieces.has(h, p) && !g_playback.covers(h, p)) h.reset_piece_deadline(piece_index_t(p));
+        return ok;
+    }
+
+    mutable std::mutex                            m_mtx;
+    std::condition_variable                       m_cv;
+    std::unordered_set<int>                       m_conns;
+    std::thread                                   m_accept;
+    int                                           m_listen = -1;
+    int                                           m_port   = 0;
+    std::atomic<bool>                             m_stop{false};
+};
+
+static stream_server g_stream;
+
+// ─────────────────────  session operations  ───────────────────
+// Shared by the JNI exports and the C ABI below.
+
+// stops the alert pump, then tears the session down
+static void shutdown_session()
+{
+    std::unique_ptr<session> ses;
+    g_prefetch.clear();
+    g_playback.clear();
+    g_stream.stop();        // its readers hold torrent handles
+    g_preambles.clear();
+    g_piece_cache.clear();
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        g_alerts.stop();
+        ses = std::move(g_ses);
+    }
+    g_status.clear();
+    g_index.clear();
+    // session destructor waits for the network thread – keep it outside g_mtx
+    if (!ses) return;
+    ses.reset();
+    g_library.clear();
+    g_upload_cache.clear();
+    LOGI("libtorrent session stopped");
+}
+
+struct add_options
+{
+    bool seed     = false;
+    bool announce = true;
+    bool dht      = true;
+    bool lsd      = true;
+    bool utp      = true;
+    bool trackers = true;
+    bool pex      = true;
+    std::string source;     // seeds: the song or album folder; save_path/<name> if empty
+};
+
+// bencoded .torrent → torrent_info, read in place from the caller's buffer;
+// with `keep_preamble` (a download, not a seed) its preamble goes to
+// g_preambles
+static std::shared_ptr<torrent_info> parse_torrent(char const* data, std::size_t len,
+                                                   std::string& err, bool keep_preamble = false)
+{
+    error_code ec;
+    bdecode_node root;
+    bdecode(data, data + len, root, ec);
+    if (ec) { err = ec.message(); return {}; }
+
+    auto ti = std::make_shared<torrent_info>(root, ec);
+    if (ec) { err = ec.message(); return {}; }
+    if (keep_preamble) g_preambles.adopt(*ti, root);
+    return ti;
+}
+
+static add_torrent_params make_add_params(std::shared_ptr<torrent_info> ti,
+                                          std::string save_path,
+                                          add_options const& o)
+{
+    add_torrent_params p;
+    if (o.seed && g_session_backend.load() != disk_backend::custom) {
+        // libtorrent's own backends: the files sit in the source's folder,
+        // and those backends would repair a failed piece in place. Upload
+        // mode makes no piece requests, so nothing is ever written; it only
+        // lasts while the torrent is not auto-managed (optimistic_disk_retry
+        // lifts it), which also leaves starting it to `announce`
+        if (!o.source.empty()) {
+            auto const slash = o.source.find_last_of('/', o.source.size() > 1 ? o.source.size() - 2 : 0);
+            if (slash != std::string::npos) save_path = slash == 0 ? "/" : o.source.substr(0, slash);
+        }
+        p.flags |= torrent_flags::upload_mode;
+        p.flags &= ~(torrent_flags::auto_managed | paused);
+    } else if (o.seed) {
+        // read in place from the library, see library_disk_io
+        std::string source = o.source;
+        if (source.empty()) {
+            source = save_path;
+            if (!source.empty() && source.back() != '/') source += '/';
+            source += ti->name();
+        }
+        g_library.add(cache_key(ti->info_hashes()), ti->files(), std::move(source));
+        save_path = library_root;
+    }
+    p.ti        = std::move(ti);
+    p.save_path = std::move(save_path);
+    if (o.seed)      p.flags |= seed_mode;
+    if (!o.announce) p.flags |= paused;
+    if (!o.dht)      p.flags |= disable_dht;
+    if (!o.lsd)      p.flags |= disable_lsd;
+    if (!o.pex)      p.flags |= disable_pex;
+    if (!o.trackers) p.trackers.clear();
+    return p;
+}
+
+// delete_files on removal, except for a seed of the user's own files:
+// library_disk_io never deletes those, libtorrent's backends would
+static remove_flags_t remove_flags_for(sha1_hash const& key, bool remove_data)
+{
+    torrent_index::entry e;
+    bool const in_place = g_index.by_hash(key, e) && e.in_place;
+    return remove_data && !in_place ? session_handle::delete_files : remove_flags_t{};
+}
+
+// Sets the disk backend, threads and file pool of the next session
+// get_session() builds; a running session gets the threads and file pool
+// through apply_settings(), the caches their sizes right away. False, with
+// nothing changed, while a session runs on another backend or `io_uring`
+// setting: close it first. library_disk_io sizes its own readers once,
+// with the session; aio_threads resizes libtorrent's pools only.
+static bool configure_disk(disk_config const& c)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (g_ses && (g_session_backend.load() != c.backend || g_session_ring.load() != c.io_uring)) return false;
+        g_disk_config = c;
+        if (g_ses && (c.aio_threads > 0 || c.file_pool_size > 0)) {
+            settings_pack sp;
+            if (c.aio_threads > 0)    sp.set_int(settings_pack::aio_threads, c.aio_threads);
+            if (c.file_pool_size > 0) sp.set_int(settings_pack::file_pool_size, c.file_pool_size);
+            g_ses->apply_settings(std::move(sp));
+        }
+    }
+    if (c.upload_cache >= 0) g_upload_cache.set_capacity(static_cast<std::size_t>(c.upload_cache));
+    if (c.read_cache >= 0)   g_piece_cache.set_capacity(static_cast<std::size_t>(c.read_cache));
+    return true;
+}
+
+// {"backend","torrents","engine","open_files","file_limit","opens","reuses",
+//  "evictions","reads","writes","hashes","ring_batches","ring_ops",
+//  "fixed_files","fixed_buffers"} of the library storage; "backend" is the
+//  session's disk backend, "engine" is "io_uring" or "pread", "writes" the
+//  refused ones (library files are read-only)
+static void write_library_stats(json_writer& w)
+{
+    auto const get = [](auto const& c) { return c.load(std::memory_order_relaxed); };
+    w.begin_object()
+     .field("backend",    disk_backend_name(g_session_backend.load()))
+     .field("torrents",   static_cast<std::uint64_t>(g_library.size()))
+     .field("engine",     get(g_library_stats.ring) ? "io_uring" : "pread")
+     .field("open_files", get(g_library_stats.open_files))
+     .field("file_limit", get(g_library_stats.file_limit))
+     .field("opens",      get(g_library_stats.opens))
+     .field("reuses",     get(g_library_stats.reuses))
+     .field("evictions",  get(g_library_stats.evictions))
+     .field("reads",      get(g_library_stats.reads))
+     .field("writes",     get(g_library_stats.writes))
+     .field("hashes",     get(g_library_stats.hashes))
+     .field("ring_batches",  get(g_library_stats.ring_batches))
+     .field("ring_ops",      get(g_library_stats.ring_ops))
+     .field("fixed_files",   get(g_library_stats.fixed_files))
+     .field("fixed_buffers", get(g_library_stats.fixed_buffers))
+     .end_object();
+}
+
+// {"capacity","bytes","entries","tracked","hits","misses","hit_rate",
+//  "admitted","displaced","trims","hottest":[{"info_hash","piece","heat",
+//  "cached"}]} of the upload cache; "hottest" is the top 8 by heat
+static void write_upload_cache_stats(json_writer& w)
+{
+    upload_cache::stats const st = g_upload_cache.snapshot(8);
+    std::uint64_t const lookups = st.hits + st.misses;
+    w.begin_object()
+     .field("capacity",  st.capacity)
+     .field("bytes",     st.bytes)
+     .field("entries",   st.entries)
+     .field("tracked",   st.tracked)
+     .field("hits",      st.hits)
+     .field("misses",    st.misses)
+     .field("hit_rate",  lookups ? double(st.hits) / double(lookups) : 0.0)
+     .field("admitted",  st.admitted)
+     .field("displaced", st.displaced)
+     .field("trims",     st.trims)
+     .key("hottest").begin_array();
+    for (auto const& p : st.hottest) {
+        w.begin_object()
+         .field("info_hash", aux::to_hex(p.ih))
+         .field("piece",     p.piece)
+         .field("heat",      p.heat)
+         .field("cached",    p.cached)
+         .end_object();
+    }
+    w.end_array().end_object();
+}
+
+// uTP can only be switched off for the whole session
+static void apply_utp(session& ses, add_options const& o)
+{
+    if (o.utp) return;
+    settings_pack sp;
+    sp.set_bool(settings_pack::enable_outgoing_utp, false);
+    sp.set_bool(settings_pack::enable_incoming_utp, false);
+    ses.apply_settings(sp);
+}
+
+// One torrent file by file – an album's tracks:
+// {"info_hash","name","piece_length","files":[{index,path,size,done,priority,root?}]};
+// "root" is the file's v2 merkle root, absent for v1-only torrents.
+// "done" only counts verified pieces. Pad files are skipped but keep their
+// index, so indices line up with set_file_priorities(). Waits on the
+// network thread; false until the metadata is there.
+static bool write_torrent_files(torrent_handle const& h, json_writer& w)
+{
+    auto const ti = h.torrent_file();
+    if (!ti) return false;
+    auto const done = h.file_progress(torrent_handle::piece_granularity);
+    auto const prio = h.get_file_priorities();
+
+    file_storage const& fs = ti->files();
+    w.begin_object()
+     .field("info_hash",    aux::to_hex(cache_key(ti->info_hashes())))
+     .field("name",         ti->name())
+     .field("piece_length", ti->piece_length())
+     .key("files").begin_array();
+    for (file_index_t const i : fs.file_range()) {
+        if (fs.pad_file_at(i)) continue;
+        std::size_t const k = static_cast<std::size_t>(static_cast<int>(i));
+        w.begin_object()
+         .field("index",    static_cast<int>(i))
+         .field("path",     fs.file_path(i))
+         .field("size",     fs.file_size(i))
+         .field("done",     k < done.size() ? done[k] : std::int64_t(0))
+         .field("priority", k < prio.size() ? int(static_cast<std::uint8_t>(prio[k])) : 4);
+        if (ti->v2()) w.field("root", aux::to_hex(fs.root(i)));
+        w.end_object();
+    }
+    w.end_array().end_object();
+    return true;
+}
+
+// Priorities by file index: 0 skips a file, 1 … 7 as in libtorrent, files
+// past the end of `prio` get the default 4. Downloading one track of an
+// album is {0, …, 0, 4} with the 4 at that track's index.
+static bool set_file_priorities(torrent_handle const& h, std::vector<int> const& prio)
+{
+    if (!h.is_valid()) return false;
+    std::vector<download_priority_t> p;
+    p.reserve(prio.size());
+    for (int const v : prio) p.emplace_back(static_cast<std::uint8_t>(std::clamp(v, 0, 7)));
+    h.prioritize_files(p);
+    return true;
+}
+
+// [{"info_hash","file_index","path"}] of every file with this v2 merkle
+// root; false if `hex` is not 64 hex chars
+static bool write_file_root_matches(std::string const& hex, json_writer& w)
+{
+    sha256_hash root;
+    if (hex.size() != 64 || !aux::from_hex(hex, root.data())) return false;
+    w.begin_array();
+    for (auto const& f : g_index.by_file_root(root)) {
+        w.begin_object()
+         .field("info_hash",  aux::to_hex(f.key))
+         .field("file_index", f.file_index)
+         .field("path",       f.path)
+         .end_object();
+    }
+    w.end_array();
+    return true;
+}
+
+// {"position_ms","offset","buffer_s","window_s","first_piece","last_piece",
+//  "underruns","underrun_ms","playing","index"} of one play head
+static void write_playback_health(json_writer& w, playback_scheduler::health const& h)
+{
+    w.begin_object()
+     .field("position_ms", h.position_ms)
+     .field("offset",      h.offset)
+     .field("buffer_s",    h.buffer_s)
+     .field("window_s",    h.window_s)
+     .field("first_piece", h.first_piece)
+     .field("last_piece",  h.last_piece)
+     .field("underruns",   h.underruns)
+     .field("underrun_ms", h.underrun_ms)
+     .field("playing",     h.playing)
+     .field("index",       h.index)
+     .end_object();
+}
+
+// Time → byte → piece map of one file of a torrent, from its container
+// header: {"format","duration_ms","audio_begin","audio_end","exact",
+// "points":[{"ms","offset","piece"}]}, or {"pending":true,"need_offset",
+// "need_length"} while the header pieces are still missing. False without
+// metadata, for a bad file index or a format without an index. Waits on
+// the network thread.
+static bool write_seek_index(torrent_index::entry const& e, int file, json_writer& w)
+{
+    auto const ti = e.handle.torrent_file();
+    if (!ti) return false;
+    file_storage const& fs = ti->files();
+    if (file < 0 || file >= fs.num_files() || fs.pad_file_at(file_index_t(file))) return false;
+    file_index_t const f(file);
+
+    seek_index::index idx;
+    std::int64_t need_offset = 0, need_length = 0;
+    g_pieces.acquire(e.handle, ti->num_pieces());
+    auto const st = read_seek_index(e.handle, *ti, f, torrent_file_path(e, fs, f), idx, need_offset, need_length);
+    g_pieces.release(e.handle);
+
+    if (st == seek_index::status::none) return false;
+    if (st == seek_index::status::need) {
+        w.begin_object()
+         .field("pending",     true)
+         .field("need_offset", need_offset)
+         .field("need_length", need_length)
+         .end_object();
+        return true;
+    }
+    w.begin_object()
+     .field("format",      idx.format)
+     .field("duration_ms", idx.duration_ms)
+     .field("audio_begin", idx.audio_begin)
+     .field("audio_end",   idx.audio_end)
+     .field("exact",       idx.exact)
+     .key("points").begin_array();
+    for (auto const& pt : idx.points) {
+        w.begin_object()
+         .field("ms",     pt.ms)
+         .field("offset", pt.offset)
+         .field("piece",  static_cast<int>(fs.map_file(f, std::min(pt.offset, fs.file_size(f) - 1), 1).piece))
+         .end_object();
+    }
+    w.end_array().end_object();
+    return true;
+}
+
+#if AUDYN_WITH_JNI
+// ────────────────────────  JNI plumbing  ──────────────────────
+static JavaVM* g_vm = nullptr;
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*)
+{
+    g_vm = vm;
+    return JNI_VERSION_1_6;
+}
+
+static std::string jstring_to_std(JNIEnv* env, jstring js)
+{
+    if (!js) return {};
+    const char* c = env->GetStringUTFChars(js, nullptr);
+    std::string out(c ? c : "");
+    if (c) env->ReleaseStringUTFChars(js, c);
+    return out;
+}
+
+static std::vector<std::string> jstrings_to_std(JNIEnv* env, jobjectArray arr)
+{
+    std::vector<std::string> out;
+    if (!arr) return out;
+    jsize const n = env->GetArrayLength(arr);
+    out.reserve(n);
+    for (jsize i = 0; i < n; ++i) {
+        auto js = static_cast<jstring>(env->GetObjectArrayElement(arr, i));
+        if (!js) continue;
+        out.push_back(jstring_to_std(env, js));
+        env->DeleteLocalRef(js);
+    }
+    return out;
+}
+
+static jbyteArray to_jbyteArray(JNIEnv* env, std::vector<char> const& buf)
+{
+    jbyteArray arr = env->NewByteArray(static_cast<jsize>(buf.size()));
+    if (!arr) return nullptr;
+    env->SetByteArrayRegion(arr, 0, static_cast<jsize>(buf.size()),
+                            reinterpret_cast<const jbyte*>(buf.data()));
+    return arr;
+}
+
+// JNIEnv for the current native thread; worker threads attach on first
+// use and detach when they exit
+static JNIEnv* attached_env()
+{
+    struct attachment {
+        JNIEnv* env = nullptr;
+        bool    owned = false;
+        ~attachment() { if (owned) g_vm->DetachCurrentThread(); }
+    };
+    thread_local attachment a;
+    if (a.env || !g_vm) return a.env;
+
+    if (g_vm->GetEnv(reinterpret_cast<void**>(&a.env), JNI_VERSION_1_6) == JNI_OK) return a.env;
+    if (g_vm->AttachCurrentThread(&a.env, nullptr) != JNI_OK) { a.env = nullptr; return nullptr; }
+    a.owned = true;
+    return a.env;
+}
+
+// Global ref to a Kotlin NativeCallback; complete() may be called from any
+// native thread, exactly once.
+class java_callback {
+public:
+    java_callback(JNIEnv* env, jobject cb) : m_cb(env->NewGlobalRef(cb))
+    {
+        if (!g_vm) env->GetJavaVM(&g_vm);
+    }
+    ~java_callback()
+    {
+        if (JNIEnv* env = attached_env()) env->DeleteGlobalRef(m_cb);
+    }
+    java_callback(java_callback const&) = delete;
+    java_callback& operator=(java_callback const&) = delete;
+
+    void complete(bool ok, jobject value, char const* error)
+    {
+        JNIEnv* env = attached_env();
+        if (!env) return;
+        jclass cls = env->GetObjectClass(m_cb);
+        jmethodID mid = env->GetMethodID(cls, "onComplete", "(ZLjava/lang/Object;Ljava/lang/String;)V");
+        jstring jerr = error ? env->NewStringUTF(error) : nullptr;
+        if (mid) env->CallVoidMethod(m_cb, mid, ok ? JNI_TRUE : JNI_FALSE, value, jerr);
+        if (env->ExceptionCheck()) env->ExceptionClear();
+        if (jerr) env->DeleteLocalRef(jerr);
+        env->DeleteLocalRef(cls);
+    }
+
+    void complete_bytes(std::vector<char> const& buf, char const* error)
+    {
+        JNIEnv* env = attached_env();
+        if (!env) return;
+        jbyteArray arr = buf.empty() ? nullptr : to_jbyteArray(env, buf);
+        complete(arr != nullptr, arr, arr ? nullptr : error);
+        if (arr) env->DeleteLocalRef(arr);
+    }
+
+private:
+    jobject m_cb;
+};
+
+// Global ref to a Kotlin CreateJobListener, shared by a job's events.
+class java_job_listener {
+public:
+    java_job_listener(JNIEnv* env, jobject l) : m_ref(env->NewGlobalRef(l))
+    {
+        if (!g_vm) env->GetJavaVM(&g_vm);
+        jclass cls = env->GetObjectClass(l);
+        m_mid = env->GetMethodID(cls, "onEvent", "(JIIILjava/lang/String;)V");
+        env->DeleteLocalRef(cls);
+    }
+    ~java_job_listener()
+    {
+        if (JNIEnv* env = attached_env()) env->DeleteGlobalRef(m_ref);
+    }
+    java_job_listener(java_job_listener const&) = delete;
+    java_job_listener& operator=(java_job_listener const&) = delete;
+
+    void operator()(create_job const& j)
+    {
+        JNIEnv* env = attached_env();
+        if (!env || !m_mid) return;
+        jstring jerr = nullptr;
+        if (j.state.load() == job_state::failed) {
+            std::lock_guard<std::mutex> jl(j.m);
+            jerr = env->NewStringUTF(j.error.c_str());
+        }
+        env->CallVoidMethod(m_ref, m_mid, static_cast<jlong>(j.id),
+                            static_cast<jint>(j.state.load()),
+                            static_cast<jint>(j.pieces_done.load()),
+                            static_cast<jint>(j.num_pieces.load()), jerr);
+        if (env->ExceptionCheck()) env->ExceptionClear();
+        if (jerr) env->DeleteLocalRef(jerr);
+    }
+
+private:
+    jobject   m_ref;
+    jmethodID m_mid = nullptr;
+};
+
+// Global ref to a Kotlin TorrentBatchListener.
+class java_batch_listener {
+public:
+    java_batch_listener(JNIEnv* env, jobject l) : m_ref(env->NewGlobalRef(l))
+    {
+        if (!g_vm) env->GetJavaVM(&g_vm);
+        jclass cls = env->GetObjectClass(l);
+        m_result = env->GetMethodID(cls, "onResult", "(JILjava/lang/String;[BLjava/lang/String;)V");
+        m_done   = env->GetMethodID(cls, "onDone", "(JIIZJ)V");
+        env->DeleteLocalRef(cls);
+    }
+    ~java_batch_listener()
+    {
+        if (JNIEnv* env = attached_env()) env->DeleteGlobalRef(m_ref);
+    }
+    java_batch_listener(java_batch_listener const&) = delete;
+    java_batch_listener& operator=(java_batch_listener const&) = delete;
+
+    void result(hash_batch const& b, std::size_t i, std::vector<char> const& buf, std::string const& err)
+    {
+        JNIEnv* env = attached_env();
+        if (!env || !m_result) return;
+        jstring    jpath = env->NewStringUTF(b.paths[i].c_str());
+        jbyteArray jbuf  = err.empty() ? to_jbyteArray(env, buf) : nullptr;
+        jstring    jerr  = err.empty() ? nullptr : env->NewStringUTF(err.c_str());
+        env->CallVoidMethod(m_ref, m_result, static_cast<jlong>(b.id), static_cast<jint>(i),
+                            jpath, jbuf, jerr);
+        if (env->ExceptionCheck()) env->ExceptionClear();
+        env->DeleteLocalRef(jpath);
+        if (jbuf) env->DeleteLocalRef(jbuf);
+        if (jerr) env->DeleteLocalRef(jerr);
+    }
+
+    void done(hash_batch const& b, int ok, int failed)
+    {
+        JNIEnv* env = attached_env();
+        if (!env || !m_done) return;
+        auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            hash_batch::clock::now() - b.started).count();
+        env->CallVoidMethod(m_ref, m_done, static_cast<jlong>(b.id), static_cast<jint>(ok),
+                            static_cast<jint>(failed), b.cancel.load() ? JNI_TRUE : JNI_FALSE,
+                            static_cast<jlong>(ms));
+        if (env->ExceptionCheck()) env->ExceptionClear();
+    }
+
+private:
+    jobject   m_ref;
+    jmethodID m_result = nullptr;
+    jmethodID m_done   = nullptr;
+};
+
+// ────────────────────────  JNI exports  ───────────────────────
+extern "C" {
+
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getAllTorrents(JNIEnv* env, jobject) {
+    g_status.request_refresh();
+    return rows_to_jstring(env, g_status.snapshot()->rows);
+}
+
+// -----------------------------------------------------------------
+// getTorrentStats()  →  JSON list of dictionaries (same as getAllTorrents)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentStats(JNIEnv* env, jobject thiz) {
+    return Java_com_example_audyn_LibtorrentWrapper_getAllTorrents(env, thiz);
+}
+
+// -----------------------------------------------------------------
+// getTorrentUpdatesSince(seq)  →  {"seq","full","updated":[…],"removed":[…]}
+// pass the returned "seq" back in on the next call; "full" means
+// "updated" is the complete table and the caller should replace its copy
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentUpdatesSince(JNIEnv* env, jobject,
+                                                                jlong jSince) {
+    g_status.request_refresh();
+    json_writer w(json_arena());
+    write_updates(w, static_cast<std::uint64_t>(jSince < 0 ? 0 : jSince));
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// getTorrentsPage(sortBy, descending, offset, limit)
+//   →  {"version","total","torrents":[…]}
+// sortBy: name | progress | upload_rate | download_rate | num_peers | state
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentsPage(JNIEnv* env, jobject,
+                                                         jstring jSortBy,
+                                                         jboolean jDescending,
+                                                         jint jOffset,
+                                                         jint jLimit) {
+    std::string sortBy;
+    if (jSortBy) {
+        const char* k = env->GetStringUTFChars(jSortBy, nullptr);
+        sortBy = k ? k : "";
+        env->ReleaseStringUTFChars(jSortBy, k);
+    }
+
+    g_status.request_refresh();
+    auto const snap = g_status.snapshot();
+    auto const page = snap->view(parse_sort_key(sortBy), jDescending == JNI_TRUE,
+                                 static_cast<std::size_t>(std::max<jint>(jOffset, 0)),
+                                 static_cast<std::size_t>(std::max<jint>(jLimit, 0)));
+
+    json_writer w(json_arena());
+    w.begin_object()
+     .field("version", snap->version)
+     .field("total",   static_cast<std::int64_t>(snap->rows.size()))
+     .key("torrents");
+    write_rows(w, page);
+    w.end_object();
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// cleanupSession()  – stops the alert pump, then tears the session down
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_cleanupSession(JNIEnv*, jobject) {
+    shutdown_session();
+}
+
+// -----------------------------------------------------------------
+// addTorrent(...)
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_addTorrent(JNIEnv* env, jobject,
+                                                    jstring jPath,
+                                                    jstring jSave,
+                                                    jboolean jSeed,
+                                                    jboolean jAnnounce,
+                                                    jboolean jEnableDHT,
+                                                    jboolean jEnableLSD,
+                                                    jboolean jEnableUTP,
+                                                    jboolean jEnableTrackers,
+                                                    jboolean jEnablePEX)
+{
+    if (!jPath || !jSave) return JNI_FALSE;
+
+    const char* path  = env->GetStringUTFChars(jPath , nullptr);
+    const char* spath = env->GetStringUTFChars(jSave , nullptr);
+
+    bool ok = false;
+    try {
+        auto& ses = get_session();
+
+        error_code ec;
+        auto ti = std::make_shared<torrent_info>(std::string(path), ec);
+        if (ec) throw std::runtime_error(ec.message());
+
+        add_torrent_params p;
+        p.ti        = ti;
+        p.save_path = spath;
+        p.flags     = {};
+
+        if (jSeed)              p.flags |= seed_mode;
+        if (!jAnnounce)         p.flags |= paused;
+        if (!jEnableDHT)        p.flags |= disable_dht;
+        if (!jEnableLSD)        p.flags |= disable_lsd;
+        if (!jEnablePEX)        p.flags |= disable_pex;
+
+        if (!jEnableTrackers)   p.trackers.clear();
+
+        // Disable uTP globally if requested
+        if (!jEnableUTP) {
+            settings_pack s;
+            s.set_bool(settings_pack::enable_outgoing_utp, false);
+            s.set_bool(settings_pack::enable_incoming_utp, false);
+            ses.apply_settings(s);
+        }
+
+        ses.async_add_torrent(std::move(p));
+        ok = true;
+    }
+    catch (std::exception const& e) { LOGE("addTorrent: %s", e.what()); }
+
+    env->ReleaseStringUTFChars(jPath , path );
+    env->ReleaseStringUTFChars(jSave , spath);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+
+bool file_exists(const std::string& path) {
+    struct ::stat buffer;  // <-- use ::stat to refer to system stat
+    return (::stat(path.c_str(), &buffer) == 0);
+}
+
+// -----------------------------------------------------------------
+// createTorrent(filePath, outputPath, trackers)  → bool
+// blocking; hashing runs on the interactive lane, not on the caller
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_createTorrent(JNIEnv* env, jobject,
+                                                       jstring jFilePath,
+                                                       jstring jOutputPath,
+                                                       jobjectArray jTrackers) {
+    if (!jFilePath || !jOutputPath) return JNI_FALSE;
+
+    std::string input  = jstring_to_std(env, jFilePath);
+    std::string output = jstring_to_std(env, jOutputPath);
+    auto trackers      = jstrings_to_std(env, jTrackers);
+
+    auto fut = g_jobs.submit(job_lane::interactive,
+        [input = std::move(input), output = std::move(output), trackers = std::move(trackers)] {
+            return write_torrent_file(input, output, trackers);
+        });
+    try { return fut.get() ? JNI_TRUE : JNI_FALSE; }
+    catch (std::exception const& e) { LOGE("createTorrent: %s", e.what()); }
+    return JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// createTorrentAsync(filePath, outputPath, trackers, callback)  → queued?
+// callback.onComplete(ok, null, error) runs on a native worker thread
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_createTorrentAsync(JNIEnv* env, jobject,
+                                                            jstring jFilePath,
+                                                            jstring jOutputPath,
+                                                            jobjectArray jTrackers,
+                                                            jobject jCallback) {
+    if (!jFilePath || !jOutputPath || !jCallback) return JNI_FALSE;
+
+    auto cb = std::make_shared<java_callback>(env, jCallback);
+    bool const queued = g_jobs.post(job_lane::interactive,
+        [input    = jstring_to_std(env, jFilePath),
+         output   = jstring_to_std(env, jOutputPath),
+         trackers = jstrings_to_std(env, jTrackers), cb] {
+            bool ok = false;
+            try { ok = write_torrent_file(input, output, trackers); }
+            catch (std::exception const& e) { LOGE("createTorrentAsync: %s", e.what()); }
+            cb->complete(ok, nullptr, ok ? nullptr : "torrent creation failed");
+        });
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+
+// -----------------------------------------------------------------
+// removeTorrentByName(name)  → bool
+// name is matched through norm_name(), like MusicSeederService.norm()
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_removeTorrentByName(JNIEnv* env, jobject,
+                                                             jstring jName)
+{
+    if (!jName) return JNI_FALSE;
+    const char* name = env->GetStringUTFChars(jName, nullptr);
+    std::string nameStr(name ? name : "");
+    env->ReleaseStringUTFChars(jName, name);
+
+    torrent_index::entry e;
+    if (!g_index.by_name(nameStr, e)) return JNI_FALSE;
+
+    g_alerts.post([h = e.handle](session& ses) { ses.remove_torrent(h); });
+    return JNI_TRUE;
+}
+
+// -----------------------------------------------------------------
+// getTorrentSavePathByName(name)  → String?
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentSavePathByName(JNIEnv* env, jobject,
+                                                                  jstring jName)
+{
+    if (!jName) return env->NewStringUTF("");
+    const char* name = env->GetStringUTFChars(jName, nullptr);
+    std::string nameStr(name ? name : "");
+    env->ReleaseStringUTFChars(jName, name);
+
+    std::string path;
+    torrent_index::entry e;
+    if (g_index.by_name(nameStr, e)) {
+        // prefer the live save path in case the storage was moved
+        auto const row = g_status.snapshot()->find(e.key);
+        path = row ? row->save_path : e.save_path;
+    }
+    return env->NewStringUTF(path.c_str());
+}
+
+/* ─────────────────────────────  NEW JNI wrapper  ─────────────────────────── */
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_audyn_LibtorrentWrapper_createTorrentBytes
+        (JNIEnv* env, jobject /*thiz*/, jstring jSourcePath)
+{
+    if (!jSourcePath) return nullptr;
+
+    std::string path = jstring_to_std(env, jSourcePath);
+
+    // hashed on the interactive lane; only the copy into Java happens here
+    std::vector<char> buf;
+    try { buf = g_jobs.submit(job_lane::interactive, [&path] { return make_torrent_buffer(path); }).get(); }
+    catch (std::exception const& e) { LOGE("createTorrentBytes: %s", e.what()); }
+
+    if (buf.empty()) {
+        LOGE("createTorrentBytes: failed to generate torrent for \"%s\"", path.c_str());
+        return nullptr;   // null -> Dart will see “null bytes”
+    }
+    return to_jbyteArray(env, buf);
+}
+
+// -----------------------------------------------------------------
+// createTorrentBytesAsync(sourcePath, background, callback)  → queued?
+// callback.onComplete(ok, byte[] or null, error) on a native worker
+// -----------------------------------------------------------------
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_createTorrentBytesAsync
+        (JNIEnv* env, jobject /*thiz*/, jstring jSourcePath, jboolean jBackground, jobject jCallback)
+{
+    if (!jSourcePath || !jCallback) return JNI_FALSE;
+
+    auto cb = std::make_shared<java_callback>(env, jCallback);
+    auto const lane = jBackground ? job_lane::background : job_lane::interactive;
+    bool const queued = g_jobs.post(lane, [path = jstring_to_std(env, jSourcePath), cb] {
+        std::vector<char> buf;
+        try { buf = make_torrent_buffer(path); }
+        catch (std::exception const& e) { LOGE("createTorrentBytesAsync: %s", e.what()); }
+        cb->complete_bytes(buf, buf.empty() ? "torrent creation failed" : nullptr);
+    });
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// getAudioIdentity(path)  → {"identity","format","file_bytes","payload_bytes"}
+// or "" when the file cannot be read; hashed on the background lane
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getAudioIdentity(JNIEnv* env, jobject, jstring jPath)
+{
+    if (!jPath) return env->NewStringUTF("");
+    std::string path = jstring_to_std(env, jPath);
+
+    std::string res;
+    try {
+        res = g_jobs.submit(job_lane::background, [&path] {
+            std::string err;
+            json_writer w(json_arena());
+            if (write_audio_identity(w, path, err)) return w.str();
+            LOGE("getAudioIdentity %s: %s", path.c_str(), err.c_str());
+            return std::string();
+        }).get();
+    } catch (std::exception const& e) { LOGE("getAudioIdentity: %s", e.what()); }
+    return env->NewStringUTF(res.c_str());
+}
+
+// -----------------------------------------------------------------
+// getExecutorStats()  → {"workers","interactive":{…},"background":{…}}
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getExecutorStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    g_jobs.write_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// startCreateJob(sourcePath, outputPath?, trackers?, background, listener?)
+//   → job id. With no outputPath the torrent is kept in memory for
+//   takeCreateJobResult(). listener.onEvent(id, state, done, total, error)
+//   runs on a native worker, at most every 250 ms plus on state changes.
+// -----------------------------------------------------------------
+JNIEXPORT jlong JNICALL
+Java_com_example_audyn_LibtorrentWrapper_startCreateJob(JNIEnv* env, jobject,
+                                                        jstring jSource,
+                                                        jstring jOutput,
+                                                        jobjectArray jTrackers,
+                                                        jboolean jBackground,
+                                                        jobject jListener)
+{
+    if (!jSource) return -1;
+
+    auto j = std::make_shared<create_job>();
+    j->source   = jstring_to_std(env, jSource);
+    j->output   = jstring_to_std(env, jOutput);
+    j->trackers = jstrings_to_std(env, jTrackers);
+    j->lane     = jBackground ? job_lane::background : job_lane::interactive;
+    if (jListener) {
+        auto l = std::make_shared<java_job_listener>(env, jListener);
+        j->on_event = [l](create_job const& job) { (*l)(job); };
+    }
+    return static_cast<jlong>(g_create_jobs.start(std::move(j)));
+}
+
+// -----------------------------------------------------------------
+// pollCreateJob(id)  → {"id","state","pieces_done","num_pieces","progress",
+//                       "elapsed_ms","source","output"?,"error"?}  or ""
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_pollCreateJob(JNIEnv* env, jobject, jlong jId)
+{
+    auto const j = g_create_jobs.find(jId);
+    if (!j) return env->NewStringUTF("");
+    json_writer w(json_arena());
+    g_create_jobs.write_job(w, *j);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_cancelCreateJob(JNIEnv*, jobject, jlong jId)
+{
+    return g_create_jobs.cancel(jId) ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// takeCreateJobResult(id)  → .torrent bytes of a finished in-memory job, or
+// null. Releases the job either way once it has finished.
+// -----------------------------------------------------------------
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_audyn_LibtorrentWrapper_takeCreateJobResult(JNIEnv* env, jobject, jlong jId)
+{
+    std::vector<char> buf;
+    if (g_create_jobs.take(jId, buf) != job_state::done || buf.empty()) return nullptr;
+    return to_jbyteArray(env, buf);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_setCreateJobConcurrency(JNIEnv*, jobject, jint n)
+{
+    g_create_jobs.set_concurrency(n);
+}
+
+// -----------------------------------------------------------------
+// createTorrentsBatch(paths, trackers?, albumTracks?, listener)  → batch id
+//   Hashes every path on the background workers, a bounded window at a
+//   time; albumTracks[i], when given, are the tracks of album key paths[i].
+//   listener.onResult(id, index, path, torrent?, error?) fires per file in
+//   completion order, onDone(id, ok, failed, cancelled, ms) once.
+// -----------------------------------------------------------------
+JNIEXPORT jlong JNICALL
+Java_com_example_audyn_LibtorrentWrapper_createTorrentsBatch(JNIEnv* env, jobject,
+                                                             jobjectArray jPaths,
+                                                             jobjectArray jTrackers,
+                                                             jobjectArray jAlbumTracks,
+                                                             jobject jListener)
+{
+    if (!jPaths || !jListener) return -1;
+
+    auto b = std::make_shared<hash_batch>();
+    b->paths    = jstrings_to_std(env, jPaths);
+    b->trackers = jstrings_to_std(env, jTrackers);
+    if (jAlbumTracks) {
+        jsize const n = env->GetArrayLength(jAlbumTracks);
+        b->album_tracks.resize(static_cast<std::size_t>(n));
+        for (jsize i = 0; i < n; ++i) {
+            auto tracks = static_cast<jobjectArray>(env->GetObjectArrayElement(jAlbumTracks, i));
+            if (!tracks) continue;
+            b->album_tracks[std::size_t(i)] = jstrings_to_std(env, tracks);
+            env->DeleteLocalRef(tracks);
+        }
+    }
+
+    auto l = std::make_shared<java_batch_listener>(env, jListener);
+    b->on_result = [l](hash_batch const& batch, std::size_t i, std::vector<char>&& buf,
+                       std::string const& err) { l->result(batch, i, buf, err); };
+    b->on_done   = [l](hash_batch const& batch, int ok, int failed) { l->done(batch, ok, failed); };
+    return static_cast<jlong>(g_batches.start(std::move(b)));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_cancelTorrentsBatch(JNIEnv*, jobject, jlong jId)
+{
+    return g_batches.cancel(jId) ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// openTorrentCache(dir)  – persistent cache of generated torrents; every
+// creation path (single, job, batch) consults it once it is open
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_openTorrentCache(JNIEnv* env, jobject, jstring jDir)
+{
+    if (!jDir) return JNI_FALSE;
+    std::string const dir = jstring_to_std(env, jDir);
+    // loading (and maybe compacting) the index reads the cache file, so it
+    // runs on a worker. With several workers, jobs queued behind it can
+    // start first; their lookups load the index themselves (open_later())
+    // instead of missing against the old one
+    g_torrent_cache.open_later(dir);
+    bool const queued = g_jobs.post(job_lane::interactive, [] { g_torrent_cache.open_pending(); });
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentCacheStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    g_torrent_cache.write_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_clearTorrentCache(JNIEnv*, jobject)
+{
+    g_torrent_cache.clear();
+}
+
+
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_addTorrentFromBytes
+        (JNIEnv* env, jobject /*thiz*/,
+         jbyteArray jBytes, jstring jSavePath,
+         jboolean jSeed, jboolean jAnnounce,
+         jboolean jEnableDHT, jboolean jEnableLSD, jboolean jEnableUTP,
+         jboolean jEnableTrackers, jboolean jEnablePEX)
+{
+    if (!jBytes || !jSavePath) return JNI_FALSE;
+
+    // grab inputs
+    jsize len     = env->GetArrayLength(jBytes);
+    jbyte* buffer = env->GetByteArrayElements(jBytes, nullptr);
+    const char* save = env->GetStringUTFChars(jSavePath, nullptr);
+
+    bool ok = false;
+    try {
+        auto& ses = get_session();
+
+        std::string err;
+        auto ti = parse_torrent(reinterpret_cast<char const*>(buffer),
+                                static_cast<std::size_t>(len), err, !jSeed);
+        if (!ti) throw std::runtime_error(err);
+
+        add_options o;
+        o.seed     = jSeed;
+        o.announce = jAnnounce;
+        o.dht      = jEnableDHT;
+        o.lsd      = jEnableLSD;
+        o.utp      = jEnableUTP;
+        o.trackers = jEnableTrackers;
+        o.pex      = jEnablePEX;
+
+        apply_utp(ses, o);
+        ses.async_add_torrent(make_add_params(std::move(ti), save, o));
+        ok = true;
+    } catch (std::exception const& e) {
+        LOGE("addTorrentFromBytes: %s", e.what());
+    }
+
+    // cleanup JNI refs
+    env->ReleaseByteArrayElements(jBytes, buffer, JNI_ABORT);
+    env->ReleaseStringUTFChars(jSavePath, save);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// addLibraryTorrent(bytes, sourcePath, announce)  → Boolean
+// seeds a torrent of a song (or album folder) in place: its files are
+// read from sourcePath through the library storage, see library_table
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_addLibraryTorrent(JNIEnv* env, jobject,
+                                                           jbyteArray jBytes, jstring jSource,
+                                                           jboolean jAnnounce)
+{
+    if (!jBytes || !jSource) return JNI_FALSE;
+    std::string const source = jstring_to_std(env, jSource);
+    if (source.empty()) return JNI_FALSE;
+
+    jsize len     = env->GetArrayLength(jBytes);
+    jbyte* buffer = env->GetByteArrayElements(jBytes, nullptr);
+
+    bool ok = false;
+    try {
+        auto& ses = get_session();
+
+        std::string err;
+        auto ti = parse_torrent(reinterpret_cast<char const*>(buffer),
+                                static_cast<std::size_t>(len), err);
+        if (!ti) throw std::runtime_error(err);
+
+        add_options o;
+        o.seed     = true;
+        o.announce = jAnnounce;
+        o.trackers = false;
+        o.source   = source;
+        ses.async_add_torrent(make_add_params(std::move(ti), std::string(), o));
+        ok = true;
+    } catch (std::exception const& e) {
+        LOGE("addLibraryTorrent: %s", e.what());
+    }
+
+    env->ReleaseByteArrayElements(jBytes, buffer, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// getLibraryStats()  → {"torrents","open_files","file_limit","opens",
+// "reuses","evictions","reads","writes","hashes"}
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getLibraryStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    write_library_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+extern libtorrent::session* g_session;
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_isTorrentActive(JNIEnv *env, jobject thiz, jstring j_info_hash) {
+    const char *info_hash_str = env->GetStringUTFChars(j_info_hash, nullptr);
+    std::string hashStr(info_hash_str ? info_hash_str : "");
+    env->ReleaseStringUTFChars(j_info_hash, info_hash_str);
+
+    lt::sha1_hash hash;
+    if (!parse_hash_hex(hashStr, hash)) {
+        LOGE("Invalid infoHash: %s", hashStr.c_str());
+        return JNI_FALSE;
+    }
+
+    auto const row = g_status.snapshot()->find(hash);
+    bool isActive = row && !row->paused();
+    return isActive ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_startTorrentByHash(JNIEnv *env, jobject /*thiz*/, jstring j_info_hash) {
+    const char *info_hash_str = env->GetStringUTFChars(j_info_hash, nullptr);
+    std::string hashStr(info_hash_str ? info_hash_str : "");
+    env->ReleaseStringUTFChars(j_info_hash, info_hash_str);
+
+    lt::sha1_hash hash;
+    if (!parse_hash_hex(hashStr, hash)) {
+        LOGE("Invalid infoHash: %s", hashStr.c_str());
+        return JNI_FALSE;
+    }
+
+    std::lock_guard<std::mutex> lk(g_mtx);
+    if (!g_ses) return JNI_FALSE;
+
+    auto handle = g_ses->find_torrent(hash);
+    if (!handle.is_valid()) {
+        LOGE("startTorrentByHash: No valid torrent found for hash %s", hashStr.c_str());
+        return JNI_FALSE;
+    }
+
+    if (handle.status().paused) {
+        handle.resume();
+        LOGI("Torrent resumed for hash: %s", hashStr.c_str());
+    } else {
+        LOGI("Torrent already running for hash: %s", hashStr.c_str());
+    }
+
+    return JNI_TRUE;
+}
+// JNI wrapper for getInfoHash
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getInfoHash(JNIEnv* env, jobject, jstring torrentPath) {
+    const char* nativePath = env->GetStringUTFChars(torrentPath, nullptr);
+    if (!nativePath) return env->NewStringUTF("");
+
+    std::vector<char> buf;
+    std::ifstream in(nativePath, std::ios_base::binary);
+    if (!in) {
+        env->ReleaseStringUTFChars(torrentPath, nativePath);
+        return env->NewStringUTF("");
+    }
+
+    in.unsetf(std::ios_base::skipws);
+    in.seekg(0, std::ios_base::end);
+    std::streampos fileSize = in.tellg();
+    in.seekg(0, std::ios_base::beg);
+    buf.reserve(fileSize);
+    buf.insert(buf.begin(),
+               std::istream_iterator<char>(in),
+               std::istream_iterator<char>());
+
+    lt::error_code ec;
+    lt::bdecode_node node;
+    lt::bdecode(buf.data(), buf.data() + buf.size(), node, ec);
+    if (ec) {
+        env->ReleaseStringUTFChars(torrentPath, nativePath);
+        return env->NewStringUTF("");
+    }
+
+    lt::torrent_info ti(node, ec);
+    if (ec) {
+        env->ReleaseStringUTFChars(torrentPath, nativePath);
+        return env->NewStringUTF("");
+    }
+
+    std::string hash = ti.info_hashes().v1.to_string();
+    env->ReleaseStringUTFChars(torrentPath, nativePath);
+    return env->NewStringUTF(hash.c_str());
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getInfoHashFromBytes(
+        JNIEnv *env,
+        jobject /* this */,
+        jbyteArray torrentBytes) {
+
+    jsize length = env->GetArrayLength(torrentBytes);
+    std::vector<char> buffer(length);
+    env->GetByteArrayRegion(torrentBytes, 0, length, reinterpret_cast<jbyte *>(buffer.data()));
+
+    try {
+        lt::error_code ec;
+        lt::bdecode_node node;
+        lt::bdecode(buffer.data(), buffer.data() + buffer.size(), node, ec);
+
+        if (ec) {
+            std::string err = "Failed to bdecode: " + ec.message();
+            return env->NewStringUTF(err.c_str());
+        }
+
+        // Create torrent_info from bdecoded node
+        lt::torrent_info info(node, ec);
+
+        if (ec) {
+            std::string err = "Failed to parse torrent_info: " + ec.message();
+            return env->NewStringUTF(err.c_str());
+        }
+
+        // v1 hash, or the full 64-char v2 hash of a v2-only torrent
+        auto const& ih = info.info_hashes();
+        std::string const hex = ih.has_v1() ? aux::to_hex(ih.v1) : aux::to_hex(ih.v2);
+        return env->NewStringUTF(hex.c_str());
+
+    } catch (const std::exception &ex) {
+        std::string err = "Exception: " + std::string(ex.what());
+        return env->NewStringUTF(err.c_str());
+    }
+}
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_stopTorrentByHash(JNIEnv *env, jobject /* this */, jstring infoHashJ) {
+    const char *infoHashC = env->GetStringUTFChars(infoHashJ, nullptr);
+    std::string infoHash(infoHashC);
+    env->ReleaseStringUTFChars(infoHashJ, infoHashC);
+
+    lt::sha1_hash hash;
+    if (!parse_hash_hex(infoHash, hash)) {
+        LOGE("stopTorrentByHash: invalid hash: %s", infoHash.c_str());
+        return JNI_FALSE;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (!g_ses) return JNI_FALSE;
+
+        auto handle = g_ses->find_torrent(hash);
+        if (handle.is_valid()) {
+            handle.pause();
+            LOGI("Torrent paused for hash: %s", infoHash.c_str());
+            return JNI_TRUE;
+        }
+    } catch (const std::exception& e) {
+        LOGE("stopTorrentByHash exception: %s", e.what());
+    } catch (...) {
+        LOGE("stopTorrentByHash: unknown exception");
+    }
+
+    return JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// removeTorrentByHash(infoHash, removeData)  → bool
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_removeTorrentByHash(JNIEnv* env, jobject,
+                                                             jstring jHash,
+                                                             jboolean jRemoveData)
+{
+    if (!jHash) return JNI_FALSE;
+    const char* c = env->GetStringUTFChars(jHash, nullptr);
+    std::string hashStr(c ? c : "");
+    env->ReleaseStringUTFChars(jHash, c);
+
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!parse_hash_hex(hashStr, key) || !g_index.by_hash(key, e)) return JNI_FALSE;
+
+    remove_flags_t const flags = remove_flags_for(key, jRemoveData);
+    g_alerts.post([h = e.handle, flags](session& ses) { ses.remove_torrent(h, flags); });
+    return JNI_TRUE;
+}
 
 // -----------------------------------------------------------------
-// getTorrentSavePathByName(name)  → String?
+// getTorrentSavePathByHash(infoHash)  → String ("" if unknown)
 // -----------------------------------------------------------------
 JNIEXPORT jstring JNICALL
-Java_com_example_audyn_LibtorrentWrapper_getTorrentSavePathByName(JNIEnv* env, jobject,
-                                                                  jstring jName)
+Java_com_example_audyn_LibtorrentWrapper_getTorrentSavePathByHash(JNIEnv* env, jobject,
+                                                                  jstring jHash)
 {
-    if (!jName) return env->NewStringUTF("");
-    const char* name = env->GetStringUTFChars(jName, nullptr);
+    if (!jHash) return env->NewStringUTF("");
+    const char* c = env->GetStringUTFChars(jHash, nullptr);
+    std::string hashStr(c ? c : "");
+    env->ReleaseStringUTFChars(jHash, c);
 
     std::string path;
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        if (g_ses) {
-            for (auto const& th : g_ses->get_torrents()) {
-                if (th.is_valid() && th.status().name == name) {
-                    path = th.save_path();  // deprecated, but OK
-                    break;
-                }
-            }
+    sha1_hash key;
+    if (parse_hash_hex(hashStr, key)) {
+        torrent_index::entry e;
+        if (auto const row = g_status.snapshot()->find(key)) path = row->save_path;
+        else if (g_index.by_hash(key, e))                  path = e.save_path;
+    }
+    return env->NewStringUTF(path.c_str());
+}
+
+// -----------------------------------------------------------------
+// lookupInfoHash(nameOrPath)  → String ("" if unknown)
+// full source-file paths are matched exactly, anything else by norm_name()
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_lookupInfoHash(JNIEnv* env, jobject,
+                                                        jstring jQuery)
+{
+    if (!jQuery) return env->NewStringUTF("");
+    const char* c = env->GetStringUTFChars(jQuery, nullptr);
+    std::string query(c ? c : "");
+    env->ReleaseStringUTFChars(jQuery, c);
+
+    torrent_index::entry e;
+    bool const found = (query.find('/') != std::string::npos && g_index.by_path(query, e))
+                    || g_index.by_name(query, e);
+    return env->NewStringUTF(found ? aux::to_hex(e.key).c_str() : "");
+}
+
+
+// -----------------------------------------------------------------
+// getTorrentFiles(infoHash)  → {"info_hash","name","piece_length","files":[…]}
+// per-track progress of an album torrent ("" if unknown); blocks briefly
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getTorrentFiles(JNIEnv* env, jobject, jstring jHash)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || !parse_hash_hex(jstring_to_std(env, jHash), key) || !g_index.by_hash(key, e))
+        return env->NewStringUTF("");
+
+    json_writer w(json_arena());
+    bool ok = false;
+    try { ok = write_torrent_files(e.handle, w); }
+    catch (std::exception const& ex) { LOGE("getTorrentFiles: %s", ex.what()); }
+    return env->NewStringUTF(ok ? w.str().c_str() : "");
+}
+
+// -----------------------------------------------------------------
+// setTorrentFilePriorities(infoHash, priorities)  → bool
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_setTorrentFilePriorities(JNIEnv* env, jobject,
+                                                                  jstring jHash,
+                                                                  jintArray jPrio)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || !jPrio || !parse_hash_hex(jstring_to_std(env, jHash), key)
+        || !g_index.by_hash(key, e)) return JNI_FALSE;
+
+    std::vector<int> prio(static_cast<std::size_t>(env->GetArrayLength(jPrio)));
+    env->GetIntArrayRegion(jPrio, 0, static_cast<jsize>(prio.size()), reinterpret_cast<jint*>(prio.data()));
+    try { return set_file_priorities(e.handle, prio) ? JNI_TRUE : JNI_FALSE; }
+    catch (std::exception const& ex) { LOGE("setTorrentFilePriorities: %s", ex.what()); }
+    return JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// setTorrentVersion("hybrid" | "v1" | "v2")  → bool
+// for every torrent created from now on; hybrid is the default
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_setTorrentVersion(JNIEnv* env, jobject, jstring jVersion)
+{
+    torrent_version v;
+    if (!jVersion || !parse_torrent_version(jstring_to_std(env, jVersion), v)) return JNI_FALSE;
+    g_torrent_version.store(v);
+    return JNI_TRUE;
+}
+
+// -----------------------------------------------------------------
+// setPreambleSeconds(seconds)  → bool
+// opening seconds of audio embedded in every torrent created from now on,
+// for peers to start playing before the swarm answers; 0 (the default)
+// embeds none
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_setPreambleSeconds(JNIEnv*, jobject, jint seconds)
+{
+    if (seconds < 0 || seconds > max_preamble_seconds) return JNI_FALSE;
+    g_preamble_seconds.store(seconds);
+    return JNI_TRUE;
+}
+
+// -----------------------------------------------------------------
+// findTorrentsByFileRoot(rootHex)  → [{"info_hash","file_index","path"}]
+// every loaded file with this v2 merkle root, e.g. one track in several
+// albums ("" on a malformed root)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_findTorrentsByFileRoot(JNIEnv* env, jobject, jstring jRoot)
+{
+    if (!jRoot) return env->NewStringUTF("");
+    json_writer w(json_arena());
+    bool ok = false;
+    try { ok = write_file_root_matches(jstring_to_std(env, jRoot), w); }
+    catch (std::exception const& e) { LOGE("findTorrentsByFileRoot: %s", e.what()); }
+    return env->NewStringUTF(ok ? w.str().c_str() : "");
+}
+
+// -----------------------------------------------------------------
+// getStreamUrl(infoHash, fileIndex)  → "http://127.0.0.1:<port>/stream/…"
+// for the player; pieces are fetched in playback order as it reads. Starts
+// the loopback server on first use ("" for an unknown torrent)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getStreamUrl(JNIEnv* env, jobject, jstring jHash, jint fileIndex)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || fileIndex < 0 || !parse_hash_hex(jstring_to_std(env, jHash), key)
+        || !g_index.by_hash(key, e)) return env->NewStringUTF("");
+    return env->NewStringUTF(g_stream.url(key, fileIndex).c_str());
+}
+
+// -----------------------------------------------------------------
+// stopStreamServer()  – drops every open stream
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_stopStreamServer(JNIEnv*, jobject)
+{
+    g_stream.stop();
+}
+
+// -----------------------------------------------------------------
+// updatePlayback(infoHash, fileIndex, positionMs, durationMs, bitrateKbps,
+//                playing, seek)  → {"buffer_s","window_s","underruns",…}
+// moves the piece deadlines to the player's play head; call about once a
+// second and right after a seek ("" for an unknown torrent or file)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_updatePlayback(JNIEnv* env, jobject, jstring jHash,
+                                                        jint fileIndex, jlong positionMs,
+                                                        jlong durationMs, jint bitrateKbps,
+                                                        jboolean playing, jboolean seek)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || !parse_hash_hex(jstring_to_std(env, jHash), key)
+        || !g_index.by_hash(key, e)) return env->NewStringUTF("");
+
+    playback_scheduler::health h;
+    json_writer w(json_arena());
+    bool ok = false;
+    try {
+        ok = g_playback.update(e, fileIndex, std::max<jlong>(0, positionMs), durationMs,
+                               bitrateKbps, playing == JNI_TRUE, seek == JNI_TRUE, h);
+    } catch (std::exception const& ex) { LOGE("updatePlayback: %s", ex.what()); }
+    if (ok) write_playback_health(w, h);
+    return env->NewStringUTF(ok ? w.str().c_str() : "");
+}
+
+// -----------------------------------------------------------------
+// setPrefetchQueue(infoHashes, fileIndices, startsInMs)  → bool
+// the player's upcoming swarm tracks in play order; the first few get the
+// opening seconds of their audio fetched ahead of time. startsInMs[i] is
+// when that track is due (-1 unknown); an empty queue cancels everything
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_setPrefetchQueue(JNIEnv* env, jobject, jobjectArray jHashes,
+                                                          jintArray jFiles, jlongArray jStarts)
+{
+    auto const hashes = jstrings_to_std(env, jHashes);
+    std::vector<jint>  files(hashes.size(), 0);
+    std::vector<jlong> starts(hashes.size(), -1);
+    if (jFiles && env->GetArrayLength(jFiles) >= static_cast<jsize>(files.size()))
+        env->GetIntArrayRegion(jFiles, 0, static_cast<jsize>(files.size()), files.data());
+    if (jStarts && env->GetArrayLength(jStarts) >= static_cast<jsize>(starts.size()))
+        env->GetLongArrayRegion(jStarts, 0, static_cast<jsize>(starts.size()), starts.data());
+
+    std::vector<prefetch_manager::item> queue;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        prefetch_manager::item it;
+        if (!parse_hash_hex(hashes[i], it.key)) continue;
+        it.file         = files[i];
+        it.starts_in_ms = starts[i];
+        queue.push_back(it);
+    }
+    try { g_prefetch.set_queue(queue); return JNI_TRUE; }
+    catch (std::exception const& ex) { LOGE("setPrefetchQueue: %s", ex.what()); }
+    return JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// configurePrefetch(seconds, tracks, budgetBytes)  – negative keeps a value
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_configurePrefetch(JNIEnv*, jobject, jint seconds,
+                                                           jint tracks, jlong budgetBytes)
+{
+    g_prefetch.configure(seconds, tracks, budgetBytes);
+}
+
+// -----------------------------------------------------------------
+// getPrefetchStats()  → {"seconds","tracks","budget","used","entries":[…]}
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getPrefetchStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    g_prefetch.write_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// configureReadCache(capacityBytes)  – RAM for pieces streamed back from
+// disk (default 32 MiB, 0 turns it off)
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_configureReadCache(JNIEnv*, jobject, jlong capacityBytes)
+{
+    if (capacityBytes >= 0) g_piece_cache.set_capacity(static_cast<std::size_t>(capacityBytes));
+}
+
+// -----------------------------------------------------------------
+// trimReadCache(level)  – onTrimMemory(level): gives the memory of the
+// read cache and the upload cache back (static: called from the
+// process-wide ComponentCallbacks2)
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_trimReadCache(JNIEnv*, jclass, jint level)
+{
+    g_piece_cache.trim(level);
+    g_upload_cache.trim(level);
+}
+
+// -----------------------------------------------------------------
+// getReadCacheStats()  → {"capacity","bytes","entries","hits","misses",
+// "hit_rate","evictions","trims"}
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getReadCacheStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    g_piece_cache.write_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// configureUploadCache(capacityBytes)  – RAM pinned for the most requested
+// pieces of seeded torrents (default 16 MiB, 0 turns it off)
+// -----------------------------------------------------------------
+JNIEXPORT void JNICALL
+Java_com_example_audyn_LibtorrentWrapper_configureUploadCache(JNIEnv*, jobject, jlong capacityBytes)
+{
+    if (capacityBytes >= 0) g_upload_cache.set_capacity(static_cast<std::size_t>(capacityBytes));
+}
+
+// -----------------------------------------------------------------
+// getUploadCacheStats()  → {"capacity","bytes","entries","tracked","hits",
+// "misses","hit_rate","admitted","displaced","trims","hottest":[…]}
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getUploadCacheStats(JNIEnv* env, jobject)
+{
+    json_writer w(json_arena());
+    write_upload_cache_stats(w);
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// getSeekIndex(infoHash, fileIndex)  → {"format","duration_ms","points":
+// [{"ms","offset","piece"}], …} from the track's container header, or
+// {"pending":true,…} until its header pieces are in ("" without one)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getSeekIndex(JNIEnv* env, jobject, jstring jHash, jint fileIndex)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || !parse_hash_hex(jstring_to_std(env, jHash), key)
+        || !g_index.by_hash(key, e)) return env->NewStringUTF("");
+    json_writer w(json_arena());
+    bool ok = false;
+    try { ok = write_seek_index(e, fileIndex, w); }
+    catch (std::exception const& ex) { LOGE("getSeekIndex: %s", ex.what()); }
+    return env->NewStringUTF(ok ? w.str().c_str() : "");
+}
+
+// -----------------------------------------------------------------
+// getPreamble(infoHash)  → {"format","duration_ms","length","state"}
+// the preamble the torrent's .torrent carried; state is "pending" until
+// its pieces are checked, then "verified" or "rejected" ("" without one)
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getPreamble(JNIEnv* env, jobject, jstring jHash)
+{
+    sha1_hash key;
+    if (!jHash || !parse_hash_hex(jstring_to_std(env, jHash), key)) return env->NewStringUTF("");
+    json_writer w(json_arena());
+    return env->NewStringUTF(g_preambles.write_info(key, w) ? w.str().c_str() : "");
+}
+
+// -----------------------------------------------------------------
+// stopPlayback(infoHash, fileIndex)  – the player moved on; the play-head
+// window goes back to the regular picker
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_stopPlayback(JNIEnv* env, jobject, jstring jHash, jint fileIndex)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!jHash || !parse_hash_hex(jstring_to_std(env, jHash), key)
+        || !g_index.by_hash(key, e)) return JNI_FALSE;
+    try { return g_playback.stop(e.handle, fileIndex) ? JNI_TRUE : JNI_FALSE; }
+    catch (std::exception const& ex) { LOGE("stopPlayback: %s", ex.what()); }
+    return JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// getInfoHashesFromBytes(bytes)  → {"v1": hex|null, "v2": hex|null} or ""
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_getInfoHashesFromBytes(JNIEnv* env, jobject, jbyteArray jBytes)
+{
+    if (!jBytes) return env->NewStringUTF("");
+    std::vector<char> buf(static_cast<std::size_t>(env->GetArrayLength(jBytes)));
+    env->GetByteArrayRegion(jBytes, 0, static_cast<jsize>(buf.size()), reinterpret_cast<jbyte*>(buf.data()));
+
+    std::string err;
+    auto const ti = parse_torrent(buf.data(), buf.size(), err);
+    if (!ti) return env->NewStringUTF("");
+
+    auto const& ih = ti->info_hashes();
+    json_writer w(json_arena());
+    w.begin_object().key("v1");
+    if (ih.has_v1()) w.value(aux::to_hex(ih.v1)); else w.value(nullptr);
+    w.key("v2");
+    if (ih.has_v2()) w.value(aux::to_hex(ih.v2)); else w.value(nullptr);
+    w.end_object();
+    return env->NewStringUTF(w.str().c_str());
+}
+
+// -----------------------------------------------------------------
+// benchmarkJsonWriter()  → JSON [{torrents, legacy_ns_per, writer_ns_per, …}]
+// ns per torrent for the old lt::entry path vs. json_writer
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_benchmarkJsonWriter(JNIEnv* env, jobject)
+{
+    std::string const res = run_json_benchmark();
+    LOGI("json benchmark: %s", res.c_str());
+    return env->NewStringUTF(res.c_str());
+}
+
+// -----------------------------------------------------------------
+// benchmarkPieceHashing()  → {"best", "variants": [{name, sha1_mb_s, sha256_mb_s}]}
+// single-core MB/s of each SHA variant this CPU supports
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_benchmarkPieceHashing(JNIEnv* env, jobject)
+{
+    std::string const res = run_hash_benchmark();
+    LOGI("hash benchmark: %s", res.c_str());
+    return env->NewStringUTF(res.c_str());
+}
+
+// -----------------------------------------------------------------
+// configureDiskBackend(backend, ioUring, aioThreads, filePoolSize,
+//                      uploadCacheBytes, readCacheBytes)
+// "custom", "posix" or "mmap" for the next session (after cleanupSession()
+// if one runs); 0 threads / pool keep the defaults, -1 keeps a cache size.
+// False on an unknown backend, or while a session runs on another one.
+// -----------------------------------------------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_example_audyn_LibtorrentWrapper_configureDiskBackend(JNIEnv* env, jobject, jstring jBackend,
+                                                             jboolean jIoUring, jint aioThreads,
+                                                             jint filePoolSize, jlong uploadCacheBytes,
+                                                             jlong readCacheBytes)
+{
+    disk_config c;
+    if (!jBackend || !parse_disk_backend(jstring_to_std(env, jBackend), c.backend)) return JNI_FALSE;
+    c.io_uring       = jIoUring == JNI_TRUE;
+    c.aio_threads    = std::max(0, static_cast<int>(aioThreads));
+    c.file_pool_size = std::max(0, static_cast<int>(filePoolSize));
+    c.upload_cache   = uploadCacheBytes;
+    c.read_cache     = readCacheBytes;
+    return configure_disk(c) ? JNI_TRUE : JNI_FALSE;
+}
+
+// -----------------------------------------------------------------
+// benchmarkDiskBackends(dir, files, fileSizeBytes)  → {"files","file_size",
+// "reads","depth","download_files","backends":[{"name","available",
+// "seed":{…},"download":{…}}]}, each workload with mb_s, iops, p50_us,
+// p99_us and errors; 0 files / size for 10000 files of 64 KiB. Takes
+// seconds to minutes and writes to `dir`.
+// -----------------------------------------------------------------
+JNIEXPORT jstring JNICALL
+Java_com_example_audyn_LibtorrentWrapper_benchmarkDiskBackends(JNIEnv* env, jobject, jstring jDir,
+                                                              jint files, jlong fileSizeBytes)
+{
+    std::string const dir = jDir ? jstring_to_std(env, jDir) : std::string();
+    if (dir.empty()) return env->NewStringUTF("");
+    std::string const res = run_disk_benchmark(dir, files > 0 ? files : 10000,
+                                               fileSizeBytes > 0 ? fileSizeBytes : 64 << 10, 40000, 32);
+    LOGI("disk benchmark: %s", res.c_str());
+    return env->NewStringUTF(res.c_str());
+}
+
+
+} // extern "C"
+#endif // AUDYN_WITH_JNI
+
+// ───────────────────────  C ABI (dart:ffi)  ───────────────────
+// Declared in audyn_ffi.h. Runs on whatever thread the caller is on (a
+// Dart isolate, a benchmark) – nothing here touches JNI or the UI thread.
+
+// Just enough of dart_native_api.h to post flat lists of ints, strings
+// and byte arrays.
+namespace dart_api {
+enum cobject_type : std::int32_t { k_null = 0, k_int64 = 3, k_string = 5, k_array = 6, k_typed_data = 7 };
+enum typed_data_type : std::int32_t { k_uint8 = 2 };
+
+struct cobject {
+    cobject_type type;
+    union {
+        std::int64_t as_int64;
+        char const*  as_string;
+        struct { std::intptr_t length; cobject** values; } as_array;
+        struct { typed_data_type type; std::intptr_t length; std::uint8_t const* values; } as_typed_data;
+        void*        pad[5];    // keeps sizeof in line with Dart_CObject
+    } value;
+};
+
+using post_cobject_fn = bool (*)(std::int64_t port, cobject* message);
+} // namespace dart_api
+
+static std::atomic<dart_api::post_cobject_fn> g_dart_post{nullptr};
+
+static void post_list(dart_api::post_cobject_fn post, std::int64_t port,
+                      dart_api::cobject** items, std::intptr_t n)
+{
+    dart_api::cobject msg{};
+    msg.type = dart_api::k_array;
+    msg.value.as_array.length = n;
+    msg.value.as_array.values = items;
+    if (!post(port, &msg)) LOGE("ffi: port %lld closed", static_cast<long long>(port));
+}
+
+// [request_id, code, payload] – the VM deep-copies the message before
+// returning, so everything may live on the stack
+static void post_completion(std::int64_t port, std::int64_t request_id,
+                            std::int32_t code, std::string const& payload)
+{
+    auto const post = g_dart_post.load(std::memory_order_acquire);
+    if (!post || port == 0) return;
+
+    dart_api::cobject id{}, rc{}, body{};
+    id.type   = dart_api::k_int64;  id.value.as_int64   = request_id;
+    rc.type   = dart_api::k_int64;  rc.value.as_int64   = code;
+    body.type = dart_api::k_string; body.value.as_string = payload.c_str();
+
+    dart_api::cobject* items[] = { &id, &rc, &body };
+    post_list(post, port, items, 3);
+}
+
+// [job_id, state, pieces_done, num_pieces, error|null] for creation jobs
+static void post_job_event(std::int64_t port, create_job const& j)
+{
+    auto const post = g_dart_post.load(std::memory_order_acquire);
+    if (!post || port == 0) return;
+
+    std::string err;
+    auto const st = j.state.load();
+    if (st == job_state::failed) {
+        std::lock_guard<std::mutex> jl(j.m);
+        err = j.error;
+    }
+
+    dart_api::cobject id{}, state{}, done{}, total{}, body{};
+    id.type    = dart_api::k_int64; id.value.as_int64    = j.id;
+    state.type = dart_api::k_int64; state.value.as_int64 = static_cast<std::int64_t>(st);
+    done.type  = dart_api::k_int64; done.value.as_int64  = j.pieces_done.load();
+    total.type = dart_api::k_int64; total.value.as_int64 = j.num_pieces.load();
+    if (st == job_state::failed) { body.type = dart_api::k_string; body.value.as_string = err.c_str(); }
+    else                           body.type = dart_api::k_null;
+
+    dart_api::cobject* items[] = { &id, &state, &done, &total, &body };
+    post_list(post, port, items, 5);
+}
+
+// batch result: [batch_id, index, AUDYN_OK, Uint8List] or
+// [batch_id, index, AUDYN_EFAILED, error]; end: [batch_id, -1, ok, failed]
+static void post_batch_event(std::int64_t port, std::int64_t batch_id, std::int64_t index,
+                             std::int64_t a, std::vector<char> const* bytes,
+                             std::string const* error, std::int64_t b = 0)
+{
+    auto const post = g_dart_post.load(std::memory_order_acquire);
+    if (!post || port == 0) return;
+
+    dart_api::cobject id{}, idx{}, c3{}, c4{};
+    id.type  = dart_api::k_int64; id.value.as_int64  = batch_id;
+    idx.type = dart_api::k_int64; idx.value.as_int64 = index;
+    c3.type  = dart_api::k_int64; c3.value.as_int64  = a;
+    if (bytes) {
+        c4.type = dart_api::k_typed_data;
+        c4.value.as_typed_data.type   = dart_api::k_uint8;
+        c4.value.as_typed_data.length = static_cast<std::intptr_t>(bytes->size());
+        c4.value.as_typed_data.values = reinterpret_cast<std::uint8_t const*>(bytes->data());
+    } else if (error) {
+        c4.type = dart_api::k_string; c4.value.as_string = error->c_str();
+    } else {
+        c4.type = dart_api::k_int64;  c4.value.as_int64  = b;
+    }
+
+    dart_api::cobject* items[] = { &id, &idx, &c3, &c4 };
+    post_list(post, port, items, 4);
+}
+
+// snprintf-style copy into a caller-owned buffer
+static std::int64_t copy_out(std::string_view s, char* buf, std::int64_t cap)
+{
+    if (buf && cap > 0) {
+        std::size_t const n = std::min<std::size_t>(s.size(), static_cast<std::size_t>(cap - 1));
+        std::memcpy(buf, s.data(), n);
+        buf[n] = '\0';
+    }
+    return static_cast<std::int64_t>(s.size());
+}
+
+static std::string hash_hex(sha1_hash const& h)
+{
+    return aux::to_hex(h);
+}
+
+// the session is process-wide; the handle only marks "opened through FFI"
+struct audyn_session { int unused; };
+struct audyn_torrent { torrent_handle handle; sha1_hash key; };
+
+static audyn_session g_ffi_session{};
+
+extern "C" {
+
+AUDYN_API const char* audyn_version(void)
+{
+    return LIBTORRENT_VERSION;
+}
+
+AUDYN_API int32_t audyn_init_dart_api(void* post_cobject)
+{
+    if (!post_cobject) return AUDYN_EINVAL;
+    g_dart_post.store(reinterpret_cast<dart_api::post_cobject_fn>(post_cobject),
+                      std::memory_order_release);
+    return AUDYN_OK;
+}
+
+AUDYN_API audyn_session* audyn_session_open(void)
+{
+    try {
+        get_session();
+        return &g_ffi_session;
+    }
+    catch (std::exception const& e) { LOGE("audyn_session_open: %s", e.what()); }
+    return nullptr;
+}
+
+AUDYN_API audyn_session* audyn_session_open_with(const audyn_disk_options* o)
+{
+    if (o) {
+        disk_config c;
+        switch (o->backend) {
+        case AUDYN_DISK_CUSTOM: c.backend = disk_backend::custom; break;
+        case AUDYN_DISK_POSIX:  c.backend = disk_backend::posix;  break;
+        case AUDYN_DISK_MMAP:   c.backend = disk_backend::mmap;   break;
+        default: return nullptr;
         }
+        c.io_uring       = o->io_uring != 0;
+        c.aio_threads    = std::max(0, static_cast<int>(o->aio_threads));
+        c.file_pool_size = std::max(0, static_cast<int>(o->file_pool_size));
+        c.upload_cache   = o->upload_cache_bytes;
+        c.read_cache     = o->read_cache_bytes;
+        if (!configure_disk(c)) return nullptr;
     }
+    return audyn_session_open();
+}
 
-    env->ReleaseStringUTFChars(jName, name);
-    return env->NewStringUTF(path.c_str());
+AUDYN_API void audyn_session_close(audyn_session* s)
+{
+    if (s) shutdown_session();
+}
+
+AUDYN_API void audyn_refresh_status(audyn_session* s)
+{
+    if (s) g_status.request_refresh();
+}
+
+AUDYN_API int64_t audyn_torrents_json(audyn_session* s, char* buf, int64_t cap)
+{
+    if (!s) return AUDYN_EINVAL;
+    g_status.request_refresh();
+    json_writer w(json_arena());
+    write_rows(w, g_status.snapshot()->rows);
+    return copy_out(w.str(), buf, cap);
+}
+
+AUDYN_API int64_t audyn_updates_since(audyn_session* s, int64_t seq, char* buf, int64_t cap)
+{
+    if (!s) return AUDYN_EINVAL;
+    g_status.request_refresh();
+    json_writer w(json_arena());
+    write_updates(w, static_cast<std::uint64_t>(seq < 0 ? 0 : seq));
+    return copy_out(w.str(), buf, cap);
+}
+
+AUDYN_API int64_t audyn_executor_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    g_jobs.write_stats(w);
+    return copy_out(w.str(), buf, cap);
+}
+
+AUDYN_API int64_t audyn_status_buffer(audyn_session* s, int32_t capacity, const uint8_t** out)
+{
+    if (!s || !out) return AUDYN_EINVAL;
+    g_status_channel.ensure(static_cast<std::uint32_t>(std::max<int32_t>(capacity, 0)),
+                            *g_status.snapshot());
+    *out = static_cast<uint8_t const*>(g_status_channel.data());
+    return static_cast<int64_t>(g_status_channel.size());
+}
+
+AUDYN_API int64_t audyn_status_pin(int64_t since_seq)
+{
+    return static_cast<int64_t>(g_status_channel.pin(static_cast<std::uint64_t>(since_seq)));
 }
-// build an in‑memory torrent and return as jbyteArray
-static jbyteArray make_torrent_bytes(JNIEnv* env, const std::string& filePath)
+
+AUDYN_API void audyn_status_unpin(int64_t seq)
 {
-    lt::file_storage fs;
-    lt::add_files(fs, filePath);
-    if (fs.num_files() == 0) return nullptr;
+    g_status_channel.unpin(static_cast<std::uint64_t>(seq));
+    // a publish skipped while the slot was pinned goes out now
+    g_status_channel.write(*g_status.snapshot());
+}
 
-    lt::create_torrent t(fs);
-    std::string parent = filePath.substr(0, filePath.find_last_of('/'));
+static add_options to_add_options(audyn_add_options const* opts)
+{
+    add_options o;
+    if (opts) {
+        o.seed     = opts->seed_mode != 0;
+        o.announce = opts->announce != 0;
+        o.dht      = opts->enable_dht != 0;
+        o.lsd      = opts->enable_lsd != 0;
+        o.utp      = opts->enable_utp != 0;
+        o.trackers = opts->enable_trackers != 0;
+        o.pex      = opts->enable_pex != 0;
+    }
+    return o;
+}
 
-    lt::error_code ec;
-    lt::set_piece_hashes(t, parent, [&](lt::piece_index_t) { return false; }, ec);
-    if (ec) return nullptr;
+// shared by audyn_add_torrent_bytes() and audyn_add_library_torrent()
+static int32_t add_torrent_bytes(char const* caller, const uint8_t* data, int64_t len,
+                                 std::string save_path, add_options const& o,
+                                 int64_t port, int64_t request_id)
+{
+    std::string err;
+    auto ti = parse_torrent(reinterpret_cast<char const*>(data),
+                            static_cast<std::size_t>(len), err, !o.seed);
+    if (!ti) {
+        LOGE("%s: %s", caller, err.c_str());
+        return AUDYN_EPARSE;
+    }
 
-    std::vector<char> buf;
-    lt::bencode(std::back_inserter(buf), t.generate());
+    std::string const hex = hash_hex(cache_key(ti->info_hashes()));
+    auto p = std::make_shared<add_torrent_params>(make_add_params(std::move(ti), std::move(save_path), o));
 
-    jbyteArray arr = env->NewByteArray(static_cast<jsize>(buf.size()));
-    env->SetByteArrayRegion(
-            arr, 0, static_cast<jsize>(buf.size()),
-            reinterpret_cast<const jbyte*>(buf.data())
-    );
-    return arr;
+    bool const queued = g_alerts.post([p, o, hex, port, request_id](session& ses) {
+        apply_utp(ses, o);
+        error_code ec;
+        ses.add_torrent(std::move(*p), ec);
+        if (ec) post_completion(port, request_id, AUDYN_EFAILED, ec.message());
+        else    post_completion(port, request_id, AUDYN_OK, hex);
+    });
+    return queued ? AUDYN_OK : AUDYN_ENOSESSION;
 }
 
-/* ─────────────────────────────  NEW JNI wrapper  ─────────────────────────── */
+AUDYN_API int32_t audyn_add_torrent_bytes(audyn_session* s,
+                                          const uint8_t* data, int64_t len,
+                                          const char* save_path,
+                                          const audyn_add_options* opts,
+                                          int64_t port, int64_t request_id)
+{
+    if (!s || !data || len <= 0 || !save_path) return AUDYN_EINVAL;
+    return add_torrent_bytes("audyn_add_torrent_bytes", data, len, save_path,
+                             to_add_options(opts), port, request_id);
+}
 
-extern "C"
-JNIEXPORT jbyteArray JNICALL
-Java_com_example_audyn_LibtorrentWrapper_createTorrentBytes
-        (JNIEnv* env, jobject /*thiz*/, jstring jSourcePath)
+AUDYN_API int32_t audyn_add_library_torrent(audyn_session* s,
+                                            const uint8_t* data, int64_t len,
+                                            const char* source_path,
+                                            const audyn_add_options* opts,
+                                            int64_t port, int64_t request_id)
 {
-    if (!jSourcePath) return nullptr;
+    if (!s || !data || len <= 0 || !source_path || !*source_path) return AUDYN_EINVAL;
+    add_options o = to_add_options(opts);
+    o.seed   = true;
+    o.source = source_path;
+    return add_torrent_bytes("audyn_add_library_torrent", data, len, std::string(), o,
+                             port, request_id);
+}
 
-    const char* src = env->GetStringUTFChars(jSourcePath, nullptr);
-    std::string path(src ? src : "");
-    env->ReleaseStringUTFChars(jSourcePath, src);
+AUDYN_API int64_t audyn_library_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    write_library_stats(w);
+    return copy_out(w.str(), buf, cap);
+}
 
-    // Use the tested helper that already does the “parent‑dir” dance
-    jbyteArray arr = make_torrent_bytes(env, path);
+AUDYN_API audyn_torrent* audyn_torrent_find(audyn_session* s, const char* query)
+{
+    if (!s || !query) return nullptr;
+    std::string const q(query);
 
-    if (arr == nullptr) {
-        LOGE("createTorrentBytes: failed to generate torrent for \"%s\"", path.c_str());
-    }
-    return arr;        // null -> Dart will see “null bytes”
+    torrent_index::entry e;
+    sha1_hash key;
+    bool const found = (parse_hash_hex(q, key) && g_index.by_hash(key, e))
+                    || (q.find('/') != std::string::npos && g_index.by_path(q, e))
+                    || g_index.by_name(q, e);
+    if (!found) return nullptr;
+    return new (std::nothrow) audyn_torrent{ e.handle, e.key };
 }
 
+AUDYN_API void audyn_torrent_release(audyn_torrent* t)
+{
+    delete t;
+}
 
-
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_addTorrentFromBytes
-        (JNIEnv* env, jobject /*thiz*/,
-         jbyteArray jBytes, jstring jSavePath,
-         jboolean jSeed, jboolean jAnnounce,
-         jboolean jEnableDHT, jboolean jEnableLSD, jboolean jEnableUTP,
-         jboolean jEnableTrackers, jboolean jEnablePEX)
+AUDYN_API int32_t audyn_torrent_get_status(audyn_torrent* t, audyn_torrent_status* out)
 {
-    if (!jBytes || !jSavePath) return JNI_FALSE;
+    if (!t || !out) return AUDYN_EINVAL;
+    auto const row = g_status.snapshot()->find(t->key);
+    if (!row) return AUDYN_ENOTFOUND;
 
-    // grab inputs
-    jsize len     = env->GetArrayLength(jBytes);
-    jbyte* buffer = env->GetByteArrayElements(jBytes, nullptr);
-    const char* save = env->GetStringUTFChars(jSavePath, nullptr);
+    std::memcpy(out->info_hash, row->key.data(), sizeof(out->info_hash));
+    out->state           = static_cast<int32_t>(row->state);
+    out->progress        = row->progress;
+    out->download_rate   = row->download_rate;
+    out->upload_rate     = row->upload_rate;
+    out->num_peers       = row->num_peers;
+    out->num_seeds       = row->num_seeds;
+    out->total_done      = row->total_done;
+    out->total_wanted    = row->total_wanted;
+    out->all_time_upload = row->all_time_upload;
+    out->flags = (row->paused() ? AUDYN_TORRENT_PAUSED : 0)
+               | ((row->flags & torrent_flags::seed_mode) ? AUDYN_TORRENT_SEED_MODE : 0)
+               | (row->state == torrent_status::seeding || row->state == torrent_status::finished
+                     ? AUDYN_TORRENT_FINISHED : 0);
+    return AUDYN_OK;
+}
 
-    bool ok = false;
-    try {
-        auto& ses = get_session();
+AUDYN_API int64_t audyn_torrent_info_hash(audyn_torrent* t, char* buf, int64_t cap)
+{
+    if (!t) return AUDYN_EINVAL;
+    return copy_out(hash_hex(t->key), buf, cap);
+}
 
-        lt::error_code ec;
-        lt::bdecode_node root;
-        lt::bdecode(reinterpret_cast<char const*>(buffer),
-                    reinterpret_cast<char const*>(buffer) + len,
-                    root, ec);
-        if (ec) throw std::runtime_error(ec.message());
+AUDYN_API int64_t audyn_torrent_save_path(audyn_torrent* t, char* buf, int64_t cap)
+{
+    if (!t) return AUDYN_EINVAL;
+    if (auto const row = g_status.snapshot()->find(t->key))
+        return copy_out(row->save_path, buf, cap);
+    torrent_index::entry e;
+    if (g_index.by_hash(t->key, e)) return copy_out(e.save_path, buf, cap);
+    return AUDYN_ENOTFOUND;
+}
 
-        auto ti = std::make_shared<lt::torrent_info>(root, ec);
-        if (ec) throw std::runtime_error(ec.message());
+// torrent_handle calls are thread-safe and only queue work for the
+// network thread, so these need neither g_mtx nor the pump
+AUDYN_API int32_t audyn_torrent_pause(audyn_torrent* t)
+{
+    if (!t) return AUDYN_EINVAL;
+    if (!t->handle.is_valid()) return AUDYN_ENOTFOUND;
+    t->handle.pause();
+    return AUDYN_OK;
+}
 
-        lt::add_torrent_params p;
-        p.ti        = ti;
-        p.save_path = save;
-        if (jSeed)           p.flags |= seed_mode;
-        if (!jAnnounce)      p.flags |= paused;
-        if (!jEnableDHT)     p.flags |= disable_dht;
-        if (!jEnableLSD)     p.flags |= disable_lsd;
-        if (!jEnablePEX)     p.flags |= disable_pex;
-        if (!jEnableTrackers) p.trackers.clear();
+AUDYN_API int32_t audyn_torrent_resume(audyn_torrent* t)
+{
+    if (!t) return AUDYN_EINVAL;
+    if (!t->handle.is_valid()) return AUDYN_ENOTFOUND;
+    t->handle.resume();
+    return AUDYN_OK;
+}
 
-        if (!jEnableUTP) {
-            lt::settings_pack sp;
-            sp.set_bool(lt::settings_pack::enable_outgoing_utp, false);
-            sp.set_bool(lt::settings_pack::enable_incoming_utp, false);
-            ses.apply_settings(sp);
-        }
+AUDYN_API int32_t audyn_torrent_remove(audyn_torrent* t, int32_t remove_data,
+                                       int64_t port, int64_t request_id)
+{
+    if (!t) return AUDYN_EINVAL;
+    remove_flags_t const flags = remove_flags_for(t->key, remove_data != 0);
+    std::string const hex = hash_hex(t->key);
+    bool const queued = g_alerts.post([h = t->handle, flags, hex, port, request_id](session& ses) {
+        ses.remove_torrent(h, flags);
+        post_completion(port, request_id, AUDYN_OK, hex);
+    });
+    return queued ? AUDYN_OK : AUDYN_ENOSESSION;
+}
 
-        ses.async_add_torrent(std::move(p));
-        ok = true;
+AUDYN_API int64_t audyn_torrent_files_json(audyn_torrent* t, char* buf, int64_t cap)
+{
+    if (!t) return AUDYN_EINVAL;
+    json_writer w(json_arena());
+    try {
+        if (!write_torrent_files(t->handle, w)) return AUDYN_ENOTFOUND;
     } catch (std::exception const& e) {
-        LOGE("addTorrentFromBytes: %s", e.what());
+        LOGE("audyn_torrent_files_json: %s", e.what());
+        return AUDYN_EFAILED;
     }
-
-    // cleanup JNI refs
-    env->ReleaseByteArrayElements(jBytes, buffer, JNI_ABORT);
-    env->ReleaseStringUTFChars(jSavePath, save);
-    return ok ? JNI_TRUE : JNI_FALSE;
+    return copy_out(w.str(), buf, cap);
 }
-extern libtorrent::session* g_session;
 
-extern "C"
-lt::sha1_hash hex_to_sha1(const std::string& hex) {
-    lt::sha1_hash hash;
-    for (int i = 0; i < 20; ++i) {
-        std::string byteString = hex.substr(i * 2, 2);
-        hash[i] = static_cast<unsigned char>(std::stoul(byteString, nullptr, 16));
+AUDYN_API int32_t audyn_torrent_set_file_priorities(audyn_torrent* t, const int32_t* prio, int32_t n)
+{
+    if (!t || (!prio && n > 0) || n < 0) return AUDYN_EINVAL;
+    try {
+        return set_file_priorities(t->handle, std::vector<int>(prio, prio + n)) ? AUDYN_OK : AUDYN_ENOTFOUND;
+    } catch (std::exception const& e) {
+        LOGE("audyn_torrent_set_file_priorities: %s", e.what());
     }
-    return hash;
+    return AUDYN_EFAILED;
 }
 
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_isTorrentActive(JNIEnv *env, jobject thiz, jstring j_info_hash) {
-    const char *info_hash_str = env->GetStringUTFChars(j_info_hash, nullptr);
-    std::string hashStr(info_hash_str ? info_hash_str : "");
-    env->ReleaseStringUTFChars(j_info_hash, info_hash_str);
+AUDYN_API int32_t audyn_set_torrent_version(int32_t version)
+{
+    if (version < 0 || version > 2) return AUDYN_EINVAL;
+    g_torrent_version.store(static_cast<torrent_version>(version));
+    return AUDYN_OK;
+}
 
-    if (hashStr.length() != 40) {
-        LOGE("Invalid infoHash length: %s", hashStr.c_str());
-        return JNI_FALSE;
-    }
+AUDYN_API int32_t audyn_set_preamble_seconds(int32_t seconds)
+{
+    if (seconds < 0 || seconds > max_preamble_seconds) return AUDYN_EINVAL;
+    g_preamble_seconds.store(seconds);
+    return AUDYN_OK;
+}
 
-    lt::sha1_hash hash = hex_to_sha1(hashStr);
+AUDYN_API int64_t audyn_find_file_root(const char* root_hex, char* buf, int64_t cap)
+{
+    if (!root_hex) return AUDYN_EINVAL;
+    json_writer w(json_arena());
+    try {
+        if (!write_file_root_matches(root_hex, w)) return AUDYN_EINVAL;
+    } catch (std::exception const& e) {
+        LOGE("audyn_find_file_root: %s", e.what());
+        return AUDYN_EFAILED;
+    }
+    return copy_out(w.str(), buf, cap);
+}
 
-    std::lock_guard<std::mutex> lk(g_mtx);
-    if (!g_ses) return JNI_FALSE;
+AUDYN_API int64_t audyn_stream_url(const char* info_hash, int32_t file_index, char* buf, int64_t cap)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!info_hash || file_index < 0 || !parse_hash_hex(info_hash, key)) return AUDYN_EINVAL;
+    if (!g_index.by_hash(key, e)) return AUDYN_ENOTFOUND;
+    std::string const url = g_stream.url(key, file_index);
+    if (url.empty()) return AUDYN_EFAILED;
+    return copy_out(url, buf, cap);
+}
 
-    auto handle = g_ses->find_torrent(hash);
-    bool isActive = handle.is_valid() && !handle.status().paused;
-    return isActive ? JNI_TRUE : JNI_FALSE;
+AUDYN_API void audyn_stream_stop(void)
+{
+    g_stream.stop();
 }
 
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_startTorrentByHash(JNIEnv *env, jobject /*thiz*/, jstring j_info_hash) {
-    const char *info_hash_str = env->GetStringUTFChars(j_info_hash, nullptr);
-    std::string hashStr(info_hash_str ? info_hash_str : "");
-    env->ReleaseStringUTFChars(j_info_hash, info_hash_str);
+AUDYN_API int64_t audyn_playback_update(const char* info_hash, int32_t file_index,
+                                        int64_t position_ms, int64_t duration_ms,
+                                        int32_t bitrate_kbps, int32_t playing, int32_t seek,
+                                        char* buf, int64_t cap)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!info_hash || file_index < 0 || !parse_hash_hex(info_hash, key)) return AUDYN_EINVAL;
+    if (!g_index.by_hash(key, e)) return AUDYN_ENOTFOUND;
 
-    if (hashStr.length() != 40) {
-        LOGE("Invalid infoHash length: %s", hashStr.c_str());
-        return JNI_FALSE;
+    playback_scheduler::health h;
+    try {
+        if (!g_playback.update(e, file_index, std::max<int64_t>(0, position_ms), duration_ms,
+                               bitrate_kbps, playing != 0, seek != 0, h))
+            return AUDYN_ENOTFOUND;
+    } catch (std::exception const& ex) {
+        LOGE("audyn_playback_update: %s", ex.what());
+        return AUDYN_EFAILED;
     }
+    json_writer w(json_arena());
+    write_playback_health(w, h);
+    return copy_out(w.str(), buf, cap);
+}
 
-    lt::sha1_hash hash = hex_to_sha1(hashStr);
+AUDYN_API int64_t audyn_seek_index(const char* info_hash, int32_t file_index, char* buf, int64_t cap)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!info_hash || file_index < 0 || !parse_hash_hex(info_hash, key)) return AUDYN_EINVAL;
+    if (!g_index.by_hash(key, e)) return AUDYN_ENOTFOUND;
+    json_writer w(json_arena());
+    try {
+        if (!write_seek_index(e, file_index, w)) return AUDYN_ENOTFOUND;
+    } catch (std::exception const& ex) {
+        LOGE("audyn_seek_index: %s", ex.what());
+        return AUDYN_EFAILED;
+    }
+    return copy_out(w.str(), buf, cap);
+}
 
-    std::lock_guard<std::mutex> lk(g_mtx);
-    if (!g_ses) return JNI_FALSE;
+AUDYN_API int64_t audyn_preamble(const char* info_hash, char* buf, int64_t cap)
+{
+    sha1_hash key;
+    if (!info_hash || !parse_hash_hex(info_hash, key)) return AUDYN_EINVAL;
+    json_writer w(json_arena());
+    if (!g_preambles.write_info(key, w)) return AUDYN_ENOTFOUND;
+    return copy_out(w.str(), buf, cap);
+}
 
-    auto handle = g_ses->find_torrent(hash);
-    if (!handle.is_valid()) {
-        LOGE("startTorrentByHash: No valid torrent found for hash %s", hashStr.c_str());
-        return JNI_FALSE;
+AUDYN_API int32_t audyn_prefetch_queue(const char* const* info_hashes, const int32_t* file_indices,
+                                       const int64_t* starts_in_ms, int32_t n)
+{
+    if (n < 0 || (n > 0 && (!info_hashes || !file_indices))) return AUDYN_EINVAL;
+    std::vector<prefetch_manager::item> queue;
+    for (int32_t i = 0; i < n; ++i) {
+        prefetch_manager::item it;
+        if (!info_hashes[i] || !parse_hash_hex(info_hashes[i], it.key)) continue;
+        it.file         = file_indices[i];
+        it.starts_in_ms = starts_in_ms ? starts_in_ms[i] : -1;
+        queue.push_back(it);
     }
-
-    if (handle.status().paused) {
-        handle.resume();
-        LOGI("Torrent resumed for hash: %s", hashStr.c_str());
-    } else {
-        LOGI("Torrent already running for hash: %s", hashStr.c_str());
+    try {
+        g_prefetch.set_queue(queue);
+    } catch (std::exception const& ex) {
+        LOGE("audyn_prefetch_queue: %s", ex.what());
+        return AUDYN_EFAILED;
     }
-
-    return JNI_TRUE;
+    return AUDYN_OK;
 }
-// JNI wrapper for getInfoHash
-JNIEXPORT jstring JNICALL
-Java_com_example_audyn_LibtorrentWrapper_getInfoHash(JNIEnv* env, jobject, jstring torrentPath) {
-    const char* nativePath = env->GetStringUTFChars(torrentPath, nullptr);
-    if (!nativePath) return env->NewStringUTF("");
 
-    std::vector<char> buf;
-    std::ifstream in(nativePath, std::ios_base::binary);
-    if (!in) {
-        env->ReleaseStringUTFChars(torrentPath, nativePath);
-        return env->NewStringUTF("");
-    }
+AUDYN_API void audyn_prefetch_configure(int32_t seconds, int32_t tracks, int64_t budget_bytes)
+{
+    g_prefetch.configure(seconds, tracks, budget_bytes);
+}
 
-    in.unsetf(std::ios_base::skipws);
-    in.seekg(0, std::ios_base::end);
-    std::streampos fileSize = in.tellg();
-    in.seekg(0, std::ios_base::beg);
-    buf.reserve(fileSize);
-    buf.insert(buf.begin(),
-               std::istream_iterator<char>(in),
-               std::istream_iterator<char>());
+AUDYN_API int64_t audyn_prefetch_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    g_prefetch.write_stats(w);
+    return copy_out(w.str(), buf, cap);
+}
 
-    lt::error_code ec;
-    lt::bdecode_node node;
-    lt::bdecode(buf.data(), buf.data() + buf.size(), node, ec);
-    if (ec) {
-        env->ReleaseStringUTFChars(torrentPath, nativePath);
-        return env->NewStringUTF("");
-    }
+AUDYN_API void audyn_read_cache_configure(int64_t capacity_bytes)
+{
+    if (capacity_bytes >= 0) g_piece_cache.set_capacity(static_cast<std::size_t>(capacity_bytes));
+}
 
-    lt::torrent_info ti(node, ec);
-    if (ec) {
-        env->ReleaseStringUTFChars(torrentPath, nativePath);
-        return env->NewStringUTF("");
-    }
+AUDYN_API void audyn_read_cache_trim(int32_t level)
+{
+    g_piece_cache.trim(level);
+    g_upload_cache.trim(level);
+}
 
-    std::string hash = ti.info_hashes().v1.to_string();
-    env->ReleaseStringUTFChars(torrentPath, nativePath);
-    return env->NewStringUTF(hash.c_str());
+AUDYN_API int64_t audyn_read_cache_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    g_piece_cache.write_stats(w);
+    return copy_out(w.str(), buf, cap);
 }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_example_audyn_LibtorrentWrapper_getInfoHashFromBytes(
-        JNIEnv *env,
-        jobject /* this */,
-        jbyteArray torrentBytes) {
+AUDYN_API void audyn_upload_cache_configure(int64_t capacity_bytes)
+{
+    if (capacity_bytes >= 0) g_upload_cache.set_capacity(static_cast<std::size_t>(capacity_bytes));
+}
 
-    jsize length = env->GetArrayLength(torrentBytes);
-    std::vector<char> buffer(length);
-    env->GetByteArrayRegion(torrentBytes, 0, length, reinterpret_cast<jbyte *>(buffer.data()));
+AUDYN_API int64_t audyn_upload_cache_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    write_upload_cache_stats(w);
+    return copy_out(w.str(), buf, cap);
+}
 
+AUDYN_API int32_t audyn_playback_stop(const char* info_hash, int32_t file_index)
+{
+    sha1_hash key;
+    torrent_index::entry e;
+    if (!info_hash || !parse_hash_hex(info_hash, key)) return AUDYN_EINVAL;
+    if (!g_index.by_hash(key, e)) return AUDYN_ENOTFOUND;
     try {
-        lt::error_code ec;
-        lt::bdecode_node node;
-        lt::bdecode(buffer.data(), buffer.data() + buffer.size(), node, ec);
+        return g_playback.stop(e.handle, file_index) ? AUDYN_OK : AUDYN_ENOTFOUND;
+    } catch (std::exception const& ex) {
+        LOGE("audyn_playback_stop: %s", ex.what());
+    }
+    return AUDYN_EFAILED;
+}
 
-        if (ec) {
-            std::string err = "Failed to bdecode: " + ec.message();
-            return env->NewStringUTF(err.c_str());
-        }
+AUDYN_API int64_t audyn_create_job_start(const char* source, const char* output,
+                                         const char* const* trackers, int32_t num_trackers,
+                                         int32_t background, int64_t port)
+{
+    if (!source || num_trackers < 0 || (num_trackers > 0 && !trackers)) return AUDYN_EINVAL;
 
-        // Create torrent_info from bdecoded node
-        lt::torrent_info info(node, ec);
+    auto j = std::make_shared<create_job>();
+    j->source = source;
+    if (output) j->output = output;
+    for (int32_t i = 0; i < num_trackers; ++i)
+        if (trackers[i]) j->trackers.emplace_back(trackers[i]);
+    j->lane = background ? job_lane::background : job_lane::interactive;
+    if (port != 0)
+        j->on_event = [port](create_job const& job) { post_job_event(port, job); };
+    return g_create_jobs.start(std::move(j));
+}
 
-        if (ec) {
-            std::string err = "Failed to parse torrent_info: " + ec.message();
-            return env->NewStringUTF(err.c_str());
-        }
+AUDYN_API int64_t audyn_create_job_poll(int64_t id, char* buf, int64_t cap)
+{
+    auto const j = g_create_jobs.find(id);
+    if (!j) return AUDYN_ENOTFOUND;
+    json_writer w(json_arena());
+    g_create_jobs.write_job(w, *j);
+    return copy_out(w.str(), buf, cap);
+}
 
-        lt::sha1_hash hash = info.info_hashes().v1;  // For v1 torrents
-        std::ostringstream oss;
-        oss << hash;
+AUDYN_API int32_t audyn_create_job_cancel(int64_t id)
+{
+    return g_create_jobs.cancel(id) ? AUDYN_OK : AUDYN_ENOTFOUND;
+}
 
-        return env->NewStringUTF(oss.str().c_str());
+AUDYN_API int64_t audyn_create_job_take(int64_t id, uint8_t* buf, int64_t cap)
+{
+    // too small: the size is reported and the result kept for another call
+    std::int64_t size = 0;
+    bool known = false;
+    if (!g_create_jobs.take(id, buf, cap, size, known)) return known ? AUDYN_EFAILED : AUDYN_ENOTFOUND;
+    return size;
+}
 
-    } catch (const std::exception &ex) {
-        std::string err = "Exception: " + std::string(ex.what());
-        return env->NewStringUTF(err.c_str());
-    }
+AUDYN_API void audyn_create_job_concurrency(int32_t n)
+{
+    g_create_jobs.set_concurrency(n);
 }
-JNIEXPORT jboolean JNICALL
-Java_com_example_audyn_LibtorrentWrapper_stopTorrentByHash(JNIEnv *env, jobject /* this */, jstring infoHashJ) {
-    const char *infoHashC = env->GetStringUTFChars(infoHashJ, nullptr);
-    std::string infoHash(infoHashC);
-    env->ReleaseStringUTFChars(infoHashJ, infoHashC);
 
-    if (infoHash.length() != 40) {
-        LOGE("stopTorrentByHash: invalid hash length: %s", infoHash.c_str());
-        return JNI_FALSE;
+AUDYN_API int64_t audyn_create_batch(const char* const* paths, int32_t num_paths,
+                                     const char* const* trackers, int32_t num_trackers,
+                                     int64_t port)
+{
+    if (!paths || num_paths < 0 || num_trackers < 0 || (num_trackers > 0 && !trackers))
+        return AUDYN_EINVAL;
+
+    auto b = std::make_shared<hash_batch>();
+    b->paths.reserve(static_cast<std::size_t>(num_paths));
+    for (int32_t i = 0; i < num_paths; ++i) b->paths.emplace_back(paths[i] ? paths[i] : "");
+    for (int32_t i = 0; i < num_trackers; ++i)
+        if (trackers[i]) b->trackers.emplace_back(trackers[i]);
+    if (port != 0) {
+        b->on_result = [port](hash_batch const& batch, std::size_t i, std::vector<char>&& buf,
+                              std::string const& err) {
+            if (err.empty()) post_batch_event(port, batch.id, static_cast<std::int64_t>(i), AUDYN_OK, &buf, nullptr);
+            else             post_batch_event(port, batch.id, static_cast<std::int64_t>(i), AUDYN_EFAILED, nullptr, &err);
+        };
+        b->on_done = [port](hash_batch const& batch, int ok, int failed) {
+            post_batch_event(port, batch.id, -1, ok, nullptr, nullptr, failed);
+        };
     }
+    return g_batches.start(std::move(b));
+}
 
-    try {
-        lt::sha1_hash hash;
-        lt::from_hex(infoHash.c_str(), infoHash.size(), hash.data());
+AUDYN_API int32_t audyn_cancel_batch(int64_t id)
+{
+    return g_batches.cancel(id) ? AUDYN_OK : AUDYN_ENOTFOUND;
+}
 
-        std::lock_guard<std::mutex> lk(g_mtx);
-        if (!g_ses) return JNI_FALSE;
+AUDYN_API int64_t audyn_hash_benchmark(char* buf, int64_t cap)
+{
+    return copy_out(run_hash_benchmark(), buf, cap);
+}
 
-        auto handle = g_ses->find_torrent(hash);
-        if (handle.is_valid()) {
-            handle.pause();
-            LOGI("Torrent paused for hash: %s", infoHash.c_str());
-            return JNI_TRUE;
-        }
-    } catch (const std::exception& e) {
-        LOGE("stopTorrentByHash exception: %s", e.what());
-    } catch (...) {
-        LOGE("stopTorrentByHash: unknown exception");
+AUDYN_API int64_t audyn_disk_benchmark(const char* dir, int32_t files, int64_t file_size,
+                                       char* buf, int64_t cap)
+{
+    if (!dir || !*dir) return AUDYN_EINVAL;
+    return copy_out(run_disk_benchmark(dir, files > 0 ? files : 10000,
+                                       file_size > 0 ? file_size : 64 << 10, 40000, 32),
+                    buf, cap);
+}
+
+AUDYN_API int64_t audyn_audio_identity(const char* path, char* buf, int64_t cap)
+{
+    if (!path) return AUDYN_EINVAL;
+    std::string err;
+    json_writer w(json_arena());
+    if (!write_audio_identity(w, path, err)) {
+        LOGE("audyn_audio_identity %s: %s", path, err.c_str());
+        return AUDYN_EFAILED;
     }
+    return copy_out(w.str(), buf, cap);
+}
 
-    return JNI_FALSE;
+AUDYN_API int32_t audyn_torrent_cache_open(const char* dir)
+{
+    if (!dir) return AUDYN_EINVAL;
+    return g_torrent_cache.open(dir) ? AUDYN_OK : AUDYN_EFAILED;
+}
+
+AUDYN_API int64_t audyn_torrent_cache_stats(char* buf, int64_t cap)
+{
+    json_writer w(json_arena());
+    g_torrent_cache.write_stats(w);
+    return copy_out(w.str(), buf, cap);
 }
 
+AUDYN_API void audyn_torrent_cache_clear(void)
+{
+    g_torrent_cache.clear();
+}
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
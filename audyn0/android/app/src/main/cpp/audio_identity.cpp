@@ -0,0 +1,256 @@
+// audio_identity.cpp  –  see audio_identity.hpp
+#include "audio_identity.hpp"
+#include "audio_tags.hpp"
+#include "piece_hash.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace audio_identity {
+namespace {
+
+using audio_tags::be32;
+using audio_tags::le32;
+
+struct range {
+    std::int64_t offset;
+    std::int64_t length;
+};
+
+class input {
+public:
+    explicit input(std::string const& path)
+        : m_fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+    {
+        struct ::stat st{};
+        if (m_fd >= 0 && ::fstat(m_fd, &st) == 0) m_size = st.st_size;
+    }
+    ~input() { if (m_fd >= 0) ::close(m_fd); }
+    input(input const&) = delete;
+    input& operator=(input const&) = delete;
+
+    bool ok() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+    std::int64_t size() const { return m_size; }
+
+    // exactly `n` bytes at `off`, or false
+    bool read(std::int64_t off, void* buf, std::size_t n) const
+    {
+        if (off < 0 || off + std::int64_t(n) > m_size) return false;
+        auto* p = static_cast<std::uint8_t*>(buf);
+        for (std::size_t got = 0; got < n; ) {
+            ssize_t const r = ::pread(m_fd, p + got, n - got, static_cast<off_t>(off + std::int64_t(got)));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    // `tag` is at `off`
+    bool has(std::int64_t off, char const* tag) const
+    {
+        std::size_t const n = std::strlen(tag);
+        char buf[16];
+        return n <= sizeof buf && read(off, buf, n) && std::memcmp(buf, tag, n) == 0;
+    }
+
+    // read() for the audio_tags helpers
+    audio_tags::reader tag_reader() const
+    {
+        return [this](std::int64_t off, void* buf, std::size_t n) { return read(off, buf, n); };
+    }
+
+private:
+    int          m_fd   = -1;
+    std::int64_t m_size = 0;
+};
+
+// MP3 frames sit between the leading ID3v2 tags and whatever trails them
+bool mp3_payload(input const& in, std::int64_t begin, std::vector<range>& out)
+{
+    std::int64_t const end = audio_tags::strip_trailing(in.tag_reader(), begin, in.size());
+    if (end <= begin) return false;
+    out.push_back({begin, end - begin});
+    return true;
+}
+
+// FLAC frames follow the last metadata block; a stray ID3v1 at the end
+// (some taggers write one) is dropped as well
+bool flac_payload(input const& in, std::int64_t begin, std::vector<range>& out)
+{
+    std::int64_t pos = begin + 4;
+    for (;;) {
+        std::uint8_t h[4];
+        if (!in.read(pos, h, sizeof h)) return false;
+        pos += 4 + ((std::int64_t(h[1]) << 16) | (std::int64_t(h[2]) << 8) | h[3]);
+        if (h[0] & 0x80) break;
+    }
+    std::int64_t const end = audio_tags::strip_id3v1(in.tag_reader(), pos, in.size());
+    if (end <= pos) return false;
+    out.push_back({pos, end - pos});
+    return true;
+}
+
+// the payload of every top-level `mdat` box; `moov` (tags, chunk offsets)
+// is left out, so re-tagging or re-muxing the index does not matter
+bool m4a_payload(input const& in, std::vector<range>& out)
+{
+    std::int64_t pos = 0;
+    while (pos + 8 <= in.size()) {
+        std::uint8_t h[16];
+        if (!in.read(pos, h, 8)) break;
+        std::int64_t size   = be32(h);
+        std::int64_t header = 8;
+        if (size == 1) {
+            if (!in.read(pos + 8, h + 8, 8)) break;
+            size   = (std::int64_t(be32(h + 8)) << 32) | be32(h + 12);
+            header = 16;
+        } else if (size == 0) {
+            size = in.size() - pos;
+        }
+        if (size < header || size > in.size() - pos) break;
+        if (std::memcmp(h + 4, "mdat", 4) == 0 && size > header)
+            out.push_back({pos + header, size - header});
+        pos += size;
+    }
+    return !out.empty();
+}
+
+bool wav_payload(input const& in, std::vector<range>& out)
+{
+    std::int64_t pos = 12;
+    std::uint8_t h[8];
+    while (in.read(pos, h, sizeof h)) {
+        std::uint32_t const size = le32(h + 4);
+        if (std::memcmp(h, "data", 4) == 0) {
+            // RF64 and streamed files leave the size at 0xFFFFFFFF
+            std::int64_t const len = size == 0xFFFFFFFFu
+                ? in.size() - pos - 8
+                : std::min<std::int64_t>(size, in.size() - pos - 8);
+            if (len <= 0) return false;
+            out.push_back({pos + 8, len});
+            return true;
+        }
+        pos += 8 + std::int64_t(size) + (size & 1);
+    }
+    return false;
+}
+
+// sniffs the container; anything unrecognised is hashed whole
+char const* payload(input const& in, std::vector<range>& out)
+{
+    std::uint8_t h[12] = {};
+    in.read(0, h, std::min<std::int64_t>(sizeof h, in.size()));
+
+    if (std::memcmp(h, "RIFF", 4) == 0 && std::memcmp(h + 8, "WAVE", 4) == 0)
+        return wav_payload(in, out) ? "wav" : nullptr;
+    if (std::memcmp(h + 4, "ftyp", 4) == 0)
+        return m4a_payload(in, out) ? "m4a" : nullptr;
+
+    std::int64_t const begin = audio_tags::skip_id3v2(in.tag_reader(), 0);
+    if (in.has(begin, "fLaC"))
+        return flac_payload(in, begin, out) ? "flac" : nullptr;
+
+    std::uint8_t s[2] = {};
+    bool const sync = in.read(begin, s, 2) && s[0] == 0xFF && (s[1] & 0xE0) == 0xE0;
+    if (begin > 0 || sync)
+        return mp3_payload(in, begin, out) ? "mp3" : nullptr;
+
+    if (in.size() == 0) return nullptr;
+    out.push_back({0, in.size()});
+    return "raw";
+}
+
+constexpr std::size_t block = 16 * 1024;
+constexpr std::size_t hsize = piece_hash::sha256_size;
+
+// root over `leaves` (count hashes), zero-padded to a power of two
+void merkle_root(std::vector<std::uint8_t>& leaves, std::uint8_t* root)
+{
+    auto const& eng = piece_hash::best();
+    std::size_t n = leaves.size() / hsize;
+    std::uint8_t pad[2 * hsize] = {};             // pad node of the current level, twice
+    std::vector<std::uint8_t const*> msgs;
+    while (n > 1) {
+        if (n & 1) {
+            leaves.insert(leaves.end(), pad, pad + hsize);
+            ++n;
+        }
+        msgs.resize(n / 2);
+        for (std::size_t i = 0; i < n / 2; ++i) msgs[i] = leaves.data() + i * 2 * hsize;
+        std::vector<std::uint8_t> next(n / 2 * hsize);
+        eng.sha256(msgs.data(), n / 2, 2 * hsize, next.data());
+        leaves.swap(next);
+        n /= 2;
+
+        std::uint8_t const* const p = pad;
+        std::uint8_t up[hsize];
+        eng.sha256(&p, 1, 2 * hsize, up);
+        std::memcpy(pad, up, hsize);
+        std::memcpy(pad + hsize, up, hsize);
+    }
+    std::memcpy(root, leaves.data(), hsize);
+}
+
+} // namespace
+
+bool compute(std::string const& path, result& out, std::string& error)
+{
+    input in(path);
+    if (!in.ok()) { error = std::strerror(errno); return false; }
+    out = result{};
+    out.file_bytes = in.size();
+
+    std::vector<range> ranges;
+    char const* const format = payload(in, ranges);
+    if (!format) { error = "no audio payload"; return false; }
+    out.format = format;
+    ::posix_fadvise(in.fd(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // leaves are hashed 4 MiB of payload at a time, so the multi-buffer
+    // variant gets 256 equally long blocks per call
+    auto const& eng = piece_hash::best();
+    std::vector<std::uint8_t> buf(256 * block);
+    std::vector<std::uint8_t> leaves;
+    std::vector<std::uint8_t const*> msgs(256);
+    std::size_t fill = 0;
+
+    auto const flush = [&](bool last) {
+        std::size_t const full = fill / block;
+        std::size_t const tail = last ? fill % block : 0;
+        std::size_t const at = leaves.size();
+        leaves.resize(at + (full + (tail ? 1 : 0)) * hsize);
+        for (std::size_t i = 0; i < full + (tail ? 1 : 0); ++i) msgs[i] = buf.data() + i * block;
+        eng.sha256(msgs.data(), full, block, leaves.data() + at);
+        if (tail) eng.sha256(&msgs[full], 1, tail, leaves.data() + at + full * hsize);
+        fill = 0;
+    };
+
+    for (range const& r : ranges) {
+        for (std::int64_t done = 0; done < r.length; ) {
+            std::size_t const n = static_cast<std::size_t>(
+                std::min<std::int64_t>(r.length - done, std::int64_t(buf.size() - fill)));
+            if (!in.read(r.offset + done, buf.data() + fill, n)) {
+                error = "read failed";
+                return false;
+            }
+            fill += n;
+            done += std::int64_t(n);
+            if (fill == buf.size()) flush(false);
+        }
+        out.payload_bytes += r.length;
+    }
+    flush(true);
+
+    merkle_root(leaves, out.root);
+    return true;
+}
+
+} // namespace audio_identity
@@ -0,0 +1,34 @@
+// audio_identity.hpp  –  content hash of an audio file, tags excluded
+// -------------------------------------------------------------
+// Two copies of a song that differ only in their tags hash to different
+// torrents, so their peers end up in separate swarms. The identity here
+// covers the audio payload alone, so the catalog can tell such copies are
+// the same recording and group their swarms:
+//
+//   mp3   ID3v2 (front and appended), APEv2, Lyrics3v2 and ID3v1 stripped
+//   flac  everything from the first frame on, after the metadata blocks
+//         (and a leading ID3v2, which some taggers add)
+//   m4a   the contents of the top-level `mdat` boxes
+//   wav   the `data` chunk
+//
+// Any other file is hashed whole. The identity is the BEP 52 merkle root
+// (16 KiB SHA-256 leaves, zero-padded to a power of two) that the payload
+// would have as a file of its own, hashed with piece_hash::best().
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace audio_identity {
+
+struct result {
+    char const*   format = "raw";   // mp3 | flac | m4a | wav | raw
+    std::int64_t  file_bytes    = 0;
+    std::int64_t  payload_bytes = 0;
+    std::uint8_t  root[32]      = {};
+};
+
+// false with `error` set when the file cannot be read or has no payload
+bool compute(std::string const& path, result& out, std::string& error);
+
+} // namespace audio_identity
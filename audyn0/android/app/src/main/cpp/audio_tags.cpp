@@ -0,0 +1,90 @@
+// audio_tags.cpp  –  see audio_tags.hpp
+#include "audio_tags.hpp"
+
+#include <cstring>
+
+namespace audio_tags {
+namespace {
+
+// 4 × 7-bit size used by ID3v2; -1 if a high bit is set
+std::int64_t syncsafe(std::uint8_t const* p)
+{
+    if ((p[0] | p[1] | p[2] | p[3]) & 0x80) return -1;
+    return (std::int64_t(p[0]) << 21) | (std::int64_t(p[1]) << 14)
+         | (std::int64_t(p[2]) << 7)  |  std::int64_t(p[3]);
+}
+
+// total size of the ID3v2 tag (header or footer `h`, 10 bytes) or 0
+std::int64_t id3v2_size(std::uint8_t const* h, char const* magic)
+{
+    if (std::memcmp(h, magic, 3) != 0 || h[3] == 0xFF || h[4] == 0xFF) return 0;
+    std::int64_t const body = syncsafe(h + 6);
+    if (body < 0) return 0;
+    return 10 + body + ((h[5] & 0x10) ? 10 : 0);
+}
+
+// `tag` is at `off`
+bool has(reader const& read, std::int64_t off, char const* tag)
+{
+    std::size_t const n = std::strlen(tag);
+    char buf[16];
+    return n <= sizeof buf && read(off, buf, n) && std::memcmp(buf, tag, n) == 0;
+}
+
+} // namespace
+
+std::int64_t skip_id3v2(reader const& read, std::int64_t pos)
+{
+    std::uint8_t h[10];
+    while (read(pos, h, sizeof h)) {
+        std::int64_t const n = id3v2_size(h, "ID3");
+        if (n == 0) break;
+        pos += n;
+    }
+    return pos;
+}
+
+std::int64_t strip_id3v1(reader const& read, std::int64_t begin, std::int64_t end)
+{
+    return end - begin >= 128 && has(read, end - 128, "TAG") ? end - 128 : end;
+}
+
+std::int64_t strip_trailing(reader const& read, std::int64_t begin, std::int64_t end)
+{
+    for (bool stripped = true; stripped && end > begin; ) {
+        stripped = false;
+        std::uint8_t b[32];
+
+        if (std::int64_t const e = strip_id3v1(read, begin, end); e != end) {
+            end = e;
+            if (end - begin >= 227 && has(read, end - 227, "TAG+")) end -= 227;
+            stripped = true;
+            continue;
+        }
+        if (end - begin >= 32 && read(end - 32, b, 32) && std::memcmp(b, "APETAGEX", 8) == 0) {
+            std::int64_t const total = std::int64_t(le32(b + 12)) + ((le32(b + 20) & 0x80000000u) ? 32 : 0);
+            if (total >= 32 && total <= end - begin) { end -= total; stripped = true; continue; }
+        }
+        if (end - begin >= 15 && read(end - 15, b, 15) && std::memcmp(b + 6, "LYRICS200", 9) == 0) {
+            std::int64_t size = 0;
+            bool digits = true;
+            for (int i = 0; i < 6; ++i) {
+                digits = digits && b[i] >= '0' && b[i] <= '9';
+                size = size * 10 + (b[i] - '0');
+            }
+            std::int64_t const total = size + 15;
+            if (digits && total <= end - begin && has(read, end - total, "LYRICSBEGIN")) {
+                end -= total;
+                stripped = true;
+                continue;
+            }
+        }
+        if (end - begin >= 10 && read(end - 10, b, 10)) {
+            std::int64_t const total = id3v2_size(b, "3DI");
+            if (total > 0 && total <= end - begin) { end -= total; stripped = true; continue; }
+        }
+    }
+    return end;
+}
+
+} // namespace audio_tags
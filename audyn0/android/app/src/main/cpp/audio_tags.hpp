@@ -0,0 +1,54 @@
+// audio_tags.hpp  –  tag framing shared by the audio header parsers
+// -------------------------------------------------------------
+// seek_index and audio_identity both need to know where the audio of a
+// file starts and ends around its tags:
+//
+//   front  any number of ID3v2 tags (mp3, and flac from some taggers)
+//   back   ID3v1 (optionally with a 227-byte "TAG+" before it), APEv2,
+//          Lyrics3v2 and an appended ID3v2.4 with footer, in any order
+//
+// Bytes come through a callback, so each parser keeps its own reader: a
+// plain file, or a torrent whose pieces may still be missing.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace audio_tags {
+
+// exactly `n` bytes at `offset`, or false
+using reader = std::function<bool(std::int64_t offset, void* buf, std::size_t n)>;
+
+inline std::uint16_t be16(std::uint8_t const* p)
+{
+    return std::uint16_t((p[0] << 8) | p[1]);
+}
+
+inline std::uint32_t be32(std::uint8_t const* p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16)
+         | (std::uint32_t(p[2]) << 8)  |  std::uint32_t(p[3]);
+}
+
+inline std::uint64_t be64(std::uint8_t const* p)
+{
+    return (std::uint64_t(be32(p)) << 32) | be32(p + 4);
+}
+
+inline std::uint32_t le32(std::uint8_t const* p)
+{
+    return (std::uint32_t(p[3]) << 24) | (std::uint32_t(p[2]) << 16)
+         | (std::uint32_t(p[1]) << 8)  |  std::uint32_t(p[0]);
+}
+
+// first byte after the ID3v2 tags at `pos` (`pos` itself without one)
+std::int64_t skip_id3v2(reader const& read, std::int64_t pos);
+
+// `end` less a 128-byte ID3v1 tag ending there, if one fits after `begin`
+std::int64_t strip_id3v1(reader const& read, std::int64_t begin, std::int64_t end);
+
+// `end` less every trailing tag listed above, down to at most `begin`
+std::int64_t strip_trailing(reader const& read, std::int64_t begin, std::int64_t end);
+
+} // namespace audio_tags
@@ -0,0 +1,344 @@
+// audyn_ffi.h  –  plain C ABI over the LibtorrentWrapper session core
+// -------------------------------------------------------------
+// Meant for dart:ffi (lib/src/native/audyn_ffi.dart) and for desktop
+// builds; the Android app still ships the JNI exports next to it.
+//
+//  * Handles are opaque. audyn_torrent handles are owned by the caller and
+//    must be released with audyn_torrent_release().
+//  * Text results go into caller-owned buffers, snprintf style: the return
+//    value is the full length without the NUL, and the output is truncated
+//    (but always terminated) when it does not fit in `cap` bytes.
+//  * Functions taking a (port, request_id) pair complete asynchronously by
+//    posting [request_id, code, payload] to that Dart native port, once
+//    audyn_init_dart_api() has been given NativeApi.postCObject. Port 0
+//    means "no completion wanted".
+//  * Negative return values are AUDYN_E* codes.
+#ifndef AUDYN_FFI_H
+#define AUDYN_FFI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#  define AUDYN_API __declspec(dllexport)
+#else
+#  define AUDYN_API __attribute__((visibility("default")))
+#endif
+
+enum
+{
+    AUDYN_OK         =  0,
+    AUDYN_EINVAL     = -1,   // bad argument (null pointer, malformed hash …)
+    AUDYN_ENOTFOUND  = -2,   // no such torrent
+    AUDYN_ENOSESSION = -3,   // session not open
+    AUDYN_EPARSE     = -4,   // .torrent data did not decode
+    AUDYN_EFAILED    = -5    // libtorrent reported an error
+};
+
+typedef struct audyn_session audyn_session;
+typedef struct audyn_torrent audyn_torrent;
+
+typedef struct audyn_add_options
+{
+    int32_t seed_mode;
+    int32_t announce;        // 0 = add paused
+    int32_t enable_dht;
+    int32_t enable_lsd;
+    int32_t enable_utp;      // session-wide
+    int32_t enable_trackers;
+    int32_t enable_pex;
+} audyn_add_options;
+
+// audyn_torrent_status.flags
+enum
+{
+    AUDYN_TORRENT_PAUSED    = 1,
+    AUDYN_TORRENT_SEED_MODE = 2,
+    AUDYN_TORRENT_FINISHED  = 4
+};
+
+typedef struct audyn_torrent_status
+{
+    uint8_t  info_hash[20];
+    int32_t  state;          // lt::torrent_status::state_t
+    float    progress;       // 0 … 1
+    int32_t  download_rate;  // bytes/s
+    int32_t  upload_rate;
+    int32_t  num_peers;
+    int32_t  num_seeds;
+    int64_t  total_done;
+    int64_t  total_wanted;
+    int64_t  all_time_upload;
+    uint32_t flags;          // AUDYN_TORRENT_*
+} audyn_torrent_status;
+
+// libtorrent version string, static storage
+AUDYN_API const char* audyn_version(void);
+
+// `post_cobject` is NativeApi.postCObject; needed for async completions
+AUDYN_API int32_t audyn_init_dart_api(void* post_cobject);
+
+// starts the session on first use; the returned handle stays valid until
+// audyn_session_close()
+AUDYN_API audyn_session* audyn_session_open(void);
+AUDYN_API void           audyn_session_close(audyn_session* s);
+
+// audyn_disk_options.backend
+enum
+{
+    AUDYN_DISK_CUSTOM = 0,   // library seeds read in place, upload cache, io_uring
+    AUDYN_DISK_POSIX  = 1,   // libtorrent's pread/pwrite backend
+    AUDYN_DISK_MMAP   = 2    // libtorrent's memory-mapped backend
+};
+
+typedef struct audyn_disk_options
+{
+    int32_t backend;             // AUDYN_DISK_*
+    int32_t io_uring;            // custom: library reads through io_uring where it works
+    int32_t aio_threads;         // 0 = libtorrent's default
+    int32_t file_pool_size;      // 0 = libtorrent's default
+    int64_t upload_cache_bytes;  // -1 = unchanged
+    int64_t read_cache_bytes;    // -1 = unchanged
+} audyn_disk_options;
+
+// audyn_session_open() with a disk backend: the backend and io_uring apply
+// when this call starts the session, threads, file pool and cache sizes at
+// once. NULL on an unknown backend, or while a session runs on another
+// backend or io_uring setting (close it first to switch).
+AUDYN_API audyn_session* audyn_session_open_with(const audyn_disk_options* o);
+
+// asks libtorrent for fresh torrent status (rate-limited, asynchronous)
+AUDYN_API void    audyn_refresh_status(audyn_session* s);
+
+// JSON list of torrents, same shape as the JNI getAllTorrents()
+AUDYN_API int64_t audyn_torrents_json(audyn_session* s, char* buf, int64_t cap);
+
+// JSON delta since `seq`, same shape as the JNI getTorrentUpdatesSince()
+AUDYN_API int64_t audyn_updates_since(audyn_session* s, int64_t seq, char* buf, int64_t cap);
+
+// native job executor: queue depth, completions and wait times per lane
+AUDYN_API int64_t audyn_executor_stats(char* buf, int64_t cap);
+
+// binary status channel (see status_channel); *out points at native memory
+// that lives as long as the process. Returns its size in bytes.
+AUDYN_API int64_t audyn_status_buffer(audyn_session* s, int32_t capacity, const uint8_t** out);
+
+// Seq of the newest frame, or 0 if nothing newer than `since_seq` was
+// published. Its slot (seq % 2) is not rewritten until audyn_status_unpin(),
+// so it can be read in place in between.
+AUDYN_API int64_t audyn_status_pin(int64_t since_seq);
+AUDYN_API void    audyn_status_unpin(int64_t seq);
+
+// bencoded .torrent bytes are parsed before returning (the caller may free
+// them right away); the torrent is added asynchronously and the 40-char
+// info-hash (or an error message) is posted to `port`.
+AUDYN_API int32_t audyn_add_torrent_bytes(audyn_session* s,
+                                          const uint8_t* data, int64_t len,
+                                          const char* save_path,
+                                          const audyn_add_options* opts,
+                                          int64_t port, int64_t request_id);
+
+// seeds a song (or an album folder) where it is: the torrent is added under
+// the shared library save path and its files are read from `source_path`.
+// Adding the same torrent again from a new path relinks it. Completion is
+// posted to `port` as for audyn_add_torrent_bytes(); seed_mode is implied.
+AUDYN_API int32_t audyn_add_library_torrent(audyn_session* s,
+                                            const uint8_t* data, int64_t len,
+                                            const char* source_path,
+                                            const audyn_add_options* opts,
+                                            int64_t port, int64_t request_id);
+
+// {"torrents","open_files","file_limit","opens","reuses","evictions",
+//  "reads","writes","hashes"}: library seeds share a pool of at most
+// file_limit descriptors (settings_pack::file_pool_size)
+AUDYN_API int64_t audyn_library_stats(char* buf, int64_t cap);
+
+// hex info-hash (40-char v1 or 64-char v2), source path or torrent name;
+// NULL if unknown
+AUDYN_API audyn_torrent* audyn_torrent_find(audyn_session* s, const char* query);
+AUDYN_API void           audyn_torrent_release(audyn_torrent* t);
+
+AUDYN_API int32_t audyn_torrent_get_status(audyn_torrent* t, audyn_torrent_status* out);
+AUDYN_API int64_t audyn_torrent_info_hash(audyn_torrent* t, char* buf, int64_t cap);
+AUDYN_API int64_t audyn_torrent_save_path(audyn_torrent* t, char* buf, int64_t cap);
+AUDYN_API int32_t audyn_torrent_pause(audyn_torrent* t);
+AUDYN_API int32_t audyn_torrent_resume(audyn_torrent* t);
+
+// removal is asynchronous; the info-hash is posted to `port` once done.
+// `remove_data` never deletes a seed's files: they are the user's
+AUDYN_API int32_t audyn_torrent_remove(audyn_torrent* t, int32_t remove_data,
+                                       int64_t port, int64_t request_id);
+
+// file by file (for an album torrent, its tracks) as JSON
+// {"info_hash","name","piece_length","files":[{index,path,size,done,priority}]};
+// AUDYN_ENOTFOUND until the metadata is known. Waits on the network thread.
+AUDYN_API int64_t audyn_torrent_files_json(audyn_torrent* t, char* buf, int64_t cap);
+
+// per file index: 0 = skip, 1 … 7 = libtorrent priority; files past `n`
+// get the default (4). Fetching one album track: 0 everywhere but its index.
+AUDYN_API int32_t audyn_torrent_set_file_priorities(audyn_torrent* t, const int32_t* prio, int32_t n);
+
+// every loaded file whose v2 merkle root is `root_hex` (64 hex chars), as
+// JSON [{"info_hash","file_index","path"}] – the same track inside several
+// album torrents, say. AUDYN_EINVAL on a malformed root.
+AUDYN_API int64_t audyn_find_file_root(const char* root_hex, char* buf, int64_t cap);
+
+// what creation produces from now on: 0 hybrid (v1 + v2, the default),
+// 1 v1 only, 2 v2 only
+AUDYN_API int32_t audyn_set_torrent_version(int32_t version);
+
+// seconds of opening audio (at most 30, capped at 1 MiB and cut on a frame
+// boundary) that creation embeds in each .torrent outside its info dict,
+// so peers adding it can start playing before the swarm answers; 0, the
+// default, embeds none. AUDYN_EINVAL out of range.
+AUDYN_API int32_t audyn_set_preamble_seconds(int32_t seconds);
+
+// URL of a torrent's file on the loopback stream server (started on first
+// use), for a media player: GET with Range is answered as the pieces come
+// in, the ones ahead of the reader fetched first via piece deadlines.
+// AUDYN_ENOTFOUND for an unknown torrent, AUDYN_EFAILED if it cannot listen.
+AUDYN_API int64_t audyn_stream_url(const char* info_hash, int32_t file_index, char* buf, int64_t cap);
+
+// closes every stream and the listening socket
+AUDYN_API void    audyn_stream_stop(void);
+
+// Reports the player's play head for a streamed file, about once a second
+// and right after a seek. The pieces covering the next seconds of audio get
+// deadlines timed to when playback reaches them; the window widens while
+// the buffer keeps up. `bitrate_kbps` 0 derives the rate from
+// `duration_ms`; once the header pieces are in, positions map to bytes
+// through the seek index ("index": its format) instead of the rate. Writes
+// {"position_ms","offset","buffer_s","window_s","first_piece","last_piece",
+// "underruns","underrun_ms","playing","index"}.
+AUDYN_API int64_t audyn_playback_update(const char* info_hash, int32_t file_index,
+                                        int64_t position_ms, int64_t duration_ms,
+                                        int32_t bitrate_kbps, int32_t playing, int32_t seek,
+                                        char* buf, int64_t cap);
+
+// Time → byte → piece map of a track from its container header (MP3
+// Xing/VBRI, FLAC SEEKTABLE, MP4 stts/stsc/stco): {"format","duration_ms",
+// "audio_begin","audio_end","exact","points":[{"ms","offset","piece"}]}, or
+// {"pending":true,"need_offset","need_length"} while the header pieces are
+// still downloading. AUDYN_ENOTFOUND when the format has no index.
+AUDYN_API int64_t audyn_seek_index(const char* info_hash, int32_t file_index, char* buf, int64_t cap);
+
+// The preamble a torrent's .torrent carried: {"format","duration_ms",
+// "length","state"}, state "pending" until its pieces have been checked,
+// then "verified" or "rejected". AUDYN_ENOTFOUND when it came without one.
+AUDYN_API int64_t audyn_preamble(const char* info_hash, char* buf, int64_t cap);
+
+// the player left the file; its deadlines go back to the regular picker
+AUDYN_API int32_t audyn_playback_stop(const char* info_hash, int32_t file_index);
+
+// The player's upcoming swarm tracks in play order (shuffle applied); call
+// again whenever the queue or shuffle mode changes, n = 0 cancels. The
+// first `tracks` entries get their opening `seconds` of audio fetched at a
+// raised piece priority, behind the current track's deadlines, within
+// `budget_bytes` missing bytes overall. `starts_in_ms` (may be NULL,
+// entries -1) is when each track is due to start, as reported in the stats.
+AUDYN_API int32_t audyn_prefetch_queue(const char* const* info_hashes, const int32_t* file_indices,
+                                       const int64_t* starts_in_ms, int32_t n);
+
+// defaults 20 s, 2 tracks, 32 MiB; negative keeps a value
+AUDYN_API void    audyn_prefetch_configure(int32_t seconds, int32_t tracks, int64_t budget_bytes);
+
+// {"seconds","tracks","budget","used","entries":[{"info_hash","file_index",
+//  "first_piece","last_piece","pieces","done","bytes","starts_in_ms"}]}
+AUDYN_API int64_t audyn_prefetch_stats(char* buf, int64_t cap);
+
+// RAM cache of the pieces the stream server reads back from disk, keyed by
+// (info-hash, piece) and shared by all readers, so seeking back is served
+// from memory. Default 32 MiB; 0 turns it off.
+AUDYN_API void    audyn_read_cache_configure(int64_t capacity_bytes);
+
+// memory pressure at Android's onTrimMemory() levels: 80, 60 and 15 empty
+// the cache (and the upload cache), 20 (UI hidden) keeps it, anything else
+// halves it
+AUDYN_API void    audyn_read_cache_trim(int32_t level);
+
+// {"capacity","bytes","entries","hits","misses","hit_rate","evictions","trims"}
+AUDYN_API int64_t audyn_read_cache_stats(char* buf, int64_t cap);
+
+// RAM cache on the upload path: request counts per (info-hash, piece)
+// decide which pieces are kept, and the hottest stay pinned within the
+// budget, so a piece many peers ask for is read from flash once. Default
+// 16 MiB; 0 turns it off.
+AUDYN_API void    audyn_upload_cache_configure(int64_t capacity_bytes);
+
+// {"capacity","bytes","entries","tracked","hits","misses","hit_rate",
+//  "admitted","displaced","trims","hottest":[{"info_hash","piece","heat",
+//  "cached"}]}
+AUDYN_API int64_t audyn_upload_cache_stats(char* buf, int64_t cap);
+
+// torrent creation jobs (job_state: 0 queued, 1 hashing, 2 done, 3 failed,
+// 4 cancelled). With a NULL `output` the .torrent is kept in memory for
+// audyn_create_job_take(). When `port` is non-zero, progress is posted as
+// [job_id, state, pieces_done, num_pieces, error|null], at most every
+// 250 ms plus once per state change. Returns the job id.
+AUDYN_API int64_t audyn_create_job_start(const char* source, const char* output,
+                                         const char* const* trackers, int32_t num_trackers,
+                                         int32_t background, int64_t port);
+AUDYN_API int64_t audyn_create_job_poll(int64_t id, char* buf, int64_t cap);
+AUDYN_API int32_t audyn_create_job_cancel(int64_t id);
+
+// copies a finished in-memory result and forgets the job; when `buf` is
+// NULL or smaller than the result, only returns its size
+AUDYN_API int64_t audyn_create_job_take(int64_t id, uint8_t* buf, int64_t cap);
+
+// how many jobs may hash at once (1 … 16, default 2)
+AUDYN_API void    audyn_create_job_concurrency(int32_t n);
+
+// Creation sources may be a file, a directory, or an album: a directory
+// path ending in '/' stands for the audio files directly inside it (mp3,
+// flac, wav, m4a) as one multi-file torrent with track-sized pieces, every
+// track padded to a piece boundary.
+
+// one torrent per path, hashed in parallel on the background workers.
+// Posts [batch_id, index, AUDYN_OK, Uint8List] or
+// [batch_id, index, AUDYN_EFAILED, error] to `port` per file as each one
+// finishes, then [batch_id, -1, succeeded, failed] once the batch is over.
+// Returns the batch id.
+AUDYN_API int64_t audyn_create_batch(const char* const* paths, int32_t num_paths,
+                                     const char* const* trackers, int32_t num_trackers,
+                                     int64_t port);
+
+// files not started yet are dropped, running ones fail with "aborted"
+AUDYN_API int32_t audyn_cancel_batch(int64_t id);
+
+// tag-independent content id of an audio file: the BEP 52 root of its
+// audio payload with ID3 / APE / FLAC metadata / MP4 boxes other than mdat
+// left out, as JSON {"identity", "format", "file_bytes", "payload_bytes"}.
+// Reads the whole file on the calling thread.
+AUDYN_API int64_t audyn_audio_identity(const char* path, char* buf, int64_t cap);
+
+// single-core MB/s of each SHA-1 / SHA-256 variant this CPU runs, as JSON
+// {"best", "variants": [{"name", "sha1_mb_s", "sha256_mb_s"}]}; takes
+// about a second
+AUDYN_API int64_t audyn_hash_benchmark(char* buf, int64_t cap);
+
+// a synthetic workload in `dir` through the posix, mmap and custom (pread
+// and io_uring) backends: random 16 KiB seeding reads over `files` files of
+// `file_size` bytes (created there on first use; 0 for 10000 files of
+// 64 KiB), then about 64 MiB downloaded into dir/download (block writes and
+// piece hashes, removed afterwards). As JSON {"files", "file_size",
+// "reads", "depth", "download_files", "backends": [{"name", "available",
+// "seed": {…}, "download": {…}}]}, each workload with {"mb_s", "iops",
+// "p50_us", "p99_us", "errors"}. Takes seconds to minutes.
+AUDYN_API int64_t audyn_disk_benchmark(const char* dir, int32_t files, int64_t file_size,
+                                       char* buf, int64_t cap);
+
+// persistent cache of generated torrents in `dir`, keyed by path and
+// checked against (device, inode, size, mtime); unchanged files are not
+// re-hashed by any of the creation calls once it is open
+AUDYN_API int32_t audyn_torrent_cache_open(const char* dir);
+AUDYN_API int64_t audyn_torrent_cache_stats(char* buf, int64_t cap);
+AUDYN_API void    audyn_torrent_cache_clear(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // AUDYN_FFI_H
@@ -0,0 +1,444 @@
+// piece_hash.cpp  –  see piece_hash.hpp
+#include "piece_hash.hpp"
+
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define PIECE_HASH_X86 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#elif defined(__aarch64__)
+#  define PIECE_HASH_ARMV8 1
+#  include <arm_neon.h>
+#  include <sys/auxv.h>
+#  ifndef HWCAP_SHA1
+#    define HWCAP_SHA1 (1 << 5)
+#  endif
+#  ifndef HWCAP_SHA2
+#    define HWCAP_SHA2 (1 << 6)
+#  endif
+#endif
+
+namespace piece_hash {
+namespace {
+
+constexpr std::uint32_t sha1_iv[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+constexpr std::uint32_t sha256_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) constexpr std::uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr std::uint32_t sha1_k[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+inline std::uint32_t load_be32(std::uint8_t const* p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16)
+         | (std::uint32_t(p[2]) << 8)  |  std::uint32_t(p[3]);
+}
+
+inline void store_be32(std::uint8_t* p, std::uint32_t v)
+{
+    p[0] = std::uint8_t(v >> 24); p[1] = std::uint8_t(v >> 16);
+    p[2] = std::uint8_t(v >> 8);  p[3] = std::uint8_t(v);
+}
+
+// the final 1 or 2 blocks of a `len`-byte message whose whole blocks have
+// been consumed: remaining bytes, 0x80, zeros, 64-bit big-endian bit count
+int make_tail(std::uint8_t const* rest, std::size_t len, std::uint8_t tail[128])
+{
+    std::size_t const r = len % 64;
+    int const blocks = r < 56 ? 1 : 2;
+    std::memset(tail, 0, 128);
+    if (r) std::memcpy(tail, rest, r);
+    tail[r] = 0x80;
+    std::uint64_t const bits = std::uint64_t(len) * 8;
+    std::uint8_t* end = tail + blocks * 64;
+    for (int i = 1; i <= 8; ++i) end[-i] = std::uint8_t(bits >> (8 * (i - 1)));
+    return blocks;
+}
+
+// ─────────── scalar and multi-buffer: one template, two word types ───────────
+// W is either one 32-bit word (scalar) or 4 lanes of them, one lane per
+// message. GCC / clang vector extensions lower the lane type to SSE2 or
+// NEON, so the same round code hashes four messages per instruction.
+typedef std::uint32_t u32x4 __attribute__((vector_size(16)));
+
+template <class W> inline W splat(std::uint32_t c) { return W{} + c; }
+template <class W> inline W rotl(W x, int n) { return (x << n) | (x >> (32 - n)); }
+template <class W> inline W rotr(W x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline std::uint32_t lane(std::uint32_t v, int) { return v; }
+inline std::uint32_t lane(u32x4 v, int j) { return v[j]; }
+
+template <class W> W load_word(std::uint8_t const* const* p, std::size_t off);
+template <> inline std::uint32_t load_word<std::uint32_t>(std::uint8_t const* const* p, std::size_t off)
+{
+    return load_be32(p[0] + off);
+}
+template <> inline u32x4 load_word<u32x4>(std::uint8_t const* const* p, std::size_t off)
+{
+    return u32x4{ load_be32(p[0] + off), load_be32(p[1] + off),
+                  load_be32(p[2] + off), load_be32(p[3] + off) };
+}
+
+template <class W>
+void sha1_compress(W s[5], W w[16])
+{
+    W a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+#pragma GCC unroll 80
+    for (int t = 0; t < 80; ++t) {
+        if (t >= 16)
+            w[t & 15] = rotl(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+        W f;
+        if (t < 20)      f = (b & c) | (~b & d);
+        else if (t < 40) f = b ^ c ^ d;
+        else if (t < 60) f = (b & c) | (b & d) | (c & d);
+        else             f = b ^ c ^ d;
+        W const tmp = rotl(a, 5) + f + e + splat<W>(sha1_k[t / 20]) + w[t & 15];
+        e = d; d = c; c = rotl(b, 30); b = a; a = tmp;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d; s[4] += e;
+}
+
+template <class W>
+void sha256_compress(W s[8], W w[16])
+{
+    W a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+#pragma GCC unroll 64
+    for (int t = 0; t < 64; ++t) {
+        if (t >= 16) {
+            W const w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            W const s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            W const s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            w[t & 15] += s0 + w[(t - 7) & 15] + s1;
+        }
+        W const S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        W const ch = (e & f) ^ (~e & g);
+        W const t1 = h + S1 + ch + splat<W>(sha256_k[t]) + w[t & 15];
+        W const S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        W const mj = (a & b) ^ (a & c) ^ (b & c);
+        W const t2 = S0 + mj;
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d; s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+// hashes `Lanes` messages of equal length; Words = 5 (SHA-1) or 8 (SHA-256)
+template <class W, int Lanes, int Words, void (*Compress)(W*, W*)>
+void hash_lanes(std::uint8_t const* const* msgs, std::size_t len,
+                std::uint32_t const* iv, std::uint8_t* out)
+{
+    W s[Words];
+    for (int i = 0; i < Words; ++i) s[i] = splat<W>(iv[i]);
+
+    W w[16];
+    std::size_t const full = len / 64;
+    for (std::size_t blk = 0; blk < full; ++blk) {
+        for (int i = 0; i < 16; ++i) w[i] = load_word<W>(msgs, blk * 64 + 4 * i);
+        Compress(s, w);
+    }
+
+    std::uint8_t tails[Lanes][128];
+    std::uint8_t const* tp[Lanes];
+    int blocks = 0;
+    for (int j = 0; j < Lanes; ++j) {
+        blocks = make_tail(msgs[j] + full * 64, len, tails[j]);
+        tp[j]  = tails[j];
+    }
+    for (int blk = 0; blk < blocks; ++blk) {
+        for (int i = 0; i < 16; ++i) w[i] = load_word<W>(tp, std::size_t(blk) * 64 + 4 * i);
+        Compress(s, w);
+    }
+
+    for (int j = 0; j < Lanes; ++j)
+        for (int i = 0; i < Words; ++i) store_be32(out + j * Words * 4 + i * 4, lane(s[i], j));
+}
+
+void sha1_scalar(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        hash_lanes<std::uint32_t, 1, 5, sha1_compress<std::uint32_t>>(msgs + i, len, sha1_iv, out + i * sha1_size);
+}
+
+void sha256_scalar(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        hash_lanes<std::uint32_t, 1, 8, sha256_compress<std::uint32_t>>(msgs + i, len, sha256_iv, out + i * sha256_size);
+}
+
+// groups of four go through the SIMD lanes, the rest one at a time
+void sha1_multibuffer(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        hash_lanes<u32x4, 4, 5, sha1_compress<u32x4>>(msgs + i, len, sha1_iv, out + i * sha1_size);
+    sha1_scalar(msgs + i, n - i, len, out + i * sha1_size);
+}
+
+void sha256_multibuffer(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        hash_lanes<u32x4, 4, 8, sha256_compress<u32x4>>(msgs + i, len, sha256_iv, out + i * sha256_size);
+    sha256_scalar(msgs + i, n - i, len, out + i * sha256_size);
+}
+
+// ─────────── single-stream hardware variants ───────────
+using block_fn = void (*)(std::uint32_t* state, std::uint8_t const* data, std::size_t blocks);
+
+template <block_fn Blocks, int Words>
+void hash_each(std::uint32_t const* iv, std::uint8_t const* const* msgs, std::size_t n,
+               std::size_t len, std::uint8_t* out)
+{
+    for (std::size_t m = 0; m < n; ++m) {
+        std::uint32_t s[Words];
+        std::memcpy(s, iv, sizeof(s));
+        std::size_t const full = len / 64;
+        if (full) Blocks(s, msgs[m], full);
+        std::uint8_t tail[128];
+        int const blocks = make_tail(msgs[m] + full * 64, len, tail);
+        Blocks(s, tail, std::size_t(blocks));
+        for (int i = 0; i < Words; ++i) store_be32(out + m * Words * 4 + i * 4, s[i]);
+    }
+}
+
+#if PIECE_HASH_X86
+#define PIECE_HASH_SHANI __attribute__((target("sha,ssse3,sse4.1")))
+
+PIECE_HASH_SHANI
+void sha1_shani_blocks(std::uint32_t* state, std::uint8_t const* data, std::size_t blocks)
+{
+    __m128i const mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0x1B);
+    __m128i e0   = _mm_set_epi32(int(state[4]), 0, 0, 0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        __m128i const abcd_save = abcd;
+        __m128i const e0_save   = e0;
+        __m128i m[4];
+        __m128i e1 = abcd;
+
+        // group i = rounds 4i … 4i+3; e0 / e1 take turns carrying E.
+        // Fully unrolled, so m[] and the switch fold into registers.
+#pragma GCC unroll 20
+        for (int i = 0; i < 20; ++i) {
+            __m128i& g = m[i & 3];
+            if (i < 4)
+                g = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)), mask);
+            else
+                g = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(m[i & 3], m[(i + 1) & 3]),
+                                                     m[(i + 2) & 3]), m[(i + 3) & 3]);
+            __m128i& e = (i & 1) ? e1 : e0;
+            __m128i& next = (i & 1) ? e0 : e1;
+            e = i == 0 ? _mm_add_epi32(e0, g) : _mm_sha1nexte_epu32(e, g);
+            next = abcd;
+            switch (i / 5) {
+                case 0:  abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break;
+                case 1:  abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break;
+                case 2:  abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break;
+                default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break;
+            }
+        }
+        // group 19 used e1 and left A-before-it in e0
+        e0   = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = std::uint32_t(_mm_extract_epi32(e0, 3));
+}
+
+PIECE_HASH_SHANI
+void sha256_shani_blocks(std::uint32_t* state, std::uint8_t const* data, std::size_t blocks)
+{
+    __m128i const mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0xB1);     // CDAB
+    __m128i s1  = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state + 4)), 0x1B); // EFGH
+    __m128i s0  = _mm_alignr_epi8(tmp, s1, 8);      // ABEF
+    s1          = _mm_blend_epi16(s1, tmp, 0xF0);   // CDGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        __m128i const abef_save = s0;
+        __m128i const cdgh_save = s1;
+        __m128i m[4];
+
+#pragma GCC unroll 16
+        for (int i = 0; i < 16; ++i) {
+            __m128i& g = m[i & 3];
+            if (i < 4)
+                g = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)), mask);
+            else
+                g = _mm_sha256msg2_epu32(
+                        _mm_add_epi32(_mm_sha256msg1_epu32(m[i & 3], m[(i + 1) & 3]),
+                                      _mm_alignr_epi8(m[(i + 3) & 3], m[(i + 2) & 3], 4)),
+                        m[(i + 3) & 3]);
+            __m128i msg = _mm_add_epi32(g, _mm_load_si128(reinterpret_cast<__m128i const*>(sha256_k + 4 * i)));
+            s1  = _mm_sha256rnds2_epu32(s1, s0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            s0  = _mm_sha256rnds2_epu32(s0, s1, msg);
+        }
+        s0 = _mm_add_epi32(s0, abef_save);
+        s1 = _mm_add_epi32(s1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(s0, 0x1B);              // FEBA
+    s1  = _mm_shuffle_epi32(s1, 0xB1);              // DCHG
+    s0  = _mm_blend_epi16(tmp, s1, 0xF0);           // DCBA
+    s1  = _mm_alignr_epi8(s1, tmp, 8);              // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), s0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), s1);
+}
+
+void sha1_shani(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    hash_each<sha1_shani_blocks, 5>(sha1_iv, msgs, n, len, out);
+}
+
+void sha256_shani(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    hash_each<sha256_shani_blocks, 8>(sha256_iv, msgs, n, len, out);
+}
+
+bool cpu_has_shani()
+{
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    bool const ssse3 = c & (1u << 9), sse41 = c & (1u << 19);
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    return ssse3 && sse41 && (b & (1u << 29));
+}
+#endif // PIECE_HASH_X86
+
+#if PIECE_HASH_ARMV8
+#  if defined(__clang__)
+#    define PIECE_HASH_CE __attribute__((target("crypto")))
+#  else
+#    define PIECE_HASH_CE __attribute__((target("+crypto")))
+#  endif
+
+PIECE_HASH_CE
+void sha1_armv8_blocks(std::uint32_t* state, std::uint8_t const* data, std::size_t blocks)
+{
+    uint32x4_t abcd = vld1q_u32(state);
+    std::uint32_t e0 = state[4];
+
+    for (; blocks > 0; --blocks, data += 64) {
+        uint32x4_t const abcd_save = abcd;
+        std::uint32_t const e0_save = e0;
+        uint32x4_t m[4];
+        std::uint32_t e = e0;
+
+#pragma GCC unroll 20
+        for (int i = 0; i < 20; ++i) {
+            uint32x4_t& g = m[i & 3];
+            if (i < 4)
+                g = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            else
+                g = vsha1su1q_u32(vsha1su0q_u32(m[i & 3], m[(i + 1) & 3], m[(i + 2) & 3]), m[(i + 3) & 3]);
+            uint32x4_t const wk = vaddq_u32(g, vdupq_n_u32(sha1_k[i / 5]));
+            std::uint32_t const next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            if (i < 5)       abcd = vsha1cq_u32(abcd, e, wk);
+            else if (i < 10) abcd = vsha1pq_u32(abcd, e, wk);
+            else if (i < 15) abcd = vsha1mq_u32(abcd, e, wk);
+            else             abcd = vsha1pq_u32(abcd, e, wk);
+            e = next;
+        }
+        abcd = vaddq_u32(abcd, abcd_save);
+        e0   = e + e0_save;
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+PIECE_HASH_CE
+void sha256_armv8_blocks(std::uint32_t* state, std::uint8_t const* data, std::size_t blocks)
+{
+    uint32x4_t s0 = vld1q_u32(state);       // ABCD
+    uint32x4_t s1 = vld1q_u32(state + 4);   // EFGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        uint32x4_t const abcd_save = s0;
+        uint32x4_t const efgh_save = s1;
+        uint32x4_t m[4];
+
+#pragma GCC unroll 16
+        for (int i = 0; i < 16; ++i) {
+            uint32x4_t& g = m[i & 3];
+            if (i < 4)
+                g = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            else
+                g = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]), m[(i + 2) & 3], m[(i + 3) & 3]);
+            uint32x4_t const wk  = vaddq_u32(g, vld1q_u32(sha256_k + 4 * i));
+            uint32x4_t const tmp = s0;
+            s0 = vsha256hq_u32(s0, s1, wk);
+            s1 = vsha256h2q_u32(s1, tmp, wk);
+        }
+        s0 = vaddq_u32(s0, abcd_save);
+        s1 = vaddq_u32(s1, efgh_save);
+    }
+
+    vst1q_u32(state, s0);
+    vst1q_u32(state + 4, s1);
+}
+
+void sha1_armv8(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    hash_each<sha1_armv8_blocks, 5>(sha1_iv, msgs, n, len, out);
+}
+
+void sha256_armv8(std::uint8_t const* const* msgs, std::size_t n, std::size_t len, std::uint8_t* out)
+{
+    hash_each<sha256_armv8_blocks, 8>(sha256_iv, msgs, n, len, out);
+}
+#endif // PIECE_HASH_ARMV8
+
+engine const scalar_engine      { "scalar",      sha1_scalar,      sha256_scalar };
+engine const multibuffer_engine { "multibuffer", sha1_multibuffer, sha256_multibuffer };
+#if PIECE_HASH_X86
+engine const shani_engine       { "sha-ni",      sha1_shani,       sha256_shani };
+#endif
+#if PIECE_HASH_ARMV8
+engine const armv8_engine       { "armv8",       sha1_armv8,       sha256_armv8 };
+#endif
+
+} // namespace
+
+std::vector<engine const*> available()
+{
+    std::vector<engine const*> v;
+#if PIECE_HASH_X86
+    if (cpu_has_shani()) v.push_back(&shani_engine);
+#endif
+#if PIECE_HASH_ARMV8
+    // both are present on every ARMv8 core with the crypto extension
+    unsigned long const hw = getauxval(AT_HWCAP);
+    if ((hw & HWCAP_SHA1) && (hw & HWCAP_SHA2)) v.push_back(&armv8_engine);
+#endif
+    v.push_back(&multibuffer_engine);
+    v.push_back(&scalar_engine);
+    return v;
+}
+
+engine const& best()
+{
+    static engine const* const e = available().front();
+    return *e;
+}
+
+} // namespace piece_hash
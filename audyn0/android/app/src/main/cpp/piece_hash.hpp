@@ -0,0 +1,43 @@
+// piece_hash.hpp  –  SHA-1 / SHA-256 for piece hashing, runtime dispatch
+// -------------------------------------------------------------
+// Used when LibtorrentWrapper creates torrents itself (see
+// hash_single_file). Kept apart from the JNI / libtorrent code because the
+// hardware variants are compiled with per-function target attributes.
+//
+// Every variant hashes a batch of independent, equally long messages:
+//
+//   armv8        ARMv8 SHA1/SHA2 crypto extensions (aarch64 HWCAP_SHA1/2)
+//   sha-ni       x86 SHA extensions (CPUID.7:EBX.SHA + SSSE3/SSE4.1)
+//   multibuffer  4 messages at once in 32-bit SIMD lanes (NEON / SSE2)
+//   scalar       portable reference, one message at a time
+//
+// best() picks the fastest one this CPU supports, once per process.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace piece_hash {
+
+constexpr std::size_t sha1_size   = 20;
+constexpr std::size_t sha256_size = 32;
+
+// msgs[0 … n) are `len` bytes each; digests are written back to back to
+// `out` (n * sha1_size or n * sha256_size bytes)
+using hash_fn = void (*)(std::uint8_t const* const* msgs, std::size_t n,
+                         std::size_t len, std::uint8_t* out);
+
+struct engine {
+    char const* name;
+    hash_fn     sha1;
+    hash_fn     sha256;
+};
+
+// fastest variant this CPU can run
+engine const& best();
+
+// every variant this CPU can run, best first; for benchmarks
+std::vector<engine const*> available();
+
+} // namespace piece_hash
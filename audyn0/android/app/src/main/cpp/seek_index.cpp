@@ -0,0 +1,603 @@
+// seek_index.cpp  –  see seek_index.hpp
+#include "seek_index.hpp"
+#include "audio_tags.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace seek_index {
+namespace {
+
+using audio_tags::be16;
+using audio_tags::be32;
+using audio_tags::be64;
+using audio_tags::le32;
+
+// reads through the caller's callback and remembers the first range it
+// could not get, which is what parse() reports back as needed
+class source {
+public:
+    source(reader const& read, std::int64_t size) : m_read(read), m_size(size) {}
+
+    std::int64_t size() const { return m_size; }
+
+    // exactly `n` bytes at `off`; a range past the end is a format error,
+    // not a missing piece
+    bool read(std::int64_t off, void* buf, std::size_t n)
+    {
+        if (off < 0 || n == 0 || off + std::int64_t(n) > m_size) return false;
+        if (m_read(off, buf, n)) return true;
+        if (m_need_length == 0) { m_need_offset = off; m_need_length = std::int64_t(n); }
+        return false;
+    }
+
+    // for bytes that only refine the index (trailing tags): a miss is not
+    // worth waiting for
+    bool try_read(std::int64_t off, void* buf, std::size_t n)
+    {
+        if (off < 0 || n == 0 || off + std::int64_t(n) > m_size) return false;
+        return m_read(off, buf, n);
+    }
+
+    // read(), or try_read() unless `wait`, for the audio_tags helpers
+    audio_tags::reader tag_reader(bool wait)
+    {
+        if (wait) return [this](std::int64_t off, void* buf, std::size_t n) { return read(off, buf, n); };
+        return [this](std::int64_t off, void* buf, std::size_t n) { return try_read(off, buf, n); };
+    }
+
+    bool         missing()     const { return m_need_length > 0; }
+    std::int64_t need_offset() const { return m_need_offset; }
+    std::int64_t need_length() const { return m_need_length; }
+
+private:
+    reader const& m_read;
+    std::int64_t  m_size;
+    std::int64_t  m_need_offset = 0;
+    std::int64_t  m_need_length = 0;
+};
+
+// points must rise in both time and offset for the interpolation; the
+// ends of the audio are added when the table leaves them out
+void finish(index& idx)
+{
+    std::vector<point> pts;
+    pts.reserve(idx.points.size() + 2);
+    pts.push_back({0, idx.audio_begin});
+    for (point const& p : idx.points) {
+        if (p.ms < 0 || p.ms > idx.duration_ms || p.offset < pts.back().offset
+            || p.offset > idx.audio_end) continue;
+        if (p.ms <= pts.back().ms) continue;
+        pts.push_back(p);
+    }
+    if (idx.duration_ms > pts.back().ms && idx.audio_end > pts.back().offset)
+        pts.push_back({idx.duration_ms, idx.audio_end});
+    idx.points.swap(pts);
+}
+
+// ───────────────────────────  mp3  ────────────────────────────
+
+struct mp3_frame {
+    bool mpeg1;
+    bool mono;
+    int  bitrate;           // kbit/s
+    int  sample_rate;
+    int  samples;           // per frame
+    int  length;            // bytes, padding included
+};
+
+// Layer III frame header at `h`
+bool mp3_header(std::uint8_t const* h, mp3_frame& f)
+{
+    static constexpr int br1[16] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+    static constexpr int br2[16] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+    static constexpr int sr1[4]  = {44100, 48000, 32000, 0};
+
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) return false;
+    int const version = (h[1] >> 3) & 3;        // 0 = 2.5, 1 reserved, 2 = 2, 3 = 1
+    int const layer   = (h[1] >> 1) & 3;        // 1 = layer III
+    int const br_idx  = h[2] >> 4;
+    int const sr_idx  = (h[2] >> 2) & 3;
+    if (version == 1 || layer != 1 || br_idx == 0 || br_idx == 15 || sr_idx == 3) return false;
+
+    f.mpeg1       = version == 3;
+    f.mono        = (h[3] >> 6) == 3;
+    f.bitrate     = f.mpeg1 ? br1[br_idx] : br2[br_idx];
+    f.sample_rate = sr1[sr_idx] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    f.samples     = f.mpeg1 ? 1152 : 576;
+    f.length      = f.samples / 8 * f.bitrate * 1000 / f.sample_rate + ((h[2] >> 1) & 1);
+    return f.length > 4;
+}
+
+// first frame at or after `begin` that is followed by another frame
+bool mp3_first_frame(std::uint8_t const* buf, std::size_t n, std::size_t& at, mp3_frame& f)
+{
+    for (std::size_t i = 0; i + 4 <= n; ++i) {
+        if (!mp3_header(buf + i, f)) continue;
+        std::size_t const next = i + std::size_t(f.length);
+        mp3_frame g;
+        if (next + 4 <= n && !mp3_header(buf + next, g)) continue;
+        at = i;
+        return true;
+    }
+    return false;
+}
+
+// end of the frames: trailing tags are stripped when the tail is already
+// there, otherwise the file end is close enough
+std::int64_t mp3_audio_end(source& in, std::int64_t begin)
+{
+    return audio_tags::strip_trailing(in.tag_reader(false), begin, in.size());
+}
+
+bool parse_mp3(source& in, std::int64_t begin, index& out)
+{
+    // the first frame is close behind the tags; 16 KiB also holds a Xing
+    // header and the frame after it
+    std::size_t const n = static_cast<std::size_t>(std::min<std::int64_t>(16 * 1024, in.size() - begin));
+    if (n < 4) return false;
+    std::vector<std::uint8_t> buf(n);
+    if (!in.read(begin, buf.data(), n)) return false;
+
+    std::size_t at;
+    mp3_frame f;
+    if (!mp3_first_frame(buf.data(), n, at, f)) return false;
+    std::int64_t const frame = begin + std::int64_t(at);
+    std::uint8_t const* const p = buf.data() + at;
+    std::size_t const avail = n - at;
+
+    out.format      = "mp3";
+    out.audio_begin = frame;
+    out.header_end  = frame;
+    out.audio_end   = mp3_audio_end(in, frame);
+
+    // `n` bytes at `off` into the frame, from `buf` or, for a frame at its
+    // end, read on their own
+    std::vector<std::uint8_t> more;
+    auto const at_frame = [&](std::size_t off, std::size_t len) -> std::uint8_t const* {
+        if (off + len <= avail) return p + off;
+        more.resize(len);
+        return in.read(frame + std::int64_t(off), more.data(), len) ? more.data() : nullptr;
+    };
+
+    // Xing / Info: right after the side information. Its fields follow
+    // the flags in order, so a header cut short is waited for (or given
+    // up on) as a whole rather than read with the later fields shifted
+    std::size_t const xing = 4 + (f.mpeg1 ? (f.mono ? 17 : 32) : (f.mono ? 9 : 17));
+    std::uint8_t const* x = at_frame(xing, 8);
+    if (!x && in.missing()) return false;
+    if (x && (std::memcmp(x, "Xing", 4) == 0 || std::memcmp(x, "Info", 4) == 0)) {
+        std::uint32_t const flags = be32(x + 4);
+        std::size_t const len = 8 + ((flags & 1) ? 4 : 0) + ((flags & 2) ? 4 : 0) + ((flags & 4) ? 100 : 0);
+        x = at_frame(xing, len);
+        if (!x) return false;
+        std::size_t pos = 8;
+        std::int64_t frames = 0, bytes = 0;
+        if (flags & 1) { frames = be32(x + pos); pos += 4; }
+        if (flags & 2) { bytes  = be32(x + pos); pos += 4; }
+        if (frames > 0) {
+            out.duration_ms = frames * f.samples * 1000 / f.sample_rate;
+            if (bytes > 0) out.audio_end = std::min(out.audio_end, frame + bytes);
+            else bytes = out.audio_end - frame;
+            if (flags & 4) {
+                for (int i = 1; i < 100; ++i)
+                    out.points.push_back({out.duration_ms * i / 100, frame + bytes * x[pos + std::size_t(i)] / 256});
+                out.exact = true;
+            }
+            finish(out);
+            return true;
+        }
+    }
+
+    // VBRI: 32 bytes after the frame header
+    if (avail >= 36 + 26 && std::memcmp(p + 36, "VBRI", 4) == 0) {
+        std::uint8_t const* v = p + 36;
+        std::int64_t const bytes      = be32(v + 10);
+        std::int64_t const frames     = be32(v + 14);
+        int const entries             = be16(v + 18);
+        int const scale               = be16(v + 20);
+        int const entry_size          = be16(v + 22);
+        int const frames_per_entry    = be16(v + 24);
+        if (frames > 0 && entry_size >= 1 && entry_size <= 4) {
+            out.duration_ms = frames * f.samples * 1000 / f.sample_rate;
+            if (bytes > 0) out.audio_end = std::min(out.audio_end, frame + bytes);
+            std::vector<std::uint8_t> table(std::size_t(entries) * std::size_t(entry_size));
+            if (!table.empty() && !in.read(frame + 36 + 26, table.data(), table.size())) return false;
+            std::int64_t offset = frame;
+            for (int i = 0; i < entries; ++i) {
+                std::int64_t v_entry = 0;
+                for (int b = 0; b < entry_size; ++b)
+                    v_entry = (v_entry << 8) | table[std::size_t(i * entry_size + b)];
+                offset += v_entry * scale;
+                out.points.push_back({std::int64_t(i + 1) * frames_per_entry * f.samples * 1000 / f.sample_rate,
+                                      offset});
+            }
+            out.exact = entries > 0;
+            finish(out);
+            return true;
+        }
+    }
+
+    // no VBR header: constant bitrate, so the average is the real rate
+    out.duration_ms = (out.audio_end - frame) * 8 / f.bitrate;
+    finish(out);
+    return out.duration_ms > 0;
+}
+
+// ───────────────────────────  flac  ───────────────────────────
+
+bool parse_flac(source& in, std::int64_t begin, index& out)
+{
+    std::int64_t pos = begin + 4;
+    std::int64_t sample_rate = 0, total = 0;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> seeks;      // sample, offset from first frame
+    for (;;) {
+        std::uint8_t h[4];
+        if (!in.read(pos, h, sizeof h)) return false;
+        int const type = h[0] & 0x7F;
+        std::int64_t const len = (std::int64_t(h[1]) << 16) | (std::int64_t(h[2]) << 8) | h[3];
+        if (type == 0 && len >= 34) {
+            std::uint8_t s[34];
+            if (!in.read(pos + 4, s, sizeof s)) return false;
+            sample_rate = (std::int64_t(s[10]) << 12) | (std::int64_t(s[11]) << 4) | (s[12] >> 4);
+            total = (std::int64_t(s[13] & 0x0F) << 32) | be32(s + 14);
+        } else if (type == 3) {
+            std::vector<std::uint8_t> t(static_cast<std::size_t>(len));
+            if (len > 0 && !in.read(pos + 4, t.data(), t.size())) return false;
+            for (std::size_t i = 0; i + 18 <= t.size(); i += 18) {
+                std::uint64_t const sample = be64(t.data() + i);
+                if (sample == ~std::uint64_t(0)) continue;          // placeholder
+                seeks.emplace_back(sample, be64(t.data() + i + 8));
+            }
+        }
+        pos += 4 + len;
+        if (h[0] & 0x80) break;
+        if (pos >= in.size()) return false;
+    }
+    if (sample_rate <= 0) return false;
+
+    out.format      = "flac";
+    out.audio_begin = pos;
+    out.header_end  = pos;
+    out.audio_end   = audio_tags::strip_id3v1(in.tag_reader(false), pos, in.size());
+    out.duration_ms = total * 1000 / sample_rate;
+    for (auto const& s : seeks)
+        out.points.push_back({std::int64_t(s.first * 1000 / std::uint64_t(sample_rate)), pos + std::int64_t(s.second)});
+    out.exact = !out.points.empty();
+    if (out.duration_ms <= 0) return false;     // unknown length: nothing to map onto
+    finish(out);
+    return true;
+}
+
+// ───────────────────────────  m4a  ────────────────────────────
+
+struct box {
+    std::uint8_t const* data = nullptr;         // payload
+    std::size_t         size = 0;
+};
+
+// first child box of `type` in [p, p + n)
+box find_box(std::uint8_t const* p, std::size_t n, char const* type)
+{
+    for (std::size_t pos = 0; pos + 8 <= n; ) {
+        std::uint64_t size = be32(p + pos);
+        std::size_t header = 8;
+        if (size == 1) {
+            if (pos + 16 > n) break;
+            size = be64(p + pos + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = n - pos;
+        }
+        if (size < header || size > n - pos) break;
+        if (std::memcmp(p + pos + 4, type, 4) == 0)
+            return {p + pos + header, static_cast<std::size_t>(size) - header};
+        pos += static_cast<std::size_t>(size);
+    }
+    return {};
+}
+
+box find_path(box b, std::initializer_list<char const*> path)
+{
+    for (char const* t : path) {
+        if (!b.data) return {};
+        b = find_box(b.data, b.size, t);
+    }
+    return b;
+}
+
+// one point per chunk of the first sound track in `moov`
+bool parse_moov(box moov, index& out)
+{
+    for (std::size_t pos = 0; pos + 8 <= moov.size; ) {
+        box const trak = find_box(moov.data + pos, moov.size - pos, "trak");
+        if (!trak.data) break;
+        pos = static_cast<std::size_t>(trak.data + trak.size - moov.data);
+
+        box const hdlr = find_path(trak, {"mdia", "hdlr"});
+        if (hdlr.size < 12 || std::memcmp(hdlr.data + 8, "soun", 4) != 0) continue;
+
+        box const mdhd = find_path(trak, {"mdia", "mdhd"});
+        if (mdhd.size < 24) return false;
+        bool const v1 = mdhd.data[0] == 1;
+        if (v1 && mdhd.size < 32) return false;
+        std::int64_t const timescale = be32(mdhd.data + (v1 ? 20 : 12));
+        std::int64_t const duration  = v1 ? std::int64_t(be64(mdhd.data + 24)) : std::int64_t(be32(mdhd.data + 16));
+        if (timescale <= 0) return false;
+
+        box const stbl = find_path(trak, {"mdia", "minf", "stbl"});
+        box const stts = find_path(stbl, {"stts"});
+        box const stsc = find_path(stbl, {"stsc"});
+        box const stsz = find_path(stbl, {"stsz"});
+        box stco = find_path(stbl, {"stco"});
+        bool const co64 = !stco.data;
+        if (co64) stco = find_path(stbl, {"co64"});
+        if (stts.size < 8 || stsc.size < 8 || stco.size < 8) return false;
+
+        std::size_t const chunks = be32(stco.data + 4);
+        std::size_t const width  = co64 ? 8 : 4;
+        if (chunks == 0 || chunks > (stco.size - 8) / width) return false;
+        auto const chunk_offset = [&](std::size_t k) {
+            std::uint8_t const* e = stco.data + 8 + k * width;
+            return co64 ? std::int64_t(be64(e)) : std::int64_t(be32(e));
+        };
+
+        std::size_t const runs = be32(stsc.data + 4);
+        std::size_t const deltas = be32(stts.data + 4);
+        if (runs == 0 || runs > (stsc.size - 8) / 12 || deltas > (stts.size - 8) / 8) return false;
+
+        std::size_t sizes = 0;
+        std::uint32_t fixed = 0;
+        if (stsz.size >= 12) {
+            fixed = be32(stsz.data + 4);
+            sizes = be32(stsz.data + 8);
+            if (fixed == 0 && sizes > (stsz.size - 12) / 4) sizes = 0;
+        }
+
+        // samples the tables describe; a chunk claiming more than are left
+        // is corrupt (and would otherwise spin on a 32-bit per-chunk count)
+        std::uint64_t samples = 0;
+        for (std::size_t d = 0; d < deltas; ++d) samples += be32(stts.data + 8 + d * 8);
+        if (stsz.size >= 12) samples = std::min<std::uint64_t>(samples, be32(stsz.data + 8));
+
+        // walk chunks, with the stsc run and stts entry they are in
+        std::size_t run = 0, delta = 0;
+        std::uint64_t in_delta = 0, sample = 0, time = 0;
+        std::int64_t last_end = 0;
+        for (std::size_t k = 0; k < chunks; ++k) {
+            while (run + 1 < runs && be32(stsc.data + 8 + (run + 1) * 12) <= k + 1) ++run;
+            std::uint32_t const per_chunk = be32(stsc.data + 8 + run * 12 + 4);
+            if (per_chunk > samples - sample) return false;
+            std::int64_t const offset = chunk_offset(k);
+            out.points.push_back({std::int64_t(time * 1000 / std::uint64_t(timescale)), offset});
+
+            std::int64_t bytes = 0;
+            for (std::uint32_t s = 0; s < per_chunk; ++s, ++sample) {
+                if (fixed) bytes += fixed;
+                else if (sample < sizes) bytes += be32(stsz.data + 12 + sample * 4);
+                while (delta < deltas && in_delta >= be32(stts.data + 8 + delta * 8)) { ++delta; in_delta = 0; }
+                if (delta < deltas) { time += be32(stts.data + 8 + delta * 8 + 4); ++in_delta; }
+            }
+            last_end = std::max(last_end, offset + bytes);
+        }
+
+        out.format      = "m4a";
+        out.audio_begin = chunk_offset(0);
+        out.audio_end   = last_end > out.audio_begin ? last_end : out.audio_begin;
+        out.duration_ms = duration > 0 ? duration * 1000 / timescale : std::int64_t(time * 1000 / std::uint64_t(timescale));
+        out.exact       = true;
+        if (out.audio_end <= out.audio_begin || out.duration_ms <= 0) return false;
+        finish(out);
+        return true;
+    }
+    return false;
+}
+
+bool parse_m4a(source& in, index& out)
+{
+    // the index is only worth a bounded read; 16 MiB of moov is hours of audio
+    constexpr std::int64_t max_moov = 16 * 1024 * 1024;
+    for (std::int64_t pos = 0; pos + 8 <= in.size(); ) {
+        std::uint8_t h[16];
+        if (!in.read(pos, h, 8)) return false;
+        std::int64_t size = be32(h), header = 8;
+        if (size == 1) {
+            if (!in.read(pos + 8, h + 8, 8)) return false;
+            size = std::int64_t(be64(h + 8));
+            header = 16;
+        } else if (size == 0) {
+            size = in.size() - pos;
+        }
+        if (size < header || size > in.size() - pos) return false;
+        if (std::memcmp(h + 4, "moov", 4) == 0) {
+            if (size - header > max_moov) return false;
+            std::vector<std::uint8_t> moov(static_cast<std::size_t>(size - header));
+            if (!in.read(pos + header, moov.data(), moov.size())) return false;
+            if (!parse_moov({moov.data(), moov.size()}, out)) return false;
+            out.header_end = pos + size;
+            return true;
+        }
+        pos += size;
+    }
+    return false;
+}
+
+// ───────────────────────────  wav  ────────────────────────────
+
+bool parse_wav(source& in, index& out)
+{
+    std::int64_t pos = 12, byte_rate = 0, align = 1;
+    std::uint8_t h[16];
+    while (in.read(pos, h, 8)) {
+        std::uint32_t const size = le32(h + 4);
+        if (std::memcmp(h, "fmt ", 4) == 0 && size >= 16) {
+            if (!in.read(pos + 8, h, 16)) return false;
+            byte_rate = le32(h + 8);
+            align     = std::max(1, h[12] | (h[13] << 8));
+        } else if (std::memcmp(h, "data", 4) == 0) {
+            if (byte_rate <= 0) return false;
+            out.format      = "wav";
+            out.audio_begin = pos + 8;
+            out.header_end  = pos + 8;
+            out.frame_align = static_cast<std::int32_t>(align);
+            out.audio_end   = size == 0xFFFFFFFFu ? in.size()
+                            : std::min<std::int64_t>(in.size(), pos + 8 + size);
+            out.duration_ms = (out.audio_end - out.audio_begin) * 1000 / byte_rate;
+            out.exact       = true;       // PCM is constant rate
+            finish(out);
+            return out.duration_ms > 0;
+        }
+        pos += 8 + std::int64_t(size) + (size & 1);
+    }
+    return false;
+}
+
+// ──────────────────────  frame boundaries  ────────────────────
+
+// FLAC frame header at `p` (n bytes available), checked down to its CRC-8:
+// the sync code alone turns up in compressed audio too often
+bool flac_frame_header(std::uint8_t const* p, std::size_t n)
+{
+    if (n < 6 || p[0] != 0xFF || (p[1] & 0xFE) != 0xF8) return false;
+    int const block = p[2] >> 4, rate = p[2] & 0x0F;
+    int const channels = p[3] >> 4, depth = (p[3] >> 1) & 7;
+    if (block == 0 || rate == 15 || channels > 10 || depth == 3 || (p[3] & 1)) return false;
+
+    // UTF-8 style frame or sample number
+    std::size_t len = 4;
+    int extra = 0;
+    if      ((p[4] & 0x80) == 0x00) extra = 0;
+    else if ((p[4] & 0xE0) == 0xC0) extra = 1;
+    else if ((p[4] & 0xF0) == 0xE0) extra = 2;
+    else if ((p[4] & 0xF8) == 0xF0) extra = 3;
+    else if ((p[4] & 0xFC) == 0xF8) extra = 4;
+    else if ((p[4] & 0xFE) == 0xFC) extra = 5;
+    else if (p[4] == 0xFE)          extra = 6;
+    else return false;
+    len += 1 + std::size_t(extra);
+    len += block == 6 ? 1 : block == 7 ? 2 : 0;
+    len += rate == 12 ? 1 : (rate == 13 || rate == 14) ? 2 : 0;
+    if (len + 1 > n) return false;
+    for (std::size_t i = 5; i < 5 + std::size_t(extra); ++i)
+        if ((p[i] & 0xC0) != 0x80) return false;
+
+    std::uint8_t crc = 0;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; ++b) crc = std::uint8_t((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc == p[len];
+}
+
+// first mp3 or flac frame in [offset, audio_end), by scanning for it
+std::int64_t scan_frame(reader const& read, index const& idx, std::int64_t offset, bool flac)
+{
+    // a frame is at most a few KiB apart from the next in either format;
+    // the scan reads ahead far enough to check the frame after the match
+    constexpr std::int64_t window = 64 * 1024;
+    std::int64_t const n = std::min(window, idx.audio_end - offset);
+    if (n <= 0) return idx.audio_end;
+    std::vector<std::uint8_t> buf(static_cast<std::size_t>(n));
+    if (!read(offset, buf.data(), buf.size())) return -1;
+
+    std::size_t const size = buf.size();
+    for (std::size_t i = 0; i + 4 <= size; ++i) {
+        if (flac) {
+            if (flac_frame_header(buf.data() + i, size - i)) return offset + std::int64_t(i);
+            continue;
+        }
+        mp3_frame f, g;
+        if (!mp3_header(buf.data() + i, f)) continue;
+        std::size_t const next = i + std::size_t(f.length);
+        if (offset + std::int64_t(next) >= idx.audio_end) return offset + std::int64_t(i);
+        if (next + 4 <= size && mp3_header(buf.data() + next, g) && g.sample_rate == f.sample_rate)
+            return offset + std::int64_t(i);
+    }
+    // nothing that looks like a frame: the end of a short tail
+    return n < window ? idx.audio_end : -1;
+}
+
+std::int64_t lerp(std::int64_t x, std::int64_t x0, std::int64_t x1, std::int64_t y0, std::int64_t y1)
+{
+    if (x1 <= x0) return y0;
+    return y0 + static_cast<std::int64_t>(double(x - x0) * double(y1 - y0) / double(x1 - x0));
+}
+
+} // namespace
+
+std::int64_t index::byte_at(std::int64_t ms) const
+{
+    if (points.empty()) return -1;
+    if (ms <= points.front().ms) return points.front().offset;
+    if (ms >= points.back().ms) return points.back().offset;
+    auto const hi = std::upper_bound(points.begin(), points.end(), ms,
+                                     [](std::int64_t t, point const& p) { return t < p.ms; });
+    auto const lo = hi - 1;
+    return lerp(ms, lo->ms, hi->ms, lo->offset, hi->offset);
+}
+
+std::int64_t index::ms_at(std::int64_t offset) const
+{
+    if (points.empty()) return -1;
+    if (offset <= points.front().offset) return points.front().ms;
+    if (offset >= points.back().offset) return points.back().ms;
+    auto const hi = std::upper_bound(points.begin(), points.end(), offset,
+                                     [](std::int64_t o, point const& p) { return o < p.offset; });
+    auto const lo = hi - 1;
+    return lerp(offset, lo->offset, hi->offset, lo->ms, hi->ms);
+}
+
+std::int64_t frame_boundary(reader const& read, index const& idx, std::int64_t offset)
+{
+    if (idx.points.empty()) return -1;
+    offset = std::max(offset, idx.audio_begin);
+    if (offset >= idx.audio_end) return idx.audio_end;
+
+    std::string_view const fmt = idx.format;
+    if (fmt == "mp3")  return scan_frame(read, idx, offset, false);
+    if (fmt == "flac") return scan_frame(read, idx, offset, true);
+    if (fmt == "m4a") {
+        // points sit on chunk starts
+        auto const it = std::lower_bound(idx.points.begin(), idx.points.end(), offset,
+                                         [](point const& p, std::int64_t o) { return p.offset < o; });
+        return it == idx.points.end() ? idx.audio_end : std::min(it->offset, idx.audio_end);
+    }
+    if (fmt == "wav") {
+        std::int64_t const a = idx.frame_align;
+        return std::min(idx.audio_end, idx.audio_begin + (offset - idx.audio_begin + a - 1) / a * a);
+    }
+    return -1;
+}
+
+status parse(reader const& read, std::int64_t file_size, index& out,
+             std::int64_t& need_offset, std::int64_t& need_length)
+{
+    out = index{};
+    source in(read, file_size);
+
+    bool ok = false;
+    std::uint8_t h[12] = {};
+    if (in.read(0, h, static_cast<std::size_t>(std::min<std::int64_t>(sizeof h, file_size)))) {
+        if (std::memcmp(h, "RIFF", 4) == 0 && std::memcmp(h + 8, "WAVE", 4) == 0) {
+            ok = parse_wav(in, out);
+        } else if (std::memcmp(h + 4, "ftyp", 4) == 0) {
+            ok = parse_m4a(in, out);
+        } else {
+            std::int64_t const begin = audio_tags::skip_id3v2(in.tag_reader(true), 0);
+            std::uint8_t m[4];
+            if (in.read(begin, m, sizeof m)) {
+                ok = std::memcmp(m, "fLaC", 4) == 0 ? parse_flac(in, begin, out)
+                                                    : parse_mp3(in, begin, out);
+            }
+        }
+    }
+    if (ok) return status::ok;
+    out = index{};
+    if (!in.missing()) return status::none;
+    need_offset = in.need_offset();
+    need_length = in.need_length();
+    return status::need;
+}
+
+} // namespace seek_index
@@ -0,0 +1,69 @@
+// seek_index.hpp  –  time → byte map of an audio file, from its header
+// -------------------------------------------------------------
+// Seeking a track that is still downloading needs the pieces that hold a
+// given timestamp. A byte offset from the average bitrate is wrong for VBR
+// MP3 and FLAC, so the index is taken from what the container records:
+//
+//   mp3   Xing/Info TOC (100 points) or VBRI table; plain CBR is linear
+//         between the first frame and the trailing tags
+//   flac  SEEKTABLE points (placeholders skipped), STREAMINFO duration
+//   m4a   one point per chunk of the audio track, from stts/stsc/stco
+//         (or co64); stsz gives the end of the last chunk
+//   wav   linear over the `data` chunk, exact for PCM
+//
+// The header is read through a callback, so the same parser works on a
+// complete file and on a torrent whose later pieces are still missing.
+// When the callback cannot supply some bytes yet, parse() says which range
+// it needs (an m4a `moov` box at the end, say) so those pieces can be
+// fetched first and the parse retried.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace seek_index {
+
+struct point {
+    std::int64_t ms;
+    std::int64_t offset;    // bytes into the file
+};
+
+struct index {
+    char const*        format      = "raw";    // mp3 | flac | m4a | wav | raw
+    std::int64_t       duration_ms = 0;
+    std::int64_t       audio_begin = 0;        // first byte of the first frame
+    std::int64_t       audio_end   = 0;        // one past the last audio byte
+    std::int64_t       header_end  = 0;        // one past the metadata a decoder needs
+                                               // first (an m4a moov may follow the audio)
+    std::int32_t       frame_align = 1;        // wav: bytes per PCM frame
+    bool               exact       = false;    // points come from a container table
+    std::vector<point> points;                 // ascending in both fields
+
+    // file offset of the frame playing at `ms`, interpolated between
+    // points; -1 for an empty index
+    std::int64_t byte_at(std::int64_t ms) const;
+    // inverse of byte_at()
+    std::int64_t ms_at(std::int64_t offset) const;
+};
+
+// exactly `n` bytes at `offset`, or false when they are not there (yet)
+using reader = std::function<bool(std::int64_t offset, void* buf, std::size_t n)>;
+
+enum class status {
+    ok,         // `out` is filled in
+    need,       // bytes [need_offset, need_offset + need_length) are missing
+    none        // not a format this knows, or a broken header
+};
+
+status parse(reader const& read, std::int64_t file_size, index& out,
+             std::int64_t& need_offset, std::int64_t& need_length);
+
+// Start of the first whole frame at or after `offset` (audio_end once past
+// the last one), so a prefix of the file cut there decodes to the end: mp3
+// and flac frames are found by their sync words, m4a cuts between chunks
+// and wav between PCM frames. -1 when the bytes to look at cannot be read.
+std::int64_t frame_boundary(reader const& read, index const& idx, std::int64_t offset);
+
+} // namespace seek_index
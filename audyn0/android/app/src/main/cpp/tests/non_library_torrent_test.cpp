@@ -0,0 +1,150 @@
+// non_library_torrent_test.cpp  –  a downloaded (non-library) torrent is
+// found on disk under its save path: its seek index is built and the
+// stream server serves its bytes. Desktop build only, through the C ABI:
+//   cmake -S android/app/src/main/cpp -B build && cmake --build build
+//   ctest --test-dir build --output-on-failure
+#include "audyn_ffi.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++g_failures;                                                       \
+        }                                                                       \
+    } while (0)
+
+// polls `f` until it returns true, for at most `seconds`
+template <class F>
+bool wait_for(F f, int seconds = 20)
+{
+    auto const until = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (!f()) {
+        if (std::chrono::steady_clock::now() > until) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return true;
+}
+
+// one second of 8 kHz 16-bit mono silence with a ramp, so ranges differ
+std::vector<char> make_wav()
+{
+    std::uint32_t const rate = 8000, data = rate * 2;
+    std::vector<char> w(44 + data);
+    auto put32 = [&](std::size_t at, std::uint32_t v) { for (int i = 0; i < 4; ++i) w[at + i] = char(v >> (8 * i)); };
+    auto put16 = [&](std::size_t at, std::uint16_t v) { w[at] = char(v); w[at + 1] = char(v >> 8); };
+    std::memcpy(&w[0], "RIFF", 4);  put32(4, 36 + data);
+    std::memcpy(&w[8], "WAVEfmt ", 8);
+    put32(16, 16); put16(20, 1); put16(22, 1); put32(24, rate); put32(28, rate * 2);
+    put16(32, 2);  put16(34, 16);
+    std::memcpy(&w[36], "data", 4); put32(40, data);
+    for (std::uint32_t i = 0; i < data; ++i) w[44 + i] = char(i * 7);
+    return w;
+}
+
+// GET `url` with a Range header, the whole response
+std::string http_range(std::string const& url, long first, long last)
+{
+    // http://127.0.0.1:<port>/<path>
+    auto const host = url.find("//") + 2;
+    auto const colon = url.find(':', host);
+    auto const slash = url.find('/', colon);
+    int const port = std::atoi(url.substr(colon + 1, slash - colon - 1).c_str());
+
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return {};
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port   = htons(static_cast<std::uint16_t>(port));
+    ::inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr);
+    std::string out;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0) {
+        std::string const req = "GET " + url.substr(slash) + " HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                                "Range: bytes=" + std::to_string(first) + "-" + std::to_string(last) +
+                                "\r\nConnection: close\r\n\r\n";
+        if (::send(fd, req.data(), req.size(), 0) == ssize_t(req.size())) {
+            char buf[4096];
+            for (ssize_t n; (n = ::recv(fd, buf, sizeof(buf), 0)) > 0; ) out.append(buf, std::size_t(n));
+        }
+    }
+    ::close(fd);
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    char tmpl[] = "/tmp/audyn-test-XXXXXX";
+    char const* dir = ::mkdtemp(tmpl);
+    if (!dir) { std::perror("mkdtemp"); return 1; }
+    std::string const track = std::string(dir) + "/tone.wav";
+    std::vector<char> const wav = make_wav();
+    std::ofstream(track, std::ios::binary).write(wav.data(), std::streamsize(wav.size()));
+
+    // .torrent bytes of the track
+    std::int64_t const job = audyn_create_job_start(track.c_str(), nullptr, nullptr, 0, 0, 0);
+    CHECK(job > 0);
+    std::int64_t size = 0;
+    CHECK(wait_for([&] { return (size = audyn_create_job_take(job, nullptr, 0)) > 0; }));
+    std::vector<std::uint8_t> bytes(std::size_t(size > 0 ? size : 0));
+    CHECK(audyn_create_job_take(job, bytes.data(), size) == size);
+
+    // added from its folder like a finished download, not as a library seed
+    audyn_session* s = audyn_session_open();
+    CHECK(s != nullptr);
+    audyn_add_options o{};
+    o.announce = 1;
+    CHECK(audyn_add_torrent_bytes(s, bytes.data(), size, dir, &o, 0, 0) == AUDYN_OK);
+
+    audyn_torrent* t = nullptr;
+    CHECK(wait_for([&] { return (t = audyn_torrent_find(s, "tone.wav")) != nullptr; }));
+    char hash[65] = {};
+    if (t) {
+        CHECK(audyn_torrent_info_hash(t, hash, sizeof(hash)) > 0);
+        CHECK(wait_for([&] {
+            audyn_refresh_status(s);
+            audyn_torrent_status st{};
+            return audyn_torrent_get_status(t, &st) == AUDYN_OK && (st.flags & AUDYN_TORRENT_FINISHED);
+        }));
+        audyn_torrent_release(t);
+    }
+
+    char buf[4096] = {};
+    CHECK(audyn_seek_index(hash, 0, buf, sizeof(buf)) > 0);
+    CHECK(std::strstr(buf, "\"format\":\"wav\"") != nullptr);
+
+    char url[512] = {};
+    CHECK(audyn_stream_url(hash, 0, url, sizeof(url)) > 0);
+    std::string const res = http_range(url, 100, 163);
+    CHECK(res.find(" 206 ") != std::string::npos);
+    auto const body = res.find("\r\n\r\n");
+    CHECK(body != std::string::npos && res.size() - (body + 4) == 64);
+    if (body != std::string::npos && res.size() - (body + 4) == 64)
+        CHECK(std::memcmp(res.data() + body + 4, wav.data() + 100, 64) == 0);
+
+    audyn_stream_stop();
+    audyn_session_close(s);
+    std::remove(track.c_str());
+    ::rmdir(dir);
+    if (g_failures) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
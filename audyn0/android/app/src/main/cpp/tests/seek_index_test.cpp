@@ -0,0 +1,283 @@
+// seek_index_test.cpp  –  seek_index::parse on a small file of each
+// container, whole and with its later bytes still missing (the range
+// parse() asks for first). No session involved:
+//   cmake -S android/app/src/main/cpp -B build && cmake --build build
+//   ctest --test-dir build --output-on-failure
+#include "seek_index.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++g_failures;                                                       \
+        }                                                                       \
+    } while (0)
+
+using bytes = std::vector<std::uint8_t>;
+
+void put(bytes& b, char const* s) { b.insert(b.end(), s, s + std::strlen(s)); }
+void put(bytes& b, bytes const& s) { b.insert(b.end(), s.begin(), s.end()); }
+void zeros(bytes& b, std::size_t n) { b.insert(b.end(), n, 0); }
+
+void be32(bytes& b, std::uint32_t v)
+{
+    for (int i = 3; i >= 0; --i) b.push_back(std::uint8_t(v >> (8 * i)));
+}
+
+void le32(bytes& b, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) b.push_back(std::uint8_t(v >> (8 * i)));
+}
+
+void le16(bytes& b, std::uint16_t v)
+{
+    b.push_back(std::uint8_t(v));
+    b.push_back(std::uint8_t(v >> 8));
+}
+
+// m4a box of `type` around `payload`
+bytes box(char const* type, bytes const& payload)
+{
+    bytes b;
+    be32(b, std::uint32_t(8 + payload.size()));
+    put(b, type);
+    put(b, payload);
+    return b;
+}
+
+// a 10-byte ID3v2.3 header and `body` bytes of padding
+void id3v2(bytes& b, std::uint8_t body)
+{
+    put(b, "ID3");
+    b.insert(b.end(), {3, 0, 0, 0, 0, 0, body});
+    zeros(b, body);
+}
+
+// a 128-byte ID3v1 tag
+void id3v1(bytes& b)
+{
+    put(b, "TAG");
+    zeros(b, 125);
+}
+
+// bytes of `file` below `have`, as a torrent with the rest missing
+seek_index::reader reader_of(bytes const& file, std::int64_t have)
+{
+    return [&file, have](std::int64_t off, void* buf, std::size_t n) {
+        if (off < 0 || off + std::int64_t(n) > std::min<std::int64_t>(have, std::int64_t(file.size()))) return false;
+        std::memcpy(buf, file.data() + off, n);
+        return true;
+    };
+}
+
+seek_index::status parse(bytes const& file, std::int64_t have, seek_index::index& idx,
+                         std::int64_t& need_offset, std::int64_t& need_length)
+{
+    need_offset = need_length = 0;
+    return seek_index::parse(reader_of(file, have), std::int64_t(file.size()), idx, need_offset, need_length);
+}
+
+// one second of 8 kHz 16-bit mono PCM
+void test_wav()
+{
+    bytes w;
+    put(w, "RIFF"); le32(w, 36 + 16000); put(w, "WAVE");
+    put(w, "fmt "); le32(w, 16);
+    le16(w, 1); le16(w, 1); le32(w, 8000); le32(w, 16000); le16(w, 2); le16(w, 16);
+    put(w, "data"); le32(w, 16000);
+    zeros(w, 16000);
+
+    seek_index::index idx;
+    std::int64_t off, len;
+    CHECK(parse(w, std::int64_t(w.size()), idx, off, len) == seek_index::status::ok);
+    CHECK(std::strcmp(idx.format, "wav") == 0);
+    CHECK(idx.duration_ms == 1000);
+    CHECK(idx.audio_begin == 44 && idx.audio_end == 44 + 16000);
+    CHECK(idx.frame_align == 2);
+    CHECK(idx.byte_at(500) == 44 + 8000);
+    CHECK(idx.ms_at(44 + 4000) == 250);
+}
+
+// ID3v2 in front, STREAMINFO for 10 s at 44.1 kHz, a SEEKTABLE with one
+// point and one placeholder, then "frames" and an ID3v1 tag
+void test_flac()
+{
+    bytes f;
+    id3v2(f, 20);
+    std::int64_t const begin = std::int64_t(f.size());
+    put(f, "fLaC");
+    f.insert(f.end(), {0x00, 0, 0, 34});                            // STREAMINFO
+    bytes si(34, 0);
+    si[10] = 0x0A; si[11] = 0xC4; si[12] = 0x40 | 0x02;             // 44100 Hz, stereo
+    si[13] = 0xF0;                                                  // 16 bit, total high bits 0
+    std::uint32_t const total = 441000;
+    for (int i = 0; i < 4; ++i) si[std::size_t(14 + i)] = std::uint8_t(total >> (8 * (3 - i)));
+    put(f, si);
+    f.insert(f.end(), {0x80 | 0x03, 0, 0, 36});                     // last block: SEEKTABLE
+    bytes st;
+    be32(st, 0); be32(st, 220500);                                  // 5 s …
+    be32(st, 0); be32(st, 6000);                                    // … 6000 bytes in
+    zeros(st, 2);
+    for (int i = 0; i < 8; ++i) st.push_back(0xFF);                 // placeholder
+    zeros(st, 10);
+    put(f, st);
+    std::int64_t const frames = std::int64_t(f.size());
+    zeros(f, 12000);
+    id3v1(f);
+
+    seek_index::index idx;
+    std::int64_t off, len;
+    CHECK(parse(f, std::int64_t(f.size()), idx, off, len) == seek_index::status::ok);
+    CHECK(std::strcmp(idx.format, "flac") == 0);
+    CHECK(idx.duration_ms == 10000);
+    CHECK(idx.audio_begin == frames && idx.header_end == frames);
+    CHECK(idx.audio_end == frames + 12000);
+    CHECK(idx.exact);
+    CHECK(idx.byte_at(5000) == frames + 6000);
+    CHECK(begin == 30);
+
+    // the metadata blocks are not there yet: the SEEKTABLE header is asked for
+    seek_index::index part;
+    CHECK(parse(f, begin + 4 + 4 + 34 + 2, part, off, len) == seek_index::status::need);
+    CHECK(off == begin + 4 + 4 + 34 && len == 4);
+}
+
+// MPEG-1 layer III, 128 kbit/s, 44.1 kHz stereo: 417-byte frames, the
+// first holding a Xing header with frame count, byte count and TOC.
+// `lead` zero bytes go in front of the first frame
+bytes make_mp3(std::size_t lead, int count)
+{
+    std::size_t const frame = 417;
+    bytes m;
+    id3v2(m, 20);
+    zeros(m, lead);
+    for (int i = 0; i < count; ++i) {
+        std::size_t const at = m.size();
+        m.insert(m.end(), {0xFF, 0xFB, 0x90, 0x00});
+        zeros(m, frame - 4);
+        if (i == 0) {
+            std::uint8_t* x = m.data() + at + 36;
+            std::memcpy(x, "Xing", 4);
+            x[7] = 0x07;                                            // frames, bytes, toc
+            std::uint32_t const n = std::uint32_t(count), b = std::uint32_t(count * frame);
+            for (int k = 0; k < 4; ++k) {
+                x[8 + k]  = std::uint8_t(n >> (8 * (3 - k)));
+                x[12 + k] = std::uint8_t(b >> (8 * (3 - k)));
+            }
+            for (int k = 0; k < 100; ++k) x[16 + k] = std::uint8_t(k * 256 / 100);
+        }
+    }
+    id3v1(m);
+    return m;
+}
+
+void test_mp3()
+{
+    int const count = 100;
+    bytes const m = make_mp3(0, count);
+    std::int64_t const frame = 30;
+    std::int64_t const audio = count * 417;
+
+    seek_index::index idx;
+    std::int64_t off, len;
+    CHECK(parse(m, std::int64_t(m.size()), idx, off, len) == seek_index::status::ok);
+    CHECK(std::strcmp(idx.format, "mp3") == 0);
+    CHECK(idx.duration_ms == count * 1152 * 1000 / 44100);
+    CHECK(idx.audio_begin == frame);
+    CHECK(idx.audio_end == frame + audio);
+    CHECK(idx.exact);
+    CHECK(idx.byte_at(idx.duration_ms / 2) == frame + audio * 128 / 256);
+
+    // a first frame at the end of the 16 KiB the parser reads up front:
+    // the Xing header behind it is missing, which is waited for rather
+    // than taken for a constant bitrate file
+    std::size_t const lead = 16 * 1024 - 20;
+    bytes const late = make_mp3(lead, count);
+    std::int64_t const xing = 30 + std::int64_t(lead) + 36;
+    seek_index::index part;
+    CHECK(parse(late, 30 + 16 * 1024, part, off, len) == seek_index::status::need);
+    CHECK(off == xing && len == 8);
+    CHECK(parse(late, std::int64_t(late.size()), part, off, len) == seek_index::status::ok);
+    CHECK(part.exact && part.duration_ms == idx.duration_ms);
+
+    // the Xing flags are there, its fields not
+    CHECK(parse(late, xing + 8, part, off, len) == seek_index::status::need);
+    CHECK(off == xing && len == 8 + 4 + 4 + 100);
+}
+
+// ftyp, an mdat of 4 chunks × 2 samples × 100 bytes, then the moov that
+// indexes it (timescale 1000, 500 per sample: 4 s)
+void test_m4a()
+{
+    bytes ftyp_payload;
+    put(ftyp_payload, "M4A ");
+    be32(ftyp_payload, 0);
+    bytes f = box("ftyp", ftyp_payload);
+    std::int64_t const data = std::int64_t(f.size()) + 8;
+    put(f, box("mdat", bytes(800, 0x55)));
+    std::int64_t const moov_at = std::int64_t(f.size());
+
+    bytes mdhd; be32(mdhd, 0); be32(mdhd, 0); be32(mdhd, 0); be32(mdhd, 1000); be32(mdhd, 4000); be32(mdhd, 0);
+    bytes hdlr; be32(hdlr, 0); be32(hdlr, 0); put(hdlr, "soun"); zeros(hdlr, 13);
+    bytes stts; be32(stts, 0); be32(stts, 1); be32(stts, 8); be32(stts, 500);
+    bytes stsc; be32(stsc, 0); be32(stsc, 1); be32(stsc, 1); be32(stsc, 2); be32(stsc, 1);
+    bytes stsz; be32(stsz, 0); be32(stsz, 100); be32(stsz, 8);
+    bytes stco; be32(stco, 0); be32(stco, 4);
+    for (int k = 0; k < 4; ++k) be32(stco, std::uint32_t(data + 200 * k));
+    bytes stbl = box("stts", stts);
+    put(stbl, box("stsc", stsc)); put(stbl, box("stsz", stsz)); put(stbl, box("stco", stco));
+    bytes mdia = box("mdhd", mdhd);
+    put(mdia, box("hdlr", hdlr));
+    put(mdia, box("minf", box("stbl", stbl)));
+    bytes const moov = box("moov", box("trak", box("mdia", mdia)));
+    put(f, moov);
+
+    seek_index::index idx;
+    std::int64_t off, len;
+    CHECK(parse(f, std::int64_t(f.size()), idx, off, len) == seek_index::status::ok);
+    CHECK(std::strcmp(idx.format, "m4a") == 0);
+    CHECK(idx.duration_ms == 4000);
+    CHECK(idx.audio_begin == data && idx.audio_end == data + 800);
+    CHECK(idx.header_end == std::int64_t(f.size()));
+    CHECK(idx.exact);
+    CHECK(idx.byte_at(1000) == data + 200);
+    CHECK(idx.byte_at(3000) == data + 600);
+
+    // the moov at the end has not arrived: its payload is what to fetch
+    seek_index::index part;
+    CHECK(parse(f, moov_at + 8, part, off, len) == seek_index::status::need);
+    CHECK(off == moov_at + 8 && len == std::int64_t(moov.size()) - 8);
+}
+
+void test_none()
+{
+    bytes junk(4096, 0x11);
+    seek_index::index idx;
+    std::int64_t off, len;
+    CHECK(parse(junk, std::int64_t(junk.size()), idx, off, len) == seek_index::status::none);
+    CHECK(idx.points.empty());
+}
+
+} // namespace
+
+int main()
+{
+    test_wav();
+    test_flac();
+    test_mp3();
+    test_m4a();
+    test_none();
+    if (g_failures) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
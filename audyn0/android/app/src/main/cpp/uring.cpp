@@ -0,0 +1,253 @@
+// uring.cpp  –  see uring.hpp
+#include "uring.hpp"
+
+#if defined(__linux__) && !defined(__ANDROID__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define AUDYN_HAVE_IO_URING 1
+#  endif
+#endif
+#ifndef AUDYN_HAVE_IO_URING
+#  define AUDYN_HAVE_IO_URING 0
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#if AUDYN_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// the same numbers on every architecture since 5.1
+#ifndef __NR_io_uring_setup
+#  define __NR_io_uring_setup    425
+#endif
+#ifndef __NR_io_uring_enter
+#  define __NR_io_uring_enter    426
+#endif
+#ifndef __NR_io_uring_register
+#  define __NR_io_uring_register 427
+#endif
+#endif
+
+namespace uring {
+
+#if AUDYN_HAVE_IO_URING
+
+namespace {
+
+template <class T>
+T* at(void* base, std::uint32_t off)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+}
+
+int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                                      nullptr, 0));
+}
+
+int reg(int fd, unsigned op, void const* arg, unsigned n)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, op, arg, n));
+}
+
+} // namespace
+
+bool supported() { return true; }
+
+ring::~ring() { close(); }
+
+void ring::close()
+{
+    if (m_sqes)    ::munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring && m_cq_ring != m_sq_ring) ::munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring) ::munmap(m_sq_ring, m_sq_ring_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+    m_sq_ring = m_cq_ring = m_sqes = nullptr;
+    m_has_buffer = false;
+    m_file_slots = 0;
+}
+
+int ring::open(unsigned entries)
+{
+    close();
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int const fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd < 0) return errno;
+    m_fd = fd;
+
+    m_sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool const single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    void* sq = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) { int const e = errno; close(); return e; }
+    m_sq_ring = sq;
+    void* cq = sq;
+    if (!single) {
+        cq = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) { int const e = errno; close(); return e; }
+    }
+    m_cq_ring   = cq;
+    m_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) { int const e = errno; close(); return e; }
+    m_sqes = sqes;
+
+    m_sq_head    = at<unsigned>(sq, p.sq_off.head);
+    m_sq_tail    = at<unsigned>(sq, p.sq_off.tail);
+    m_sq_mask    = *at<unsigned>(sq, p.sq_off.ring_mask);
+    m_sq_array   = at<unsigned>(sq, p.sq_off.array);
+    m_sq_entries = p.sq_entries;
+    m_cq_head    = at<unsigned>(cq, p.cq_off.head);
+    m_cq_tail    = at<unsigned>(cq, p.cq_off.tail);
+    m_cq_mask    = *at<unsigned>(cq, p.cq_off.ring_mask);
+    m_cqes       = at<io_uring_cqe>(cq, p.cq_off.cqes);
+    m_to_submit  = 0;
+    return 0;
+}
+
+int ring::register_buffer(void* base, std::size_t len)
+{
+    if (m_fd < 0) return EBADF;
+    iovec iov{base, len};
+    if (reg(m_fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0) return errno;
+    m_has_buffer = true;
+    return 0;
+}
+
+int ring::register_files(unsigned count)
+{
+    if (m_fd < 0) return EBADF;
+    std::vector<int> fds(count, -1);    // sparse: every slot empty
+    if (reg(m_fd, IORING_REGISTER_FILES, fds.data(), count) < 0) return errno;
+    m_file_slots = count;
+    return 0;
+}
+
+int ring::update_file(unsigned slot, int fd)
+{
+    if (slot >= m_file_slots) return EINVAL;
+    io_uring_files_update up;
+    std::memset(&up, 0, sizeof(up));
+    std::int32_t fds[1] = {fd};
+    up.offset = slot;
+    up.fds    = reinterpret_cast<std::uintptr_t>(fds);
+    if (reg(m_fd, IORING_REGISTER_FILES_UPDATE, &up, 1) < 0) return errno;
+    return 0;
+}
+
+unsigned ring::space() const
+{
+    if (m_fd < 0) return 0;
+    unsigned const head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    return m_sq_entries - (*m_sq_tail - head);
+}
+
+bool ring::read(int fd, bool fixed_file, void* buf, unsigned len, std::uint64_t off,
+                bool fixed_buf, iovec* iov, std::uint64_t user_data)
+{
+    if (space() == 0) return false;
+    unsigned const tail = *m_sq_tail;
+    unsigned const idx  = tail & m_sq_mask;
+    io_uring_sqe& sqe = static_cast<io_uring_sqe*>(m_sqes)[idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.fd        = fd;
+    sqe.off       = off;
+    sqe.user_data = user_data;
+    if (fixed_file) sqe.flags |= IOSQE_FIXED_FILE;
+    if (fixed_buf) {
+        sqe.opcode    = IORING_OP_READ_FIXED;
+        sqe.addr      = reinterpret_cast<std::uintptr_t>(buf);
+        sqe.len       = len;
+        sqe.buf_index = 0;
+    } else {
+        iov->iov_base = buf;
+        iov->iov_len  = len;
+        sqe.opcode    = IORING_OP_READV;
+        sqe.addr      = reinterpret_cast<std::uintptr_t>(iov);
+        sqe.len       = 1;
+    }
+    m_sq_array[idx] = idx;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++m_to_submit;
+    return true;
+}
+
+int ring::submit(unsigned wait_for)
+{
+    if (m_fd < 0) return -EBADF;
+    for (;;) {
+        int const n = enter(m_fd, m_to_submit, wait_for, wait_for ? IORING_ENTER_GETEVENTS : 0);
+        if (n >= 0) {
+            m_to_submit -= std::min(m_to_submit, unsigned(n));
+            return n;
+        }
+        if (errno == EINTR) continue;
+        return -errno;
+    }
+}
+
+unsigned ring::reap(completion* out, unsigned n)
+{
+    if (m_fd < 0) return 0;
+    unsigned head = *m_cq_head;
+    unsigned const tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    unsigned got = 0;
+    auto const* cqes = static_cast<io_uring_cqe const*>(m_cqes);
+    while (head != tail && got < n) {
+        io_uring_cqe const& c = cqes[head & m_cq_mask];
+        out[got++] = {c.user_data, c.res};
+        ++head;
+    }
+    __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+    return got;
+}
+
+unsigned ring::take_back(std::uint64_t* out, unsigned n)
+{
+    if (m_fd < 0) return 0;
+    unsigned const head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *m_sq_tail;
+    unsigned got = 0;
+    auto const* sqes = static_cast<io_uring_sqe const*>(m_sqes);
+    while (tail != head && got < n) {
+        --tail;
+        out[got++] = sqes[m_sq_array[tail & m_sq_mask]].user_data;
+    }
+    __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+    m_to_submit -= std::min(m_to_submit, got);
+    return got;
+}
+
+#else   // !AUDYN_HAVE_IO_URING
+
+bool supported() { return false; }
+
+ring::~ring() = default;
+void ring::close() {}
+int ring::open(unsigned) { return ENOSYS; }
+int ring::register_buffer(void*, std::size_t) { return ENOSYS; }
+int ring::register_files(unsigned) { return ENOSYS; }
+int ring::update_file(unsigned, int) { return ENOSYS; }
+unsigned ring::space() const { return 0; }
+bool ring::read(int, bool, void*, unsigned, std::uint64_t, bool, iovec*, std::uint64_t) { return false; }
+int ring::submit(unsigned) { return -ENOSYS; }
+unsigned ring::reap(completion*, unsigned) { return 0; }
+unsigned ring::take_back(std::uint64_t*, unsigned) { return 0; }
+
+#endif
+
+} // namespace uring
@@ -0,0 +1,98 @@
+// uring.hpp  –  minimal io_uring submission ring, without liburing
+// -------------------------------------------------------------
+// Just what the library storage needs to batch its reads (see
+// uring_reader in LibtorrentWrapper.cpp): one ring, one registered buffer
+// arena, a sparse table of registered files, READ_FIXED / READV
+// submissions and a reap loop. Everything goes through the raw syscalls,
+// so nothing extra is linked in.
+//
+// Only built for desktop Linux. Android kernels have io_uring, but the app
+// seccomp policy kills the process on the first io_uring syscall instead
+// of failing it, so there supported() is false and ring::open() refuses
+// without trying. Callers stay on pread() whenever open() fails.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct iovec;
+
+namespace uring {
+
+// compiled in, and not on a platform where trying it is fatal
+bool supported();
+
+struct completion {
+    std::uint64_t user_data;
+    std::int32_t  res;          // bytes read, or -errno
+};
+
+class ring {
+public:
+    ring() = default;
+    ~ring();
+    ring(ring const&) = delete;
+    ring& operator=(ring const&) = delete;
+
+    // 0, or the errno of the first failing step (ENOSYS without io_uring)
+    int open(unsigned entries);
+    bool is_open() const { return m_fd >= 0; }
+    unsigned entries() const { return m_sq_entries; }
+
+    // [base, base + len) becomes fixed buffer 0 for read()s with `fixed_buf`
+    int register_buffer(void* base, std::size_t len);
+    // a table of `count` empty file slots for read()s with `fixed_file`
+    int register_files(unsigned count);
+    // points `slot` at `fd` (the ring keeps its own reference to the file)
+    int update_file(unsigned slot, int fd);
+    bool has_buffer() const { return m_has_buffer; }
+    unsigned file_slots() const { return m_file_slots; }
+
+    // free submission entries
+    unsigned space() const;
+
+    // queues a read of `len` bytes at `off` into `buf`; `fd` is a slot of
+    // register_files() when `fixed_file`. Without `fixed_buf`, `iov` must
+    // stay valid until the read completes. False when the ring is full.
+    bool read(int fd, bool fixed_file, void* buf, unsigned len, std::uint64_t off,
+              bool fixed_buf, iovec* iov, std::uint64_t user_data);
+
+    // submits everything queued and waits until at least `wait_for`
+    // completions are there: the number submitted, or -errno
+    int submit(unsigned wait_for);
+
+    // moves up to `n` completions to `out`
+    unsigned reap(completion* out, unsigned n);
+
+    // takes back up to `n` reads the kernel has not picked up (after a
+    // failed submit()), newest first: their user_data goes to `out`
+    unsigned take_back(std::uint64_t* out, unsigned n);
+
+private:
+    void close();
+
+    int            m_fd = -1;
+    void*          m_sq_ring = nullptr;
+    void*          m_cq_ring = nullptr;
+    void*          m_sqes    = nullptr;
+    std::size_t    m_sq_ring_size = 0;
+    std::size_t    m_cq_ring_size = 0;
+    std::size_t    m_sqes_size    = 0;
+
+    unsigned*      m_sq_head  = nullptr;
+    unsigned*      m_sq_tail  = nullptr;
+    unsigned*      m_sq_array = nullptr;
+    unsigned       m_sq_mask  = 0;
+    unsigned       m_sq_entries = 0;
+    unsigned       m_to_submit  = 0;
+
+    unsigned*      m_cq_head  = nullptr;
+    unsigned*      m_cq_tail  = nullptr;
+    unsigned       m_cq_mask  = 0;
+    void*          m_cqes     = nullptr;
+
+    bool           m_has_buffer = false;
+    unsigned       m_file_slots = 0;
+};
+
+} // namespace uring
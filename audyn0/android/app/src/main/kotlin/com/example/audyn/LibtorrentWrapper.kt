@@ -1,8 +1,39 @@
 package com.example.audyn
 import java.io.IOException
 
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.content.res.Configuration
 import java.io.File
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * Completion for the *Async natives. Invoked once, on a native worker
+ * thread – hop to the main thread before touching Flutter or UI state.
+ * [value] is null or a ByteArray, depending on the call.
+ */
+fun interface NativeCallback {
+    fun onComplete(ok: Boolean, value: Any?, error: String?)
+}
+
+/**
+ * Progress of a torrent-creation job, called on a native worker thread at
+ * most every 250 ms plus once per state change.
+ * [state]: 0 queued, 1 hashing, 2 done, 3 failed, 4 cancelled.
+ */
+fun interface CreateJobListener {
+    fun onEvent(jobId: Long, state: Int, piecesDone: Int, numPieces: Int, error: String?)
+}
+
+/**
+ * Results of [LibtorrentWrapper.createTorrentsBatch], called on native
+ * worker threads. [onResult] fires once per file in completion order with
+ * either the `.torrent` bytes or an error; [onDone] fires last.
+ */
+interface TorrentBatchListener {
+    fun onResult(batchId: Long, index: Int, path: String, torrent: ByteArray?, error: String?)
+    fun onDone(batchId: Long, succeeded: Int, failed: Int, cancelled: Boolean, elapsedMs: Long)
+}
 
 class LibtorrentWrapper(private val context: Context) {
 
@@ -10,6 +41,31 @@ class LibtorrentWrapper(private val context: Context) {
         init {
             System.loadLibrary("libtorrentwrapper") // JNI .so library
         }
+
+        /** Gives read- and upload-cache memory back at an [ComponentCallbacks2] trim level. */
+        @JvmStatic
+        external fun trimReadCache(level: Int)
+
+        /**
+         * Registered with the application once per process. It holds no
+         * wrapper, so an Activity recreated on rotation is not kept alive.
+         */
+        private val trimCallbacks = object : ComponentCallbacks2 {
+            override fun onTrimMemory(level: Int) = trimReadCache(level)
+            override fun onLowMemory() = trimReadCache(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+            override fun onConfigurationChanged(newConfig: Configuration) {}
+        }
+        private val trimRegistered = AtomicBoolean(false)
+    }
+
+    init {
+        // keyed by inode, so it must not be restored onto another device
+        openTorrentCache(File(context.noBackupFilesDir, "torrent_cache").absolutePath)
+
+        // the streamed-piece cache gives its memory back when the system runs low
+        if (trimRegistered.compareAndSet(false, true)) {
+            context.applicationContext.registerComponentCallbacks(trimCallbacks)
+        }
     }
 
     /* ────────────── ORIGINAL JNI API ────────────── */
@@ -36,12 +92,58 @@ class LibtorrentWrapper(private val context: Context) {
         trackers: Array<String>? = null
     ): Boolean
 
+    /** Non-blocking [createTorrent]; false if the native job queue is full. */
+    external fun createTorrentAsync(
+        filePath: String,
+        outputPath: String,
+        trackers: Array<String>?,
+        callback: NativeCallback
+    ): Boolean
+
     external fun removeTorrentByName(torrentName: String): Boolean
 
     external fun getTorrentSavePathByName(torrentName: String): String?
 
     external fun getTorrentStats(): String
 
+    /**
+     * Changes to the native status table since [seq] as JSON:
+     * `{"seq", "full", "updated": [...], "removed": [infoHash, ...]}`.
+     * Pass the returned `seq` into the next call.
+     */
+    external fun getTorrentUpdatesSince(seq: Long): String
+
+    /**
+     * One page of the native status snapshot as JSON:
+     * `{"version", "total", "torrents": [...]}`. [sortBy] is one of
+     * name, progress, upload_rate, download_rate, num_peers, state.
+     */
+    external fun getTorrentsPage(sortBy: String?, descending: Boolean, offset: Int, limit: Int): String
+
+    /** Times the bridge JSON writer against the old lt::entry path; JSON rows per list size. */
+    external fun benchmarkJsonWriter(): String
+
+    /** Single-core MB/s of each native SHA-1 / SHA-256 variant, as JSON. */
+    external fun benchmarkPieceHashing(): String
+
+    /**
+     * Disk backend ("custom", "posix" or "mmap") and io_uring of the next session;
+     * threads, file pool and cache sizes apply at once. 0 keeps a default, -1 a
+     * cache size. False while a session runs on another backend or io_uring
+     * setting; call [cleanupSession] first.
+     */
+    external fun configureDiskBackend(
+        backend: String,
+        ioUring: Boolean,
+        aioThreads: Int,
+        filePoolSize: Int,
+        uploadCacheBytes: Long,
+        readCacheBytes: Long
+    ): Boolean
+
+    /** Seed and download MB/s, IOPS and p99 latency of each disk backend in [dir], as JSON. */
+    external fun benchmarkDiskBackends(dir: String, files: Int, fileSizeBytes: Long): String
+
     external fun cleanupSession()
 
 
@@ -53,6 +155,73 @@ class LibtorrentWrapper(private val context: Context) {
      */
     external fun createTorrentBytes(sourcePath: String): ByteArray
 
+    /**
+     * Non-blocking [createTorrentBytes]. [background] queues the job behind
+     * interactive work (bulk seeding). Returns false if the queue is full.
+     */
+    external fun createTorrentBytesAsync(
+        sourcePath: String,
+        background: Boolean,
+        callback: NativeCallback
+    ): Boolean
+
+    /**
+     * Tag-independent content id of an audio file as JSON
+     * (identity, format, file_bytes, payload_bytes), or "" on error.
+     * Blocks while the file is hashed.
+     */
+    external fun getAudioIdentity(path: String): String
+
+    /** Native job executor queue depths and wait times as JSON. */
+    external fun getExecutorStats(): String
+
+    /**
+     * Starts a cancellable torrent-creation job and returns its id.
+     * With a null [outputPath] the `.torrent` stays in memory until
+     * [takeCreateJobResult].
+     */
+    external fun startCreateJob(
+        sourcePath: String,
+        outputPath: String?,
+        trackers: Array<String>?,
+        background: Boolean,
+        listener: CreateJobListener?
+    ): Long
+
+    /** Job snapshot as JSON, or "" if the id is unknown. */
+    external fun pollCreateJob(jobId: Long): String
+
+    external fun cancelCreateJob(jobId: Long): Boolean
+
+    /** Bytes of a finished in-memory job; the job is forgotten afterwards. */
+    external fun takeCreateJobResult(jobId: Long): ByteArray?
+
+    /** How many creation jobs may hash at once (1 … 16). */
+    external fun setCreateJobConcurrency(n: Int)
+
+    /**
+     * Creates one torrent per path, hashing files in parallel on the
+     * background workers. Returns the batch id. A directory path ending in
+     * '/' is an album: its audio files become one multi-file torrent, or
+     * only `albumTracks[i]` when that is given for it.
+     */
+    external fun createTorrentsBatch(
+        paths: Array<String>,
+        trackers: Array<String>?,
+        albumTracks: Array<Array<String>?>?,
+        listener: TorrentBatchListener
+    ): Long
+
+    external fun cancelTorrentsBatch(batchId: Long): Boolean
+
+    /** Opens the on-disk cache of generated torrents in the background (done in init). */
+    external fun openTorrentCache(dir: String): Boolean
+
+    /** Cache entries, hits / misses and file usage as JSON. */
+    external fun getTorrentCacheStats(): String
+
+    external fun clearTorrentCache()
+
     /**
      * Loads a torrent from raw `.torrent` bytes.
      * Assumes torrent metadata is already generated externally.
@@ -71,6 +240,20 @@ class LibtorrentWrapper(private val context: Context) {
 
     external fun isTorrentActive(infoHash: String): Boolean
 
+    /**
+     * Seeds a song (or an album folder) where it is in the library: its files
+     * are read from [sourcePath] instead of a per-song save path. Adding the
+     * same torrent again from a new path relinks it.
+     */
+    external fun addLibraryTorrent(
+        torrentBytes: ByteArray,
+        sourcePath: String,
+        announce: Boolean
+    ): Boolean
+
+    /** Library seeds, shared descriptor pool usage and I/O counts as JSON. */
+    external fun getLibraryStats(): String
+
 
     /* ────────────── Kotlin-only helper ────────────── */
 
@@ -82,9 +265,19 @@ class LibtorrentWrapper(private val context: Context) {
         sourceFilePath: String,
         trackers: Array<String>? = null
     ): Boolean {
+        return createTorrent(sourceFilePath, torrentPathInAppDir(sourceFilePath), trackers)
+    }
+
+    fun createTorrentInAppDirAsync(
+        sourceFilePath: String,
+        trackers: Array<String>?,
+        callback: NativeCallback
+    ): Boolean =
+        createTorrentAsync(sourceFilePath, torrentPathInAppDir(sourceFilePath), trackers, callback)
+
+    private fun torrentPathInAppDir(sourceFilePath: String): String {
         val torrentName = File(sourceFilePath).nameWithoutExtension + ".torrent"
-        val output = File(context.filesDir, torrentName)
-        return createTorrent(sourceFilePath, output.absolutePath, trackers)
+        return File(context.filesDir, torrentName).absolutePath
     }
     external fun startTorrentByHash(infoHash: String): Boolean
 
@@ -97,9 +290,108 @@ class LibtorrentWrapper(private val context: Context) {
         return getInfoHashNative(torrentFile.absolutePath)
     }
 
-    // 🔽 NEW JNI declaration
+    /** v1 info-hash, or the 64-char v2 hash of a v2-only torrent. */
     external fun getInfoHashFromBytes(torrentBytes: ByteArray): String
 
     external fun stopTorrentByHash(infoHash: String): Boolean
 
+    external fun removeTorrentByHash(infoHash: String, removeData: Boolean): Boolean
+
+    external fun getTorrentSavePathByHash(infoHash: String): String
+
+    /** Info-hash of the torrent for a source file path or (normalised) name, or "". */
+    external fun lookupInfoHash(nameOrPath: String): String
+
+    /** "hybrid" (default), "v1" or "v2": what torrent creation produces from now on. */
+    external fun setTorrentVersion(version: String): Boolean
+
+    /**
+     * Seconds of opening audio (0–30, 0 = none, the default) embedded in every
+     * torrent created from now on, so peers can start playing it at once.
+     */
+    external fun setPreambleSeconds(seconds: Int): Boolean
+
+    /** Files (in any loaded torrent) with this v2 merkle root, as a JSON list, or "". */
+    external fun findTorrentsByFileRoot(rootHex: String): String
+
+    /**
+     * Loopback HTTP URL a player can open for one file of a torrent while it
+     * downloads (Range requests are served as pieces arrive), or "".
+     */
+    external fun getStreamUrl(infoHash: String, fileIndex: Int): String
+
+    /** Closes the stream server and every open stream. */
+    external fun stopStreamServer()
+
+    /**
+     * Reports the player's play head for a streamed file so the pieces just
+     * ahead of it are fetched first. [bitrateKbps] 0 derives the rate from
+     * [durationMs]. Returns the buffer health as JSON (`buffer_s`,
+     * `window_s`, `underruns`, …), or "" for an unknown torrent or file.
+     */
+    external fun updatePlayback(
+        infoHash: String,
+        fileIndex: Int,
+        positionMs: Long,
+        durationMs: Long,
+        bitrateKbps: Int,
+        playing: Boolean,
+        seek: Boolean
+    ): String
+
+    /**
+     * Time → byte → piece map of a track from its container header (MP3
+     * Xing/VBRI, FLAC SEEKTABLE, MP4 chunk tables) as JSON, `{"pending": true, …}`
+     * while the header pieces download, or "" if the format has none.
+     */
+    external fun getSeekIndex(infoHash: String, fileIndex: Int): String
+
+    /**
+     * The preamble a torrent's .torrent carried, as JSON `{format, duration_ms,
+     * length, state}` (state: pending, verified or rejected), or "" if none.
+     */
+    external fun getPreamble(infoHash: String): String
+
+    /**
+     * The player's upcoming swarm tracks in play order (shuffle applied).
+     * The first few get the opening seconds of their audio downloaded ahead
+     * of time, behind the current track. [startsInMs] is when each is due
+     * (-1 if unknown); an empty queue cancels all prefetching.
+     */
+    external fun setPrefetchQueue(
+        infoHashes: Array<String>,
+        fileIndices: IntArray,
+        startsInMs: LongArray
+    ): Boolean
+
+    /** Seconds per track, number of tracks and byte budget; negative keeps a value. */
+    external fun configurePrefetch(seconds: Int, tracks: Int, budgetBytes: Long)
+
+    /** Prefetch budget and per-entry progress as JSON. */
+    external fun getPrefetchStats(): String
+
+    /** RAM for streamed pieces read back from disk (default 32 MiB, 0 = off). */
+    external fun configureReadCache(capacityBytes: Long)
+
+    /** Read-cache size and hit rate as JSON. */
+    external fun getReadCacheStats(): String
+
+    /** RAM pinned for the most requested seeded pieces (default 16 MiB, 0 = off). */
+    external fun configureUploadCache(capacityBytes: Long)
+
+    /** Upload-cache hits, misses and hottest pieces as JSON. */
+    external fun getUploadCacheStats(): String
+
+    /** The player left the file; its piece deadlines are dropped. */
+    external fun stopPlayback(infoHash: String, fileIndex: Int): Boolean
+
+    /** {"v1": hex|null, "v2": hex|null} of raw `.torrent` bytes, or "". */
+    external fun getInfoHashesFromBytes(torrentBytes: ByteArray): String
+
+    /** Per-file size, verified bytes and priority of a (album) torrent as JSON, or "". */
+    external fun getTorrentFiles(infoHash: String): String
+
+    /** Priority per file index: 0 skips the file, 1 … 7; missing entries stay at 4. */
+    external fun setTorrentFilePriorities(infoHash: String, priorities: IntArray): Boolean
+
 }
@@ -4,6 +4,7 @@ import android.os.Bundle
 import com.ryanheise.audioservice.AudioServiceFragmentActivity
 import io.flutter.embedding.engine.FlutterEngine
 import io.flutter.plugin.common.MethodChannel
+import java.util.concurrent.Executors
 
 class MainActivity : AudioServiceFragmentActivity() {
 
@@ -13,15 +14,30 @@ class MainActivity : AudioServiceFragmentActivity() {
     /** JNI wrapper instance with Android context */
     private lateinit var libtorrentWrapper: LibtorrentWrapper
 
+    /** Used to push native events (creation-job progress) back to Dart */
+    private var channel: MethodChannel? = null
+
+    /**
+     * Prefetch and playback updates, off the UI thread and one at a time in
+     * the order Dart sent them, so a stale queue never lands after a newer one.
+     */
+    private val playbackExecutor = Executors.newSingleThreadExecutor()
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         libtorrentWrapper = LibtorrentWrapper(this)
     }
 
+    override fun onDestroy() {
+        playbackExecutor.shutdown()
+        super.onDestroy()
+    }
+
     override fun configureFlutterEngine(flutterEngine: FlutterEngine) {
         super.configureFlutterEngine(flutterEngine)
 
         MethodChannel(flutterEngine.dartExecutor.binaryMessenger, CHANNEL)
+            .also { channel = it }
             .setMethodCallHandler { call, result ->
                 when (call.method) {
 
@@ -64,6 +80,291 @@ class MainActivity : AudioServiceFragmentActivity() {
                             .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
                     }
 
+                    "removeTorrent", "removeTorrentByInfoHash" -> {
+                        val args       = call.arguments as? Map<*, *>
+                        val infoHash   = args?.get("infoHash") as? String
+                        val removeData = args?.get("removeData") as? Boolean ?: false
+
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching {
+                            libtorrentWrapper.removeTorrentByHash(infoHash, removeData)
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getTorrentSavePath" -> {
+                        val infoHash = when (val a = call.arguments) {
+                            is String      -> a
+                            is Map<*, *>   -> a["infoHash"] as? String
+                            else           -> null
+                        }
+
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching {
+                            libtorrentWrapper.getTorrentSavePathByHash(infoHash).ifEmpty { null }
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "lookupInfoHash" -> {
+                        val query = when (val a = call.arguments) {
+                            is String      -> a
+                            is Map<*, *>   -> a["query"] as? String
+                            else           -> null
+                        }
+
+                        if (query.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "query is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching {
+                            libtorrentWrapper.lookupInfoHash(query).ifEmpty { null }
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "setTorrentVersion" -> {
+                        val version = (call.arguments as? Map<*, *>)?.get("version") as? String
+                        if (version.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "version is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.setTorrentVersion(version) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "setPreambleSeconds" -> {
+                        val seconds = ((call.arguments as? Map<*, *>)?.get("seconds") as? Number)?.toInt()
+                        if (seconds == null) {
+                            result.error("INVALID_ARGUMENT", "seconds is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.setPreambleSeconds(seconds) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "findTorrentsByFileRoot" -> {
+                        val root = (call.arguments as? Map<*, *>)?.get("root") as? String
+                        if (root.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "root is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.findTorrentsByFileRoot(root).ifEmpty { null } }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getStreamUrl" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        val fileIndex = (args?.get("fileIndex") as? Number)?.toInt() ?: 0
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.getStreamUrl(infoHash, fileIndex).ifEmpty { null } }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "stopStreamServer" -> {
+                        runCatching { libtorrentWrapper.stopStreamServer() }
+                            .onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "updatePlayback" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+                        // reprioritises pieces under the session lock; in order with prefetch updates
+                        playbackExecutor.execute {
+                            val res = runCatching {
+                                libtorrentWrapper.updatePlayback(
+                                    infoHash,
+                                    (args?.get("fileIndex") as? Number)?.toInt() ?: 0,
+                                    (args?.get("positionMs") as? Number)?.toLong() ?: 0L,
+                                    (args?.get("durationMs") as? Number)?.toLong() ?: 0L,
+                                    (args?.get("bitrateKbps") as? Number)?.toInt() ?: 0,
+                                    args?.get("playing") as? Boolean ?: true,
+                                    args?.get("seek") as? Boolean ?: false
+                                ).ifEmpty { null }
+                            }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }
+                    }
+
+                    "getSeekIndex" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        val fileIndex = (args?.get("fileIndex") as? Number)?.toInt() ?: 0
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.getSeekIndex(infoHash, fileIndex).ifEmpty { null } }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getPreamble" -> {
+                        val infoHash = (call.arguments as? Map<*, *>)?.get("infoHash") as? String
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.getPreamble(infoHash).ifEmpty { null } }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "setPrefetchQueue" -> {
+                        val entries = (call.arguments as? Map<*, *>)?.get("queue") as? List<*>
+                        if (entries == null) {
+                            result.error("INVALID_ARGUMENT", "queue is required", null)
+                            return@setMethodCallHandler
+                        }
+                        val items = entries.mapNotNull { it as? Map<*, *> }
+                            .filter { (it["infoHash"] as? String).isNullOrEmpty().not() }
+                        // plans and prioritises pieces of every queued track
+                        playbackExecutor.execute {
+                            val res = runCatching {
+                                libtorrentWrapper.setPrefetchQueue(
+                                    items.map { it["infoHash"] as String }.toTypedArray(),
+                                    items.map { (it["fileIndex"] as? Number)?.toInt() ?: 0 }.toIntArray(),
+                                    items.map { (it["startsInMs"] as? Number)?.toLong() ?: -1L }.toLongArray()
+                                )
+                            }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }
+                    }
+
+                    "configurePrefetch" -> {
+                        val args = call.arguments as? Map<*, *>
+                        runCatching {
+                            libtorrentWrapper.configurePrefetch(
+                                (args?.get("seconds") as? Number)?.toInt() ?: -1,
+                                (args?.get("tracks") as? Number)?.toInt() ?: -1,
+                                (args?.get("budgetBytes") as? Number)?.toLong() ?: -1L
+                            )
+                        }.onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getPrefetchStats" -> {
+                        runCatching { libtorrentWrapper.getPrefetchStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "configureReadCache" -> {
+                        val bytes = ((call.arguments as? Map<*, *>)?.get("capacityBytes") as? Number)?.toLong()
+                        if (bytes == null || bytes < 0) {
+                            result.error("INVALID_ARGUMENT", "capacityBytes is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.configureReadCache(bytes) }
+                            .onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getReadCacheStats" -> {
+                        runCatching { libtorrentWrapper.getReadCacheStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "configureUploadCache" -> {
+                        val bytes = ((call.arguments as? Map<*, *>)?.get("capacityBytes") as? Number)?.toLong()
+                        if (bytes == null || bytes < 0) {
+                            result.error("INVALID_ARGUMENT", "capacityBytes is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.configureUploadCache(bytes) }
+                            .onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getUploadCacheStats" -> {
+                        runCatching { libtorrentWrapper.getUploadCacheStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "stopPlayback" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        val fileIndex = (args?.get("fileIndex") as? Number)?.toInt() ?: 0
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.stopPlayback(infoHash, fileIndex) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getInfoHashesFromBytes" -> {
+                        val bytes = (call.arguments as? Map<*, *>)?.get("torrentBytes") as? ByteArray
+                        if (bytes == null) {
+                            result.error("INVALID_ARGUMENT", "torrentBytes is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.getInfoHashesFromBytes(bytes).ifEmpty { null } }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getTorrentFiles" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        if (infoHash.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "infoHash is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching {
+                            libtorrentWrapper.getTorrentFiles(infoHash).ifEmpty { null }
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "setTorrentFilePriorities" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val infoHash = args?.get("infoHash") as? String
+                        val priorities = (args?.get("priorities") as? List<*>)
+                            ?.map { (it as? Number)?.toInt() ?: 4 }
+                        if (infoHash.isNullOrEmpty() || priorities == null) {
+                            result.error("INVALID_ARGUMENT", "infoHash and priorities are required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching {
+                            libtorrentWrapper.setTorrentFilePriorities(infoHash, priorities.toIntArray())
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
                     /*───────────────────────────────*
                      *  ADD TORRENT (FILE‑BASED)
                      *───────────────────────────────*/
@@ -112,9 +413,11 @@ class MainActivity : AudioServiceFragmentActivity() {
                             return@setMethodCallHandler
                         }
 
-                        runCatching { libtorrentWrapper.createTorrentBytes(sourcePath) }
-                            .onSuccess(result::success)
-                            .onFailure { e -> result.error("NATIVE_ERROR", e.localizedMessage, null) }
+                        val background = args?.get("background") as? Boolean ?: false
+                        val queued = libtorrentWrapper.createTorrentBytesAsync(sourcePath, background) { _, bytes, _ ->
+                            runOnUiThread { result.success(bytes as? ByteArray) }
+                        }
+                        if (!queued) result.error("BUSY", "native job queue is full", null)
                     }
                     "startTorrentByHash" -> {
                         val args = call.arguments as? Map<*, *>
@@ -182,6 +485,28 @@ class MainActivity : AudioServiceFragmentActivity() {
                             .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
                     }
 
+                    "addLibraryTorrent" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val torrentBytes = args?.get("torrentBytes") as? ByteArray
+                        val sourcePath   = args?.get("sourcePath")   as? String
+                        if (args == null || torrentBytes == null || sourcePath.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "torrentBytes or sourcePath missing", null)
+                            return@setMethodCallHandler
+                        }
+                        val announce = args["announce"] as? Boolean ?: false
+
+                        runCatching {
+                            libtorrentWrapper.addLibraryTorrent(torrentBytes, sourcePath, announce)
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getLibraryStats" -> {
+                        runCatching { libtorrentWrapper.getLibraryStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
                     /*───────────────────────────────*
                      *  INFORMATION QUERIES
                      *───────────────────────────────*/
@@ -197,6 +522,236 @@ class MainActivity : AudioServiceFragmentActivity() {
                             .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
                     }
 
+                    "getTorrentsPage" -> {
+                        val args       = call.arguments as? Map<*, *>
+                        val sortBy     = args?.get("sortBy") as? String
+                        val descending = args?.get("descending") as? Boolean ?: true
+                        val offset     = (args?.get("offset") as? Number)?.toInt() ?: 0
+                        val limit      = (args?.get("limit") as? Number)?.toInt() ?: 50
+
+                        runCatching { libtorrentWrapper.getTorrentsPage(sortBy, descending, offset, limit) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getTorrentUpdatesSince" -> {
+                        val seq = when (val a = call.arguments) {
+                            is Number    -> a.toLong()
+                            is Map<*, *> -> (a["seq"] as? Number)?.toLong()
+                            else         -> null
+                        } ?: 0L
+
+                        runCatching { libtorrentWrapper.getTorrentUpdatesSince(seq) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    /*───────────────────────────────*
+                     *  TORRENT‑CREATION JOBS
+                     *───────────────────────────────*/
+                    "startCreateJob" -> {
+                        val args       = call.arguments as? Map<*, *>
+                        val sourcePath = args?.get("sourcePath") as? String
+
+                        if (sourcePath.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "sourcePath is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        val outputPath = args?.get("outputPath") as? String
+                        val trackers   = (args?.get("trackers") as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
+                        val background = args?.get("background") as? Boolean ?: false
+
+                        runCatching {
+                            libtorrentWrapper.startCreateJob(sourcePath, outputPath, trackers, background) { id, state, done, total, error ->
+                                val event = mapOf(
+                                    "id" to id, "state" to state,
+                                    "piecesDone" to done, "numPieces" to total, "error" to error
+                                )
+                                runOnUiThread { channel?.invokeMethod("createJobEvent", event) }
+                            }
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "pollCreateJob", "cancelCreateJob", "takeCreateJobResult" -> {
+                        val args  = call.arguments as? Map<*, *>
+                        val jobId = (args?.get("jobId") as? Number)?.toLong()
+                        if (jobId == null) {
+                            result.error("INVALID_ARGUMENT", "jobId is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        runCatching<Any?> {
+                            when (call.method) {
+                                "pollCreateJob"   -> libtorrentWrapper.pollCreateJob(jobId)
+                                "cancelCreateJob" -> libtorrentWrapper.cancelCreateJob(jobId)
+                                else              -> libtorrentWrapper.takeCreateJobResult(jobId)
+                            }
+                        }.onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "setCreateJobConcurrency" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val n    = (args?.get("concurrency") as? Number)?.toInt()
+                        if (n == null) {
+                            result.error("INVALID_ARGUMENT", "concurrency is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.setCreateJobConcurrency(n) }
+                            .onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "createTorrentsBatch" -> {
+                        val args  = call.arguments as? Map<*, *>
+                        val paths = (args?.get("paths") as? List<*>)?.filterIsInstance<String>()
+
+                        if (paths == null) {
+                            result.error("INVALID_ARGUMENT", "paths is required", null)
+                            return@setMethodCallHandler
+                        }
+
+                        val trackers = (args?.get("trackers") as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
+                        val albums = args?.get("albums") as? Map<*, *>
+                        val albumTracks = albums?.let { a ->
+                            Array(paths.size) { i ->
+                                (a[paths[i]] as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
+                            }
+                        }
+                        val listener = object : TorrentBatchListener {
+                            override fun onResult(batchId: Long, index: Int, path: String, torrent: ByteArray?, error: String?) {
+                                val event = mapOf(
+                                    "batchId" to batchId, "index" to index, "path" to path,
+                                    "torrent" to torrent, "error" to error
+                                )
+                                runOnUiThread { channel?.invokeMethod("batchResult", event) }
+                            }
+
+                            override fun onDone(batchId: Long, succeeded: Int, failed: Int, cancelled: Boolean, elapsedMs: Long) {
+                                val event = mapOf(
+                                    "batchId" to batchId, "succeeded" to succeeded, "failed" to failed,
+                                    "cancelled" to cancelled, "elapsedMs" to elapsedMs
+                                )
+                                runOnUiThread { channel?.invokeMethod("batchDone", event) }
+                            }
+                        }
+
+                        runCatching { libtorrentWrapper.createTorrentsBatch(paths.toTypedArray(), trackers, albumTracks, listener) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "cancelTorrentsBatch" -> {
+                        val args    = call.arguments as? Map<*, *>
+                        val batchId = (args?.get("batchId") as? Number)?.toLong()
+                        if (batchId == null) {
+                            result.error("INVALID_ARGUMENT", "batchId is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching { libtorrentWrapper.cancelTorrentsBatch(batchId) }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getTorrentCacheStats" -> {
+                        runCatching { libtorrentWrapper.getTorrentCacheStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "clearTorrentCache" -> {
+                        runCatching { libtorrentWrapper.clearTorrentCache() }
+                            .onSuccess { result.success(null) }
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "getExecutorStats" -> {
+                        runCatching { libtorrentWrapper.getExecutorStats() }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "benchmarkJsonWriter" -> {
+                        // a few hundred ms of work – keep it off the UI thread
+                        Thread {
+                            val res = runCatching { libtorrentWrapper.benchmarkJsonWriter() }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }.start()
+                    }
+
+                    "getAudioIdentity" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val path = args?.get("path") as? String
+                        if (path.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "path is required", null)
+                            return@setMethodCallHandler
+                        }
+                        // reads the whole file – keep it off the UI thread
+                        Thread {
+                            val res = runCatching { libtorrentWrapper.getAudioIdentity(path).ifEmpty { null } }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }.start()
+                    }
+
+                    "benchmarkPieceHashing" -> {
+                        // ~1 s of hashing – keep it off the UI thread
+                        Thread {
+                            val res = runCatching { libtorrentWrapper.benchmarkPieceHashing() }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }.start()
+                    }
+
+                    "configureDiskBackend" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val backend = args?.get("backend") as? String
+                        if (backend.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "backend is required", null)
+                            return@setMethodCallHandler
+                        }
+                        runCatching {
+                            libtorrentWrapper.configureDiskBackend(
+                                backend,
+                                args?.get("ioUring") as? Boolean ?: true,
+                                (args?.get("aioThreads") as? Number)?.toInt() ?: 0,
+                                (args?.get("filePoolSize") as? Number)?.toInt() ?: 0,
+                                (args?.get("uploadCacheBytes") as? Number)?.toLong() ?: -1L,
+                                (args?.get("readCacheBytes") as? Number)?.toLong() ?: -1L
+                            )
+                        }
+                            .onSuccess(result::success)
+                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                    }
+
+                    "benchmarkDiskBackends" -> {
+                        val args = call.arguments as? Map<*, *>
+                        val dir = args?.get("dir") as? String
+                        if (dir.isNullOrEmpty()) {
+                            result.error("INVALID_ARGUMENT", "dir is required", null)
+                            return@setMethodCallHandler
+                        }
+                        val files = (args?.get("files") as? Number)?.toInt() ?: 0
+                        val fileSize = (args?.get("fileSizeBytes") as? Number)?.toLong() ?: 0L
+                        // seconds to minutes of disk I/O – keep it off the UI thread
+                        Thread {
+                            val res = runCatching { libtorrentWrapper.benchmarkDiskBackends(dir, files, fileSize) }
+                            runOnUiThread {
+                                res.onSuccess(result::success)
+                                   .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                            }
+                        }.start()
+                    }
+
                     /*───────────────────────────────*
                      *  (OPTIONAL) CREATE TORRENT FILE
                      *───────────────────────────────*/
@@ -208,17 +763,18 @@ class MainActivity : AudioServiceFragmentActivity() {
                         }
 
                         val filePath   = args["filePath"]   as? String
-                        val outputPath = args["outputPath"] as? String
+                        val outputPath = args?.get("outputPath") as? String
                         if (filePath.isNullOrEmpty() || outputPath.isNullOrEmpty()) {
                             result.error("INVALID_ARGUMENT", "filePath or outputPath missing", null)
                             return@setMethodCallHandler
                         }
 
-                        val trackers   = (args["trackers"] as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
+                        val trackers   = (args?.get("trackers") as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
 
-                        runCatching { libtorrentWrapper.createTorrent(filePath, outputPath, trackers) }
-                            .onSuccess(result::success)
-                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                        val queued = libtorrentWrapper.createTorrentAsync(filePath, outputPath, trackers) { ok, _, _ ->
+                            runOnUiThread { result.success(ok) }
+                        }
+                        if (!queued) result.error("BUSY", "native job queue is full", null)
                     }
 
                     "createTorrentInAppDir" -> {
@@ -234,11 +790,12 @@ class MainActivity : AudioServiceFragmentActivity() {
                             return@setMethodCallHandler
                         }
 
-                        val trackers = (args["trackers"] as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
+                        val trackers = (args?.get("trackers") as? List<*>)?.filterIsInstance<String>()?.toTypedArray()
 
-                        runCatching { libtorrentWrapper.createTorrentInAppDir(filePath, trackers) }
-                            .onSuccess(result::success)
-                            .onFailure { e -> result.error("ERROR", e.localizedMessage, null) }
+                        val queued = libtorrentWrapper.createTorrentInAppDirAsync(filePath, trackers) { ok, _, _ ->
+                            runOnUiThread { result.success(ok) }
+                        }
+                        if (!queued) result.error("BUSY", "native job queue is full", null)
                     }
 
                     "isTorrentActive" -> {
@@ -15,21 +15,32 @@ import '../utils/CryptoHelper.dart';
 import '../src/data/services/LibtorrentService.dart';
 
 class MusicSeederService {
-  MusicSeederService._(this.audioQuery);
-
-  static Future<MusicSeederService> create([OnAudioQuery? aq]) async {
-    final service = MusicSeederService._(aq ?? OnAudioQuery());
+  MusicSeederService._(this.audioQuery, this.preambleSeconds);
+
+  /// [preambleSeconds] of each track's opening audio go into its .torrent,
+  /// so a peer adding it from the catalog hears it before the swarm
+  /// connects. Opt-in: 0 (the default) leaves them out, which keeps the
+  /// stored torrents small and the torrent cache valid.
+  static Future<MusicSeederService> create([
+    OnAudioQuery? aq,
+    int preambleSeconds = defaultPreambleSeconds,
+  ]) async {
+    final service = MusicSeederService._(aq ?? OnAudioQuery(), preambleSeconds);
     await service._init();
     return service;
   }
 
+  static const defaultPreambleSeconds = 0;
+
   final OnAudioQuery audioQuery;
+  final int preambleSeconds;
   final LibtorrentService _libtorrent = LibtorrentService();
 
   Directory? torrentsDir;
   final Set<String> knownTorrentNames = {};
   final Map<String, String> _nameToPathMap = {};
   final Map<String, Map<String, dynamic>> _metaCache = {};
+  final Map<String, String> _identityCache = {};
 
   Map<String, String> get nameToPathMap => _nameToPathMap;
 
@@ -44,6 +55,7 @@ class MusicSeederService {
     } else {
       debugPrint('[Seeder] Using existing torrents directory: ${torrentsDir!.path}');
     }
+    await _libtorrent.setPreambleSeconds(preambleSeconds);
   }
 
   static String norm(String name) {
@@ -51,8 +63,13 @@ class MusicSeederService {
     return base.toLowerCase().replaceAll(RegExp(r'[^\w]+'), '_');
   }
 
+  /// Seeds every valid song in the library. With [groupByAlbum], folders
+  /// holding at least [minAlbumTracks] songs are seeded as one multi-file
+  /// torrent each instead of one torrent per track, which cuts the number
+  /// of torrents (and their announces and memory) by about the album size.
   Future<List<String>> seedMissingSongs({
-    Duration gap = const Duration(milliseconds: 120),
+    bool groupByAlbum = false,
+    int minAlbumTracks = 3,
   }) async {
     if (!(await audioQuery.permissionsStatus())) {
       if (!await audioQuery.permissionsRequest()) return [];
@@ -78,11 +95,33 @@ class MusicSeederService {
       }
     }
 
-    final createdTorrents = await _seedFiles(valid, gap);
-    return createdTorrents;
+    if (!groupByAlbum) return _seedFiles(valid);
+
+    final byDir = <String, List<String>>{};
+    for (final path in valid) {
+      byDir.putIfAbsent(p.dirname(path), () => []).add(path);
+    }
+    final sources = <String>[];
+    final albums = <String, List<String>>{};
+    byDir.forEach((dir, tracks) {
+      if (tracks.length >= minAlbumTracks) {
+        final source = LibtorrentService.albumSource(dir);
+        sources.add(source);
+        albums[source] = tracks;
+      } else {
+        sources.addAll(tracks);
+      }
+    });
+    return _seedFiles(sources, albums: albums);
   }
 
-  Future<List<String>> _seedFiles(List<String> paths, Duration gap) async {
+  /// Hashes all [paths] in one native batch (parallel, bounded memory) and
+  /// registers each torrent as its result arrives. [albums] maps album
+  /// sources among [paths] to the songs they stand for.
+  Future<List<String>> _seedFiles(
+    List<String> paths, {
+    Map<String, List<String>> albums = const {},
+  }) async {
     if (torrentsDir == null) {
       debugPrint('[Seeder] torrentsDir not initialized.');
       return [];
@@ -93,27 +132,34 @@ class MusicSeederService {
           .map((m) => norm(m['name']?.toString() ?? ''))
     };
 
-    final createdTorrents = <String>[];
-
+    final existing = <String>[];
     for (final songPath in paths) {
-      final file = File(songPath);
-      if (!await file.exists()) continue;
+      final exists = LibtorrentService.isAlbumSource(songPath)
+          ? await Directory(songPath).exists()
+          : await File(songPath).exists();
+      if (exists) existing.add(songPath);
+    }
 
-      final key = norm(songPath);
-      final encPath = p.join(torrentsDir!.path, '$key.audyn.torrent');
+    final createdTorrents = <String>[];
 
-      Uint8List? torrentBytesPlain;
-      try {
-        torrentBytesPlain = await createTorrentBytesFromPath(file.path);
-        if (torrentBytesPlain == null || torrentBytesPlain.isEmpty) {
-          debugPrint('[Seeder] ❌ Failed to create torrent for $songPath');
-          continue;
-        }
-      } catch (e) {
-        debugPrint('[Seeder] ❌ createTorrentBytes failed: $e');
+    // an album is hashed from exactly its validated songs, not whatever
+    // else sits in its folder
+    await for (final res in _libtorrent.createTorrentsBatch(existing, albums: albums)) {
+      final songPath = res['path'] as String;
+      final torrentBytesPlain = res['torrent'] as Uint8List?;
+      if (torrentBytesPlain == null || torrentBytesPlain.isEmpty) {
+        debugPrint('[Seeder] ❌ Failed to create torrent for $songPath: ${res['error']}');
         continue;
       }
 
+      final tracks = albums[songPath];
+      // an album's torrent is named after its folder and seeded from it
+      final sourcePath = tracks == null
+          ? songPath
+          : songPath.substring(0, songPath.length - 1);
+      final key = norm(sourcePath);
+      final encPath = p.join(torrentsDir!.path, '$key.audyn.torrent');
+
       try {
         final encBytes = CryptoHelper.encryptBytes(torrentBytesPlain);
         await File(encPath).writeAsBytes(encBytes, flush: true);
@@ -124,28 +170,45 @@ class MusicSeederService {
       }
 
       if (!active.contains(key)) {
-        final ok = await _libtorrent.addTorrentFromBytes(
+        final ok = await _libtorrent.addLibraryTorrent(
           torrentBytesPlain,
-          p.dirname(songPath),
-          seedMode: true,
+          sourcePath,
           announce: false,
         );
         if (!ok) {
-          debugPrint('[Seeder] ⚠️ addTorrentFromBytes failed for $songPath');
+          debugPrint('[Seeder] ⚠️ addLibraryTorrent failed for $songPath');
           continue;
         }
       }
 
       if (knownTorrentNames.add(key)) {
-        _nameToPathMap[key] = songPath;
+        _nameToPathMap[key] = sourcePath;
       }
-
-      await Future.delayed(gap);
+      if (tracks != null) await _adoptAlbumTracks(tracks, active);
     }
 
     return createdTorrents;
   }
 
+  /// Tracks now seeded by an album torrent: keeps their metadata lookups
+  /// working and retires the single-track torrents they had before.
+  Future<void> _adoptAlbumTracks(List<String> tracks, Set<String> active) async {
+    for (final track in tracks) {
+      final key = norm(track);
+      _nameToPathMap[key] = track;
+      if (!knownTorrentNames.remove(key) && !active.contains(key)) continue;
+
+      final hash = await _libtorrent.lookupInfoHash(p.basename(track));
+      if (hash != null) await _libtorrent.removeTorrent(hash);
+      try {
+        final old = File(p.join(torrentsDir!.path, '$key.audyn.torrent'));
+        if (await old.exists()) await old.delete();
+      } catch (e) {
+        debugPrint('[Seeder] ⚠️ Could not delete old torrent for $track: $e');
+      }
+    }
+  }
+
   Future<Map<String, dynamic>?> getMetadataForName(String anyName) async {
     final key = norm(anyName);
     if (_metaCache.containsKey(key)) return _metaCache[key];
@@ -172,6 +235,21 @@ class MusicSeederService {
     }
   }
 
+  /// Tag-independent audio id of a seeded song, for grouping torrents of
+  /// the same recording in the catalog.
+  Future<String?> getAudioIdentity(String anyName) async {
+    final key = norm(anyName);
+    final cached = _identityCache[key];
+    if (cached != null) return cached;
+
+    final path = _nameToPathMap[key];
+    if (path == null || !await File(path).exists()) return null;
+
+    final id = (await _libtorrent.getAudioIdentity(path))?['identity'] as String?;
+    if (id != null) _identityCache[key] = id;
+    return id;
+  }
+
   String? getEncryptedTorrentPath(String anyName) {
     final key = norm(anyName);
     if (!knownTorrentNames.contains(key) || torrentsDir == null) return null;
@@ -195,8 +273,8 @@ class MusicSeederService {
   }
 
   /// Create torrent bytes from a given song path using libtorrent
-  Future<Uint8List?> createTorrentBytesFromPath(String filePath) async {
-    return await _libtorrent.createTorrentBytes(filePath);
+  Future<Uint8List?> createTorrentBytesFromPath(String filePath, {bool background = false}) async {
+    return await _libtorrent.createTorrentBytes(filePath, background: background);
   }
 
   /// Seeds a single song, returns the encrypted .torrent path
@@ -218,10 +296,9 @@ class MusicSeederService {
         .any((m) => norm(m['name']?.toString() ?? '') == key);
 
     if (!alreadySeeding) {
-      final ok = await _libtorrent.addTorrentFromBytes(
+      final ok = await _libtorrent.addLibraryTorrent(
         torrentBytes,
-        p.dirname(songFilePath),
-        seedMode: true,
+        songFilePath,
         announce: false,
       );
       if (!ok) {
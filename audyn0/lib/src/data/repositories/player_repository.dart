@@ -1,3 +1,4 @@
+import 'dart:async';
 import 'dart:io';
 
 import 'package:hive/hive.dart';
@@ -5,6 +6,7 @@ import 'package:just_audio/just_audio.dart';
 import 'package:just_audio_background/just_audio_background.dart';
 import 'package:audyn/src/data/repositories/song_repository.dart';
 import 'package:audyn/src/data/services/hive_box.dart';
+import 'package:audyn/src/data/services/LibtorrentService.dart';
 import 'package:on_audio_query/on_audio_query.dart';
 
 abstract class MusicPlayer {
@@ -14,6 +16,12 @@ abstract class MusicPlayer {
     List<SongModel> playlist,
   );
   MediaItem getMediaItemFromSong(SongModel song);
+  Future<void> playStream(
+    Uri uri,
+    MediaItem mediaItem, {
+    String? infoHash,
+    int fileIndex = 0,
+  });
   Future<void> savePlaylist();
   Future<List<SongModel>> loadPlaylist();
   Future<void> setSequenceFromPlaylist(
@@ -47,6 +55,16 @@ class JustAudioPlayer implements MusicPlayer {
   List<SongModel> currentPlaylist = [];
   late ConcatenatingAudioSource _queue;
 
+  // swarm track being streamed, whose play head is reported to the native
+  // piece scheduler
+  final LibtorrentService _libtorrent = LibtorrentService();
+  String? _streamHash;
+  int _streamFile = 0;
+  StreamSubscription<Duration>? _playheadSub;
+  DateTime _lastPlayheadReport = DateTime.fromMillisecondsSinceEpoch(0);
+  // upcoming swarm tracks last handed to the native prefetcher
+  String _prefetchKey = '';
+
   var box = Hive.box(HiveBox.boxName);
 
   @override
@@ -66,6 +84,10 @@ class JustAudioPlayer implements MusicPlayer {
       }
     });
 
+    // keep the play-head reports and the swarm prefetch in step with the
+    // queue, track changes and shuffle
+    _player.sequenceStateStream.listen(_onSequenceState);
+
     // set loop mode
     if (box.get(HiveBox.loopModeKey) != null) {
       _player.setLoopMode(LoopMode.values[box.get(HiveBox.loopModeKey)]);
@@ -85,6 +107,7 @@ class JustAudioPlayer implements MusicPlayer {
     List<SongModel> playlist, {
     bool play = true,
   }) async {
+    await _stopPlayheadReports();
     List<AudioSource> sources = [];
 
     for (var song in playlist) {
@@ -139,6 +162,119 @@ class JustAudioPlayer implements MusicPlayer {
     }
   }
 
+  /// Plays a track that is not in the library yet, e.g. the loopback URL
+  /// from [LibtorrentService.getStreamUrl] while the torrent downloads.
+  /// Replaces the queue; the saved playlist is left alone. With [infoHash]
+  /// the play head is reported to the native scheduler, which then fetches
+  /// pieces in play order just ahead of it.
+  @override
+  Future<void> playStream(
+    Uri uri,
+    MediaItem mediaItem, {
+    String? infoHash,
+    int fileIndex = 0,
+  }) async {
+    await _stopPlayheadReports();
+    currentPlaylist = [];
+    _queue = ConcatenatingAudioSource(
+      children: [AudioSource.uri(uri, tag: mediaItem)],
+    );
+    await _player.setAudioSource(_queue);
+    if (infoHash != null) await _followStream(infoHash, fileIndex);
+    await _player.play();
+  }
+
+  /// Starts reporting the play head of a streamed track, replacing the
+  /// one reported so far.
+  Future<void> _followStream(String infoHash, int fileIndex) async {
+    if (_streamHash == infoHash && _streamFile == fileIndex) return;
+    await _stopPlayheadReports();
+    _streamHash = infoHash;
+    _streamFile = fileIndex;
+    _playheadSub = _player.positionStream.listen((_) {
+      if (DateTime.now().difference(_lastPlayheadReport) >=
+          const Duration(seconds: 1)) {
+        _reportPlayhead();
+      }
+    });
+    await _reportPlayhead();
+  }
+
+  /// `(infoHash, fileIndex)` of a loopback stream URL from
+  /// [LibtorrentService.getStreamUrl], or null for any other source.
+  static (String, int)? _streamOf(IndexedAudioSource? source) {
+    if (source is! UriAudioSource) return null;
+    final uri = source.uri;
+    final segments = uri.pathSegments;
+    if (uri.host != '127.0.0.1' ||
+        segments.length < 3 ||
+        segments[0] != 'stream') {
+      return null;
+    }
+    return (segments[1], int.tryParse(segments[2]) ?? 0);
+  }
+
+  /// Follows the current track if it streams from the swarm, and hands the
+  /// swarm tracks queued after it (in play order, shuffle applied) to the
+  /// native prefetcher, so their opening seconds are there before they
+  /// start. Only sent when that list changes.
+  void _onSequenceState(SequenceState? state) {
+    final current = state?.currentSource;
+    final stream = _streamOf(current);
+    if (stream != null) {
+      _followStream(stream.$1, stream.$2);
+    } else if (currentPlaylist.isNotEmpty) {
+      _stopPlayheadReports();
+    }
+
+    final order = state?.effectiveSequence ?? const <IndexedAudioSource>[];
+    final at = current == null ? -1 : order.indexOf(current);
+    final currentDuration = (current?.tag as MediaItem?)?.duration;
+    Duration? startsIn =
+        currentDuration == null ? null : currentDuration - _player.position;
+    final queue = <Map<String, dynamic>>[];
+    for (final source in order.skip(at + 1)) {
+      final upcoming = _streamOf(source);
+      if (upcoming != null) {
+        queue.add({
+          'infoHash': upcoming.$1,
+          'fileIndex': upcoming.$2,
+          if (startsIn != null) 'startsInMs': startsIn.inMilliseconds,
+        });
+      }
+      final d = (source.tag as MediaItem?)?.duration;
+      startsIn = (startsIn == null || d == null) ? null : startsIn + d;
+    }
+
+    final key = queue.map((e) => '${e['infoHash']}/${e['fileIndex']}').join(',');
+    if (key == _prefetchKey) return;
+    _prefetchKey = key;
+    _libtorrent.setPrefetchQueue(queue);
+  }
+
+  Future<void> _reportPlayhead({bool seek = false}) async {
+    final hash = _streamHash;
+    if (hash == null) return;
+    _lastPlayheadReport = DateTime.now();
+    await _libtorrent.updatePlayback(
+      hash,
+      fileIndex: _streamFile,
+      position: _player.position,
+      duration: _player.duration,
+      playing: _player.playing,
+      seek: seek,
+    );
+  }
+
+  Future<void> _stopPlayheadReports() async {
+    final hash = _streamHash;
+    if (hash == null) return;
+    _streamHash = null;
+    await _playheadSub?.cancel();
+    _playheadSub = null;
+    await _libtorrent.stopPlayback(hash, fileIndex: _streamFile);
+  }
+
   /// save current playlist to hive
   @override
   Future savePlaylist() async {
@@ -188,7 +324,10 @@ class JustAudioPlayer implements MusicPlayer {
   Future<void> pause() => _player.pause();
 
   @override
-  Future<void> stop() => _player.stop();
+  Future<void> stop() async {
+    await _stopPlayheadReports();
+    await _player.stop();
+  }
 
   @override
   Future<void> seek(Duration position, {int? index}) async {
@@ -200,6 +339,7 @@ class JustAudioPlayer implements MusicPlayer {
     } else {
       await _player.seek(position);
     }
+    await _reportPlayhead(seek: true);
   }
 
   @override
@@ -221,7 +361,10 @@ class JustAudioPlayer implements MusicPlayer {
   Stream<LoopMode> get loopMode => _player.loopModeStream;
 
   @override
-  Future<void> dispose() async => await _player.dispose();
+  Future<void> dispose() async {
+    await _stopPlayheadReports();
+    await _player.dispose();
+  }
 
   @override
   Stream<bool> get playing => _player.playingStream;
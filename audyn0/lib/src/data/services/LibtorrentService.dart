@@ -1,3 +1,4 @@
+import 'dart:async';
 import 'dart:convert';
 import 'dart:typed_data';
 import 'dart:io';
@@ -7,6 +8,8 @@ import 'package:crypto/crypto.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:path/path.dart' as p;
 
+import '../../native/audyn_ffi.dart';
+
 /// A thin, Flutter‑side wrapper around the native libtorrent bridge.
 /// All heavy work happens in the platform (Android / iOS / desktop) code.
 ///
@@ -41,6 +44,181 @@ class LibtorrentService {
     }
   }
 
+  /// Delta against the native status table. Returns
+  /// `{seq, full, updated: [...], removed: [infoHash, ...]}`; feed `seq`
+  /// back into the next call. When `full` is 1 the caller should replace
+  /// its copy with `updated`.
+  Future<Map<String, dynamic>> getTorrentUpdatesSince(int seq) async {
+    try {
+      final raw = await _channel.invokeMethod<String>(
+        'getTorrentUpdatesSince',
+        {'seq': seq},
+      );
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getTorrentUpdatesSince failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// One page of torrents from the native status snapshot, e.g. the top 20
+  /// by upload rate. [sortBy] is one of `name`, `progress`, `upload_rate`,
+  /// `download_rate`, `num_peers`, `state`. Returns
+  /// `{version, total, torrents: [...]}`.
+  Future<Map<String, dynamic>> getTorrentsPage({
+    String? sortBy,
+    bool descending = true,
+    int offset = 0,
+    int limit = 50,
+  }) async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getTorrentsPage', {
+        'sortBy': sortBy,
+        'descending': descending,
+        'offset': offset,
+        'limit': limit,
+      });
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getTorrentsPage failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// Native job executor: worker count plus queue depth, completions,
+  /// rejections and wait times for the interactive and background lanes.
+  Future<Map<String, dynamic>> getExecutorStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getExecutorStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getExecutorStats failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// Persistent torrent cache: entries, hits, misses, live/dead bytes.
+  Future<Map<String, dynamic>> getTorrentCacheStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getTorrentCacheStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getTorrentCacheStats failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// Drops every cached torrent; the next seed pass re-hashes everything.
+  Future<void> clearTorrentCache() async {
+    try {
+      await _channel.invokeMethod('clearTorrentCache');
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] clearTorrentCache failed: $e\n$st');
+    }
+  }
+
+  /// Content id of an audio file that ignores its tags (ID3, APE, FLAC
+  /// metadata, MP4 boxes other than `mdat`): copies of one recording tagged
+  /// differently share it. `{identity, format, file_bytes, payload_bytes}`.
+  Future<Map<String, dynamic>?> getAudioIdentity(String path) async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getAudioIdentity', {'path': path});
+      if (raw == null || raw.isEmpty) return null;
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : null;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getAudioIdentity failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Single-core MB/s of every native SHA-1 / SHA-256 variant this device
+  /// supports (armv8 / sha-ni / multibuffer / scalar) and which one
+  /// torrent creation uses.
+  Future<Map<String, dynamic>> benchmarkPieceHashing() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('benchmarkPieceHashing');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] benchmarkPieceHashing failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// Picks the disk backend of the next native session: `custom` (library
+  /// seeds read in place, upload cache, io_uring where it works), `posix`
+  /// or `mmap`. Thread and file-pool counts of 0 keep libtorrent's
+  /// defaults; they and the cache sizes apply at once, null keeps a cache
+  /// size. Returns false, changing nothing, while a session runs on another
+  /// backend or `ioUring` setting – clean it up first to switch.
+  Future<bool> configureDiskBackend(
+    String backend, {
+    bool ioUring = true,
+    int aioThreads = 0,
+    int filePoolSize = 0,
+    int? uploadCacheBytes,
+    int? readCacheBytes,
+  }) async {
+    try {
+      final ok = await _channel.invokeMethod<bool>('configureDiskBackend', {
+        'backend': backend,
+        'ioUring': ioUring,
+        'aioThreads': aioThreads,
+        'filePoolSize': filePoolSize,
+        'uploadCacheBytes': uploadCacheBytes ?? -1,
+        'readCacheBytes': readCacheBytes ?? -1,
+      });
+      return ok ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] configureDiskBackend failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// Synthetic seed and download workload in [dir] through every disk
+  /// backend: `{files, file_size, reads, depth, download_files, backends:
+  /// [{name, available, seed: {mb_s, iops, p50_us, p99_us, errors},
+  /// download: {…}}]}`. 0 files / size run 10000 files of 64 KiB.
+  Future<Map<String, dynamic>> benchmarkDiskBackends(String dir,
+      {int files = 0, int fileSizeBytes = 0}) async {
+    try {
+      final raw = await _channel.invokeMethod<String>('benchmarkDiskBackends', {
+        'dir': dir,
+        'files': files,
+        'fileSizeBytes': fileSizeBytes,
+      });
+      if (raw == null || raw.isEmpty) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] benchmarkDiskBackends failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// Native JSON-writer micro-benchmark (100 / 1k / 10k synthetic torrents).
+  Future<List<dynamic>> benchmarkJsonWriter() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('benchmarkJsonWriter');
+      if (raw == null) return [];
+      final parsed = jsonDecode(raw);
+      return parsed is List ? parsed : [];
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] benchmarkJsonWriter failed: $e\n$st');
+      return [];
+    }
+  }
+
   /*─────────────────────────────────────────*
    *  ADD / REMOVE TORRENTS  (file‑based)    *
    *─────────────────────────────────────────*/
@@ -127,16 +305,95 @@ class LibtorrentService {
     }
   }
 
+  /// Info-hash of the torrent seeded from [nameOrPath] (a full source path
+  /// or anything [MusicSeederService.norm] maps to the same key).
+  Future<String?> lookupInfoHash(String nameOrPath) async {
+    try {
+      return await _channel.invokeMethod<String>(
+        'lookupInfoHash',
+        {'query': nameOrPath},
+      );
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] lookupInfoHash failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Creation source for an album: the audio files directly inside [dir],
+  /// as one multi-file torrent (one torrent, one announce, per album).
+  static String albumSource(String dir) => dir.endsWith('/') ? dir : '$dir/';
+
+  static bool isAlbumSource(String path) => path.length > 1 && path.endsWith('/');
+
+  /// Files of a torrent – an album's tracks – as
+  /// `{info_hash, name, piece_length, files: [{index, path, size, done, priority, root}]}`;
+  /// `root` (the file's v2 merkle root) is missing for v1-only torrents.
+  Future<Map<String, dynamic>?> getTorrentFiles(String infoHash) async {
+    try {
+      final json = await _channel.invokeMethod<String>(
+        'getTorrentFiles',
+        {'infoHash': infoHash},
+      );
+      if (json == null || json.isEmpty) return null;
+      return Map<String, dynamic>.from(jsonDecode(json) as Map);
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getTorrentFiles failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Priority per file index: 0 skips the file, 1 … 7; files past the end
+  /// of [priorities] keep the default 4.
+  Future<bool> setTorrentFilePriorities(String infoHash, List<int> priorities) async {
+    try {
+      final ok = await _channel.invokeMethod<bool>('setTorrentFilePriorities', {
+        'infoHash': infoHash,
+        'priorities': priorities,
+      });
+      return ok ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] setTorrentFilePriorities failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// Downloads only the track at [fileIndex] of an album torrent.
+  Future<bool> downloadAlbumTrack(String infoHash, int fileIndex) async {
+    final files = await getTorrentFiles(infoHash);
+    if (files == null) return false;
+    final count = (files['files'] as List)
+        .map((f) => (f as Map)['index'] as int)
+        .fold<int>(0, (n, i) => i >= n ? i + 1 : n);
+    if (fileIndex < 0 || fileIndex >= count) return false;
+    final priorities = List<int>.filled(count, 0);
+    priorities[fileIndex] = 4;
+    return setTorrentFilePriorities(infoHash, priorities);
+  }
+
+  Future<String?> getTorrentSavePath(String infoHash) async {
+    try {
+      return await _channel.invokeMethod<String>(
+        'getTorrentSavePath',
+        {'infoHash': infoHash},
+      );
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getTorrentSavePath failed: $e\n$st');
+      return null;
+    }
+  }
+
   /*─────────────────────────────────────────*
    *  (OPTIONAL)  BYTE‑BASED ADD / EXPORT    *
    *─────────────────────────────────────────*/
 
-  Future<Uint8List?> createTorrentBytes(String sourcePath) async {
+  /// Hashes [sourcePath] on a native worker. [background] queues it behind
+  /// interactive work, for bulk seeding.
+  Future<Uint8List?> createTorrentBytes(String sourcePath, {bool background = false}) async {
     try {
       print('[DEBUG] Calling native createTorrentBytes($sourcePath)');
       final result = await _channel.invokeMethod<Uint8List>(
         'createTorrentBytes',
-        {'sourcePath': sourcePath},
+        {'sourcePath': sourcePath, 'background': background},
       );
       print('[DEBUG] Got result: ${result?.length ?? "null"} bytes');
       return result;
@@ -146,6 +403,162 @@ class LibtorrentService {
     }
   }
 
+  /*─────────────────────────────────────────*
+   *  TORRENT‑CREATION JOBS                  *
+   *─────────────────────────────────────────*/
+
+  static final StreamController<MethodCall> _nativeEvents =
+      StreamController<MethodCall>.broadcast();
+  static bool _eventsHooked = false;
+
+  /// Calls the platform side pushes to us (job progress, batch results).
+  static Stream<MethodCall> get _events {
+    if (!_eventsHooked) {
+      _eventsHooked = true;
+      _channel.setMethodCallHandler((call) async {
+        if (call.arguments is Map) _nativeEvents.add(call);
+        return null;
+      });
+    }
+    return _nativeEvents.stream;
+  }
+
+  /// Progress of creation jobs: `{id, state, piecesDone, numPieces, error}`,
+  /// at most every 250 ms per job plus once per state change. `state` is
+  /// 0 queued, 1 hashing, 2 done, 3 failed, 4 cancelled.
+  Stream<Map<String, dynamic>> get createJobEvents => _events
+      .where((c) => c.method == 'createJobEvent')
+      .map((c) => Map<String, dynamic>.from(c.arguments as Map));
+
+  /// Starts hashing [sourcePath] and returns the job id (or null). Without
+  /// [outputPath] the torrent is kept natively for [takeCreateJobResult].
+  Future<int?> startCreateJob(
+      String sourcePath, {
+        String? outputPath,
+        List<String>? trackers,
+        bool background = false,
+      }) async {
+    _events; // make sure progress events have a handler installed
+    try {
+      return await _channel.invokeMethod<int>('startCreateJob', {
+        'sourcePath': sourcePath,
+        'outputPath': outputPath,
+        'trackers': trackers,
+        'background': background,
+      });
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] startCreateJob failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Snapshot of a job, or an empty map once it is unknown (taken/evicted).
+  Future<Map<String, dynamic>> pollCreateJob(int jobId) async {
+    try {
+      final raw = await _channel.invokeMethod<String>('pollCreateJob', {'jobId': jobId});
+      if (raw == null || raw.isEmpty) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] pollCreateJob failed: $e\n$st');
+      return {};
+    }
+  }
+
+  Future<bool> cancelCreateJob(int jobId) async {
+    try {
+      return await _channel.invokeMethod<bool>('cancelCreateJob', {'jobId': jobId}) ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] cancelCreateJob failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// `.torrent` bytes of a finished in-memory job; the job is released.
+  Future<Uint8List?> takeCreateJobResult(int jobId) async {
+    try {
+      return await _channel.invokeMethod<Uint8List>('takeCreateJobResult', {'jobId': jobId});
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] takeCreateJobResult failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// How many creation jobs may hash at the same time (1 … 16, default 2).
+  Future<void> setCreateJobConcurrency(int concurrency) async {
+    try {
+      await _channel.invokeMethod('setCreateJobConcurrency', {'concurrency': concurrency});
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] setCreateJobConcurrency failed: $e\n$st');
+    }
+  }
+
+  /// Creates one torrent per path, hashed in parallel natively. Emits
+  /// `{index, path, torrent: Uint8List?, error: String?}` per file as each
+  /// one finishes (not in input order) and closes after the last file.
+  /// Cancelling the subscription cancels the rest of the batch. Paths made
+  /// with [albumSource] become one multi-file torrent per album: of the
+  /// tracks [albums] lists for it, or else of every audio file in the folder.
+  Stream<Map<String, dynamic>> createTorrentsBatch(
+      List<String> paths, {
+        List<String>? trackers,
+        Map<String, List<String>>? albums,
+      }) {
+    late final StreamController<Map<String, dynamic>> out;
+    StreamSubscription<MethodCall>? sub;
+    int? batchId;
+    final early = <MethodCall>[];
+
+    void handle(MethodCall call) {
+      final args = Map<String, dynamic>.from(call.arguments as Map);
+      if (args['batchId'] != batchId) return;
+      if (call.method == 'batchResult') {
+        out.add(args);
+      } else if (call.method == 'batchDone') {
+        debugPrint('[LibtorrentService] batch $batchId: ${args['succeeded']} ok, '
+            '${args['failed']} failed in ${args['elapsedMs']} ms');
+        sub?.cancel();
+        out.close();
+      }
+    }
+
+    out = StreamController<Map<String, dynamic>>(
+      onListen: () async {
+        // results can race the reply carrying the batch id
+        sub = _events.listen((c) => batchId == null ? early.add(c) : handle(c));
+        try {
+          batchId = await _channel.invokeMethod<int>('createTorrentsBatch', {
+            'paths': paths,
+            'trackers': trackers,
+            if (albums != null && albums.isNotEmpty) 'albums': albums,
+          });
+        } catch (e, st) {
+          debugPrint('[LibtorrentService] createTorrentsBatch failed: $e\n$st');
+        }
+        if (batchId == null) {
+          await sub?.cancel();
+          await out.close();
+          return;
+        }
+        for (final c in early) {
+          handle(c);
+        }
+        early.clear();
+      },
+      onCancel: () async {
+        await sub?.cancel();
+        final id = batchId;
+        if (id == null || out.isClosed) return;
+        try {
+          await _channel.invokeMethod<bool>('cancelTorrentsBatch', {'batchId': id});
+        } catch (e, st) {
+          debugPrint('[LibtorrentService] cancelTorrentsBatch failed: $e\n$st');
+        }
+      },
+    );
+    return out.stream;
+  }
+
   Future<bool> addTorrentFromBytes(
       Uint8List torrentBytes,
       String savePath, {
@@ -166,7 +579,313 @@ class LibtorrentService {
     }
   }
 
+  /// Seeds the song (or album folder, see [albumSource]) at [sourcePath]
+  /// where it is: the native library storage reads its files in place, so
+  /// no per-song save path is needed and re-adding it after a rename
+  /// relinks the running torrent.
+  Future<bool> addLibraryTorrent(
+      Uint8List torrentBytes,
+      String sourcePath, {
+        bool announce = false,
+      }) async {
+    try {
+      final ok = await _channel.invokeMethod<bool>('addLibraryTorrent', {
+        'torrentBytes': torrentBytes,
+        'sourcePath': sourcePath,
+        'announce': announce,
+      });
+      return ok ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] addLibraryTorrent failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// `{torrents, open_files, file_limit, opens, reuses, evictions, reads,
+  /// writes, hashes}` of the library storage seeds are served from.
+  Future<Map<String, dynamic>> getLibraryStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getLibraryStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getLibraryStats failed: $e\n$st');
+      return {};
+    }
+  }
+
   /// NEW DIRECT METHOD: Get infoHash from raw .torrent bytes without writing to file.
+  /// A v1 (40 hex chars) or v2 (64 hex chars) info-hash; every lookup by
+  /// hash accepts either, so a hybrid torrent can be found by both.
+  static bool isInfoHash(String s) => RegExp(r'^([a-f0-9]{40}|[a-f0-9]{64})$').hasMatch(s);
+
+  /// Both hashes of a .torrent: `{v1: String?, v2: String?}` – a hybrid
+  /// has both, a v1- or v2-only torrent just one.
+  Future<Map<String, String?>?> getInfoHashesFromBytes(Uint8List torrentBytes) async {
+    try {
+      final raw = await _channel.invokeMethod<String>(
+        'getInfoHashesFromBytes',
+        {'torrentBytes': torrentBytes},
+      );
+      if (raw == null || raw.isEmpty) return null;
+      final m = jsonDecode(raw) as Map;
+      return {'v1': m['v1'] as String?, 'v2': m['v2'] as String?};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getInfoHashesFromBytes failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// What torrent creation produces from now on: `hybrid` (default; v1 and
+  /// v2 peers share one swarm), `v1` or `v2`.
+  Future<bool> setTorrentVersion(String version) async {
+    try {
+      final ok = await _channel.invokeMethod<bool>('setTorrentVersion', {'version': version});
+      return ok ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] setTorrentVersion failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// Seconds of opening audio (0–30; 0, the default, embeds none) that
+  /// torrent creation puts into each .torrent from now on. Peers adding it
+  /// from the catalog start playing from those bytes while the swarm
+  /// connects; the info-hash is unaffected.
+  Future<bool> setPreambleSeconds(int seconds) async {
+    try {
+      final ok = await _channel.invokeMethod<bool>('setPreambleSeconds', {'seconds': seconds});
+      return ok ?? false;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] setPreambleSeconds failed: $e\n$st');
+      return false;
+    }
+  }
+
+  /// Every loaded file whose v2 merkle root is [root] (the `root` field of
+  /// [getTorrentFiles]): the same track in other albums or torrents.
+  Future<List<Map<String, dynamic>>> findTorrentsByFileRoot(String root) async {
+    try {
+      final raw = await _channel.invokeMethod<String>('findTorrentsByFileRoot', {'root': root});
+      if (raw == null || raw.isEmpty) return [];
+      return (jsonDecode(raw) as List)
+          .map((e) => Map<String, dynamic>.from(e as Map))
+          .toList();
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] findTorrentsByFileRoot failed: $e\n$st');
+      return [];
+    }
+  }
+
+  /// Loopback URL that plays file [fileIndex] of a torrent while it is
+  /// still downloading: the native stream server answers the player's Range
+  /// requests as pieces arrive and moves the pieces it reads next to the
+  /// front of the queue. Null for an unknown torrent.
+  Future<String?> getStreamUrl(String infoHash, {int fileIndex = 0}) async {
+    if (!isInfoHash(infoHash)) return null;
+    try {
+      final url = await _channel.invokeMethod<String>(
+        'getStreamUrl',
+        {'infoHash': infoHash, 'fileIndex': fileIndex},
+      );
+      return (url == null || url.isEmpty) ? null : url;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getStreamUrl failed: $e\n$st');
+      return null;
+    }
+  }
+
+  Future<void> stopStreamServer() async {
+    try {
+      await _channel.invokeMethod('stopStreamServer');
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] stopStreamServer failed: $e\n$st');
+    }
+  }
+
+  /// Reports the play head of a streamed file so the native scheduler keeps
+  /// piece deadlines just ahead of it. Call about once a second and with
+  /// [seek] right after a seek. [bitrateKbps] 0 derives the rate from
+  /// [duration]. Returns the buffer health – `buffer_s` (seconds of audio
+  /// downloaded ahead of the play head), `window_s`, `underruns`,
+  /// `underrun_ms` – or null for an unknown torrent.
+  Future<Map<String, dynamic>?> updatePlayback(
+    String infoHash, {
+    int fileIndex = 0,
+    required Duration position,
+    Duration? duration,
+    int bitrateKbps = 0,
+    bool playing = true,
+    bool seek = false,
+  }) async {
+    if (!isInfoHash(infoHash)) return null;
+    try {
+      final raw = await _channel.invokeMethod<String>('updatePlayback', {
+        'infoHash': infoHash,
+        'fileIndex': fileIndex,
+        'positionMs': position.inMilliseconds,
+        'durationMs': duration?.inMilliseconds ?? 0,
+        'bitrateKbps': bitrateKbps,
+        'playing': playing,
+        'seek': seek,
+      });
+      if (raw == null || raw.isEmpty) return null;
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : null;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] updatePlayback failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Time → byte → piece map of a track, read natively from its container
+  /// header: `{format, duration_ms, exact, points: [{ms, offset, piece}]}`.
+  /// `{pending: true, ...}` while the header pieces are still downloading;
+  /// null when the format has no index.
+  Future<Map<String, dynamic>?> getSeekIndex(
+    String infoHash, {
+    int fileIndex = 0,
+  }) async {
+    if (!isInfoHash(infoHash)) return null;
+    try {
+      final raw = await _channel.invokeMethod<String>(
+        'getSeekIndex',
+        {'infoHash': infoHash, 'fileIndex': fileIndex},
+      );
+      if (raw == null || raw.isEmpty) return null;
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : null;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getSeekIndex failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// The preamble the torrent's .torrent carried: `{format, duration_ms,
+  /// length, state}` with state `pending` until its pieces are checked,
+  /// then `verified` or `rejected`. Null when it came without one.
+  Future<Map<String, dynamic>?> getPreamble(String infoHash) async {
+    if (!isInfoHash(infoHash)) return null;
+    try {
+      final raw = await _channel.invokeMethod<String>('getPreamble', {'infoHash': infoHash});
+      if (raw == null || raw.isEmpty) return null;
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : null;
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getPreamble failed: $e\n$st');
+      return null;
+    }
+  }
+
+  /// Hands the player's upcoming swarm tracks to the native prefetcher, in
+  /// play order with shuffle applied. Each entry is `{infoHash, fileIndex,
+  /// startsInMs}` (`startsInMs` optional). The first few tracks get their
+  /// opening seconds downloaded before the current one ends, so swarm
+  /// tracks start gaplessly. An empty list cancels prefetching.
+  Future<void> setPrefetchQueue(List<Map<String, dynamic>> queue) async {
+    try {
+      await _channel.invokeMethod('setPrefetchQueue', {
+        'queue': queue
+            .where((e) => e['infoHash'] is String && isInfoHash(e['infoHash']))
+            .toList(growable: false),
+      });
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] setPrefetchQueue failed: $e\n$st');
+    }
+  }
+
+  /// Seconds fetched per track, how many upcoming tracks, and the byte
+  /// budget across them; omitted values stay as they are.
+  Future<void> configurePrefetch({
+    int? seconds,
+    int? tracks,
+    int? budgetBytes,
+  }) async {
+    try {
+      await _channel.invokeMethod('configurePrefetch', {
+        'seconds': seconds ?? -1,
+        'tracks': tracks ?? -1,
+        'budgetBytes': budgetBytes ?? -1,
+      });
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] configurePrefetch failed: $e\n$st');
+    }
+  }
+
+  Future<Map<String, dynamic>> getPrefetchStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getPrefetchStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getPrefetchStats failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// RAM for streamed pieces read back from disk, shared by every stream
+  /// (default 32 MiB; 0 turns it off). Seeking back is served from it.
+  Future<void> configureReadCache(int capacityBytes) async {
+    try {
+      await _channel.invokeMethod('configureReadCache', {'capacityBytes': capacityBytes});
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] configureReadCache failed: $e\n$st');
+    }
+  }
+
+  /// `{capacity, bytes, entries, hits, misses, hit_rate, evictions, trims}`
+  /// of the streamed-piece read cache.
+  Future<Map<String, dynamic>> getReadCacheStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getReadCacheStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getReadCacheStats failed: $e\n$st');
+      return {};
+    }
+  }
+
+  /// RAM kept for the pieces peers request most from this device's seeds
+  /// (default 16 MiB; 0 turns it off). The hottest pieces stay pinned.
+  Future<void> configureUploadCache(int capacityBytes) async {
+    try {
+      await _channel.invokeMethod('configureUploadCache', {'capacityBytes': capacityBytes});
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] configureUploadCache failed: $e\n$st');
+    }
+  }
+
+  /// `{capacity, bytes, entries, tracked, hits, misses, hit_rate, admitted,
+  /// displaced, trims, hottest: [{info_hash, piece, heat, cached}]}` of the
+  /// upload cache.
+  Future<Map<String, dynamic>> getUploadCacheStats() async {
+    try {
+      final raw = await _channel.invokeMethod<String>('getUploadCacheStats');
+      if (raw == null) return {};
+      final parsed = jsonDecode(raw);
+      return parsed is Map<String, dynamic> ? parsed : {};
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] getUploadCacheStats failed: $e\n$st');
+      return {};
+    }
+  }
+
+  Future<void> stopPlayback(String infoHash, {int fileIndex = 0}) async {
+    if (!isInfoHash(infoHash)) return;
+    try {
+      await _channel.invokeMethod(
+        'stopPlayback',
+        {'infoHash': infoHash, 'fileIndex': fileIndex},
+      );
+    } catch (e, st) {
+      debugPrint('[LibtorrentService] stopPlayback failed: $e\n$st');
+    }
+  }
+
   Future<String?> getInfoHashFromDecryptedBytes(Uint8List torrentBytes) async {
     try {
       final result = await _channel.invokeMethod<String>(
@@ -239,8 +958,8 @@ class LibtorrentService {
       return;
     }
 
-    // Validate length and format (40-char lowercase hex string)
-    final isValidHash = RegExp(r'^[a-f0-9]{40}$').hasMatch(infoHash);
+    // Validate length and format (40-char v1 or 64-char v2 lowercase hex)
+    final isValidHash = isInfoHash(infoHash);
     if (!isValidHash) {
       debugPrint('[LibtorrentService] ❌ startTorrentByHash: invalid format for infoHash: "$infoHash"');
       return;
@@ -281,9 +1000,15 @@ class LibtorrentService {
   }
   /// Checks if a torrent with the given infoHash is currently running
   Future<bool> isTorrentRunning(String infoHash) async {
+    // read in place from the binary status channel when dart:ffi is up;
+    // a truncated frame cannot rule the torrent out
+    final inFrame = AudynFfi.open()?.withStatusFrame<bool?>((f) =>
+        f.indexOf(infoHash) >= 0 ? true : (f.total > f.length ? null : false));
+    if (inFrame != null) return inFrame;
+
     try {
       final torrents = await getAllTorrents();
-      return torrents.any((t) => t['infoHash'] == infoHash);
+      return torrents.any((t) => t['info_hash'] == infoHash);
     } catch (e, st) {
       debugPrint('[LibtorrentService] isTorrentRunning failed: $e\n$st');
       return false;
@@ -293,14 +1018,21 @@ class LibtorrentService {
   /// Basic health check — expand this based on your criteria
   /// For now, returns true if torrent has at least 1 peer or is seeding
   Future<bool> isTorrentHealthy(String infoHash) async {
+    final inFrame = AudynFfi.open()?.withStatusFrame<bool?>((f) {
+      final i = f.indexOf(infoHash);
+      if (i < 0) return f.total > f.length ? null : false;
+      return f.numPeers(i) > 0 || f.progress(i) >= 0.95;
+    });
+    if (inFrame != null) return inFrame;
+
     try {
       final torrents = await getAllTorrents();
       final torrent = torrents.firstWhere(
-            (t) => t['infoHash'] == infoHash,
+            (t) => t['info_hash'] == infoHash,
         orElse: () => {},
       );
 
-      final peers = int.tryParse('${torrent['numPeers'] ?? 0}') ?? 0;
+      final peers = int.tryParse('${torrent['num_peers'] ?? 0}') ?? 0;
       final progress = double.tryParse('${torrent['progress'] ?? 0.0}') ?? 0.0;
 
       // Example criteria: has peers or is nearly complete
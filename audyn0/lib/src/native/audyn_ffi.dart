@@ -0,0 +1,405 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+
+import 'status_frame.dart';
+
+/// Direct `dart:ffi` binding to the C ABI in `audyn_ffi.h`.
+///
+/// Calls go straight into the native library on the calling isolate – no
+/// platform-thread hop and no StandardMessageCodec round trip. Asynchronous
+/// operations (add / remove) complete through a [ReceivePort] that the
+/// native side posts `[requestId, code, payload]` to.
+///
+/// The MethodChannel API in `LibtorrentService` keeps working alongside;
+/// both drive the same native session.
+class AudynFfi {
+  static const int ok = 0;
+  static const int errInvalid = -1;
+  static const int errNotFound = -2;
+  static const int errNoSession = -3;
+  static const int errParse = -4;
+  static const int errFailed = -5;
+
+  static const int _statusDefaultCapacity = 8192;
+
+  AudynFfi._(this._lib) : _b = _Bindings(_lib);
+
+  static AudynFfi? _instance;
+
+  /// Opens the native library and the session; null if either fails.
+  static AudynFfi? open() {
+    if (_instance != null) return _instance;
+    try {
+      final ffi = AudynFfi._(DynamicLibrary.open('liblibtorrentwrapper.so'));
+      if (ffi._b.initDartApi(NativeApi.postCObject.cast()) != ok) return null;
+      ffi._session = ffi._b.sessionOpen();
+      if (ffi._session == nullptr) return null;
+      ffi._port.listen(ffi._onCompletion);
+      return _instance = ffi;
+    } catch (e, st) {
+      debugPrint('[AudynFfi] open failed: $e\n$st');
+      return null;
+    }
+  }
+
+  final DynamicLibrary _lib;
+  final _Bindings _b;
+  Pointer<Void> _session = nullptr;
+  final ReceivePort _port = ReceivePort('audyn_ffi');
+  final Map<int, Completer<String>> _pending = {};
+  int _nextRequest = 1;
+
+  Pointer<Uint8> _status = nullptr;
+  int _statusSize = 0;
+
+  DynamicLibrary get library => _lib;
+
+  String get version => _b.version().cast<Utf8>().toDartString();
+
+  void close() {
+    _b.sessionClose(_session);
+    _session = nullptr;
+    _port.close();
+    for (final c in _pending.values) {
+      c.completeError(StateError('session closed'));
+    }
+    _pending.clear();
+    _instance = null;
+  }
+
+  void refreshStatus() => _b.refreshStatus(_session);
+
+  /// Same JSON list as `getAllTorrents`.
+  List<dynamic> torrents() {
+    final raw = _readString((buf, cap) => _b.torrentsJson(_session, buf, cap));
+    final parsed = raw == null ? null : jsonDecode(raw);
+    return parsed is List ? parsed : const [];
+  }
+
+  /// Same JSON delta as `getTorrentUpdatesSince`.
+  Map<String, dynamic> updatesSince(int seq) {
+    final raw = _readString((buf, cap) => _b.updatesSince(_session, seq, buf, cap));
+    final parsed = raw == null ? null : jsonDecode(raw);
+    return parsed is Map<String, dynamic> ? parsed : const {};
+  }
+
+  /// Runs [read] on the latest binary status frame, in place in native
+  /// memory: the frame is pinned, so the writer leaves it alone until [read]
+  /// returns. The frame must not be used after that. Returns null when
+  /// nothing changed since [sinceSeq].
+  T? withStatusFrame<T>(T Function(TorrentStatusFrame frame) read, {int sinceSeq = 0}) {
+    refreshStatus();
+    if (_status == nullptr) {
+      final out = calloc<Pointer<Uint8>>();
+      try {
+        _statusSize = _b.statusBuffer(_session, _statusDefaultCapacity, out);
+        _status = out.value;
+      } finally {
+        calloc.free(out);
+      }
+      if (_statusSize <= 0) {
+        _status = nullptr;
+        return null;
+      }
+    }
+
+    final seq = _b.statusPin(sinceSeq);
+    if (seq == 0) return null;
+    try {
+      final frame = TorrentStatusFrame.view(_status.asTypedList(_statusSize), seq);
+      return frame == null ? null : read(frame);
+    } finally {
+      _b.statusUnpin(seq);
+    }
+  }
+
+  /// Adds a torrent from `.torrent` bytes; completes with its info-hash.
+  Future<String> addTorrentBytes(
+      Uint8List torrentBytes, {
+        required String savePath,
+        bool seedMode = false,
+        bool announce = false,
+        bool enableDHT = true,
+        bool enableLSD = true,
+        bool enableUTP = true,
+        bool enableTrackers = false,
+        bool enablePeerExchange = true,
+      }) {
+    final path = savePath.toNativeUtf8();
+    final opts = calloc<_AddOptions>();
+    try {
+      opts.ref
+        ..seedMode = seedMode ? 1 : 0
+        ..announce = announce ? 1 : 0
+        ..enableDht = enableDHT ? 1 : 0
+        ..enableLsd = enableLSD ? 1 : 0
+        ..enableUtp = enableUTP ? 1 : 0
+        ..enableTrackers = enableTrackers ? 1 : 0
+        ..enablePex = enablePeerExchange ? 1 : 0;
+
+      final id = _nextRequest++;
+      final completer = Completer<String>();
+      _pending[id] = completer;
+      // leaf call: the native side reads the Dart heap bytes in place
+      final rc = _b.addTorrentBytes(_session, torrentBytes.address, torrentBytes.length, path,
+          opts, _port.sendPort.nativePort, id);
+      if (rc != ok) {
+        _pending.remove(id);
+        return Future.error(AudynFfiException('addTorrentBytes', rc));
+      }
+      return completer.future;
+    } finally {
+      // parsed synchronously – safe to release before completion
+      calloc.free(path);
+      calloc.free(opts);
+    }
+  }
+
+  /// Handle for a torrent by info-hash, source path or name; null if unknown.
+  /// Call [AudynTorrent.release] when done.
+  AudynTorrent? find(String query) {
+    final q = query.toNativeUtf8();
+    try {
+      final t = _b.torrentFind(_session, q);
+      return t == nullptr ? null : AudynTorrent._(this, t);
+    } finally {
+      calloc.free(q);
+    }
+  }
+
+  void _onCompletion(dynamic msg) {
+    if (msg is! List || msg.length != 3) return;
+    final completer = _pending.remove(msg[0] as int);
+    if (completer == null) return;
+    final code = msg[1] as int;
+    if (code == ok) {
+      completer.complete(msg[2] as String);
+    } else {
+      completer.completeError(AudynFfiException(msg[2] as String, code));
+    }
+  }
+
+  // snprintf-style native call: retry once with the exact size needed
+  String? _readString(int Function(Pointer<Utf8> buf, int cap) call) {
+    var cap = 16 * 1024;
+    for (var attempt = 0; attempt < 2; attempt++) {
+      final buf = calloc<Uint8>(cap);
+      try {
+        final n = call(buf.cast(), cap);
+        if (n < 0) return null;
+        if (n < cap) return buf.cast<Utf8>().toDartString(length: n);
+        cap = n + 1;
+      } finally {
+        calloc.free(buf);
+      }
+    }
+    return null;
+  }
+}
+
+/// Caller-owned native torrent handle.
+class AudynTorrent {
+  AudynTorrent._(this._ffi, this._ptr);
+
+  final AudynFfi _ffi;
+  Pointer<Void> _ptr;
+
+  String get infoHash =>
+      _ffi._readString((buf, cap) => _ffi._b.torrentInfoHash(_ptr, buf, cap)) ?? '';
+
+  String? get savePath =>
+      _ffi._readString((buf, cap) => _ffi._b.torrentSavePath(_ptr, buf, cap));
+
+  /// Latest cached status, or null if the torrent has not been reported yet.
+  AudynTorrentStatus? status() {
+    final out = calloc<_TorrentStatus>();
+    try {
+      if (_ffi._b.torrentGetStatus(_ptr, out) != AudynFfi.ok) return null;
+      return AudynTorrentStatus._(out.ref);
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  bool pause() => _ffi._b.torrentPause(_ptr) == AudynFfi.ok;
+  bool resume() => _ffi._b.torrentResume(_ptr) == AudynFfi.ok;
+
+  /// Completes with the info-hash once libtorrent has dropped the torrent.
+  Future<String> remove({bool removeData = false}) {
+    final id = _ffi._nextRequest++;
+    final completer = Completer<String>();
+    _ffi._pending[id] = completer;
+    final rc = _ffi._b.torrentRemove(
+        _ptr, removeData ? 1 : 0, _ffi._port.sendPort.nativePort, id);
+    if (rc != AudynFfi.ok) {
+      _ffi._pending.remove(id);
+      return Future.error(AudynFfiException('remove', rc));
+    }
+    return completer.future;
+  }
+
+  void release() {
+    if (_ptr == nullptr) return;
+    _ffi._b.torrentRelease(_ptr);
+    _ptr = nullptr;
+  }
+}
+
+class AudynTorrentStatus {
+  AudynTorrentStatus._(_TorrentStatus s)
+      : state = s.state,
+        progress = s.progress,
+        downloadRate = s.downloadRate,
+        uploadRate = s.uploadRate,
+        numPeers = s.numPeers,
+        numSeeds = s.numSeeds,
+        totalDone = s.totalDone,
+        totalWanted = s.totalWanted,
+        allTimeUpload = s.allTimeUpload,
+        flags = s.flags;
+
+  final int state;
+  final double progress;
+  final int downloadRate;
+  final int uploadRate;
+  final int numPeers;
+  final int numSeeds;
+  final int totalDone;
+  final int totalWanted;
+  final int allTimeUpload;
+  final int flags;
+
+  bool get isPaused => flags & TorrentStatusFrame.flagPaused != 0;
+  bool get isFinished => flags & TorrentStatusFrame.flagFinished != 0;
+}
+
+class AudynFfiException implements Exception {
+  AudynFfiException(this.message, this.code);
+
+  final String message;
+  final int code;
+
+  @override
+  String toString() => 'AudynFfiException($code): $message';
+}
+
+/*─────────────────────────────────────────*
+ *  struct / function mirrors of audyn_ffi.h
+ *─────────────────────────────────────────*/
+
+final class _AddOptions extends Struct {
+  @Int32()
+  external int seedMode;
+  @Int32()
+  external int announce;
+  @Int32()
+  external int enableDht;
+  @Int32()
+  external int enableLsd;
+  @Int32()
+  external int enableUtp;
+  @Int32()
+  external int enableTrackers;
+  @Int32()
+  external int enablePex;
+}
+
+final class _TorrentStatus extends Struct {
+  @Array(20)
+  external Array<Uint8> infoHash;
+  @Int32()
+  external int state;
+  @Float()
+  external double progress;
+  @Int32()
+  external int downloadRate;
+  @Int32()
+  external int uploadRate;
+  @Int32()
+  external int numPeers;
+  @Int32()
+  external int numSeeds;
+  @Int64()
+  external int totalDone;
+  @Int64()
+  external int totalWanted;
+  @Int64()
+  external int allTimeUpload;
+  @Uint32()
+  external int flags;
+}
+
+class _Bindings {
+  _Bindings(DynamicLibrary l)
+      : version = l.lookupFunction<Pointer<Char> Function(), Pointer<Char> Function()>(
+            'audyn_version'),
+        initDartApi = l.lookupFunction<Int32 Function(Pointer<Void>),
+            int Function(Pointer<Void>)>('audyn_init_dart_api'),
+        sessionOpen = l.lookupFunction<Pointer<Void> Function(),
+            Pointer<Void> Function()>('audyn_session_open'),
+        sessionClose = l.lookupFunction<Void Function(Pointer<Void>),
+            void Function(Pointer<Void>)>('audyn_session_close'),
+        refreshStatus = l.lookupFunction<Void Function(Pointer<Void>),
+            void Function(Pointer<Void>)>('audyn_refresh_status'),
+        torrentsJson = l.lookupFunction<Int64 Function(Pointer<Void>, Pointer<Utf8>, Int64),
+            int Function(Pointer<Void>, Pointer<Utf8>, int)>('audyn_torrents_json'),
+        updatesSince = l.lookupFunction<
+            Int64 Function(Pointer<Void>, Int64, Pointer<Utf8>, Int64),
+            int Function(Pointer<Void>, int, Pointer<Utf8>, int)>('audyn_updates_since'),
+        statusBuffer = l.lookupFunction<
+            Int64 Function(Pointer<Void>, Int32, Pointer<Pointer<Uint8>>),
+            int Function(Pointer<Void>, int, Pointer<Pointer<Uint8>>)>('audyn_status_buffer'),
+        statusPin = l.lookupFunction<Int64 Function(Int64), int Function(int)>(
+            'audyn_status_pin'),
+        statusUnpin = l.lookupFunction<Void Function(Int64), void Function(int)>(
+            'audyn_status_unpin'),
+        addTorrentBytes = l.lookupFunction<
+            Int32 Function(Pointer<Void>, Pointer<Uint8>, Int64, Pointer<Utf8>,
+                Pointer<_AddOptions>, Int64, Int64),
+            int Function(Pointer<Void>, Pointer<Uint8>, int, Pointer<Utf8>,
+                Pointer<_AddOptions>, int, int)>('audyn_add_torrent_bytes', isLeaf: true),
+        torrentFind = l.lookupFunction<Pointer<Void> Function(Pointer<Void>, Pointer<Utf8>),
+            Pointer<Void> Function(Pointer<Void>, Pointer<Utf8>)>('audyn_torrent_find'),
+        torrentRelease = l.lookupFunction<Void Function(Pointer<Void>),
+            void Function(Pointer<Void>)>('audyn_torrent_release'),
+        torrentGetStatus = l.lookupFunction<
+            Int32 Function(Pointer<Void>, Pointer<_TorrentStatus>),
+            int Function(Pointer<Void>, Pointer<_TorrentStatus>)>('audyn_torrent_get_status'),
+        torrentInfoHash = l.lookupFunction<Int64 Function(Pointer<Void>, Pointer<Utf8>, Int64),
+            int Function(Pointer<Void>, Pointer<Utf8>, int)>('audyn_torrent_info_hash'),
+        torrentSavePath = l.lookupFunction<Int64 Function(Pointer<Void>, Pointer<Utf8>, Int64),
+            int Function(Pointer<Void>, Pointer<Utf8>, int)>('audyn_torrent_save_path'),
+        torrentPause = l.lookupFunction<Int32 Function(Pointer<Void>),
+            int Function(Pointer<Void>)>('audyn_torrent_pause'),
+        torrentResume = l.lookupFunction<Int32 Function(Pointer<Void>),
+            int Function(Pointer<Void>)>('audyn_torrent_resume'),
+        torrentRemove = l.lookupFunction<Int32 Function(Pointer<Void>, Int32, Int64, Int64),
+            int Function(Pointer<Void>, int, int, int)>('audyn_torrent_remove');
+
+  final Pointer<Char> Function() version;
+  final int Function(Pointer<Void>) initDartApi;
+  final Pointer<Void> Function() sessionOpen;
+  final void Function(Pointer<Void>) sessionClose;
+  final void Function(Pointer<Void>) refreshStatus;
+  final int Function(Pointer<Void>, Pointer<Utf8>, int) torrentsJson;
+  final int Function(Pointer<Void>, int, Pointer<Utf8>, int) updatesSince;
+  final int Function(Pointer<Void>, int, Pointer<Pointer<Uint8>>) statusBuffer;
+  final int Function(int) statusPin;
+  final void Function(int) statusUnpin;
+  final int Function(Pointer<Void>, Pointer<Uint8>, int, Pointer<Utf8>,
+      Pointer<_AddOptions>, int, int) addTorrentBytes;
+  final Pointer<Void> Function(Pointer<Void>, Pointer<Utf8>) torrentFind;
+  final void Function(Pointer<Void>) torrentRelease;
+  final int Function(Pointer<Void>, Pointer<_TorrentStatus>) torrentGetStatus;
+  final int Function(Pointer<Void>, Pointer<Utf8>, int) torrentInfoHash;
+  final int Function(Pointer<Void>, Pointer<Utf8>, int) torrentSavePath;
+  final int Function(Pointer<Void>) torrentPause;
+  final int Function(Pointer<Void>) torrentResume;
+  final int Function(Pointer<Void>, int, int, int) torrentRemove;
+}
@@ -227,8 +227,8 @@ class LibtorrentWrapper {
       print('ERROR: infoHash is null or empty!');
       return false;
     }
-    if (infoHash.length != 40) {
-      print('ERROR: infoHash length is not 40 chars: ${infoHash.length}');
+    if (infoHash.length != 40 && infoHash.length != 64) {
+      print('ERROR: infoHash is neither 40 (v1) nor 64 (v2) chars: ${infoHash.length}');
       return false;
     }
 
@@ -0,0 +1,99 @@
+import 'dart:typed_data';
+
+/// View of one frame of the native binary status channel
+/// (`status_channel` in LibtorrentWrapper.cpp), handed out by
+/// `AudynFfi.withStatusFrame`.
+///
+/// The bytes are read in place – nothing is parsed or copied, every getter
+/// reads straight from the columnar layout in native memory. All fields are
+/// little-endian.
+class TorrentStatusFrame {
+  static const int _magic = 0x53445541; // 'AUDS'
+  static const int _headerBytes = 64;
+  static const int _frameHeaderBytes = 32;
+
+  static const int flagPaused = 1;
+  static const int flagSeedMode = 2;
+  static const int flagFinished = 4;
+
+  final ByteData _data;
+  final int capacity;
+
+  // frame header and column offsets, relative to the start of [_data]
+  final int _frame;
+  final int _progress;
+  final int _down;
+  final int _up;
+  final int _peers;
+  final int _seeds;
+  final int _state;
+  final int _flags;
+  final int _hashes;
+
+  TorrentStatusFrame._(this._data, this.capacity, int frame)
+      : _frame = frame,
+        _progress = frame + _frameHeaderBytes,
+        _down = frame + _frameHeaderBytes + 4 * capacity,
+        _up = frame + _frameHeaderBytes + 8 * capacity,
+        _peers = frame + _frameHeaderBytes + 12 * capacity,
+        _seeds = frame + _frameHeaderBytes + 14 * capacity,
+        _state = frame + _frameHeaderBytes + 16 * capacity,
+        _flags = frame + _frameHeaderBytes + 17 * capacity,
+        _hashes = frame + _frameHeaderBytes + 18 * capacity;
+
+  /// Frame [seq] of the whole channel buffer [channel], or null if it is not
+  /// a status channel this decoder understands.
+  static TorrentStatusFrame? view(Uint8List channel, int seq) {
+    if (channel.lengthInBytes < _headerBytes) return null;
+    final data = ByteData.sublistView(channel);
+    if (data.getUint32(0, Endian.little) != _magic) return null;
+    if (data.getUint16(4, Endian.little) != 1) return null;
+
+    final slots = data.getUint16(6, Endian.little);
+    final capacity = data.getUint32(8, Endian.little);
+    final frameBytes = data.getUint32(12, Endian.little);
+    if (slots == 0 || channel.lengthInBytes < _headerBytes + slots * frameBytes) return null;
+    return TorrentStatusFrame._(data, capacity, _headerBytes + (seq % slots) * frameBytes);
+  }
+
+  /// Sequence number of this frame – pass it back to skip unchanged frames.
+  int get seq => _data.getUint64(_frame, Endian.little);
+
+  /// Version of the native status snapshot the frame was written from.
+  int get version => _data.getUint64(_frame + 8, Endian.little);
+
+  /// Rows present in this frame.
+  int get length => _data.getUint32(_frame + 16, Endian.little);
+
+  /// Torrents in the session; larger than [length] if the frame was truncated.
+  int get total => _data.getUint32(_frame + 20, Endian.little);
+
+  double progress(int i) => _data.getFloat32(_progress + 4 * i, Endian.little);
+  int downloadRate(int i) => _data.getInt32(_down + 4 * i, Endian.little);
+  int uploadRate(int i) => _data.getInt32(_up + 4 * i, Endian.little);
+  int numPeers(int i) => _data.getUint16(_peers + 2 * i, Endian.little);
+  int numSeeds(int i) => _data.getUint16(_seeds + 2 * i, Endian.little);
+  int state(int i) => _data.getUint8(_state + i);
+  int flags(int i) => _data.getUint8(_flags + i);
+
+  bool isPaused(int i) => flags(i) & flagPaused != 0;
+  bool isFinished(int i) => flags(i) & flagFinished != 0;
+
+  /// Lower-case hex info-hash, same format as the JSON APIs.
+  String infoHash(int i) {
+    final sb = StringBuffer();
+    final base = _hashes + 20 * i;
+    for (var b = 0; b < 20; b++) {
+      sb.write(_data.getUint8(base + b).toRadixString(16).padLeft(2, '0'));
+    }
+    return sb.toString();
+  }
+
+  /// Row index for [infoHash], or -1.
+  int indexOf(String infoHash) {
+    for (var i = 0; i < length; i++) {
+      if (this.infoHash(i) == infoHash) return i;
+    }
+    return -1;
+  }
+}
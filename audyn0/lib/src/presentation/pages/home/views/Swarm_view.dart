@@ -127,7 +127,9 @@ class _SwarmViewState extends State<SwarmView> {
     if (!await _audioQuery.permissionsRequest()) return;
 
     final songs = await _audioQuery.querySongs();
-    final existingSongPaths = songs.map((s) => s.data).toSet();
+    final existingSongKeys = songs
+        .map((s) => MusicSeederService.norm(p.basenameWithoutExtension(s.data)))
+        .toSet();
 
     // Clean orphaned torrent files
     final seededTorrents = await _seeder!.getAllSeededTorrents();
@@ -135,8 +137,7 @@ class _SwarmViewState extends State<SwarmView> {
       final base = p.basenameWithoutExtension(encTorrentPath);
       final norm = MusicSeederService.norm(base);
 
-      final isStillPresent = existingSongPaths.any((sp) =>
-      MusicSeederService.norm(p.basenameWithoutExtension(sp)) == norm);
+      final isStillPresent = existingSongKeys.contains(norm);
 
       if (!isStillPresent) {
         final infoHash = await _getInfoHashFromPath(encTorrentPath);